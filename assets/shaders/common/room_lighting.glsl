@@ -0,0 +1,118 @@
+// Materials, clustered lights and shadows shared by the room shaders.
+// Keep in sync with MaterialTable::MAX_MATERIALS.
+#define MAX_MATERIALS 256
+
+struct Material {
+    vec4 color;
+    vec4 params; // x = texture layer (-1 = none), y = uv scale, zw = aspect scale
+};
+
+layout(std140) uniform Materials {
+    Material materials[MAX_MATERIALS];
+};
+
+uniform sampler2DArray materialTex;
+
+// Baked indirect light; replaces ambientLight when enabled.
+uniform sampler2D lightmap;
+uniform bool lightmapEnabled;
+
+// Keep in sync with ClusteredLights.
+#define CLUSTER_TILES_X 16u
+#define CLUSTER_TILES_Y 9u
+#define CLUSTER_SLICES 24u
+#define LIGHT_TEXELS 4
+
+uniform samplerBuffer lightData;
+uniform usamplerBuffer lightClusters;
+uniform usamplerBuffer lightIndices;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepth;
+uniform vec3 ambientLight;
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+// Keep in sync with ShadowMaps.
+#define SHADOW_CASCADES 4
+#define MAX_SPOT_SHADOWS 32
+
+layout(std140) uniform Shadows {
+    mat4 cascadeMatrices[SHADOW_CASCADES];
+    vec4 cascadeSplits;
+    vec4 cascadeTexelSizes;
+    mat4 spotShadowMatrices[MAX_SPOT_SHADOWS];
+};
+
+uniform sampler2DArrayShadow cascadeShadows;
+uniform sampler2DArrayShadow spotShadows;
+
+float sunShadow(vec3 position, vec3 normal, float viewDepth) {
+    int cascade = 0;
+    while (cascade < SHADOW_CASCADES && viewDepth > cascadeSplits[cascade]) ++cascade;
+    if (cascade == SHADOW_CASCADES) return 1.0;
+
+    // Offset along the normal by about a texel to keep surfaces off their own depth.
+    vec3 p = (cascadeMatrices[cascade] * vec4(position + normal * cascadeTexelSizes[cascade] * 1.5, 1.0)).xyz;
+    // 3x3 taps, each already a bilinear 2x2 comparison.
+    vec2 texel = 1.0 / vec2(textureSize(cascadeShadows, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            lit += texture(cascadeShadows, vec4(p.xy + vec2(x, y) * texel, float(cascade), p.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+float spotShadow(int layer, vec3 position, vec3 normal) {
+    vec4 p = spotShadowMatrices[layer] * vec4(position + normal * 0.02, 1.0);
+    p.xyz /= p.w;
+    return texture(spotShadows, vec4(p.xy, float(layer), p.z));
+}
+
+// Diffuse light from the sun and the lights binned into this fragment's cluster,
+// on top of `ambient`.
+vec3 lighting(vec3 position, vec3 normal, vec3 ambient, float viewDepth) {
+    uint slice = uint(clamp(log(viewDepth) * clusterDepth.x + clusterDepth.y, 0.0, float(CLUSTER_SLICES - 1u)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), uvec2(CLUSTER_TILES_X - 1u, CLUSTER_TILES_Y - 1u));
+    uvec2 range = texelFetch(lightClusters, int((slice * CLUSTER_TILES_Y + tile.y) * CLUSTER_TILES_X + tile.x)).xy;
+
+    vec3 light = ambient;
+    float sun = max(dot(normal, -sunDirection), 0.0);
+    if (sun > 0.0) light += sunColor * sun * sunShadow(position, normal, viewDepth);
+
+    for (uint i = 0u; i < range.y; ++i) {
+        int base = int(texelFetch(lightIndices, int(range.x + i)).x) * LIGHT_TEXELS;
+        vec4 positionRange = texelFetch(lightData, base);
+        vec4 colorInner = texelFetch(lightData, base + 1);
+        vec4 directionOuter = texelFetch(lightData, base + 2);
+        int shadowLayer = int(texelFetch(lightData, base + 3).x);
+
+        vec3 toLight = positionRange.xyz - position;
+        float distance = length(toLight);
+        vec3 l = toLight / max(distance, 1e-4);
+        // Inverse square, windowed to reach zero at the range.
+        float window = clamp(1.0 - pow(distance / positionRange.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        float cone = smoothstep(directionOuter.w, colorInner.w, dot(-l, directionOuter.xyz));
+        float diffuse = max(dot(normal, l), 0.0) * attenuation * cone;
+        if (diffuse > 0.0 && shadowLayer >= 0) diffuse *= spotShadow(shadowLayer, position, normal);
+        light += colorInner.rgb * diffuse;
+    }
+    return light;
+}
+
+// The material's colour times the vertex colour, textured if it has a layer.
+vec4 materialColor(uint material, vec3 vertexColor, vec2 uv) {
+    Material m = materials[material];
+    vec4 color = m.color * vec4(vertexColor, 1.0);
+    if (m.params.x >= 0.0) {
+        color *= texture(materialTex, vec3(uv * m.params.y * m.params.zw, m.params.x));
+    }
+    return color;
+}
+
+// The lightmap where one is loaded, otherwise the flat ambient term.
+vec3 indirectLight(vec2 lightmapUV) {
+    return lightmapEnabled ? texture(lightmap, lightmapUV).rgb : ambientLight;
+}
@@ -0,0 +1,102 @@
+#version 330 core
+// Edge-adaptive spatial upsampling after FidelityFX FSR1 EASU: a 12-tap
+// Lanczos-like kernel stretched along the local edge direction, clamped to
+// the 2x2 texels around the sample so it cannot ring.
+out vec4 FragColor;
+
+uniform sampler2D inputTex;
+uniform vec2 inputSize;
+uniform vec2 outputSize;
+
+vec3 tap(ivec2 p) {
+    return texelFetch(inputTex, clamp(p, ivec2(0), ivec2(inputSize) - 1), 0).rgb;
+}
+
+// Cheap luma, as EASU uses: 0.5 r + g + 0.5 b.
+float luma(vec3 c) {
+    return c.g + 0.5 * (c.r + c.b);
+}
+
+// Direction and edge length from one of the four centre texels: l is the
+// texel, a/b/d/e the ones above, left, right and below. w is its bilinear weight.
+void accumulateEdge(inout vec2 dir, inout float len, float w, float a, float b, float l, float d, float e) {
+    float lenX = max(abs(d - l), abs(l - b));
+    float dirX = d - b;
+    lenX = clamp(abs(dirX) / max(lenX, 1e-5), 0.0, 1.0);
+    dir.x += dirX * w;
+    len += lenX * lenX * w;
+
+    float lenY = max(abs(e - l), abs(l - a));
+    float dirY = e - a;
+    lenY = clamp(abs(dirY) / max(lenY, 1e-5), 0.0, 1.0);
+    dir.y += dirY * w;
+    len += lenY * lenY * w;
+}
+
+void accumulateTap(inout vec3 color, inout float weight, vec2 offset, vec2 dir, vec2 len2, float lob, float clp, vec3 c) {
+    // Rotate into the edge frame and stretch.
+    vec2 v = vec2(dot(offset, dir), dot(offset, vec2(-dir.y, dir.x))) * len2;
+    float d2 = min(dot(v, v), clp);
+    // (25/16 (2/5 x^2 - 1)^2 - 9/16) (lob x^2 - 1)^2 approximates the windowed sinc.
+    float wB = 0.4 * d2 - 1.0;
+    float wA = lob * d2 - 1.0;
+    float w = (25.0 / 16.0 * wB * wB - (25.0 / 16.0 - 1.0)) * wA * wA;
+    color += c * w;
+    weight += w;
+}
+
+void main() {
+    vec2 pp = gl_FragCoord.xy * inputSize / outputSize - 0.5;
+    vec2 fp = floor(pp);
+    pp -= fp;
+    ivec2 p = ivec2(fp);
+
+    //    b c
+    //  e f g h
+    //  i j k l
+    //    n o
+    vec3 b = tap(p + ivec2(0, -1)), c = tap(p + ivec2(1, -1));
+    vec3 e = tap(p + ivec2(-1, 0)), f = tap(p), g = tap(p + ivec2(1, 0)), h = tap(p + ivec2(2, 0));
+    vec3 i = tap(p + ivec2(-1, 1)), j = tap(p + ivec2(0, 1)), k = tap(p + ivec2(1, 1)), l = tap(p + ivec2(2, 1));
+    vec3 n = tap(p + ivec2(0, 2)), o = tap(p + ivec2(1, 2));
+
+    float bL = luma(b), cL = luma(c), eL = luma(e), fL = luma(f), gL = luma(g), hL = luma(h);
+    float iL = luma(i), jL = luma(j), kL = luma(k), lL = luma(l), nL = luma(n), oL = luma(o);
+
+    vec2 dir = vec2(0.0);
+    float len = 0.0;
+    accumulateEdge(dir, len, (1.0 - pp.x) * (1.0 - pp.y), bL, eL, fL, gL, jL);
+    accumulateEdge(dir, len, pp.x * (1.0 - pp.y), cL, fL, gL, hL, kL);
+    accumulateEdge(dir, len, (1.0 - pp.x) * pp.y, fL, iL, jL, kL, nL);
+    accumulateEdge(dir, len, pp.x * pp.y, gL, jL, kL, lL, oL);
+
+    float dir2 = dot(dir, dir);
+    dir = dir2 < 1.0 / 32768.0 ? vec2(1.0, 0.0) : dir * inversesqrt(dir2);
+    len = len * 0.5;
+    len *= len;
+    // Longer along axis-aligned edges, up to sqrt(2) along diagonals.
+    float stretch = 1.0 / max(abs(dir.x), abs(dir.y));
+    vec2 len2 = vec2(1.0 + (stretch - 1.0) * len, 1.0 - 0.5 * len);
+    // Negative lobe strength: sharper on edges, softer in flat areas.
+    float lob = 0.5 + (1.0 / 4.0 - 0.04 - 0.5) * len;
+    float clp = 1.0 / lob;
+
+    vec3 color = vec3(0.0);
+    float weight = 0.0;
+    accumulateTap(color, weight, vec2(0.0, -1.0) - pp, dir, len2, lob, clp, b);
+    accumulateTap(color, weight, vec2(1.0, -1.0) - pp, dir, len2, lob, clp, c);
+    accumulateTap(color, weight, vec2(-1.0, 1.0) - pp, dir, len2, lob, clp, i);
+    accumulateTap(color, weight, vec2(0.0, 1.0) - pp, dir, len2, lob, clp, j);
+    accumulateTap(color, weight, vec2(0.0, 0.0) - pp, dir, len2, lob, clp, f);
+    accumulateTap(color, weight, vec2(-1.0, 0.0) - pp, dir, len2, lob, clp, e);
+    accumulateTap(color, weight, vec2(1.0, 1.0) - pp, dir, len2, lob, clp, k);
+    accumulateTap(color, weight, vec2(2.0, 1.0) - pp, dir, len2, lob, clp, l);
+    accumulateTap(color, weight, vec2(2.0, 0.0) - pp, dir, len2, lob, clp, h);
+    accumulateTap(color, weight, vec2(1.0, 0.0) - pp, dir, len2, lob, clp, g);
+    accumulateTap(color, weight, vec2(1.0, 2.0) - pp, dir, len2, lob, clp, o);
+    accumulateTap(color, weight, vec2(0.0, 2.0) - pp, dir, len2, lob, clp, n);
+
+    vec3 lo = min(min(f, g), min(j, k));
+    vec3 hi = max(max(f, g), max(j, k));
+    FragColor = vec4(clamp(color / weight, lo, hi), 1.0);
+}
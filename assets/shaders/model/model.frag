@@ -0,0 +1,33 @@
+#version 330 core
+in vec3 vColor;
+in vec3 vNormal;
+in vec2 vUV;
+in vec4 vTangent;
+
+out vec4 FragColor;
+
+uniform sampler2D baseColorTex;
+uniform sampler2D normalTex;
+uniform int uHasBaseColorTex;
+uniform int uHasNormalTex;
+uniform vec4 uBaseColor;
+
+void main() {
+    vec4 albedo = uBaseColor * vec4(vColor, 1.0);
+    if (uHasBaseColorTex == 1) albedo *= texture(baseColorTex, vUV);
+
+    // Imported meshes without normals still render, just unshaded.
+    float shade = 1.0;
+    if (dot(vNormal, vNormal) > 0.0) {
+        vec3 n = normalize(vNormal);
+        if (uHasNormalTex == 1 && dot(vTangent.xyz, vTangent.xyz) > 0.0) {
+            vec3 t = normalize(vTangent.xyz - n * dot(n, vTangent.xyz));
+            vec3 b = cross(n, t) * vTangent.w;
+            vec3 tn = texture(normalTex, vUV).xyz * 2.0 - 1.0;
+            n = normalize(mat3(t, b, n) * tn);
+        }
+        shade = 0.35 + 0.65 * max(dot(n, normalize(vec3(0.4, 1.0, 0.3))), 0.0);
+    }
+
+    FragColor = vec4(albedo.rgb * shade, albedo.a);
+}
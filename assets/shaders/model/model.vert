@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec2 aUV;
+layout (location = 4) in vec4 aTangent;
+
+out vec3 vColor;
+out vec3 vNormal;
+out vec2 vUV;
+out vec4 vTangent;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    vColor = aColor;
+    vNormal = mat3(model) * aNormal;
+    vUV = aUV;
+    vTangent = vec4(mat3(model) * aTangent.xyz, aTangent.w);
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D opaqueColor;
+uniform sampler2D accumTex;
+uniform sampler2D revealageTex;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 opaque = texelFetch(opaqueColor, pixel, 0).rgb;
+    vec4 accum = texelFetch(accumTex, pixel, 0);
+    float revealage = exp(-texelFetch(revealageTex, pixel, 0).r);
+
+    vec3 average = accum.rgb / max(accum.a, 1e-5);
+    FragColor = vec4(mix(average, opaque, revealage), 1.0);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+// Robust contrast-adaptive sharpening after FidelityFX FSR1 RCAS: a
+// negative-lobe cross filter whose lobe is the largest that keeps the
+// result inside the neighbourhood's range, so edges sharpen without ringing.
+out vec4 FragColor;
+
+uniform sampler2D inputTex;
+// Linear strength, exp2(-stops); 1 is the sharpest.
+uniform float sharpness;
+
+// Lobe limit from FSR: keeps the filter from going unstable.
+const float LOBE_LIMIT = 0.25 - 1.0 / 16.0;
+
+void main() {
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    ivec2 last = textureSize(inputTex, 0) - 1;
+    //   b
+    // d e f
+    //   h
+    vec3 b = texelFetch(inputTex, clamp(p + ivec2(0, -1), ivec2(0), last), 0).rgb;
+    vec3 d = texelFetch(inputTex, clamp(p + ivec2(-1, 0), ivec2(0), last), 0).rgb;
+    vec3 e = texelFetch(inputTex, p, 0).rgb;
+    vec3 f = texelFetch(inputTex, clamp(p + ivec2(1, 0), ivec2(0), last), 0).rgb;
+    vec3 h = texelFetch(inputTex, clamp(p + ivec2(0, 1), ivec2(0), last), 0).rgb;
+
+    vec3 mn = min(min(b, d), min(f, h));
+    vec3 mx = max(max(b, d), max(f, h));
+    // Lobe that would take the centre to 0 or to 1, per channel.
+    vec3 hitMin = min(mn, e) / max(4.0 * mx, 1e-5);
+    vec3 hitMax = (1.0 - max(mx, e)) / min(4.0 * mn - 4.0, -1e-5);
+    vec3 lobeRGB = max(-hitMin, hitMax);
+    float lobe = max(-LOBE_LIMIT, min(max(lobeRGB.r, max(lobeRGB.g, lobeRGB.b)), 0.0)) * sharpness;
+
+    vec3 color = (lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0);
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+
+// Accumulation pass of weighted blended OIT (McGuire & Bavoil 2013), drawn
+// with additive blending into both targets.
+in vec3 vColor;
+in vec3 vWorldPos;
+in vec3 vNormal;
+in vec2 vUV;
+in vec2 vLightmapUV;
+flat in uint vMaterial;
+in float vViewDepth;
+
+layout(location = 0) out vec4 Accum;
+// Sum of -log(1 - alpha); the composite takes exp() to get the product of
+// (1 - alpha) without needing a second blend mode.
+layout(location = 1) out float Revealage;
+
+#include "../common/room_lighting.glsl"
+
+void main() {
+    vec4 color = materialColor(vMaterial, vColor, vUV);
+    color.rgb *= lighting(vWorldPos, normalize(vNormal), indirectLight(vLightmapUV), vViewDepth);
+
+    float alpha = clamp(color.a, 0.0, 0.999);
+    // Depth weight: nearer surfaces dominate where layers overlap.
+    float z = gl_FragCoord.z;
+    float weight = clamp(pow(min(1.0, alpha * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - z * 0.9, 3.0), 1e-2, 3e3);
+
+    Accum = vec4(color.rgb * alpha, alpha) * weight;
+    Revealage = -log(1.0 - alpha);
+}
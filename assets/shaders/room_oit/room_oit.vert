@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in vec2 aUV;
+layout (location = 5) in uint aMaterial;
+layout (location = 6) in vec2 aLightmapUV;
+
+out vec3 vColor;
+out vec3 vWorldPos;
+out vec3 vNormal;
+out vec2 vUV;
+out vec2 vLightmapUV;
+out float vViewDepth;
+flat out uint vMaterial;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    vec4 world = model * vec4(aPos, 1.0);
+    vWorldPos = world.xyz;
+    vColor = aColor;
+    vNormal = mat3(model) * aNormal;
+    vUV = aUV;
+    vLightmapUV = aLightmapUV;
+    vMaterial = aMaterial;
+    vec4 viewPos = view * world;
+    vViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+flat out int vInstance;
+
+uniform mat4 model;
+
+void main() {
+    vInstance = gl_InstanceID;
+    gl_Position = model * vec4(aPos, 1.0);
+}
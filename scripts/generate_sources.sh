@@ -0,0 +1,11 @@
+#!/usr/bin/env sh
+# generate_sources.sh
+# Writes a sources.txt file listing every .cpp and .c under ./src with each path quoted.
+# Linux/macOS counterpart of generate_sources.ps1.
+
+set -e
+
+root=$(pwd)
+find "$root/src" -type f \( -name '*.cpp' -o -name '*.c' \) | sort | sed 's/.*/"&"/' > "$root/sources.txt"
+
+echo "Wrote $(wc -l < "$root/sources.txt" | tr -d ' ') entries to sources.txt"
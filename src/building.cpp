@@ -0,0 +1,579 @@
+#include "building.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glad/glad.h>
+
+#include "math/MeshProcessing/MeshProcessing.h"
+#include "utils/Jobs/Jobs.h"
+#include "utils/Profiler/Profiler.h"
+
+namespace {
+    constexpr float EPS = 1e-4f;
+
+    float distanceToBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+        return glm::length(point - glm::clamp(point, min, max));
+    }
+    // Rough per-room budget, used only to reserve room buffers.
+    constexpr size_t ROOM_VERTICES = 160;
+    constexpr size_t ROOM_INDICES = 240;
+    // Rooms per job; each is a few hundred vertices.
+    constexpr size_t ROOM_GRAIN = 8;
+
+    const glm::vec3 UP(0.0f, 1.0f, 0.0f);
+
+    const glm::vec3 colFloor(0.8f, 0.8f, 0.8f);
+    const glm::vec3 colCeiling(0.7f, 0.7f, 0.9f);
+    const glm::vec3 colNorth(0.9f, 0.7f, 0.7f);
+    const glm::vec3 colSouth(0.7f, 0.9f, 0.7f);
+    const glm::vec3 colWest(0.7f, 0.7f, 0.9f);
+    const glm::vec3 colEast(0.9f, 0.9f, 0.7f);
+    const glm::vec3 colFacade(0.85f, 0.85f, 0.85f);
+    const glm::vec3 colWhite(1.0f);
+
+    // Appends quad abcd, wound counter-clockwise as seen from the side `normal` points to.
+    void pushQuad(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        const glm::vec3& a,
+        const glm::vec3& b,
+        const glm::vec3& c,
+        const glm::vec3& d,
+        const glm::vec3& color,
+        const glm::vec3& normal,
+        uint32_t material
+    ) {
+        uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (const glm::vec3& p : {a, b, c, d}) {
+            Vertex v{p, color};
+            v.normal = normal;
+            v.material = material;
+            vertices.push_back(v);
+        }
+        if (glm::dot(glm::cross(b - a, c - a), normal) >= 0.0f) {
+            indices.insert(indices.end(), {base + 0, base + 1, base + 2, base + 0, base + 2, base + 3});
+        } else {
+            indices.insert(indices.end(), {base + 0, base + 2, base + 1, base + 0, base + 3, base + 2});
+        }
+    }
+
+    // Rectangle in wall coordinates: u along the wall, v = world y.
+    struct Rect {
+        float u0, u1, v0, v1;
+    };
+
+    // Vertical plane: point(u, v) = origin + axis * u + up * v, facing `normal`.
+    // Axis is +x or +z, so u is a world coordinate.
+    struct WallFrame {
+        glm::vec3 origin;
+        glm::vec3 axis;
+        glm::vec3 normal;
+
+        glm::vec3 at(float u, float v, float offset = 0.0f) const {
+            return origin + axis * u + UP * v + normal * offset;
+        }
+    };
+
+    bool overlaps(const Rect& a, const Rect& b) {
+        return a.u0 < b.u1 && b.u0 < a.u1 && a.v0 < b.v1 && b.v0 < a.v1;
+    }
+
+    bool contains(const Rect& outer, const Rect& inner) {
+        return inner.u0 >= outer.u0 && inner.u1 <= outer.u1 && inner.v0 >= outer.v0 && inner.v1 <= outer.v1;
+    }
+
+    void pushRect(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        const WallFrame& w,
+        const Rect& r,
+        const glm::vec3& color,
+        uint32_t material,
+        float offset = 0.0f
+    ) {
+        if (r.u1 - r.u0 <= EPS || r.v1 - r.v0 <= EPS) return;
+        pushQuad(vertices, indices,
+                 w.at(r.u0, r.v0, offset), w.at(r.u1, r.v0, offset),
+                 w.at(r.u1, r.v1, offset), w.at(r.u0, r.v1, offset),
+                 color, w.normal, material);
+    }
+
+    // `wall` minus `hole`, as up to four quads.
+    void pushWall(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        const WallFrame& w,
+        const Rect& wall,
+        const Rect* hole,
+        const glm::vec3& color,
+        uint32_t material
+    ) {
+        if (!hole) {
+            pushRect(vertices, indices, w, wall, color, material);
+            return;
+        }
+        pushRect(vertices, indices, w, {wall.u0, hole->u0, wall.v0, wall.v1}, color, material);
+        pushRect(vertices, indices, w, {hole->u1, wall.u1, wall.v0, wall.v1}, color, material);
+        pushRect(vertices, indices, w, {hole->u0, hole->u1, wall.v0, hole->v0}, color, material);
+        pushRect(vertices, indices, w, {hole->u0, hole->u1, hole->v1, wall.v1}, color, material);
+    }
+
+    // Lines an opening through a wall whose centre plane is `w`, `halfDepth` to either side.
+    void pushReveal(
+        std::vector<Vertex>& vertices,
+        std::vector<uint32_t>& indices,
+        const WallFrame& w,
+        float halfDepth,
+        const Rect& hole,
+        const glm::vec3& color,
+        uint32_t material
+    ) {
+        float h = halfDepth;
+        pushQuad(vertices, indices,
+                 w.at(hole.u0, hole.v0, -h), w.at(hole.u0, hole.v0, h),
+                 w.at(hole.u0, hole.v1, h), w.at(hole.u0, hole.v1, -h), color, w.axis, material);
+        pushQuad(vertices, indices,
+                 w.at(hole.u1, hole.v0, -h), w.at(hole.u1, hole.v0, h),
+                 w.at(hole.u1, hole.v1, h), w.at(hole.u1, hole.v1, -h), color, -w.axis, material);
+        pushQuad(vertices, indices,
+                 w.at(hole.u0, hole.v1, -h), w.at(hole.u1, hole.v1, -h),
+                 w.at(hole.u1, hole.v1, h), w.at(hole.u0, hole.v1, h), color, -UP, material);
+        pushQuad(vertices, indices,
+                 w.at(hole.u0, hole.v0, -h), w.at(hole.u1, hole.v0, -h),
+                 w.at(hole.u1, hole.v0, h), w.at(hole.u0, hole.v0, h), color, UP, material);
+    }
+
+    void pushPortal(BuildingChunkData& chunk, const WallFrame& w, const Rect& hole, uint32_t a, uint32_t b) {
+        BuildingPortal portal;
+        portal.corners[0] = w.at(hole.u0, hole.v0);
+        portal.corners[1] = w.at(hole.u1, hole.v0);
+        portal.corners[2] = w.at(hole.u1, hole.v1);
+        portal.corners[3] = w.at(hole.u0, hole.v1);
+        portal.rooms[0] = a;
+        portal.rooms[1] = b;
+        chunk.portals.push_back(portal);
+    }
+
+    void emitRoom(
+        const BuildingDesc& d,
+        uint32_t ix,
+        uint32_t iy,
+        uint32_t iz,
+        BuildingChunkData& chunk,
+        BuildingRoom& room
+    ) {
+        std::vector<Vertex>& V = chunk.vertices;
+        std::vector<uint32_t>& I = chunk.indices;
+        const BuildingMaterials& mat = d.materials;
+
+        float ht = d.wallThickness * 0.5f;
+        float cx = static_cast<float>(ix) * d.roomWidth;
+        float cz = static_cast<float>(iz) * d.roomDepth;
+        float yb = static_cast<float>(iy) * d.storyHeight;
+
+        // Grid lines run through the middle of the walls.
+        float gx0 = cx - d.roomWidth * 0.5f, gx1 = cx + d.roomWidth * 0.5f;
+        float gz0 = cz - d.roomDepth * 0.5f, gz1 = cz + d.roomDepth * 0.5f;
+
+        float x0 = gx0 + ht, x1 = gx1 - ht;
+        float z0 = gz0 + ht, z1 = gz1 - ht;
+        float y0 = yb, y1 = yb + d.storyHeight - d.wallThickness;
+
+        bool west = ix > 0;
+        bool east = ix + 1 < d.roomsX;
+        bool north = iz > 0;
+        bool south = iz + 1 < d.roomsZ;
+        bool top = iy + 1 == d.floors;
+
+        uint32_t self = Building::roomIndex(d, ix, iy, iz);
+        room.min = glm::vec3(x0, y0, z0);
+        room.max = glm::vec3(x1, y1, z1);
+        room.firstIndex = static_cast<uint32_t>(I.size());
+        room.firstGlassIndex = static_cast<uint32_t>(chunk.glassIndices.size());
+        size_t firstVertex = V.size();
+        size_t firstGlassVertex = chunk.glassVertices.size();
+
+        pushQuad(V, I, {x0, y0, z0}, {x1, y0, z0}, {x1, y0, z1}, {x0, y0, z1}, colFloor, UP, mat.floor);
+        pushQuad(V, I, {x0, y1, z0}, {x1, y1, z0}, {x1, y1, z1}, {x0, y1, z1}, colCeiling, -UP, mat.ceiling);
+        if (top) {
+            float rx0 = west ? gx0 : gx0 - ht, rx1 = east ? gx1 : gx1 + ht;
+            float rz0 = north ? gz0 : gz0 - ht, rz1 = south ? gz1 : gz1 + ht;
+            float ry = yb + d.storyHeight;
+            pushQuad(V, I, {rx0, ry, rz0}, {rx1, ry, rz0}, {rx1, ry, rz1}, {rx0, ry, rz1}, colFacade, UP, mat.roof);
+        }
+
+        struct Side {
+            // Wall frame through the grid line, facing into this room.
+            WallFrame centre;
+            Rect interior;
+            // Extent of the outside face along the wall.
+            float outerU0, outerU1;
+            bool shared;
+            // Doors are lined by the room on their -x / -z side.
+            bool ownsReveal;
+            glm::vec3 color;
+        };
+
+        Rect xSpan{x0, x1, y0, y1};
+        Rect zSpan{z0, z1, y0, y1};
+        Side sides[4] = {
+            {{{0.0f, 0.0f, gz0}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}, xSpan,
+             west ? gx0 : gx0 - ht, east ? gx1 : gx1 + ht, north, false, colNorth},
+            {{{0.0f, 0.0f, gz1}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}}, xSpan,
+             west ? gx0 : gx0 - ht, east ? gx1 : gx1 + ht, south, true, colSouth},
+            {{{gx0, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 0.0f, 0.0f}}, zSpan,
+             north ? gz0 : gz0 - ht, south ? gz1 : gz1 + ht, west, false, colWest},
+            {{{gx1, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f, 0.0f}}, zSpan,
+             north ? gz0 : gz0 - ht, south ? gz1 : gz1 + ht, east, true, colEast},
+        };
+
+        Rect holes[4];
+        bool hasHole[4] = {};
+        for (int s = 0; s < 4; ++s) {
+            const Side& side = sides[s];
+            const Rect& in = side.interior;
+            float uc = (in.u0 + in.u1) * 0.5f;
+            float length = in.u1 - in.u0;
+            float height = in.v1 - in.v0;
+
+            Rect hole;
+            if (side.shared) {
+                hole = {uc - d.doorWidth * 0.5f, uc + d.doorWidth * 0.5f, y0, std::min(y0 + d.doorHeight, y1)};
+            } else {
+                float vc = y0 + height * 0.55f;
+                hole = {uc - length * 0.175f, uc + length * 0.175f, vc - height * 0.175f, vc + height * 0.175f};
+            }
+            hole.u0 = std::max(hole.u0, in.u0 + EPS);
+            hole.u1 = std::min(hole.u1, in.u1 - EPS);
+            hole.v1 = std::min(hole.v1, in.v1 - EPS);
+            hasHole[s] = (side.shared || d.windows) && hole.u1 > hole.u0 + EPS && hole.v1 > hole.v0 + EPS;
+            holes[s] = hole;
+
+            WallFrame inner = side.centre;
+            inner.origin += inner.normal * ht;
+            pushWall(V, I, inner, in, hasHole[s] ? &holes[s] : nullptr, side.color, mat.wall);
+
+            if (side.shared) {
+                if (hasHole[s] && side.ownsReveal) {
+                    pushReveal(V, I, side.centre, ht, hole, side.color, mat.wall);
+                    uint32_t other = s == 1 ? Building::roomIndex(d, ix, iy, iz + 1) : Building::roomIndex(d, ix + 1, iy, iz);
+                    pushPortal(chunk, side.centre, hole, self, other);
+                }
+                continue;
+            }
+
+            WallFrame outer = side.centre;
+            outer.origin -= outer.normal * ht;
+            outer.normal = -outer.normal;
+            Rect outside{side.outerU0, side.outerU1, yb, yb + d.storyHeight};
+            pushWall(V, I, outer, outside, hasHole[s] ? &holes[s] : nullptr, colFacade, mat.facade);
+
+            if (hasHole[s]) {
+                pushReveal(V, I, side.centre, ht, hole, colFacade, mat.facade);
+                pushRect(chunk.glassVertices, chunk.glassIndices, side.centre, hole, colWhite, mat.glass);
+                pushPortal(chunk, side.centre, hole, self, PortalGraph::OUTSIDE);
+            }
+        }
+
+        MeshProcessing::generatePlanarUVs(std::span<Vertex>(V).subspan(firstVertex));
+        MeshProcessing::generatePlanarUVs(std::span<Vertex>(chunk.glassVertices).subspan(firstGlassVertex));
+
+        if (d.paintings && !mat.paintings.empty()) {
+            const glm::vec2 quadUVs[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+            auto painting = [&](uint32_t slot) {
+                return mat.paintings[(self * 2 + slot) % mat.paintings.size()];
+            };
+            auto hang = [&](int s, const Rect& frame, uint32_t material) {
+                if (!contains(sides[s].interior, frame)) return;
+                if (hasHole[s] && overlaps(frame, holes[s])) return;
+
+                WallFrame inner = sides[s].centre;
+                inner.origin += inner.normal * ht;
+                size_t base = V.size();
+                pushRect(V, I, inner, frame, colWhite, material, 0.01f);
+                for (size_t i = base; i < V.size(); ++i) V[i].uv = quadUVs[i - base];
+            };
+
+            float h = y1 - y0;
+            float u1 = cx - d.roomWidth * 0.25f;
+            float v1 = y0 + h * 0.6f;
+            hang(0, {u1 - 0.6f, u1 + 0.6f, v1 - 0.45f, v1 + 0.45f}, painting(0));
+
+            float u2 = cz + d.roomDepth * 0.25f;
+            float v2 = y0 + h * 0.55f;
+            hang(3, {u2 - 0.5f, u2 + 0.5f, v2 - 0.35f, v2 + 0.35f}, painting(1));
+        }
+
+        room.indexCount = static_cast<uint32_t>(I.size()) - room.firstIndex;
+        room.glassIndexCount = static_cast<uint32_t>(chunk.glassIndices.size()) - room.firstGlassIndex;
+    }
+
+    // Appends a room emitted on its own to `chunk`, rebasing its
+    // indices and the ranges `room` records.
+    void appendRoom(BuildingChunkData& chunk, const BuildingChunkData& geometry, BuildingRoom& room) {
+        auto append = [](std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                         const std::vector<Vertex>& srcVertices, const std::vector<uint32_t>& srcIndices) {
+            uint32_t base = static_cast<uint32_t>(vertices.size());
+            vertices.insert(vertices.end(), srcVertices.begin(), srcVertices.end());
+            for (uint32_t index : srcIndices) indices.push_back(base + index);
+        };
+        room.firstIndex += static_cast<uint32_t>(chunk.indices.size());
+        room.firstGlassIndex += static_cast<uint32_t>(chunk.glassIndices.size());
+        append(chunk.vertices, chunk.indices, geometry.vertices, geometry.indices);
+        append(chunk.glassVertices, chunk.glassIndices, geometry.glassVertices, geometry.glassIndices);
+        chunk.portals.insert(chunk.portals.end(), geometry.portals.begin(), geometry.portals.end());
+    }
+}
+
+size_t BuildingData::triangleCount() const {
+    size_t indices = 0;
+    for (const auto& chunk : chunks) indices += chunk.indices.size() + chunk.glassIndices.size();
+    return indices / 3;
+}
+
+BuildingData Building::generate(const BuildingDesc& desc) {
+    PROFILE_SCOPE("Building::generate");
+    BuildingData data;
+    data.desc = desc;
+    if (desc.roomsX == 0 || desc.roomsZ == 0 || desc.floors == 0) return data;
+
+    uint32_t chunksX = (desc.roomsX + CHUNK_ROOMS - 1) / CHUNK_ROOMS;
+    uint32_t chunksZ = (desc.roomsZ + CHUNK_ROOMS - 1) / CHUNK_ROOMS;
+    data.rooms.resize(static_cast<size_t>(desc.roomsX) * desc.roomsZ * desc.floors);
+    data.chunks.resize(static_cast<size_t>(chunksX) * chunksZ * desc.floors);
+
+    // Rooms are independent, so each is emitted into its own buffers, and the
+    // chunks then concatenate them in grid order. No tangents: the room
+    // shaders have no normal maps to use them.
+    std::vector<BuildingChunkData> roomGeometry(data.rooms.size());
+    Jobs::parallelFor(data.rooms.size(), ROOM_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            uint32_t x = static_cast<uint32_t>(r % desc.roomsX);
+            uint32_t z = static_cast<uint32_t>((r / desc.roomsX) % desc.roomsZ);
+            uint32_t floor = static_cast<uint32_t>(r / (static_cast<size_t>(desc.roomsX) * desc.roomsZ));
+            BuildingChunkData& geometry = roomGeometry[r];
+            geometry.vertices.reserve(ROOM_VERTICES);
+            geometry.indices.reserve(ROOM_INDICES);
+            emitRoom(desc, x, floor, z, geometry, data.rooms[r]);
+        }
+    });
+
+    Jobs::parallelFor(data.chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            BuildingChunkData& chunk = data.chunks[c];
+            uint32_t cx = static_cast<uint32_t>(c % chunksX);
+            uint32_t cz = static_cast<uint32_t>((c / chunksX) % chunksZ);
+            uint32_t floor = static_cast<uint32_t>(c / (static_cast<size_t>(chunksX) * chunksZ));
+
+            uint32_t xEnd = std::min(desc.roomsX, (cx + 1) * CHUNK_ROOMS);
+            uint32_t zEnd = std::min(desc.roomsZ, (cz + 1) * CHUNK_ROOMS);
+            size_t vertexCount = 0, indexCount = 0, glassVertexCount = 0, glassIndexCount = 0;
+            for (uint32_t z = cz * CHUNK_ROOMS; z < zEnd; ++z) {
+                for (uint32_t x = cx * CHUNK_ROOMS; x < xEnd; ++x) {
+                    const BuildingChunkData& geometry = roomGeometry[roomIndex(desc, x, floor, z)];
+                    vertexCount += geometry.vertices.size();
+                    indexCount += geometry.indices.size();
+                    glassVertexCount += geometry.glassVertices.size();
+                    glassIndexCount += geometry.glassIndices.size();
+                }
+            }
+            chunk.vertices.reserve(vertexCount);
+            chunk.indices.reserve(indexCount);
+            chunk.glassVertices.reserve(glassVertexCount);
+            chunk.glassIndices.reserve(glassIndexCount);
+
+            for (uint32_t z = cz * CHUNK_ROOMS; z < zEnd; ++z) {
+                for (uint32_t x = cx * CHUNK_ROOMS; x < xEnd; ++x) {
+                    uint32_t r = roomIndex(desc, x, floor, z);
+                    BuildingRoom& room = data.rooms[r];
+                    room.chunk = static_cast<uint32_t>(c);
+                    chunk.rooms.push_back(r);
+                    appendRoom(chunk, roomGeometry[r], room);
+                    roomGeometry[r] = BuildingChunkData();
+                }
+            }
+
+            chunk.min = glm::vec3(std::numeric_limits<float>::max());
+            chunk.max = glm::vec3(-std::numeric_limits<float>::max());
+            for (const Vertex& v : chunk.vertices) {
+                chunk.min = glm::min(chunk.min, v.position);
+                chunk.max = glm::max(chunk.max, v.position);
+            }
+        }
+    });
+
+    // Packed after the parallel part so the layout does not depend on it.
+    if (desc.lightmapTexelsPerUnit > 0.0f) {
+        std::vector<LightmapMesh> meshes;
+        meshes.reserve(data.chunks.size() * 2);
+        for (BuildingChunkData& chunk : data.chunks) {
+            meshes.push_back({&chunk.vertices, &chunk.indices});
+            // Glass is lit by the lightmap too, in the OIT pass.
+            meshes.push_back({&chunk.glassVertices, &chunk.glassIndices});
+        }
+        LightmapPackOptions options;
+        options.texelsPerUnit = desc.lightmapTexelsPerUnit;
+        data.lightmap = LightmapPacker::pack(meshes, options);
+    }
+
+    return data;
+}
+
+Building::Building(const BuildingData& data)
+    : m_desc(data.desc), m_rooms(data.rooms), m_lightmap(data.lightmap) {
+    PROFILE_SCOPE("Building::Building");
+    m_chunks.reserve(data.chunks.size());
+    for (const auto& src : data.chunks) {
+        Chunk chunk;
+        chunk.mesh = std::make_unique<Mesh>(src.vertices, src.indices);
+        if (!src.glassIndices.empty()) {
+            chunk.glass = std::make_unique<Mesh>(src.glassVertices, src.glassIndices);
+        }
+        chunk.min = src.min;
+        chunk.max = src.max;
+        m_chunkBounds.add(src.min, src.max);
+        m_chunks.push_back(std::move(chunk));
+    }
+
+    // Cells reach into the walls so doorways belong to the rooms on both sides.
+    glm::vec3 reach(m_desc.wallThickness * 0.5f + EPS, 0.0f, m_desc.wallThickness * 0.5f + EPS);
+    for (const BuildingRoom& room : m_rooms) {
+        m_graph.addCell(room.min - reach, room.max + reach);
+    }
+    for (const auto& src : data.chunks) {
+        for (const BuildingPortal& portal : src.portals) {
+            m_graph.addPortal(portal.corners, portal.rooms[0], portal.rooms[1]);
+        }
+    }
+}
+
+uint32_t Building::findRoom(const glm::vec3& point) const {
+    if (m_rooms.empty()) return PortalGraph::OUTSIDE;
+
+    // Rooms sit on a regular grid, so only the nearest one can contain the point.
+    long x = std::lround(point.x / m_desc.roomWidth);
+    long z = std::lround(point.z / m_desc.roomDepth);
+    long y = static_cast<long>(std::floor(point.y / m_desc.storyHeight));
+    if (x < 0 || z < 0 || y < 0 ||
+        x >= static_cast<long>(m_desc.roomsX) ||
+        z >= static_cast<long>(m_desc.roomsZ) ||
+        y >= static_cast<long>(m_desc.floors)) {
+        return PortalGraph::OUTSIDE;
+    }
+
+    uint32_t index = roomIndex(m_desc, static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z));
+    const BuildingRoom& room = m_rooms[index];
+    float reach = m_desc.wallThickness * 0.5f + EPS;
+    bool inside = point.x >= room.min.x - reach && point.x <= room.max.x + reach &&
+                  point.z >= room.min.z - reach && point.z <= room.max.z + reach &&
+                  point.y >= room.min.y && point.y <= room.max.y;
+    return inside ? index : PortalGraph::OUTSIDE;
+}
+
+void Building::submit(
+    RenderQueue& queue,
+    Shader& shader,
+    const MaterialTable& materials,
+    const glm::mat4& viewProjection,
+    const glm::vec3& eye,
+    const glm::ivec4& viewport
+) const {
+    PROFILE_SCOPE("Building::submit");
+    m_drawnChunks = 0;
+    m_drawnRooms = 0;
+    m_submittedTriangles = 0;
+
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.materials = &materials;
+
+    uint32_t start = findRoom(eye);
+    if (start == PortalGraph::OUTSIDE) {
+        submitChunks(queue, packet, Frustum::fromMatrix(viewProjection), eye);
+    } else {
+        submitRooms(queue, packet, start, viewProjection, eye, viewport);
+    }
+}
+
+void Building::drawShadowCasters(std::span<const Frustum> views) const {
+    for (const Chunk& chunk : m_chunks) {
+        bool inside = false;
+        for (const Frustum& view : views) {
+            if (view.intersectsAABB(chunk.min, chunk.max)) {
+                inside = true;
+                break;
+            }
+        }
+        if (inside) chunk.mesh->drawInstanced(static_cast<GLsizei>(views.size()));
+    }
+}
+
+void Building::submitChunks(RenderQueue& queue, DrawPacket packet, const Frustum& frustum, const glm::vec3& eye) const {
+    m_chunkBounds.cull(frustum, m_visible);
+    m_drawnChunks = m_visible.size();
+
+    for (uint32_t i : m_visible) {
+        const Chunk& chunk = m_chunks[i];
+        packet.depth = distanceToBox(eye, chunk.min, chunk.max);
+
+        packet.pass = RenderPass::Opaque;
+        packet.mesh = chunk.mesh.get();
+        queue.submit(packet);
+        m_submittedTriangles += static_cast<size_t>(chunk.mesh->indexCount()) / 3;
+
+        if (chunk.glass) {
+            packet.pass = RenderPass::Transparent;
+            packet.mesh = chunk.glass.get();
+            queue.submit(packet);
+            m_submittedTriangles += static_cast<size_t>(chunk.glass->indexCount()) / 3;
+        }
+    }
+}
+
+void Building::submitRooms(
+    RenderQueue& queue,
+    DrawPacket packet,
+    uint32_t start,
+    const glm::mat4& viewProjection,
+    const glm::vec3& eye,
+    const glm::ivec4& viewport
+) const {
+    m_graph.traverse(viewProjection, eye, start, m_visibleRooms, m_traversal);
+    m_drawnRooms = m_visibleRooms.size();
+
+    auto scissor = [&](const glm::vec4& rect) {
+        auto toPixels = [](float ndc, int origin, int size) {
+            return origin + static_cast<int>((ndc * 0.5f + 0.5f) * static_cast<float>(size));
+        };
+        int x0 = toPixels(rect.x, viewport.x, viewport.z);
+        int y0 = toPixels(rect.y, viewport.y, viewport.w);
+        int x1 = toPixels(rect.z, viewport.x, viewport.z) + 1;
+        int y1 = toPixels(rect.w, viewport.y, viewport.w) + 1;
+        return glm::ivec4(x0, y0, x1 - x0, y1 - y0);
+    };
+
+    for (const auto& visible : m_visibleRooms) {
+        const BuildingRoom& room = m_rooms[visible.cell];
+        const Chunk& chunk = m_chunks[room.chunk];
+        packet.depth = distanceToBox(eye, room.min, room.max);
+        packet.scissor = scissor(visible.rect);
+
+        packet.pass = RenderPass::Opaque;
+        packet.mesh = chunk.mesh.get();
+        packet.firstIndex = static_cast<GLsizei>(room.firstIndex);
+        packet.indexCount = static_cast<GLsizei>(room.indexCount);
+        queue.submit(packet);
+        m_submittedTriangles += room.indexCount / 3;
+
+        if (room.glassIndexCount > 0) {
+            packet.pass = RenderPass::Transparent;
+            packet.mesh = chunk.glass.get();
+            packet.firstIndex = static_cast<GLsizei>(room.firstGlassIndex);
+            packet.indexCount = static_cast<GLsizei>(room.glassIndexCount);
+            queue.submit(packet);
+            m_submittedTriangles += room.glassIndexCount / 3;
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/CullingSet/CullingSet.h"
+#include "math/Frustum/Frustum.h"
+#include "math/LightmapPacker/LightmapPacker.h"
+#include "math/Mesh/Mesh.h"
+#include "math/PortalGraph/PortalGraph.h"
+#include "math/Vertex.h"
+#include "utils/RenderQueue/RenderQueue.h"
+#include "utils/MaterialTable/MaterialTable.h"
+#include "utils/Shader/Shader.h"
+
+// MaterialTable indices for each kind of surface.
+struct BuildingMaterials {
+    uint32_t floor = 0;
+    uint32_t ceiling = 1;
+    uint32_t wall = 2;
+    uint32_t facade = 3;
+    uint32_t roof = 4;
+    uint32_t glass = 5;
+    // Each room hangs two of these, cycling through the list.
+    std::vector<uint32_t> paintings = {6, 7};
+};
+
+// Floor plan of a grid building: roomsX x roomsZ rooms on each of `floors` stories.
+// Room (x, z) on story y is centred at (x * roomWidth, y * storyHeight, z * roomDepth).
+// Neighbouring rooms share a wall with a door in it; outside walls get a window.
+struct BuildingDesc {
+    uint32_t roomsX = 1;
+    uint32_t roomsZ = 1;
+    uint32_t floors = 1;
+
+    // Wall centre to wall centre, and floor to floor.
+    float roomWidth = 10.0f;
+    float roomDepth = 10.0f;
+    float storyHeight = 3.0f;
+    // Walls and the slabs between stories.
+    float wallThickness = 0.2f;
+
+    float doorWidth = 1.0f;
+    float doorHeight = 2.1f;
+    bool windows = true;
+    bool paintings = true;
+
+    // Lightmap texels per metre for the walls and glass; 0 leaves lightmap UVs unset.
+    float lightmapTexelsPerUnit = 0.0f;
+
+    BuildingMaterials materials;
+};
+
+struct BuildingRoom {
+    uint32_t chunk = 0;
+    // Ranges of the chunk's opaque and glass index buffers.
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t firstGlassIndex = 0;
+    uint32_t glassIndexCount = 0;
+    // Interior (floor to ceiling, wall face to wall face).
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+// Door or window opening on the centre plane of its wall.
+struct BuildingPortal {
+    glm::vec3 corners[4];
+    // rooms[1] is PortalGraph::OUTSIDE for windows.
+    uint32_t rooms[2];
+};
+
+// Merged geometry of up to CHUNK_ROOMS x CHUNK_ROOMS rooms on one story.
+struct BuildingChunkData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Vertex> glassVertices;
+    std::vector<uint32_t> glassIndices;
+    std::vector<uint32_t> rooms;
+    std::vector<BuildingPortal> portals;
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+struct BuildingData {
+    BuildingDesc desc;
+    // Indexed by Building::roomIndex().
+    std::vector<BuildingRoom> rooms;
+    std::vector<BuildingChunkData> chunks;
+    // One atlas over every chunk's opaque geometry, if desc asked for it.
+    LightmapAtlas lightmap;
+
+    size_t triangleCount() const;
+};
+
+class Building {
+public:
+    static constexpr uint32_t CHUNK_ROOMS = 4;
+
+    // CPU only. Rooms are generated in parallel, then concatenated into chunks,
+    // also in parallel.
+    static BuildingData generate(const BuildingDesc& desc);
+
+    static uint32_t roomIndex(const BuildingDesc& desc, uint32_t x, uint32_t floor, uint32_t z) {
+        return (floor * desc.roomsZ + z) * desc.roomsX + x;
+    }
+
+    explicit Building(const BuildingData& data);
+
+    Building(const Building&) = delete;
+    Building& operator=(const Building&) = delete;
+
+    // From inside, submits the rooms visible through doors from the eye's room,
+    // each scissored to the screen rectangle it is seen through. From outside,
+    // submits every chunk intersecting the frustum. Glass goes to the
+    // transparent pass. `viewport` (x, y, width, height) is the target the
+    // queue will draw into; scissor rects are computed against it.
+    void submit(
+        RenderQueue& queue,
+        Shader& shader,
+        const MaterialTable& materials,
+        const glm::mat4& viewProjection,
+        const glm::vec3& eye,
+        const glm::ivec4& viewport
+    ) const;
+
+    // Opaque geometry of every chunk inside any of `views`, drawn once with
+    // one instance per view, for a depth-only pass whose shader is bound.
+    void drawShadowCasters(std::span<const Frustum> views) const;
+
+    // Room containing `point` (doorways count for both sides), or PortalGraph::OUTSIDE.
+    uint32_t findRoom(const glm::vec3& point) const;
+    const PortalGraph& portals() const { return m_graph; }
+
+    const BuildingDesc& desc() const { return m_desc; }
+    size_t roomCount() const { return m_rooms.size(); }
+    size_t chunkCount() const { return m_chunks.size(); }
+    const BuildingRoom& room(size_t i) const { return m_rooms[i]; }
+    const LightmapAtlas& lightmap() const { return m_lightmap; }
+
+    // Stats of the last submit call.
+    size_t drawnChunks() const { return m_drawnChunks; }
+    size_t drawnRooms() const { return m_drawnRooms; }
+    size_t submittedTriangles() const { return m_submittedTriangles; }
+
+private:
+    struct Chunk {
+        std::unique_ptr<Mesh> mesh;
+        std::unique_ptr<Mesh> glass;
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    void submitChunks(RenderQueue& queue, DrawPacket packet, const Frustum& frustum, const glm::vec3& eye) const;
+    void submitRooms(
+        RenderQueue& queue,
+        DrawPacket packet,
+        uint32_t start,
+        const glm::mat4& viewProjection,
+        const glm::vec3& eye,
+        const glm::ivec4& viewport
+    ) const;
+
+    BuildingDesc m_desc;
+    std::vector<BuildingRoom> m_rooms;
+    std::vector<Chunk> m_chunks;
+    LightmapAtlas m_lightmap;
+    CullingSet m_chunkBounds;
+    PortalGraph m_graph;
+
+    mutable std::vector<uint32_t> m_visible;
+    mutable std::vector<PortalGraph::VisibleCell> m_visibleRooms;
+    mutable PortalGraph::Scratch m_traversal;
+    mutable size_t m_drawnChunks = 0;
+    mutable size_t m_drawnRooms = 0;
+    mutable size_t m_submittedTriangles = 0;
+};
@@ -1,4 +1,17 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <glad/glad.h> // ! Keep this import above glfw3 import
 #include <GLFW/glfw3.h>
@@ -7,12 +20,36 @@
 #include "utils/Time/Time.h"
 #include "utils/Texture/Texture.h"
 #include "utils/Camera/Camera.h"
+#include "utils/ClusteredLights/ClusteredLights.h"
+#include "utils/DynamicResolution/DynamicResolution.h"
+#include "utils/FrameCapture/FrameCapture.h"
+#include "utils/FrameLoop/FrameLoop.h"
+#include "utils/GpuProfiler/GpuProfiler.h"
+#include "utils/HeadlessContext/HeadlessContext.h"
 
+#include "math/Bvh/Bvh.h"
+#include "math/CullingSet/CullingSet.h"
+#include "math/DynamicMesh/DynamicMesh.h"
+#include "math/Frustum/Frustum.h"
 #include "math/Mesh/Mesh.h"
 #include "math/Primitives/Primitives.h"
 #include "utils/Skybox/Skybox.h"
+#include "utils/MaterialTable/MaterialTable.h"
+#include "utils/Model/Model.h"
+#include "utils/Jobs/Jobs.h"
+#include "utils/LightmapBaker/LightmapBaker.h"
+#include "utils/ModelImporter/ModelImporter.h"
+#include "utils/Profiler/Profiler.h"
+#include "utils/RenderFarm/RenderFarm.h"
+#include "utils/RenderGraph/RenderGraph.h"
+#include "utils/RenderQueue/RenderQueue.h"
+#include "utils/RenderThread/RenderThread.h"
+#include "utils/RenderThread/TripleBuffer.h"
+#include "utils/Scene/Scene.h"
+#include "utils/ShadowMaps/ShadowMaps.h"
+#include "utils/WeightedOIT/WeightedOIT.h"
 
-#include "room.h"
+#include "building.h"
 
 // TODO: create a better mouse input handling system
 void mouseCallback(GLFWwindow* window, double xPos, double yPos) {
@@ -51,37 +88,768 @@ void checkKeyboardEvents(GLFWwindow* window, float cameraSpeed, float deltaTime)
     camera->processKeyboard(CameraMovement::Down, deltaTime, cameraSpeed);
 }
 
-static void framebuffer_size_callback(GLFWwindow* window, int w, int h) {
-    glViewport(0, 0, w, h);
+const glm::vec3 SUN_DIRECTION(-0.45f, -0.75f, -0.35f);
+const glm::vec3 SUN_COLOR(1.6f, 1.5f, 1.35f);
+// Escaped bake paths see this; roughly the skybox's midday average.
+const glm::vec3 SKY_COLOR(0.55f, 0.65f, 0.8f);
+// Bake and runtime must agree, or the atlas will not match the file.
+const float LIGHTMAP_TEXELS_PER_UNIT = 4.0f;
+// After ShadowMaps' units.
+const int LIGHTMAP_TEXTURE_UNIT = 9;
+// Collision sphere around the eye; well under half a doorway.
+const float CAMERA_RADIUS = 0.25f;
+// Frames kept for --gpu-trace, about ten seconds at 60 Hz.
+const size_t GPU_TRACE_FRAMES = 600;
+
+static std::vector<MaterialDesc> roomMaterials() {
+  return {
+    {"floor", TEXTURES_DIR + std::string("/granite-tile/diffuse.jpg"), glm::vec4(1.0f), 0.5f},
+    {"ceiling", TEXTURES_DIR + std::string("/wood-shutter/diffuse.jpg"), glm::vec4(1.0f), 0.5f},
+    {"wall", TEXTURES_DIR + std::string("/painted-plaster/diffuse.jpg"), glm::vec4(1.0f), 0.5f},
+    {"facade", TEXTURES_DIR + std::string("/painted-plaster/diffuse.jpg"), glm::vec4(1.0f), 0.25f},
+    {"roof", TEXTURES_DIR + std::string("/blue-metal-plate/diffuse.jpg"), glm::vec4(1.0f), 0.25f},
+    {"glass", "", glm::vec4(0.6f, 0.8f, 1.0f, 0.3f)},
+    {"monalisa", ASSETS_DIR + "/images/monalisa.png", glm::vec4(1.0f), 1.0f, false},
+    {"van-gogh", ASSETS_DIR + "/images/van-gogh.png", glm::vec4(1.0f), 1.0f, false},
+  };
+}
+
+// Material indices by name, matching a MaterialTable built from `descs`.
+static void assignBuildingMaterials(const std::vector<MaterialDesc>& descs, BuildingMaterials& out) {
+  auto find = [&](const std::string& name) {
+    for (size_t i = 0; i < descs.size(); ++i) {
+      if (descs[i].name == name) return static_cast<uint32_t>(i);
+    }
+    return 0u;
+  };
+  out.floor = find("floor");
+  out.ceiling = find("ceiling");
+  out.wall = find("wall");
+  out.facade = find("facade");
+  out.roof = find("roof");
+  out.glass = find("glass");
+  out.paintings = {find("monalisa"), find("van-gogh")};
+}
+
+static double generateBuildingTimed(const BuildingDesc& desc, BuildingData& out) {
+  auto start = std::chrono::steady_clock::now();
+  out = Building::generate(desc);
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
-int main(void) {
-  GLFWwindow* window;
+// Three corners per triangle of every chunk, opaque then glass, for Bvh::build.
+static std::vector<glm::vec3> buildingCorners(const BuildingData& data) {
+  std::vector<glm::vec3> corners;
+  corners.reserve(data.triangleCount() * 3);
+  for (const BuildingChunkData& chunk : data.chunks) {
+    for (uint32_t i : chunk.indices) corners.push_back(chunk.vertices[i].position);
+    for (uint32_t i : chunk.glassIndices) corners.push_back(chunk.glassVertices[i].position);
+  }
+  return corners;
+}
 
-  /* Initialize the library */
-  if (!glfwInit()) {
-    std::cerr << "Failed to initialize GLFW\n";
-    return -1;
+// Scene entities with bounds and their world boxes, as Bvh::buildBoxes takes them.
+static void sceneBoxes(
+  const Scene& scene,
+  std::vector<Scene::Entity>& entities,
+  std::vector<glm::vec3>& mins,
+  std::vector<glm::vec3>& maxs
+) {
+  entities.clear();
+  mins.clear();
+  maxs.clear();
+  for (Scene::Entity entity = 0; entity < scene.size(); ++entity) {
+    if (!scene.hasBounds(entity)) continue;
+    entities.push_back(entity);
+    mins.push_back(scene.worldMin(entity));
+    maxs.push_back(scene.worldMax(entity));
   }
+}
 
-  const int SCR_W = 1280;
-  const int SCR_H = 720;
-  const float SCR_ASPECT = (float)SCR_W / (float)SCR_H;
+// Prints what the ray through the screen centre hits first: a scene entity or
+// the building (with the room it belongs to).
+static void pickCenter(
+  const Camera& camera,
+  const Bvh& world,
+  const Bvh& entityBvh,
+  const std::vector<Scene::Entity>& entities,
+  const Building& building
+) {
+  Ray ray;
+  ray.origin = camera.position();
+  ray.direction = camera.front();
+  ray.tMin = camera.nearPlane();
+
+  auto start = std::chrono::steady_clock::now();
+  RayHit worldHit, entityHit;
+  bool hitWorld = world.intersect(ray, worldHit);
+  if (hitWorld) ray.tMax = worldHit.t;
+  bool hitEntity = entityBvh.intersect(ray, entityHit);
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  if (hitEntity) {
+    std::cout << "Picked entity " << entities[entityHit.primitive] << " at " << entityHit.t << " m";
+  } else if (hitWorld) {
+    // Step back towards the eye so a hit on a wall face resolves to the viewer's side.
+    glm::vec3 point = ray.origin + ray.direction * std::max(ray.tMin, worldHit.t - 0.01f);
+    uint32_t room = building.findRoom(point);
+    std::cout << "Picked triangle " << worldHit.primitive << " at " << worldHit.t << " m, ";
+    if (room == PortalGraph::OUTSIDE) std::cout << "outside";
+    else std::cout << "room " << room;
+  } else {
+    std::cout << "Picked nothing";
+  }
+  std::cout << " (" << us << " us)\n";
+}
+
+// Everything the render thread needs of a frame. The main thread fills one
+// in and publishes it; after that it is read-only.
+struct FrameSnapshot {
+  Camera camera{glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 45.0f, 1.0f};
+  int width = 0;
+  int height = 0;
+  // World matrices of the visible entities showing the loaded model.
+  std::vector<glm::mat4> models;
+  // The model entity, a dynamic shadow caster wherever it is visible.
+  bool hasCaster = false;
+  glm::mat4 casterWorld = glm::mat4(1.0f);
+  glm::vec3 casterMin = glm::vec3(0.0f);
+  glm::vec3 casterMax = glm::vec3(0.0f);
+  // Line list of the bounds overlay; empty while it is off.
+  std::vector<Vertex> boundsLines;
+};
+
+struct ModelDrawContext {
+  const Model* model;
+  Shader* shader;
+  const FrameSnapshot* frame;
+};
+
+// Queue callback for a scene entity showing the loaded model; packet.arg indexes frame->models.
+static void drawModelPacket(const DrawPacket& packet) {
+  const auto* context = static_cast<const ModelDrawContext*>(packet.user);
+  const glm::mat4& world = context->frame->models[packet.arg];
+  const Camera* camera = &context->frame->camera;
+  context->shader->bind();
+  context->shader->setMat4("model", world);
+  context->model->drawCulled(*context->shader, world, camera->frustum(), camera->position());
+}
+
+struct LineDrawContext {
+  const DynamicMesh* lines;
+  Shader* shader;
+};
+
+// Queue callback for the streamed bounds overlay.
+static void drawLinesPacket(const DrawPacket& packet) {
+  const auto* context = static_cast<const LineDrawContext*>(packet.user);
+  context->shader->bind();
+  context->lines->draw();
+}
+
+// The 12 edges of a box, as line-list vertices.
+static void pushBoxLines(std::vector<Vertex>& lines, const glm::vec3& min, const glm::vec3& max, const glm::vec3& color) {
+  auto corner = [&](int i) {
+    return glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+  };
+  for (int i = 0; i < 8; ++i) {
+    for (int axis = 1; axis < 8; axis <<= 1) {
+      if (i & axis) continue;
+      Vertex a{}, b{};
+      a.position = corner(i);
+      b.position = corner(i | axis);
+      a.color = b.color = color;
+      lines.push_back(a);
+      lines.push_back(b);
+    }
+  }
+}
+
+struct CameraKey {
+  glm::vec3 eye;
+  glm::vec3 target;
+};
+
+// One key per line, "eyeX eyeY eyeZ targetX targetY targetZ". Blank lines and
+// lines starting with # are skipped.
+static bool loadCameraPath(const std::string& path, std::vector<CameraKey>& keys) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open camera path: " << path << "\n";
+    return false;
+  }
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    ++lineNumber;
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') continue;
+    std::istringstream in(line);
+    CameraKey key;
+    if (!(in >> key.eye.x >> key.eye.y >> key.eye.z >> key.target.x >> key.target.y >> key.target.z)) {
+      std::cerr << path << ":" << lineNumber << ": expected \"eyeX eyeY eyeZ targetX targetY targetZ\"\n";
+      return false;
+    }
+    keys.push_back(key);
+  }
+  if (keys.empty()) {
+    std::cerr << "Camera path has no keys: " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+// Frame `frame` of `frames`, spread evenly along the path and moving
+// linearly between keys.
+static CameraKey cameraPathPose(const std::vector<CameraKey>& keys, uint32_t frame, uint32_t frames) {
+  if (keys.size() == 1 || frames <= 1) return keys.front();
+  float t = static_cast<float>(frame) * static_cast<float>(keys.size() - 1) / static_cast<float>(frames - 1);
+  size_t i = std::min(static_cast<size_t>(t), keys.size() - 2);
+  float f = t - static_cast<float>(i);
+  return {glm::mix(keys[i].eye, keys[i + 1].eye, f), glm::mix(keys[i].target, keys[i + 1].target, f)};
+}
+
+// Ceiling lamps on a perSide x perSide grid in every room, alternating
+// between point lights and downward spots.
+static void placeRoomLamps(const std::vector<BuildingRoom>& rooms, ClusteredLights& lights, uint32_t perSide) {
+  const glm::vec3 warm(1.0f, 0.85f, 0.65f);
+  for (const BuildingRoom& room : rooms) {
+    glm::vec3 size = room.max - room.min;
+    float cell = std::max(size.x, size.z) / static_cast<float>(perSide);
+    for (uint32_t z = 0; z < perSide; ++z) {
+      for (uint32_t x = 0; x < perSide; ++x) {
+        Light light;
+        light.position = glm::vec3(
+          room.min.x + size.x * (x + 0.5f) / perSide,
+          room.max.y - 0.2f,
+          room.min.z + size.z * (z + 0.5f) / perSide
+        );
+        light.color = warm;
+        if ((x + z) % 2 == 0) {
+          light.range = std::max(cell * 0.75f, size.y * 1.5f);
+          light.intensity = 12.0f;
+        } else {
+          light.type = LightType::Spot;
+          light.range = size.y * 2.0f;
+          light.intensity = 16.0f;
+          light.castsShadows = true;
+        }
+        lights.add(light);
+      }
+    }
+  }
+}
+
+// CPU-only: times Building::generate over a range of sizes and exits.
+static int benchmarkBuilding() {
+  const uint32_t sizes[][3] = {
+    {10, 10, 1},
+    {32, 32, 1},
+    {50, 50, 4},
+    {100, 100, 1},
+  };
+  const int runs = 3;
+
+  std::cout << "Building generation (" << Jobs::threadCount() << " threads, best of " << runs << ")\n";
+  for (const auto& size : sizes) {
+    BuildingDesc desc;
+    desc.roomsX = size[0];
+    desc.roomsZ = size[1];
+    desc.floors = size[2];
+
+    double best = 0.0;
+    BuildingData data;
+    for (int run = 0; run < runs; ++run) {
+      double ms = generateBuildingTimed(desc, data);
+      if (run == 0 || ms < best) best = ms;
+    }
+    std::cout << "  " << size[0] << "x" << size[1] << "x" << size[2]
+              << ": " << data.rooms.size() << " rooms, "
+              << data.triangleCount() << " triangles, "
+              << data.chunks.size() << " chunks, "
+              << best << " ms\n";
+  }
+  return 0;
+}
+
+// CPU-only: times CullingSet::cull over a million random boxes and exits.
+static int benchmarkCulling() {
+  const size_t objectCount = 1000000;
+  const int runs = 10;
+
+  CullingSet set;
+  set.reserve(objectCount);
+  uint32_t seed = 1;
+  auto random = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+  };
+  for (size_t i = 0; i < objectCount; ++i) {
+    glm::vec3 center(random() * 2000.0f - 1000.0f, random() * 200.0f - 100.0f, random() * 2000.0f - 1000.0f);
+    glm::vec3 extent(0.5f + random() * 4.0f);
+    set.add(center - extent, center + extent);
+  }
+
+  Camera camera(glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(1.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 60.0f, 16.0f / 9.0f);
+  const Frustum& frustum = camera.frustum();
+
+  struct Variant {
+    const char* name;
+    CullOptions options;
+  };
+  const Variant variants[] = {
+    {"scalar", {false, false}},
+    {CullingSet::simdPath(), {true, false}},
+    {"scalar parallel", {false, true}},
+    {"simd parallel", {true, true}},
+  };
+
+  std::cout << "Culling " << objectCount << " objects (" << Jobs::threadCount()
+            << " threads, SIMD path " << CullingSet::simdPath() << ", best of " << runs << ")\n";
+  std::vector<uint32_t> visible;
+  for (const auto& variant : variants) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      set.cull(frustum, visible, variant.options);
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < best) best = ms;
+    }
+    std::cout << "  " << variant.name << ": " << visible.size() << " visible, " << best << " ms\n";
+  }
+  return 0;
+}
+
+// CPU-only: times Scene::update over a million entities (roots with children) and exits.
+static int benchmarkScene() {
+  const size_t rootCount = 100000;
+  const size_t childrenPerRoot = 9;
+  const int runs = 5;
+
+  Scene scene;
+  std::vector<Scene::Entity> roots;
+  roots.reserve(rootCount);
+  for (size_t i = 0; i < rootCount; ++i) {
+    Scene::Entity root = scene.create();
+    scene.setPosition(root, glm::vec3(static_cast<float>(i % 1000), 0.0f, static_cast<float>(i / 1000)));
+    for (size_t c = 0; c < childrenPerRoot; ++c) {
+      Scene::Entity child = scene.create(root);
+      scene.setPosition(child, glm::vec3(0.0f, static_cast<float>(c), 0.0f));
+      scene.setBounds(child, glm::vec3(-0.5f), glm::vec3(0.5f));
+    }
+    roots.push_back(root);
+  }
+
+  auto timeUpdate = [&](size_t moveEvery) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+      if (moveEvery) {
+        for (size_t i = 0; i < roots.size(); i += moveEvery) {
+          scene.setRotation(roots[i], glm::angleAxis(static_cast<float>(run), glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+      }
+      auto start = std::chrono::steady_clock::now();
+      scene.update();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+  };
+
+  std::cout << "Scene update, " << scene.size() << " entities (" << Jobs::threadCount() << " threads, best of " << runs << ")\n";
+  double all = timeUpdate(1);
+  std::cout << "  all moving: " << scene.updatedCount() << " updated, " << all << " ms\n";
+  double some = timeUpdate(100);
+  std::cout << "  1% moving: " << scene.updatedCount() << " updated, " << some << " ms\n";
+  double none = timeUpdate(0);
+  std::cout << "  static: " << scene.updatedCount() << " updated, " << none << " ms\n";
+  return 0;
+}
+
+// CPU-only: times radixSort against std::sort over a million draw keys and exits.
+static int benchmarkRenderQueue() {
+  const size_t packetCount = 1000000;
+  const int runs = 5;
+
+  std::vector<SortItem> source(packetCount);
+  uint32_t seed = 1;
+  auto random = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+  };
+  for (size_t i = 0; i < packetCount; ++i) {
+    RenderPass pass = random() % 8 == 0 ? RenderPass::Transparent : RenderPass::Opaque;
+    float depth = static_cast<float>(random() % 100000) * 0.01f;
+    source[i] = {RenderQueue::makeKey(pass, depth, random() % 8, random() % 32, random() % 1024), static_cast<uint32_t>(i)};
+  }
+
+  std::vector<SortItem> items, scratch;
+  auto time = [&](auto&& sort) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+      items = source;
+      auto start = std::chrono::steady_clock::now();
+      sort();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+  };
+
+  std::cout << "Sorting " << packetCount << " draw keys (" << Jobs::threadCount() << " threads, best of " << runs << ")\n";
+  std::cout << "  radix: " << time([&] { radixSort(items, scratch); }) << " ms\n";
+  std::cout << "  std::sort: " << time([&] {
+    std::sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+  }) << " ms\n";
+  return 0;
+}
+
+// CPU-only: times ClusteredLights binning over a lamp-filled building and exits.
+static int benchmarkLights() {
+  BuildingDesc desc;
+  desc.roomsX = 32;
+  desc.roomsZ = 32;
+  desc.floors = 2;
+  const uint32_t lampsPerSide = 2;
+  const int width = 1920;
+  const int height = 1080;
+  const int runs = 10;
+
+  BuildingData data = Building::generate(desc);
+  ClusteredLights lights;
+  placeRoomLamps(data.rooms, lights, lampsPerSide);
+
+  struct View {
+    const char* name;
+    glm::vec3 eye;
+    glm::vec3 target;
+  };
+  const View views[] = {
+    {"inside", glm::vec3(5.0f, 1.7f, 5.0f), glm::vec3(150.0f, 1.7f, 150.0f)},
+    {"above", glm::vec3(-40.0f, 60.0f, -40.0f), glm::vec3(160.0f, 0.0f, 160.0f)},
+  };
+
+  std::cout << "Clustered light binning, " << lights.size() << " lights, "
+            << ClusteredLights::CLUSTER_COUNT << " clusters (" << Jobs::threadCount()
+            << " threads, best of " << runs << ")\n";
+  for (const View& view : views) {
+    Camera camera(view.eye, view.target, glm::vec3(0.0f, 1.0f, 0.0f), 60.0f, static_cast<float>(width) / height);
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      lights.update(camera, width, height, false);
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < best) best = ms;
+    }
+    const ClusteredLights::Stats& stats = lights.stats();
+    std::cout << "  " << view.name << ": " << stats.visibleLights << " visible";
+    if (stats.droppedLights > 0) std::cout << " (" << stats.droppedLights << " dropped)";
+    std::cout << ", " << stats.indices << " cluster entries (max " << stats.maxClusterLights << " per cluster), "
+              << best << " ms\n";
+  }
+  return 0;
+}
+
+// CPU-only: times Bvh builds, ray queries, refit and sphere collision over a
+// building of about a million triangles and exits.
+static int benchmarkBvh() {
+  BuildingDesc desc;
+  desc.roomsX = 100;
+  desc.roomsZ = 100;
+  desc.floors = 2;
+  const size_t rayCount = 100000;
+  const int runs = 3;
+
+  BuildingData data = Building::generate(desc);
+  std::vector<glm::vec3> corners = buildingCorners(data);
+  data = {};
+
+  uint32_t seed = 1;
+  auto random = [&]() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+  };
+  Bvh probe;
+  probe.build(corners);
+  glm::vec3 lo = probe.boundsMin(), extent = probe.boundsMax() - lo;
+  std::vector<Ray> rays(rayCount);
+  std::vector<glm::vec3> spheres(rayCount);
+  for (size_t i = 0; i < rayCount; ++i) {
+    rays[i].origin = lo + extent * glm::vec3(random(), random(), random());
+    rays[i].direction = glm::normalize(glm::vec3(random(), random(), random()) * 2.0f - 1.0f);
+    spheres[i] = lo + extent * glm::vec3(random(), random(), random());
+  }
+  // Coherent packets: 8 rays fanning out from one eye, as for picking a small area.
+  std::vector<Ray> packets(rayCount);
+  for (size_t i = 0; i < rayCount; ++i) {
+    const Ray& eye = rays[i - i % Bvh::PACKET_SIZE];
+    packets[i].origin = eye.origin;
+    packets[i].direction = glm::normalize(eye.direction + glm::vec3(random(), random(), random()) * 0.02f);
+  }
+
+  auto time = [&](auto&& fn) {
+    double best = 0.0;
+    for (int run = 0; run < runs; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      fn();
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+  };
+  auto perQuery = [&](double ms) { return ms * 1000.0 / rayCount; };
 
-  window = glfwCreateWindow(SCR_W, SCR_H, "Room", NULL, NULL);
-  if (!window) {
-    glfwTerminate();
-    std::cerr << "Failed to Create Window\n";
-    return -1;
+  std::cout << "BVH over " << corners.size() / 3 << " triangles, " << rayCount << " queries ("
+            << Jobs::threadCount() << " threads, best of " << runs << ")\n";
+  for (uint32_t width : {4u, 8u}) {
+    Bvh bvh;
+    double serial = time([&] { bvh.build(corners, {width, false}); });
+    double parallel = time([&] { bvh.build(corners, {width, true}); });
+    double refit = time([&] { bvh.refit(corners); });
+
+    size_t hits = 0;
+    RayHit hit;
+    double nearest = time([&] {
+      hits = 0;
+      for (const Ray& ray : rays) hits += bvh.intersect(ray, hit);
+    });
+    double any = time([&] {
+      for (const Ray& ray : rays) bvh.occluded(ray);
+    });
+    std::vector<RayHit> packetHits(rayCount);
+    double single = time([&] {
+      for (size_t i = 0; i < rayCount; ++i) bvh.intersect(packets[i], packetHits[i]);
+    });
+    double packet = time([&] { bvh.intersect(packets, packetHits); });
+    size_t pushed = 0;
+    double collide = time([&] {
+      pushed = 0;
+      for (glm::vec3 p : spheres) pushed += bvh.collideSphere(p, CAMERA_RADIUS);
+    });
+
+    std::cout << "  width " << width << " (" << Bvh::simdPath(width) << "): " << bvh.nodeCount() << " nodes\n"
+              << "    build " << serial << " ms serial, " << parallel << " ms parallel, refit " << refit << " ms\n"
+              << "    nearest hit " << perQuery(nearest) << " us (" << hits << " hits), any hit " << perQuery(any) << " us\n"
+              << "    coherent rays " << perQuery(single) << " us single, " << perQuery(packet) << " us in packets of "
+              << Bvh::PACKET_SIZE << "\n"
+              << "    sphere collision " << perQuery(collide) << " us (" << pushed << " pushed)\n";
+  }
+  return 0;
+}
+
+// CPU-only: path traces the building's indirect light into a lightmap at
+// `path` (Radiance .hdr) and exits. Runs without a GPU; load the result with
+// --lightmap and the same --building and --lamps arguments.
+static int bakeLightmap(BuildingDesc desc, uint32_t lampsPerSide, const std::string& modelPath, const std::string& path) {
+  std::vector<MaterialDesc> materialDescs = roomMaterials();
+  assignBuildingMaterials(materialDescs, desc.materials);
+  desc.lightmapTexelsPerUnit = LIGHTMAP_TEXELS_PER_UNIT;
+  BuildingData data = Building::generate(desc);
+
+  std::vector<glm::vec3> albedo;
+  for (const MaterialDesc& material : materialDescs) {
+    glm::vec3 color(material.color);
+    if (!material.texturePath.empty()) color *= Texture::averageColor(material.texturePath);
+    albedo.push_back(color);
+  }
+
+  LightmapBaker baker;
+  for (const BuildingChunkData& chunk : data.chunks) {
+    baker.addMesh(chunk.vertices, chunk.indices, albedo, LightmapBaker::Role::Receiver);
+    baker.addMesh(chunk.glassVertices, chunk.glassIndices, albedo, LightmapBaker::Role::Transparent);
+  }
+
+  // The imported model sits at the origin; it blocks and bounces light.
+  ModelData model;
+  if (!modelPath.empty() && ModelImporter::load(modelPath, model)) {
+    for (const MeshData& mesh : model.meshes) {
+      glm::vec3 color(1.0f);
+      if (mesh.material >= 0) color = glm::vec3(model.materials[static_cast<size_t>(mesh.material)].baseColor);
+      baker.addMesh(mesh.vertices, mesh.indices, std::span<const glm::vec3>(&color, 1), LightmapBaker::Role::Occluder);
+    }
+  }
+
+  ClusteredLights lamps;
+  placeRoomLamps(data.rooms, lamps, lampsPerSide);
+  std::vector<Light> lights;
+  for (uint32_t i = 0; i < lamps.size(); ++i) lights.push_back(lamps.light(i));
+  baker.setLights(lights);
+  baker.setSun(SUN_DIRECTION, SUN_COLOR);
+  baker.setSky(SKY_COLOR);
+
+  const LightmapAtlas& atlas = data.lightmap;
+  std::cout << "Baking " << atlas.width << "x" << atlas.height << " lightmap (" << atlas.charts << " charts, "
+            << lights.size() << " lights, " << Jobs::threadCount() << " threads)\n";
+  LightmapBakeOptions options;
+  std::vector<glm::vec3> texels;
+  baker.bake(atlas.width, atlas.height, options, texels, [](int pass, int passes) {
+    std::cout << "  pass " << pass << "/" << passes << "\n";
+  });
+
+  const LightmapBaker::Stats& stats = baker.stats();
+  std::cout << "  " << stats.texels << " texels, " << stats.triangles << " triangles, "
+            << stats.paths << " paths in " << stats.traceMs << " ms, denoised in "
+            << stats.denoiseMs << " ms\n";
+  if (!LightmapBaker::save(path, atlas.width, atlas.height, texels)) return 1;
+  std::cout << "Wrote " << path << "\n";
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string modelPath;
+  BuildingDesc buildingDesc;
+  // Ceiling lamps per room along each side.
+  uint32_t lampsPerSide = 1;
+  std::string bakePath;
+  std::string lightmapPath;
+  // Keep the camera out of walls, floors and glass.
+  bool collide = true;
+  DynamicResolutionOptions resolutionOptions;
+  // > 0 pins the render scale instead of following GPU time.
+  float fixedScale = 0.0f;
+  // Chrome trace of the last GPU_TRACE_FRAMES frames, written on exit.
+  std::string gpuTracePath;
+  // CPU zones from startup to exit.
+  std::string cpuTracePath;
+  FrameLoopOptions frameOptions;
+  // > 0 renders offscreen at this size, with no window.
+  int headlessWidth = 0;
+  int headlessHeight = 0;
+  // Headless frames to render; by default one per camera path key.
+  uint32_t headlessFrames = 0;
+  std::string cameraPathFile;
+  // Headless frames are saved here as numbered PNGs.
+  std::string outputDir;
+  // > 0 splits the headless frames across this many worker processes.
+  int farmWorkers = 0;
+  // A farm worker that reports no frame for this long is restarted.
+  double farmTimeoutSeconds = RenderFarmOptions{}.frameTimeoutSeconds;
+  // Set in a farm worker: its socket to the coordinator.
+  int farmWorkerFd = -1;
+  // Finished textures are cached here for the next run; see TextureCache.
+  std::string assetCacheDir;
+  // Outlines the eye's room and the visible entities; B toggles it.
+  bool showBounds = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--model" && i + 1 < argc) modelPath = argv[++i];
+    else if (arg == "--building" && i + 3 < argc) {
+      buildingDesc.roomsX = static_cast<uint32_t>(std::atoi(argv[++i]));
+      buildingDesc.roomsZ = static_cast<uint32_t>(std::atoi(argv[++i]));
+      buildingDesc.floors = static_cast<uint32_t>(std::atoi(argv[++i]));
+    }
+    else if (arg == "--bench-building") return benchmarkBuilding();
+    else if (arg == "--bench-culling") return benchmarkCulling();
+    else if (arg == "--bench-scene") return benchmarkScene();
+    else if (arg == "--lamps" && i + 1 < argc) lampsPerSide = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+    else if (arg == "--bench-queue") return benchmarkRenderQueue();
+    else if (arg == "--bench-lights") return benchmarkLights();
+    else if (arg == "--bake-lightmap" && i + 1 < argc) bakePath = argv[++i];
+    else if (arg == "--lightmap" && i + 1 < argc) lightmapPath = argv[++i];
+    else if (arg == "--bench-bvh") return benchmarkBvh();
+    else if (arg == "--noclip") collide = false;
+    else if (arg == "--gpu-budget" && i + 1 < argc) resolutionOptions.targetMs = static_cast<float>(std::atof(argv[++i]));
+    else if (arg == "--resolution-scale" && i + 1 < argc) fixedScale = static_cast<float>(std::atof(argv[++i]));
+    else if (arg == "--gpu-trace" && i + 1 < argc) gpuTracePath = argv[++i];
+    else if (arg == "--cpu-trace" && i + 1 < argc) cpuTracePath = argv[++i];
+    else if (arg == "--tick-rate" && i + 1 < argc) frameOptions.tickRate = std::atof(argv[++i]);
+    else if (arg == "--fixed-frame" && i + 1 < argc) frameOptions.fixedFrameSeconds = std::atof(argv[++i]) * 1e-3;
+    else if (arg == "--headless" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%dx%d", &headlessWidth, &headlessHeight) != 2 || headlessWidth <= 0 || headlessHeight <= 0) {
+        std::cerr << "--headless expects WIDTHxHEIGHT, e.g. 1920x1080\n";
+        return 1;
+      }
+    }
+    else if (arg == "--frames" && i + 1 < argc) headlessFrames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+    else if (arg == "--camera-path" && i + 1 < argc) cameraPathFile = argv[++i];
+    else if (arg == "--output" && i + 1 < argc) outputDir = argv[++i];
+    else if (arg == "--farm" && i + 1 < argc) farmWorkers = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--farm-timeout" && i + 1 < argc) farmTimeoutSeconds = std::max(1.0, std::atof(argv[++i]));
+    else if (arg == "--farm-worker" && i + 1 < argc) farmWorkerFd = std::atoi(argv[++i]);
+    else if (arg == "--asset-cache" && i + 1 < argc) assetCacheDir = argv[++i];
+    else if (arg == "--show-bounds") showBounds = true;
+  }
+  PROFILE_THREAD("main");
+  if (!cpuTracePath.empty()) Profiler::start();
+  if (!bakePath.empty()) return bakeLightmap(buildingDesc, lampsPerSide, modelPath, bakePath);
+
+  const bool headless = headlessWidth > 0;
+  std::vector<CameraKey> cameraPath;
+  if (!cameraPathFile.empty() && !loadCameraPath(cameraPathFile, cameraPath)) return 1;
+  if (headlessFrames == 0) headlessFrames = cameraPath.empty() ? 1 : static_cast<uint32_t>(cameraPath.size());
+  if (!outputDir.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(outputDir, error);
+    if (error) {
+      std::cerr << "Failed to create output directory: " << outputDir << "\n";
+      return 1;
+    }
+  }
+
+  if (farmWorkers > 0) {
+    if (!headless) {
+      std::cerr << "--farm needs --headless WIDTHxHEIGHT\n";
+      return 1;
+    }
+    // Workers get everything else; traces from several processes would
+    // overwrite each other.
+    std::vector<std::string> workerArgs;
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if ((arg == "--farm" || arg == "--farm-timeout" || arg == "--cpu-trace" || arg == "--gpu-trace") && i + 1 < argc) {
+        ++i;
+        continue;
+      }
+      workerArgs.push_back(arg);
+    }
+    if (assetCacheDir.empty()) {
+      workerArgs.push_back("--asset-cache");
+      workerArgs.push_back(ASSETS_DIR + "/cache");
+    }
+    RenderFarmOptions farmOptions;
+    farmOptions.workers = farmWorkers;
+    farmOptions.frames = headlessFrames;
+    farmOptions.frameTimeoutSeconds = farmTimeoutSeconds;
+    farmOptions.outputDir = outputDir;
+    return RenderFarm::coordinate(argv[0], workerArgs, farmOptions);
   }
 
-  /* Make the window's context current */
-  glfwMakeContextCurrent(window);
-  glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+  GLFWwindow* window = nullptr;
+  // Outlives every GL object below, so they are deleted with it still current.
+  std::unique_ptr<HeadlessContext> headlessContext;
+
+  const int SCR_W = headless ? headlessWidth : 1280;
+  const int SCR_H = headless ? headlessHeight : 720;
+  const float SCR_ASPECT = (float)SCR_W / (float)SCR_H;
+
+  if (headless) {
+    headlessContext = std::make_unique<HeadlessContext>();
+    if (!headlessContext->valid()) return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+      std::cerr << "Failed to initialize GLAD\n";
+      return -1;
+    }
+  } else {
+    /* Initialize the library */
+    if (!glfwInit()) {
+      std::cerr << "Failed to initialize GLFW\n";
+      return -1;
+    }
+
+    window = glfwCreateWindow(SCR_W, SCR_H, "Room", NULL, NULL);
+    if (!window) {
+      glfwTerminate();
+      std::cerr << "Failed to Create Window\n";
+      return -1;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(window);
 
-  if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-    std::cerr << "Failed to initialize GLAD\n";
-    return -1;
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      std::cerr << "Failed to initialize GLAD\n";
+      return -1;
+    }
   }
 
   std::cout << "Using OpenGL Driver: " << glGetString(GL_VERSION) << std::endl;
@@ -89,6 +857,7 @@ int main(void) {
   glEnable(GL_DEPTH_TEST);
 
   const int cubemapSize = 1024;
+  if (!assetCacheDir.empty()) Texture::setCacheDirectory(assetCacheDir);
 
   Camera camera(
     glm::vec3(0.0f, 2.0f, 4.0f),
@@ -97,9 +866,11 @@ int main(void) {
     45.0f,
     SCR_ASPECT
   );
-  glfwSetCursorPosCallback(window, mouseCallback);
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-  glfwSetWindowUserPointer(window, &camera);
+  if (window) {
+    glfwSetCursorPosCallback(window, mouseCallback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    glfwSetWindowUserPointer(window, &camera);
+  }
 
   auto skyboxCube = Primitives::Cube(1.0f);
   Skybox skybox(
@@ -110,65 +881,493 @@ int main(void) {
     SCR_H
   );
 
-  auto roomWidth = 10.f;
-  auto roomHeight = 3.f;
-  auto roomDepth = 10.f;
-
-  Room room(
-    roomWidth,
-    roomHeight,
-    roomDepth,
-    TEXTURES_DIR + std::string("/painted-plaster/diffuse.jpg"),
-    TEXTURES_DIR + std::string("/wood-shutter/diffuse.jpg"),
-    TEXTURES_DIR + std::string("/granite-tile/diffuse.jpg"),
-    true
-  );
+  std::vector<MaterialDesc> materialDescs = roomMaterials();
+  MaterialTable materials(materialDescs);
+  assignBuildingMaterials(materialDescs, buildingDesc.materials);
+  if (!lightmapPath.empty()) buildingDesc.lightmapTexelsPerUnit = LIGHTMAP_TEXELS_PER_UNIT;
+
+  BuildingData buildingData;
+  double buildingMs = generateBuildingTimed(buildingDesc, buildingData);
+  Building building(buildingData);
+  std::cout << "Building: " << building.roomCount() << " rooms, "
+            << buildingData.triangleCount() << " triangles in "
+            << building.chunkCount() << " chunks, generated in " << buildingMs << " ms\n";
+  // What the last submit drew out of the whole building: rooms seen through
+  // doors from inside, chunks in the frustum from outside.
+  auto drawnBuilding = [&building]() {
+    std::string text = building.drawnRooms() > 0
+      ? std::to_string(building.drawnRooms()) + "/" + std::to_string(building.roomCount()) + " rooms"
+      : std::to_string(building.drawnChunks()) + "/" + std::to_string(building.chunkCount()) + " chunks";
+    return text + ", " + std::to_string(building.submittedTriangles()) + " triangles";
+  };
+
+  ClusteredLights lights;
+  lights.setAmbient(glm::vec3(0.25f));
+  lights.setSun(SUN_DIRECTION, SUN_COLOR);
+  placeRoomLamps(buildingData.rooms, lights, lampsPerSide);
+  std::cout << "Lights: " << lights.size() << "\n";
+
+  // For camera collision and picking; the GPU copies are all the renderer needs.
+  auto bvhStart = std::chrono::steady_clock::now();
+  Bvh worldBvh;
+  {
+    PROFILE_SCOPE("world BVH");
+    worldBvh.build(buildingCorners(buildingData), {8});
+  }
+  std::cout << "Building BVH: " << worldBvh.nodeCount() << " nodes in "
+            << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bvhStart).count() << " ms\n";
+  buildingData = {};
+
+  ShadowMaps shadows;
+  shadows.setStaticCasters([&building](Shader&, std::span<const Frustum> views) {
+    building.drawShadowCasters(views);
+  });
+
+  GLuint lightmapTex = 0;
+  if (!lightmapPath.empty()) {
+    int lightmapW = 0, lightmapH = 0;
+    lightmapTex = Texture::loadLightmap(lightmapPath, &lightmapW, &lightmapH);
+    if (lightmapTex && (lightmapW != building.lightmap().width || lightmapH != building.lightmap().height)) {
+      std::cerr << "Lightmap " << lightmapPath << " is " << lightmapW << "x" << lightmapH
+                << ", the building's atlas is " << building.lightmap().width << "x" << building.lightmap().height
+                << "; bake it with the same --building arguments\n";
+      glDeleteTextures(1, &lightmapTex);
+      lightmapTex = 0;
+    }
+  }
 
   Shader roomShader("room");
-  roomShader.bind();
-  roomShader.setMat4("model", glm::mat4(1.0f));
-  roomShader.setFloat("uTile", 0.5f);
-  roomShader.setVec3("uRoomCenter", glm::vec3(0.0f, roomHeight * 0.5f, 0.0f));
-  roomShader.setVec3("uHalfSize", glm::vec3(
-    roomWidth * 0.5f,
-    roomHeight * 0.5f,
-    roomDepth * 0.5f
-  ));
-
-  /* Loop until the user closes the window */
-  while (!glfwWindowShouldClose(window)) {
-    Time::update();
-
-    int width, height;
-    glfwGetFramebufferSize(window, &width, &height);
-    glViewport(0, 0, width, height);
-    camera.setAspect((float)width / (float)height);
+  Shader roomOitShader("room_oit");
+  for (Shader* shader : {&roomShader, &roomOitShader}) {
+    shader->bind();
+    shader->setMat4("model", glm::mat4(1.0f));
+    // Always on its own unit: a sampler2D sharing unit 0 with the material array is an error.
+    shader->setInt("lightmap", LIGHTMAP_TEXTURE_UNIT);
+    shader->setInt("lightmapEnabled", lightmapTex != 0);
+  }
+  if (lightmapTex) {
+    glActiveTexture(GL_TEXTURE0 + LIGHTMAP_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, lightmapTex);
+    glActiveTexture(GL_TEXTURE0);
+  }
+  Shader lineShader("debug_lines");
+  // Rewritten every frame, so it streams through DynamicMesh's ring.
+  DynamicMesh boundsLines(256, 0, GL_LINES);
+  WeightedOIT oit;
+  DynamicResolution resolution(resolutionOptions);
+  // Batch frames should not depend on how fast the machine drew the ones
+  // before them, so headless runs stay at full resolution unless told otherwise.
+  if (headless && fixedScale <= 0.0f) fixedScale = 1.0f;
+  if (fixedScale > 0.0f) resolution.setFixedScale(fixedScale);
+  GpuProfiler gpuProfiler;
+  if (!gpuTracePath.empty()) gpuProfiler.setTraceFrames(GPU_TRACE_FRAMES);
+  // The render scale, what the building and render queue drew and per-pass
+  // GPU times go in the window title, refreshed a few times a second.
+  // The render thread writes them; only the main thread may set the title.
+  int64_t titleNs = 0;
+  std::mutex titleMutex;
+  std::string gpuTitle;
+  std::atomic<bool> titleChanged{false};
 
-    /* Render here */
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // Headless frames render into this in place of a window's backbuffer.
+  GLuint headlessTarget = 0;
+  if (headless) {
+    glGenTextures(1, &headlessTarget);
+    glBindTexture(GL_TEXTURE_2D, headlessTarget);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_W, SCR_H, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  TripleBuffer<FrameSnapshot> snapshots;
+  // The snapshot being drawn, for callbacks the render thread runs.
+  const FrameSnapshot* renderFrame = nullptr;
+
+  // Renderable handles of scene entities.
+  const uint32_t RENDER_MODEL = 0;
+
+  RenderQueue renderQueue;
+  RenderGraph frameGraph;
+
+  Scene scene;
+  std::vector<Scene::Entity> visibleEntities;
+
+  std::unique_ptr<Model> model;
+  Scene::Entity modelEntity = Scene::NONE;
+  std::unique_ptr<Shader> modelShader;
+  if (!modelPath.empty()) {
+    model = Model::load(modelPath);
+    if (model) {
+      modelShader = std::make_unique<Shader>("model");
+      Scene::Entity entity = scene.create();
+      scene.setBounds(entity, model->boundsMin(), model->boundsMax());
+      scene.setRenderable(entity, RENDER_MODEL);
+      modelEntity = entity;
+      // Scene entities may move, so they are redrawn over the cached building shadows.
+      shadows.setDynamicCasters([&renderFrame, &model](Shader& depthShader, std::span<const Frustum> views) {
+        depthShader.setMat4("model", renderFrame->casterWorld);
+        model->drawDepth(static_cast<GLsizei>(views.size()));
+      });
+    }
+  }
+
+  // Entity boxes for picking, refitted as entities move.
+  Bvh entityBvh;
+  std::vector<Scene::Entity> pickEntities;
+  std::vector<glm::vec3> entityMins, entityMaxs;
+  scene.update();
+  sceneBoxes(scene, pickEntities, entityMins, entityMaxs);
+  entityBvh.buildBoxes(entityMins, entityMaxs);
+  bool pickHeld = false;
+  bool boundsHeld = false;
+
+  // Camera movement is simulated at the fixed tick rate; frames render the
+  // eye blended between the last two ticks. Mouse look stays per frame.
+  const float cameraSpeed = 3.0f;
+  FrameLoop frameLoop(frameOptions);
+  glm::vec3 previousEye = camera.position();
+  glm::vec3 currentEye = camera.position();
+
+  // Draws the newest published snapshot on whichever thread owns the context.
+  auto drawFrame = [&]() -> bool {
+    if (!snapshots.acquire()) return false;
+    const FrameSnapshot& frame = snapshots.front();
+    renderFrame = &frame;
+    // Shadows main's camera, which the main thread keeps moving meanwhile.
+    const Camera& camera = frame.camera;
+    int width = frame.width;
+    int height = frame.height;
+    if (width <= 0 || height <= 0) return false;
+
+    glViewport(0, 0, width, height);
+    // The scene renders at this size; the aspect stays the window's.
+    glm::ivec2 renderSize = resolution.renderSize(width, height);
+    resolution.beginFrame();
+    gpuProfiler.beginFrame();
 
     // if (shader.reloadIfChanged()) {
     //   std::cout << "Shader reloaded OK\n";
     // }
 
-    skybox.draw(camera);
+    renderQueue.clear();
+
+    if (frame.hasCaster) shadows.setDynamicBounds(frame.casterMin, frame.casterMax);
+    {
+      PROFILE_SCOPE("shadows");
+      GpuProfiler::Scope scope(gpuProfiler, "shadows");
+      shadows.update(camera, lights);
+    }
+    glViewport(0, 0, renderSize.x, renderSize.y);
 
     roomShader.bind();
     roomShader.setMat4("view", camera.getViewMatrix());
     roomShader.setMat4("projection", camera.getProjectionMatrix());
+    roomOitShader.bind();
+    roomOitShader.setMat4("view", camera.getViewMatrix());
+    roomOitShader.setMat4("projection", camera.getProjectionMatrix());
+    {
+      PROFILE_SCOPE("light binning");
+      lights.update(camera, renderSize.x, renderSize.y);
+    }
+    for (Shader* shader : {&roomShader, &roomOitShader}) {
+      lights.bind(*shader);
+      shadows.bind(*shader);
+    }
+
+    building.submit(
+      renderQueue,
+      roomShader,
+      materials,
+      camera.getViewProjectionMatrix(),
+      camera.position(),
+      glm::ivec4(0, 0, renderSize.x, renderSize.y)
+    );
+
+    if (model) {
+      modelShader->bind();
+      modelShader->setMat4("view", camera.getViewMatrix());
+      modelShader->setMat4("projection", camera.getProjectionMatrix());
+    }
+    ModelDrawContext modelContext{model.get(), modelShader.get(), &frame};
+    for (size_t i = 0; i < frame.models.size() && model; ++i) {
+      DrawPacket packet;
+      packet.depth = glm::length(glm::vec3(frame.models[i][3]) - camera.position());
+      packet.shader = modelShader.get();
+      packet.callback = drawModelPacket;
+      packet.user = &modelContext;
+      packet.arg = static_cast<uint32_t>(i);
+      renderQueue.submit(packet);
+    }
+
+    boundsLines.beginFrame();
+    LineDrawContext linesContext{&boundsLines, &lineShader};
+    if (!frame.boundsLines.empty()) {
+      boundsLines.update(frame.boundsLines);
+      lineShader.bind();
+      lineShader.setMat4("view", camera.getViewMatrix());
+      lineShader.setMat4("projection", camera.getProjectionMatrix());
+      DrawPacket packet;
+      packet.shader = &lineShader;
+      packet.callback = drawLinesPacket;
+      packet.user = &linesContext;
+      renderQueue.submit(packet);
+    }
+
+    skybox.submit(renderQueue, camera);
 
-    room.draw(roomShader);
+    {
+      PROFILE_SCOPE("queue sort");
+      renderQueue.sort();
+    }
 
-    float cameraSpeed = 3.0f;
-    checkKeyboardEvents(window, cameraSpeed, Time::deltaTime);
+    /* Render here */
+    frameGraph.reset();
+    RenderResource backbuffer = headlessTarget
+      ? frameGraph.importTexture("headless-target", headlessTarget, {width, height, GL_RGBA8})
+      : frameGraph.importBackbuffer(width, height);
+    RenderResource sceneColor = RenderGraph::INVALID;
+    RenderResource sceneDepth = RenderGraph::INVALID;
+    frameGraph.addPass(
+      "opaque",
+      [&](RenderGraph::Builder& builder) {
+        sceneColor = builder.create("scene-color", {renderSize.x, renderSize.y, GL_RGBA8});
+        sceneDepth = builder.create("scene-depth", {renderSize.x, renderSize.y, GL_DEPTH_COMPONENT24});
+      },
+      [&renderQueue, &gpuProfiler](const RenderGraph::Context&) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        {
+          GpuProfiler::Scope scope(gpuProfiler, "geometry");
+          renderQueue.execute(RenderPass::Opaque, RenderPass::Opaque);
+        }
+        GpuProfiler::Scope scope(gpuProfiler, "skybox");
+        renderQueue.execute(RenderPass::Sky, RenderPass::Sky);
+      }
+    );
+    if (resolution.upscaling(width, height)) {
+      RenderResource resolved = frameGraph.createTexture("scene-resolved", {renderSize.x, renderSize.y, GL_RGBA8});
+      oit.addPasses(frameGraph, renderQueue, roomOitShader, sceneColor, sceneDepth, resolved);
+      resolution.addPasses(frameGraph, resolved, backbuffer);
+    } else {
+      oit.addPasses(frameGraph, renderQueue, roomOitShader, sceneColor, sceneDepth, backbuffer);
+    }
+    {
+      PROFILE_SCOPE("render graph");
+      frameGraph.compile();
+      frameGraph.execute(&gpuProfiler);
+    }
+    gpuProfiler.endFrame();
+    resolution.endFrame();
+
+    if (Time::now() - titleNs > 250'000'000 || resolution.changed()) {
+      titleNs = Time::now();
+      std::lock_guard<std::mutex> lock(titleMutex);
+      const RenderQueue::Stats& queueStats = renderQueue.stats();
+      gpuTitle = "Room | render scale " + std::to_string(std::lround(resolution.scale() * 100.0f)) + "% | " +
+                 drawnBuilding() + " | " + std::to_string(queueStats.drawCalls) + " draws, " +
+                 std::to_string(queueStats.programChanges + queueStats.materialChanges) + " state changes | GPU " +
+                 gpuProfiler.summary();
+      titleChanged = true;
+    }
+    return true;
+  };
+
+  // Fills in and publishes the next snapshot from the camera and the scene.
+  auto publishFrame = [&](int width, int height) {
+    FrameSnapshot& frame = snapshots.back();
+    frame.camera = camera;
+    frame.width = width;
+    frame.height = height;
+    {
+      PROFILE_SCOPE("scene cull");
+      scene.cull(camera.frustum(), visibleEntities);
+    }
+    frame.models.clear();
+    for (Scene::Entity entity : visibleEntities) {
+      if (scene.renderable(entity) == RENDER_MODEL && model) frame.models.push_back(scene.world(entity));
+    }
+    frame.hasCaster = modelEntity != Scene::NONE;
+    if (frame.hasCaster) {
+      frame.casterWorld = scene.world(modelEntity);
+      frame.casterMin = scene.worldMin(modelEntity);
+      frame.casterMax = scene.worldMax(modelEntity);
+    }
+    frame.boundsLines.clear();
+    if (showBounds) {
+      uint32_t room = building.findRoom(camera.position());
+      if (room != PortalGraph::OUTSIDE) {
+        // Pulled in off the walls so the lines do not z-fight with them.
+        const glm::vec3 inset(0.02f);
+        const BuildingRoom& bounds = building.room(room);
+        pushBoxLines(frame.boundsLines, bounds.min + inset, bounds.max - inset, glm::vec3(0.2f, 0.9f, 1.0f));
+      }
+      for (Scene::Entity entity : visibleEntities) {
+        if (scene.hasBounds(entity)) {
+          pushBoxLines(frame.boundsLines, scene.worldMin(entity), scene.worldMax(entity), glm::vec3(1.0f, 0.85f, 0.1f));
+        }
+      }
+    }
+    snapshots.publish();
+  };
+
+  if (headless) {
+    // Everything runs on this thread, which has the context; there is no
+    // window to poll.
+    std::unique_ptr<FarmWorker> farmWorker;
+    if (farmWorkerFd >= 0) farmWorker = std::make_unique<FarmWorker>(farmWorkerFd);
+    FrameCaptureOptions captureOptions;
+    if (farmWorker) {
+      captureOptions.written = [&farmWorker](uint32_t index, bool ok) { farmWorker->done(index, ok); };
+    }
+    std::unique_ptr<FrameCapture> capture;
+    if (!outputDir.empty()) capture = std::make_unique<FrameCapture>(SCR_W, SCR_H, outputDir, captureOptions);
+
+    auto renderHeadlessFrame = [&](uint32_t i) {
+      PROFILE_SCOPE("frame");
+      if (!cameraPath.empty()) {
+        CameraKey pose = cameraPathPose(cameraPath, i, headlessFrames);
+        camera = Camera(pose.eye, pose.target, glm::vec3(0.0f, 1.0f, 0.0f), 45.0f, SCR_ASPECT);
+      }
+      {
+        PROFILE_SCOPE("scene update");
+        scene.update();
+      }
+      publishFrame(SCR_W, SCR_H);
+      drawFrame();
+      if (capture) {
+        capture->capture(headlessTarget, i);
+        capture->poll();
+      } else if (farmWorker) {
+        farmWorker->done(i, true);
+      }
+    };
+
+    std::cout << "Rendering " << headlessFrames << " frames at " << SCR_W << "x" << SCR_H
+              << " (" << headlessContext->kind() << " context, " << glGetString(GL_RENDERER) << ")\n";
+    int64_t startNs = Time::now();
+    uint32_t rendered = 0;
+    if (farmWorker) {
+      // Frames come from the coordinator. Results only go back once their
+      // files are written, so when no work is waiting, the readbacks still in
+      // flight are finished rather than left for frames that may never come.
+      farmWorker->ready();
+      uint32_t frame = 0;
+      while (!farmWorker->finished()) {
+        if (!farmWorker->next(frame, 0)) {
+          if (capture) capture->finish();
+          if (!farmWorker->next(frame, -1)) break;
+        }
+        if (frame >= headlessFrames) {
+          farmWorker->done(frame, false);
+          continue;
+        }
+        renderHeadlessFrame(frame);
+        ++rendered;
+      }
+    } else {
+      for (uint32_t i = 0; i < headlessFrames; ++i) {
+        renderHeadlessFrame(i);
+        ++rendered;
+      }
+    }
+    if (capture) capture->finish();
+    glFinish();
+
+    double seconds = static_cast<double>(Time::now() - startNs) * 1e-9;
+    std::cout << "Rendered " << rendered << " frames in " << seconds << " s ("
+              << seconds * 1e3 / std::max(rendered, 1u) << " ms/frame, " << rendered / seconds << " fps)\n";
+    std::string gpuSummary = gpuProfiler.summary();
+    if (!gpuSummary.empty()) std::cout << "GPU " << gpuSummary << "\n";
+    std::cout << "Building drawn in the last frame: " << drawnBuilding() << "\n";
+    const RenderQueue::Stats& queueStats = renderQueue.stats();
+    std::cout << "Render queue in the last frame: " << queueStats.packets << " packets, "
+              << queueStats.drawCalls << " draws, "
+              << queueStats.programChanges + queueStats.materialChanges << " state changes ("
+              << queueStats.unsortedStateChanges << " in submission order), "
+              << queueStats.filteredCommands << " redundant binds filtered\n";
+    if (capture) {
+      FrameCapture::Stats stats = capture->stats();
+      std::cout << "Wrote " << stats.written << " frames to " << outputDir << " (" << stats.failed << " failed, "
+                << stats.readbackStalls << " readback stalls, " << stats.encoderStalls << " encoder stalls)\n";
+    }
+  } else {
+    // From here on the render thread owns the context and every GL object
+    // above; the main thread only polls input, simulates and publishes
+    // snapshots.
+    glfwMakeContextCurrent(nullptr);
+    RenderThread renderThread(window, drawFrame);
+
+    /* Loop until the user closes the window */
+    while (!glfwWindowShouldClose(window)) {
+      PROFILE_SCOPE("frame");
+
+      /* Poll for and process events */
+      glfwPollEvents();
+
+      int ticks = frameLoop.beginFrame();
+      for (int tick = 0; tick < ticks; ++tick) {
+        PROFILE_SCOPE("tick");
+        previousEye = currentEye;
+        camera.setPosition(currentEye);
+        checkKeyboardEvents(window, cameraSpeed, static_cast<float>(frameLoop.tickSeconds()));
+        glm::vec3 eye = camera.position();
+        if (collide) worldBvh.collideSphere(eye, CAMERA_RADIUS);
+        currentEye = eye;
+      }
+      camera.setPosition(glm::mix(previousEye, currentEye, static_cast<float>(frameLoop.alpha())));
 
-    /* Swap front and back buffers */
-    glfwSwapBuffers(window);
+      int width, height;
+      glfwGetFramebufferSize(window, &width, &height);
+      if (width > 0 && height > 0) camera.setAspect((float)width / (float)height);
 
-    /* Poll for and process events */
-    glfwPollEvents();
+      {
+        PROFILE_SCOPE("scene update");
+        scene.update();
+      }
+      if (scene.updatedCount() > 0) {
+        PROFILE_SCOPE("entity BVH");
+        size_t boxCount = entityMins.size();
+        sceneBoxes(scene, pickEntities, entityMins, entityMaxs);
+        if (entityMins.size() == boxCount) entityBvh.refitBoxes(entityMins, entityMaxs);
+        else entityBvh.buildBoxes(entityMins, entityMaxs);
+      }
+
+      publishFrame(width, height);
+      renderThread.submit();
+
+      bool pickDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+      if (pickDown && !pickHeld) pickCenter(camera, worldBvh, entityBvh, pickEntities, building);
+      pickHeld = pickDown;
+
+      bool boundsDown = glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS;
+      if (boundsDown && !boundsHeld) showBounds = !showBounds;
+      boundsHeld = boundsDown;
+
+      if (titleChanged.exchange(false)) {
+        std::lock_guard<std::mutex> lock(titleMutex);
+        glfwSetWindowTitle(window, gpuTitle.c_str());
+      }
+
+      // Stay at most one snapshot ahead of the renderer, but keep polling
+      // input at least once a tick while it waits on vsync.
+      {
+        PROFILE_SCOPE("wait render");
+        renderThread.waitPickedUp(std::chrono::nanoseconds(static_cast<int64_t>(frameLoop.tickSeconds() * 1e9)));
+      }
+    }
+
+    renderThread.stop();
+    glfwMakeContextCurrent(window);
+  }
+
+  if (!cpuTracePath.empty()) {
+    Profiler::stop();
+    if (Profiler::writeTrace(cpuTracePath)) std::cout << "Wrote " << cpuTracePath << "\n";
+  }
+  if (!gpuTracePath.empty() && gpuProfiler.writeTrace(gpuTracePath)) {
+    std::cout << "Wrote " << gpuTracePath << "\n";
   }
 
-  glfwTerminate();
+  if (!headless) glfwTerminate();
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,1049 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include "utils/Jobs/Jobs.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BVH_SSE 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define BVH_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if BVH_SSE && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BVH_AVX2 1
+#endif
+
+namespace {
+    constexpr int BINS = 12;
+    // SAH costs, relative to one primitive test.
+    constexpr float TRAVERSAL_COST = 1.0f;
+    constexpr float PRIMITIVE_COST = 1.0f;
+    constexpr int STACK_SIZE = 128;
+    // Ranges at least this large are binned and bounded across the job pool,
+    // in chunks of PARALLEL_CHUNK primitives.
+    constexpr uint32_t PARALLEL_BINNING = 1u << 15;
+    constexpr uint32_t PARALLEL_CHUNK = 1u << 13;
+    // Ranges below this become one job each once the top of the tree is split.
+    constexpr uint32_t SUBTREE_SIZE = 1u << 12;
+
+    struct Box {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+
+        void grow(const glm::vec3& p) {
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+        void grow(const Box& b) {
+            min = glm::min(min, b.min);
+            max = glm::max(max, b.max);
+        }
+        float area() const {
+            if (min.x > max.x) return 0.0f;
+            glm::vec3 e = max - min;
+            return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+        }
+    };
+
+    // Binary tree before collapsing. A leaf has count > 0.
+    struct BuildNode {
+        Box box;
+        Box centroids;
+        uint32_t left = 0;
+        uint32_t right = 0;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct BuildInput {
+        std::span<const glm::vec3> mins;
+        std::span<const glm::vec3> maxs;
+        std::vector<glm::vec3> centroids;
+        std::vector<uint32_t>& order;
+    };
+
+    struct Bins {
+        Box box[3][BINS];
+        uint32_t count[3][BINS] = {};
+
+        void merge(const Bins& other) {
+            for (int a = 0; a < 3; ++a) {
+                for (int b = 0; b < BINS; ++b) {
+                    box[a][b].grow(other.box[a][b]);
+                    count[a][b] += other.count[a][b];
+                }
+            }
+        }
+    };
+
+    struct RangeBounds {
+        Box box;
+        Box centroids;
+
+        void merge(const RangeBounds& other) {
+            box.grow(other.box);
+            centroids.grow(other.centroids);
+        }
+    };
+
+    struct Split {
+        int axis = -1;
+        int bin = 0;
+        float cost = FLT_MAX;
+    };
+
+    // Per axis: BINS over the centroid extent, or 0 when the extent is flat.
+    glm::vec3 binScale(const Box& centroids) {
+        glm::vec3 extent = centroids.max - centroids.min;
+        glm::vec3 scale;
+        for (int a = 0; a < 3; ++a) scale[a] = extent[a] > 0.0f ? BINS / extent[a] : 0.0f;
+        return scale;
+    }
+
+    inline int binOf(float c, float lo, float scale) {
+        return std::min(BINS - 1, static_cast<int>((c - lo) * scale));
+    }
+
+    // Large ranges are reduced in chunks on the job pool and merged in order.
+    // Box unions are exact, so the result matches the serial loop.
+    template <typename Result, typename Fn>
+    Result reduceRange(uint32_t first, uint32_t count, bool parallel, const Fn& fn) {
+        Result result;
+        if (!parallel || count < PARALLEL_BINNING) {
+            fn(first, first + count, result);
+            return result;
+        }
+        uint32_t chunks = (count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+        std::vector<Result> partial(chunks);
+        Jobs::parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                uint32_t from = first + static_cast<uint32_t>(c) * PARALLEL_CHUNK;
+                fn(from, std::min(first + count, from + PARALLEL_CHUNK), partial[c]);
+            }
+        });
+        for (const Result& p : partial) result.merge(p);
+        return result;
+    }
+
+    RangeBounds rangeBounds(const BuildInput& in, uint32_t first, uint32_t count, bool parallel) {
+        return reduceRange<RangeBounds>(first, count, parallel, [&](uint32_t begin, uint32_t end, RangeBounds& out) {
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t p = in.order[i];
+                out.box.grow(in.mins[p]);
+                out.box.grow(in.maxs[p]);
+                out.centroids.grow(in.centroids[p]);
+            }
+        });
+    }
+
+    // Binned SAH split of the node's range by centroid.
+    Split findSplit(const BuildInput& in, const BuildNode& node, bool parallel) {
+        glm::vec3 lo = node.centroids.min;
+        glm::vec3 scale = binScale(node.centroids);
+        Bins bins = reduceRange<Bins>(node.first, node.count, parallel, [&](uint32_t begin, uint32_t end, Bins& out) {
+            for (uint32_t i = begin; i < end; ++i) {
+                uint32_t p = in.order[i];
+                for (int a = 0; a < 3; ++a) {
+                    int b = binOf(in.centroids[p][a], lo[a], scale[a]);
+                    out.box[a][b].grow(in.mins[p]);
+                    out.box[a][b].grow(in.maxs[p]);
+                    ++out.count[a][b];
+                }
+            }
+        });
+
+        Split best;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (scale[axis] <= 0.0f) continue;
+
+            // Sweep from the right, then evaluate each plane sweeping from the left.
+            float rightArea[BINS];
+            uint32_t rightCount[BINS];
+            Box box;
+            uint32_t n = 0;
+            for (int b = BINS - 1; b > 0; --b) {
+                box.grow(bins.box[axis][b]);
+                n += bins.count[axis][b];
+                rightArea[b] = box.area();
+                rightCount[b] = n;
+            }
+            box = Box();
+            n = 0;
+            for (int b = 0; b < BINS - 1; ++b) {
+                box.grow(bins.box[axis][b]);
+                n += bins.count[axis][b];
+                if (n == 0 || rightCount[b + 1] == 0) continue;
+                float cost = box.area() * n + rightArea[b + 1] * rightCount[b + 1];
+                if (cost < best.cost) best = {axis, b, cost};
+            }
+        }
+        return best;
+    }
+
+    // Splits nodes[index] in two, appending the children. Returns false when
+    // it stays a leaf.
+    bool splitNode(const BuildInput& in, std::vector<BuildNode>& nodes, uint32_t index, bool parallel) {
+        BuildNode node = nodes[index];
+        if (node.count <= 1) return false;
+
+        Split split = findSplit(in, node, parallel);
+        float leafCost = PRIMITIVE_COST * node.count;
+        float splitCost = split.axis >= 0 ? TRAVERSAL_COST + PRIMITIVE_COST * split.cost / node.box.area() : FLT_MAX;
+        if (node.count <= Bvh::MAX_LEAF_PRIMITIVES && leafCost <= splitCost) return false;
+
+        uint32_t* begin = in.order.data() + node.first;
+        uint32_t* end = begin + node.count;
+        uint32_t* middle;
+        if (split.axis >= 0) {
+            int axis = split.axis;
+            float lo = node.centroids.min[axis];
+            float scale = binScale(node.centroids)[axis];
+            middle = std::partition(begin, end, [&](uint32_t p) {
+                return binOf(in.centroids[p][axis], lo, scale) <= split.bin;
+            });
+        } else {
+            // Every centroid coincides: split the range in half.
+            middle = begin + node.count / 2;
+        }
+
+        uint32_t leftCount = static_cast<uint32_t>(middle - begin);
+        BuildNode left, right;
+        left.first = node.first;
+        left.count = leftCount;
+        right.first = node.first + leftCount;
+        right.count = node.count - leftCount;
+        RangeBounds leftBounds = rangeBounds(in, left.first, left.count, parallel);
+        RangeBounds rightBounds = rangeBounds(in, right.first, right.count, parallel);
+        left.box = leftBounds.box;
+        left.centroids = leftBounds.centroids;
+        right.box = rightBounds.box;
+        right.centroids = rightBounds.centroids;
+
+        uint32_t leftIndex = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(left);
+        nodes.push_back(right);
+        nodes[index].left = leftIndex;
+        nodes[index].right = leftIndex + 1;
+        nodes[index].count = 0;
+        return true;
+    }
+
+    // Splits from nodes[root] down. Ranges smaller than `deferBelow` are left
+    // unsplit and listed in `deferred` instead.
+    void splitTree(
+        const BuildInput& in,
+        std::vector<BuildNode>& nodes,
+        uint32_t root,
+        bool parallel,
+        uint32_t deferBelow,
+        std::vector<uint32_t>* deferred
+    ) {
+        std::vector<uint32_t> pending = {root};
+        while (!pending.empty()) {
+            uint32_t index = pending.back();
+            pending.pop_back();
+            if (nodes[index].count < deferBelow) {
+                deferred->push_back(index);
+                continue;
+            }
+            if (!splitNode(in, nodes, index, parallel)) continue;
+            pending.push_back(nodes[index].left);
+            pending.push_back(nodes[index].right);
+        }
+    }
+
+    // Each wide node takes its binary node's children, repeatedly opening the
+    // largest inner child until W slots are used. Wide nodes are appended
+    // after their parent, which refit relies on.
+    template <uint32_t W, typename NodeT>
+    void collapse(const std::vector<BuildNode>& nodes, uint32_t empty, std::vector<NodeT>& out) {
+        auto emptyNode = [&] {
+            NodeT n;
+            for (uint32_t i = 0; i < W; ++i) {
+                n.minX[i] = n.minY[i] = n.minZ[i] = FLT_MAX;
+                n.maxX[i] = n.maxY[i] = n.maxZ[i] = -FLT_MAX;
+                n.child[i] = empty;
+                n.count[i] = 0;
+            }
+            return n;
+        };
+
+        struct Slot {
+            uint32_t binary;
+            uint32_t node;
+            uint32_t slot;
+        };
+        std::vector<Slot> work;
+        std::vector<uint32_t> children;
+        auto open = [&](uint32_t binary) {
+            children = {nodes[binary].left, nodes[binary].right};
+            while (children.size() < W) {
+                int largest = -1;
+                float area = -1.0f;
+                for (size_t c = 0; c < children.size(); ++c) {
+                    const BuildNode& child = nodes[children[c]];
+                    if (child.count == 0 && child.box.area() > area) {
+                        area = child.box.area();
+                        largest = static_cast<int>(c);
+                    }
+                }
+                if (largest < 0) break;
+                const BuildNode& opened = nodes[children[largest]];
+                children[largest] = opened.right;
+                children.push_back(opened.left);
+            }
+
+            uint32_t wide = static_cast<uint32_t>(out.size());
+            out.push_back(emptyNode());
+            for (size_t c = 0; c < children.size(); ++c) {
+                work.push_back({children[c], wide, static_cast<uint32_t>(c)});
+            }
+            return wide;
+        };
+
+        if (nodes[0].count > 0) {
+            out.push_back(emptyNode());
+            work.push_back({0, 0, 0});
+        } else {
+            open(0);
+        }
+
+        while (!work.empty()) {
+            Slot item = work.back();
+            work.pop_back();
+            const BuildNode& source = nodes[item.binary];
+            NodeT& parent = out[item.node];
+            parent.minX[item.slot] = source.box.min.x;
+            parent.minY[item.slot] = source.box.min.y;
+            parent.minZ[item.slot] = source.box.min.z;
+            parent.maxX[item.slot] = source.box.max.x;
+            parent.maxY[item.slot] = source.box.max.y;
+            parent.maxZ[item.slot] = source.box.max.z;
+
+            if (source.count > 0) {
+                parent.child[item.slot] = source.first;
+                parent.count[item.slot] = static_cast<uint8_t>(source.count);
+            } else {
+                uint32_t wide = open(item.binary);
+                out[item.node].child[item.slot] = wide;
+            }
+        }
+    }
+
+    glm::vec3 inverseDirection(const glm::vec3& direction) {
+        glm::vec3 inv;
+        for (int i = 0; i < 3; ++i) {
+            float d = direction[i];
+            if (std::abs(d) < 1e-20f) d = std::copysign(1e-20f, d);
+            inv[i] = 1.0f / d;
+        }
+        return inv;
+    }
+
+    // Four child boxes against one ray. `node` points at minX; the six arrays
+    // follow each other `stride` floats apart.
+#if BVH_SSE
+    inline uint32_t slabTest4(const float* node, size_t stride, const glm::vec3& origin, const glm::vec3& inv, float tMin, float tMax, float* near) {
+        __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+        __m128 ix = _mm_set1_ps(inv.x), iy = _mm_set1_ps(inv.y), iz = _mm_set1_ps(inv.z);
+        __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node), ox), ix);
+        __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node + stride), oy), iy);
+        __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node + stride * 2), oz), iz);
+        __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node + stride * 3), ox), ix);
+        __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node + stride * 4), oy), iy);
+        __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node + stride * 5), oz), iz);
+        __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+                                  _mm_max_ps(_mm_min_ps(z0, z1), _mm_set1_ps(tMin)));
+        __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+                                 _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(tMax)));
+        _mm_storeu_ps(near, tNear);
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+    }
+#elif BVH_NEON
+    inline uint32_t slabTest4(const float* node, size_t stride, const glm::vec3& origin, const glm::vec3& inv, float tMin, float tMax, float* near) {
+        static const uint32_t bits[4] = {1, 2, 4, 8};
+        float32x4_t ox = vdupq_n_f32(origin.x), oy = vdupq_n_f32(origin.y), oz = vdupq_n_f32(origin.z);
+        float32x4_t x0 = vmulq_n_f32(vsubq_f32(vld1q_f32(node), ox), inv.x);
+        float32x4_t y0 = vmulq_n_f32(vsubq_f32(vld1q_f32(node + stride), oy), inv.y);
+        float32x4_t z0 = vmulq_n_f32(vsubq_f32(vld1q_f32(node + stride * 2), oz), inv.z);
+        float32x4_t x1 = vmulq_n_f32(vsubq_f32(vld1q_f32(node + stride * 3), ox), inv.x);
+        float32x4_t y1 = vmulq_n_f32(vsubq_f32(vld1q_f32(node + stride * 4), oy), inv.y);
+        float32x4_t z1 = vmulq_n_f32(vsubq_f32(vld1q_f32(node + stride * 5), oz), inv.z);
+        float32x4_t tNear = vmaxq_f32(vmaxq_f32(vminq_f32(x0, x1), vminq_f32(y0, y1)),
+                                      vmaxq_f32(vminq_f32(z0, z1), vdupq_n_f32(tMin)));
+        float32x4_t tFar = vminq_f32(vminq_f32(vmaxq_f32(x0, x1), vmaxq_f32(y0, y1)),
+                                     vminq_f32(vmaxq_f32(z0, z1), vdupq_n_f32(tMax)));
+        vst1q_f32(near, tNear);
+        return vaddvq_u32(vandq_u32(vcleq_f32(tNear, tFar), vld1q_u32(bits)));
+    }
+#else
+    inline uint32_t slabTest4(const float* node, size_t stride, const glm::vec3& origin, const glm::vec3& inv, float tMin, float tMax, float* near) {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            float x0 = (node[i] - origin.x) * inv.x, x1 = (node[stride * 3 + i] - origin.x) * inv.x;
+            float y0 = (node[stride + i] - origin.y) * inv.y, y1 = (node[stride * 4 + i] - origin.y) * inv.y;
+            float z0 = (node[stride * 2 + i] - origin.z) * inv.z, z1 = (node[stride * 5 + i] - origin.z) * inv.z;
+            float tNear = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), tMin));
+            float tFar = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), tMax));
+            near[i] = tNear;
+            if (tNear <= tFar) mask |= 1u << i;
+        }
+        return mask;
+    }
+#endif
+
+#if BVH_AVX2
+    __attribute__((target("avx2")))
+    uint32_t slabTest8AVX2(const float* node, const glm::vec3& origin, const glm::vec3& inv, float tMin, float tMax, float* near) {
+        __m256 ox = _mm256_set1_ps(origin.x), oy = _mm256_set1_ps(origin.y), oz = _mm256_set1_ps(origin.z);
+        __m256 ix = _mm256_set1_ps(inv.x), iy = _mm256_set1_ps(inv.y), iz = _mm256_set1_ps(inv.z);
+        __m256 x0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node), ox), ix);
+        __m256 y0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node + 8), oy), iy);
+        __m256 z0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node + 16), oz), iz);
+        __m256 x1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node + 24), ox), ix);
+        __m256 y1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node + 32), oy), iy);
+        __m256 z1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node + 40), oz), iz);
+        __m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)),
+                                     _mm256_max_ps(_mm256_min_ps(z0, z1), _mm256_set1_ps(tMin)));
+        __m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)),
+                                    _mm256_min_ps(_mm256_max_ps(z0, z1), _mm256_set1_ps(tMax)));
+        _mm256_storeu_ps(near, tNear);
+        return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+    }
+#endif
+
+    bool hasAVX2() {
+#if BVH_AVX2
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    // Every child of a W-wide node against one ray.
+    template <uint32_t W>
+    inline uint32_t slabTest(const float* node, const glm::vec3& origin, const glm::vec3& inv, float tMin, float tMax, float* near, bool avx2) {
+        if constexpr (W == 4) {
+            return slabTest4(node, 4, origin, inv, tMin, tMax, near);
+        } else {
+#if BVH_AVX2
+            if (avx2) return slabTest8AVX2(node, origin, inv, tMin, tMax, near);
+#endif
+            (void)avx2;
+            return slabTest4(node, 8, origin, inv, tMin, tMax, near) |
+                   slabTest4(node + 4, 8, origin, inv, tMin, tMax, near + 4) << 4;
+        }
+    }
+
+    // Closest point on the triangle (a, a + e1, a + e2) to p, after Ericson.
+    glm::vec3 closestOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& e1, const glm::vec3& e2) {
+        glm::vec3 b = a + e1, c = a + e2;
+        glm::vec3 ap = p - a;
+        float d1 = glm::dot(e1, ap), d2 = glm::dot(e2, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+        glm::vec3 bp = p - b;
+        float d3 = glm::dot(e1, bp), d4 = glm::dot(e2, bp);
+        if (d3 >= 0.0f && d4 <= d3) return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + e1 * (d1 / (d1 - d3));
+
+        glm::vec3 cp = p - c;
+        float d5 = glm::dot(e1, cp), d6 = glm::dot(e2, cp);
+        if (d6 >= 0.0f && d5 <= d6) return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + e2 * (d2 / (d2 - d6));
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+
+        float denom = 1.0f / (va + vb + vc);
+        return a + e1 * (vb * denom) + e2 * (vc * denom);
+    }
+
+    // One box against every ray of a packet, four rays per SIMD step.
+    template <typename Packet>
+    inline uint32_t packetSlabTest(const Packet& p, const float* lo, const float* hi, float* near) {
+        constexpr uint32_t N = Bvh::PACKET_SIZE;
+        uint32_t mask = 0;
+#if BVH_SSE
+        __m128 bx0 = _mm_set1_ps(lo[0]), by0 = _mm_set1_ps(lo[1]), bz0 = _mm_set1_ps(lo[2]);
+        __m128 bx1 = _mm_set1_ps(hi[0]), by1 = _mm_set1_ps(hi[1]), bz1 = _mm_set1_ps(hi[2]);
+        for (uint32_t g = 0; g < N; g += 4) {
+            __m128 ox = _mm_load_ps(p.ox + g), oy = _mm_load_ps(p.oy + g), oz = _mm_load_ps(p.oz + g);
+            __m128 ix = _mm_load_ps(p.ix + g), iy = _mm_load_ps(p.iy + g), iz = _mm_load_ps(p.iz + g);
+            __m128 x0 = _mm_mul_ps(_mm_sub_ps(bx0, ox), ix), x1 = _mm_mul_ps(_mm_sub_ps(bx1, ox), ix);
+            __m128 y0 = _mm_mul_ps(_mm_sub_ps(by0, oy), iy), y1 = _mm_mul_ps(_mm_sub_ps(by1, oy), iy);
+            __m128 z0 = _mm_mul_ps(_mm_sub_ps(bz0, oz), iz), z1 = _mm_mul_ps(_mm_sub_ps(bz1, oz), iz);
+            __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+                                      _mm_max_ps(_mm_min_ps(z0, z1), _mm_load_ps(p.tMin + g)));
+            __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+                                     _mm_min_ps(_mm_max_ps(z0, z1), _mm_load_ps(p.tMax + g)));
+            _mm_storeu_ps(near + g, tNear);
+            mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar))) << g;
+        }
+#elif BVH_NEON
+        static const uint32_t bits[4] = {1, 2, 4, 8};
+        float32x4_t bx0 = vdupq_n_f32(lo[0]), by0 = vdupq_n_f32(lo[1]), bz0 = vdupq_n_f32(lo[2]);
+        float32x4_t bx1 = vdupq_n_f32(hi[0]), by1 = vdupq_n_f32(hi[1]), bz1 = vdupq_n_f32(hi[2]);
+        for (uint32_t g = 0; g < N; g += 4) {
+            float32x4_t ox = vld1q_f32(p.ox + g), oy = vld1q_f32(p.oy + g), oz = vld1q_f32(p.oz + g);
+            float32x4_t ix = vld1q_f32(p.ix + g), iy = vld1q_f32(p.iy + g), iz = vld1q_f32(p.iz + g);
+            float32x4_t x0 = vmulq_f32(vsubq_f32(bx0, ox), ix), x1 = vmulq_f32(vsubq_f32(bx1, ox), ix);
+            float32x4_t y0 = vmulq_f32(vsubq_f32(by0, oy), iy), y1 = vmulq_f32(vsubq_f32(by1, oy), iy);
+            float32x4_t z0 = vmulq_f32(vsubq_f32(bz0, oz), iz), z1 = vmulq_f32(vsubq_f32(bz1, oz), iz);
+            float32x4_t tNear = vmaxq_f32(vmaxq_f32(vminq_f32(x0, x1), vminq_f32(y0, y1)),
+                                          vmaxq_f32(vminq_f32(z0, z1), vld1q_f32(p.tMin + g)));
+            float32x4_t tFar = vminq_f32(vminq_f32(vmaxq_f32(x0, x1), vmaxq_f32(y0, y1)),
+                                         vminq_f32(vmaxq_f32(z0, z1), vld1q_f32(p.tMax + g)));
+            vst1q_f32(near + g, tNear);
+            mask |= vaddvq_u32(vandq_u32(vcleq_f32(tNear, tFar), vld1q_u32(bits))) << g;
+        }
+#else
+        for (uint32_t i = 0; i < N; ++i) {
+            float x0 = (lo[0] - p.ox[i]) * p.ix[i], x1 = (hi[0] - p.ox[i]) * p.ix[i];
+            float y0 = (lo[1] - p.oy[i]) * p.iy[i], y1 = (hi[1] - p.oy[i]) * p.iy[i];
+            float z0 = (lo[2] - p.oz[i]) * p.iz[i], z1 = (hi[2] - p.oz[i]) * p.iz[i];
+            float tNear = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), p.tMin[i]));
+            float tFar = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::min(std::max(z0, z1), p.tMax[i]));
+            near[i] = tNear;
+            if (tNear <= tFar) mask |= 1u << i;
+        }
+#endif
+        return mask;
+    }
+}
+
+// Rays of one packet, structure-of-arrays. Unused lanes get an empty
+// [tMin, tMax] so they never enter a box.
+struct Bvh::Packet {
+    alignas(16) float ox[PACKET_SIZE], oy[PACKET_SIZE], oz[PACKET_SIZE];
+    alignas(16) float ix[PACKET_SIZE], iy[PACKET_SIZE], iz[PACKET_SIZE];
+    alignas(16) float tMin[PACKET_SIZE], tMax[PACKET_SIZE];
+    glm::vec3 inv[PACKET_SIZE];
+    const Ray* rays = nullptr;
+    RayHit* hits = nullptr;
+    // Lanes still tracing, and lanes that hit something.
+    uint32_t active = 0;
+    uint32_t found = 0;
+};
+
+const char* Bvh::simdPath(uint32_t width) {
+#if BVH_SSE
+    if (width == 8) return hasAVX2() ? "avx2" : "sse x2";
+    return "sse";
+#elif BVH_NEON
+    return width == 8 ? "neon x2" : "neon";
+#else
+    (void)width;
+    return "scalar";
+#endif
+}
+
+void Bvh::clear() {
+    m_nodes4.clear();
+    m_nodes8.clear();
+    m_triangles.clear();
+    m_primitiveBoxes.clear();
+    m_boxes = false;
+    m_boundsMin = glm::vec3(0.0f);
+    m_boundsMax = glm::vec3(0.0f);
+}
+
+void Bvh::build(std::span<const glm::vec3> corners, const BvhBuildOptions& options) {
+    clear();
+    uint32_t triangleCount = static_cast<uint32_t>(corners.size() / 3);
+    if (triangleCount == 0) return;
+
+    std::vector<glm::vec3> mins(triangleCount), maxs(triangleCount);
+    Jobs::parallelFor(triangleCount, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; ++t) {
+            const glm::vec3* c = &corners[t * 3];
+            mins[t] = glm::min(c[0], glm::min(c[1], c[2]));
+            maxs[t] = glm::max(c[0], glm::max(c[1], c[2]));
+        }
+    });
+
+    std::vector<uint32_t> order;
+    buildTree(mins, maxs, triangleCount, options, order);
+
+    m_triangles.resize(triangleCount);
+    Jobs::parallelFor(triangleCount, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t t = order[i];
+            const glm::vec3& v0 = corners[t * 3];
+            m_triangles[i] = {v0, corners[t * 3 + 1] - v0, corners[t * 3 + 2] - v0, t};
+        }
+    });
+}
+
+void Bvh::buildBoxes(std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs, const BvhBuildOptions& options) {
+    clear();
+    uint32_t count = static_cast<uint32_t>(std::min(mins.size(), maxs.size()));
+    if (count == 0) return;
+
+    std::vector<uint32_t> order;
+    buildTree(mins.first(count), maxs.first(count), count, options, order);
+
+    m_boxes = true;
+    m_primitiveBoxes.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        m_primitiveBoxes[i] = {mins[order[i]], maxs[order[i]], order[i]};
+    }
+}
+
+void Bvh::buildTree(
+    std::span<const glm::vec3> mins,
+    std::span<const glm::vec3> maxs,
+    uint32_t count,
+    const BvhBuildOptions& options,
+    std::vector<uint32_t>& order
+) {
+    if (options.width != 4 && options.width != 8) {
+        std::cerr << "Bvh width " << options.width << " is not supported, using 4\n";
+    }
+    m_width = options.width == 8 ? 8 : 4;
+    bool parallel = options.parallel && Jobs::threadCount() > 1;
+
+    order.resize(count);
+    BuildInput in{mins, maxs, std::vector<glm::vec3>(count), order};
+    Jobs::parallelFor(count, 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            in.centroids[p] = (mins[p] + maxs[p]) * 0.5f;
+            order[p] = static_cast<uint32_t>(p);
+        }
+    });
+
+    std::vector<BuildNode> binary;
+    binary.reserve(count * 2 / MAX_LEAF_PRIMITIVES + 1);
+    RangeBounds rootBounds = rangeBounds(in, 0, count, parallel);
+    BuildNode root;
+    root.box = rootBounds.box;
+    root.centroids = rootBounds.centroids;
+    root.count = count;
+    binary.push_back(root);
+    m_boundsMin = root.box.min;
+    m_boundsMax = root.box.max;
+
+    if (!parallel) {
+        splitTree(in, binary, 0, false, 0, nullptr);
+    } else {
+        // Split the top with parallel binning, finish each small range as its
+        // own job, then splice the subtrees in a fixed order.
+        std::vector<uint32_t> deferred;
+        splitTree(in, binary, 0, true, SUBTREE_SIZE, &deferred);
+
+        std::vector<std::vector<BuildNode>> subtrees(deferred.size());
+        Jobs::parallelFor(deferred.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) {
+                subtrees[s] = {binary[deferred[s]]};
+                splitTree(in, subtrees[s], 0, false, 0, nullptr);
+            }
+        });
+
+        for (size_t s = 0; s < deferred.size(); ++s) {
+            // Local node i > 0 lands at offset + i; the local root replaces the deferred node.
+            uint32_t offset = static_cast<uint32_t>(binary.size()) - 1;
+            for (size_t i = 0; i < subtrees[s].size(); ++i) {
+                BuildNode node = subtrees[s][i];
+                if (node.count == 0) {
+                    node.left += offset;
+                    node.right += offset;
+                }
+                if (i == 0) binary[deferred[s]] = node;
+                else binary.push_back(node);
+            }
+        }
+    }
+
+    if (m_width == 8) collapse<8>(binary, EMPTY, m_nodes8);
+    else collapse<4>(binary, EMPTY, m_nodes4);
+}
+
+void Bvh::refit(std::span<const glm::vec3> corners) {
+    if (m_boxes || corners.size() / 3 != m_triangles.size()) {
+        std::cerr << "Bvh refit with " << corners.size() / 3 << " triangles, built with " << primitiveCount() << "\n";
+        return;
+    }
+    Jobs::parallelFor(m_triangles.size(), 1 << 14, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Triangle& tri = m_triangles[i];
+            const glm::vec3& v0 = corners[tri.id * 3];
+            tri.v0 = v0;
+            tri.edge1 = corners[tri.id * 3 + 1] - v0;
+            tri.edge2 = corners[tri.id * 3 + 2] - v0;
+        }
+    });
+    if (m_width == 8) refitNodes<8>();
+    else refitNodes<4>();
+}
+
+void Bvh::refitBoxes(std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs) {
+    if (!m_boxes || mins.size() != m_primitiveBoxes.size() || maxs.size() != m_primitiveBoxes.size()) {
+        std::cerr << "Bvh refit with " << mins.size() << " boxes, built with " << primitiveCount() << "\n";
+        return;
+    }
+    for (PrimitiveBox& box : m_primitiveBoxes) {
+        box.min = mins[box.id];
+        box.max = maxs[box.id];
+    }
+    if (m_width == 8) refitNodes<8>();
+    else refitNodes<4>();
+}
+
+template <uint32_t W>
+void Bvh::refitNodes() {
+    auto& tree = nodes<W>();
+    if (tree.empty()) return;
+
+    // Children come after their parents, so one backwards sweep updates every
+    // child before the slot that bounds it.
+    for (size_t n = tree.size(); n-- > 0;) {
+        Node<W>& node = tree[n];
+        for (uint32_t c = 0; c < W; ++c) {
+            if (node.child[c] == EMPTY) continue;
+            Box box;
+            if (node.count[c] > 0) {
+                for (uint32_t i = node.child[c]; i < node.child[c] + node.count[c]; ++i) {
+                    if (m_boxes) {
+                        box.grow(m_primitiveBoxes[i].min);
+                        box.grow(m_primitiveBoxes[i].max);
+                    } else {
+                        const Triangle& tri = m_triangles[i];
+                        box.grow(tri.v0);
+                        box.grow(tri.v0 + tri.edge1);
+                        box.grow(tri.v0 + tri.edge2);
+                    }
+                }
+            } else {
+                const Node<W>& child = tree[node.child[c]];
+                for (uint32_t k = 0; k < W; ++k) {
+                    if (child.child[k] == EMPTY) continue;
+                    box.grow(glm::vec3(child.minX[k], child.minY[k], child.minZ[k]));
+                    box.grow(glm::vec3(child.maxX[k], child.maxY[k], child.maxZ[k]));
+                }
+            }
+            node.minX[c] = box.min.x;
+            node.minY[c] = box.min.y;
+            node.minZ[c] = box.min.z;
+            node.maxX[c] = box.max.x;
+            node.maxY[c] = box.max.y;
+            node.maxZ[c] = box.max.z;
+        }
+    }
+
+    Box bounds;
+    const Node<W>& root = tree[0];
+    for (uint32_t c = 0; c < W; ++c) {
+        if (root.child[c] == EMPTY) continue;
+        bounds.grow(glm::vec3(root.minX[c], root.minY[c], root.minZ[c]));
+        bounds.grow(glm::vec3(root.maxX[c], root.maxY[c], root.maxZ[c]));
+    }
+    m_boundsMin = bounds.min;
+    m_boundsMax = bounds.max;
+}
+
+bool Bvh::intersectLeaf(
+    uint32_t first,
+    uint32_t count,
+    const Ray& ray,
+    const glm::vec3& inv,
+    float& tMax,
+    RayHit& hit,
+    bool anyHit
+) const {
+    bool found = false;
+    for (uint32_t i = first; i < first + count; ++i) {
+        if (m_boxes) {
+            const PrimitiveBox& box = m_primitiveBoxes[i];
+            glm::vec3 t0 = (box.min - ray.origin) * inv;
+            glm::vec3 t1 = (box.max - ray.origin) * inv;
+            glm::vec3 lo = glm::min(t0, t1), hi = glm::max(t0, t1);
+            float tNear = std::max(std::max(lo.x, lo.y), std::max(lo.z, ray.tMin));
+            float tFar = std::min(std::min(hi.x, hi.y), std::min(hi.z, tMax));
+            if (tNear > tFar) continue;
+            hit = {tNear, 0.0f, 0.0f, box.id};
+            tMax = tNear;
+        } else {
+            const Triangle& tri = m_triangles[i];
+            glm::vec3 p = glm::cross(ray.direction, tri.edge2);
+            float det = glm::dot(tri.edge1, p);
+            if (std::abs(det) < 1e-12f) continue;
+            float invDet = 1.0f / det;
+            glm::vec3 s = ray.origin - tri.v0;
+            float u = glm::dot(s, p) * invDet;
+            if (u < 0.0f || u > 1.0f) continue;
+            glm::vec3 q = glm::cross(s, tri.edge1);
+            float v = glm::dot(ray.direction, q) * invDet;
+            if (v < 0.0f || u + v > 1.0f) continue;
+            float t = glm::dot(tri.edge2, q) * invDet;
+            if (t < ray.tMin || t > tMax) continue;
+            hit = {t, u, v, tri.id};
+            tMax = t;
+        }
+        if (anyHit) return true;
+        found = true;
+    }
+    return found;
+}
+
+template <uint32_t W, bool AnyHit>
+bool Bvh::traverse(const Ray& ray, RayHit& hit) const {
+    const auto& tree = nodes<W>();
+    if (tree.empty()) return false;
+
+    glm::vec3 inv = inverseDirection(ray.direction);
+    bool avx2 = W == 8 && hasAVX2();
+    float tMax = ray.tMax;
+    bool found = false;
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const Node<W>& node = tree[stack[--top]];
+        alignas(16) float near[W];
+        uint32_t mask = slabTest<W>(node.minX, ray.origin, inv, ray.tMin, tMax, near, avx2);
+
+        // Inner children are pushed far to near so the nearest is popped first.
+        uint32_t inner[W];
+        int innerCount = 0;
+        while (mask) {
+            uint32_t c = static_cast<uint32_t>(__builtin_ctz(mask));
+            mask &= mask - 1;
+            if (node.child[c] == EMPTY) continue;
+            if (node.count[c] == 0) {
+                inner[innerCount++] = c;
+                continue;
+            }
+            if (intersectLeaf(node.child[c], node.count[c], ray, inv, tMax, hit, AnyHit)) {
+                if (AnyHit) return true;
+                found = true;
+            }
+        }
+
+        std::sort(inner, inner + innerCount, [&](uint32_t a, uint32_t b) { return near[a] > near[b]; });
+        for (int i = 0; i < innerCount && top < STACK_SIZE; ++i) {
+            stack[top++] = node.child[inner[i]];
+        }
+    }
+    return found;
+}
+
+bool Bvh::intersect(const Ray& ray, RayHit& hit) const {
+    return m_width == 8 ? traverse<8, false>(ray, hit) : traverse<4, false>(ray, hit);
+}
+
+bool Bvh::occluded(const Ray& ray) const {
+    RayHit hit;
+    return m_width == 8 ? traverse<8, true>(ray, hit) : traverse<4, true>(ray, hit);
+}
+
+template <uint32_t W, bool AnyHit>
+void Bvh::traversePacket(Packet& packet) const {
+    const auto& tree = nodes<W>();
+    if (tree.empty()) return;
+
+    struct Entry {
+        uint32_t node;
+        uint32_t rays;
+    };
+    Entry stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = {0, packet.active};
+
+    while (top > 0) {
+        Entry entry = stack[--top];
+        uint32_t rays = entry.rays & packet.active;
+        if (!rays) continue;
+        const Node<W>& node = tree[entry.node];
+
+        // Per inner child: the rays entering it and their nearest entry, so
+        // children are visited front to back for the packet as a whole.
+        Entry inner[W];
+        float innerNear[W];
+        int innerCount = 0;
+        for (uint32_t c = 0; c < W && rays; ++c) {
+            if (node.child[c] == EMPTY) continue;
+            float lo[3] = {node.minX[c], node.minY[c], node.minZ[c]};
+            float hi[3] = {node.maxX[c], node.maxY[c], node.maxZ[c]};
+            alignas(16) float near[PACKET_SIZE];
+            uint32_t entering = packetSlabTest(packet, lo, hi, near) & rays;
+            if (!entering) continue;
+
+            if (node.count[c] == 0) {
+                float nearest = FLT_MAX;
+                for (uint32_t m = entering; m; m &= m - 1) nearest = std::min(nearest, near[__builtin_ctz(m)]);
+                inner[innerCount] = {node.child[c], entering};
+                innerNear[innerCount++] = nearest;
+                continue;
+            }
+
+            for (uint32_t m = entering; m; m &= m - 1) {
+                uint32_t r = static_cast<uint32_t>(__builtin_ctz(m));
+                if (!intersectLeaf(node.child[c], node.count[c], packet.rays[r], packet.inv[r], packet.tMax[r], packet.hits[r], AnyHit)) continue;
+                packet.found |= 1u << r;
+                if (AnyHit) packet.active &= ~(1u << r);
+            }
+            rays &= packet.active;
+        }
+
+        int order[W];
+        for (int i = 0; i < innerCount; ++i) order[i] = i;
+        std::sort(order, order + innerCount, [&](int a, int b) { return innerNear[a] > innerNear[b]; });
+        for (int i = 0; i < innerCount && top < STACK_SIZE; ++i) {
+            stack[top++] = inner[order[i]];
+        }
+    }
+}
+
+template <bool AnyHit>
+void Bvh::tracePackets(std::span<const Ray> rays, std::span<RayHit> hits, std::span<uint8_t> results) const {
+    RayHit scratch[PACKET_SIZE];
+    for (size_t first = 0; first < rays.size(); first += PACKET_SIZE) {
+        uint32_t count = static_cast<uint32_t>(std::min<size_t>(PACKET_SIZE, rays.size() - first));
+        Packet packet;
+        packet.rays = rays.data() + first;
+        packet.hits = AnyHit ? scratch : hits.data() + first;
+        packet.active = (1u << count) - 1;
+        for (uint32_t r = 0; r < PACKET_SIZE; ++r) {
+            if (r < count) {
+                const Ray& ray = packet.rays[r];
+                packet.inv[r] = inverseDirection(ray.direction);
+                packet.ox[r] = ray.origin.x;
+                packet.oy[r] = ray.origin.y;
+                packet.oz[r] = ray.origin.z;
+                packet.ix[r] = packet.inv[r].x;
+                packet.iy[r] = packet.inv[r].y;
+                packet.iz[r] = packet.inv[r].z;
+                packet.tMin[r] = ray.tMin;
+                packet.tMax[r] = ray.tMax;
+                packet.hits[r] = RayHit();
+            } else {
+                packet.ox[r] = packet.oy[r] = packet.oz[r] = 0.0f;
+                packet.ix[r] = packet.iy[r] = packet.iz[r] = 1.0f;
+                packet.tMin[r] = 1.0f;
+                packet.tMax[r] = 0.0f;
+            }
+        }
+
+        if (m_width == 8) traversePacket<8, AnyHit>(packet);
+        else traversePacket<4, AnyHit>(packet);
+
+        if (AnyHit) {
+            for (uint32_t r = 0; r < count; ++r) results[first + r] = (packet.found >> r) & 1;
+        }
+    }
+}
+
+void Bvh::intersect(std::span<const Ray> rays, std::span<RayHit> hits) const {
+    if (hits.size() < rays.size()) return;
+    tracePackets<false>(rays, hits, {});
+}
+
+void Bvh::occluded(std::span<const Ray> rays, std::span<uint8_t> results) const {
+    if (results.size() < rays.size()) return;
+    tracePackets<true>(rays, {}, results);
+}
+
+template <uint32_t W>
+void Bvh::overlapNodes(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const {
+    const auto& tree = nodes<W>();
+    if (tree.empty()) return;
+
+    uint32_t stack[STACK_SIZE];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node<W>& node = tree[stack[--top]];
+        for (uint32_t c = 0; c < W; ++c) {
+            if (node.child[c] == EMPTY) continue;
+            if (node.minX[c] > max.x || node.maxX[c] < min.x ||
+                node.minY[c] > max.y || node.maxY[c] < min.y ||
+                node.minZ[c] > max.z || node.maxZ[c] < min.z) continue;
+            if (node.count[c] == 0) {
+                if (top < STACK_SIZE) stack[top++] = node.child[c];
+                continue;
+            }
+            for (uint32_t i = node.child[c]; i < node.child[c] + node.count[c]; ++i) out.push_back(i);
+        }
+    }
+}
+
+void Bvh::overlap(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const {
+    // Leaf positions first, then narrowed to each primitive's own bounds and mapped to ids.
+    size_t first = out.size();
+    if (m_width == 8) overlapNodes<8>(min, max, out);
+    else overlapNodes<4>(min, max, out);
+
+    size_t kept = first;
+    for (size_t i = first; i < out.size(); ++i) {
+        glm::vec3 lo, hi;
+        uint32_t id;
+        if (m_boxes) {
+            const PrimitiveBox& box = m_primitiveBoxes[out[i]];
+            lo = box.min;
+            hi = box.max;
+            id = box.id;
+        } else {
+            const Triangle& tri = m_triangles[out[i]];
+            lo = glm::min(tri.v0, glm::min(tri.v0 + tri.edge1, tri.v0 + tri.edge2));
+            hi = glm::max(tri.v0, glm::max(tri.v0 + tri.edge1, tri.v0 + tri.edge2));
+            id = tri.id;
+        }
+        if (glm::any(glm::greaterThan(lo, max)) || glm::any(glm::lessThan(hi, min))) continue;
+        out[kept++] = id;
+    }
+    out.resize(kept);
+}
+
+bool Bvh::collideSphere(glm::vec3& center, float radius, int iterations) const {
+    if (m_boxes || m_triangles.empty()) return false;
+
+    std::vector<uint32_t> candidates;
+    bool moved = false;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        candidates.clear();
+        if (m_width == 8) overlapNodes<8>(center - radius, center + radius, candidates);
+        else overlapNodes<4>(center - radius, center + radius, candidates);
+
+        // Resolve the deepest contact; the rest are measured again next round.
+        float deepest = 0.0f;
+        glm::vec3 push(0.0f);
+        for (uint32_t i : candidates) {
+            const Triangle& tri = m_triangles[i];
+            glm::vec3 offset = center - closestOnTriangle(center, tri.v0, tri.edge1, tri.edge2);
+            float distance = glm::length(offset);
+            float depth = radius - distance;
+            if (depth <= deepest) continue;
+
+            glm::vec3 normal;
+            if (distance > 1e-6f) {
+                normal = offset / distance;
+            } else {
+                // Centre on the plane: leave along the face normal.
+                normal = glm::cross(tri.edge1, tri.edge2);
+                float length = glm::length(normal);
+                if (length <= 0.0f) continue;
+                normal /= length;
+            }
+            deepest = depth;
+            push = normal * depth;
+        }
+        if (deepest <= 0.0f) break;
+        center += push;
+        moved = true;
+    }
+    return moved;
+}
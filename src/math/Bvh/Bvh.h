@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct Ray {
+    glm::vec3 origin = glm::vec3(0.0f);
+    // Need not be normalised; hit distances are in multiples of it.
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float tMin = 0.0f;
+    float tMax = 1e30f;
+};
+
+struct RayHit {
+    float t = 0.0f;
+    // Barycentric weights of the triangle's second and third corners; 0 for boxes.
+    float u = 0.0f;
+    float v = 0.0f;
+    // Index of the triangle or box given to build(), UINT32_MAX on a miss.
+    uint32_t primitive = UINT32_MAX;
+};
+
+struct BvhBuildOptions {
+    // Children per node: 4 (one SSE/NEON test) or 8 (one AVX2 test, or two
+    // 4-wide halves on CPUs without it).
+    uint32_t width = 4;
+    // Bin large ranges and build independent subtrees on the job pool. The
+    // tree is the same either way.
+    bool parallel = true;
+};
+
+// Bounding volume hierarchy over triangles or boxes for CPU queries (baking,
+// picking, camera collision). Built with binned SAH as a binary tree, then
+// collapsed into nodes of 4 or 8 children whose boxes are stored
+// structure-of-arrays, so one SIMD slab test covers every child of a node.
+// Packets of rays share one traversal, testing each child box against all of
+// their rays at once.
+//
+// Primitives are copied in leaf order; queries report the index they were
+// given to build(). refit() moves them without rebuilding: the topology is
+// kept and only the boxes grow or shrink, which suits objects that move but
+// do not swap places wholesale. Queries are const and safe to run from many
+// threads; build and refit are not.
+class Bvh {
+public:
+    static constexpr uint32_t MAX_WIDTH = 8;
+    static constexpr uint32_t MAX_LEAF_PRIMITIVES = 4;
+    // Rays traced together by the span overloads of intersect() and occluded().
+    static constexpr uint32_t PACKET_SIZE = 8;
+
+    // `corners` holds three positions per triangle.
+    void build(std::span<const glm::vec3> corners, const BvhBuildOptions& options = {});
+    // One axis-aligned box per primitive, e.g. object bounds.
+    void buildBoxes(std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs, const BvhBuildOptions& options = {});
+    void clear();
+
+    // New positions for the primitives given to build() or buildBoxes(), in
+    // the same order and count.
+    void refit(std::span<const glm::vec3> corners);
+    void refitBoxes(std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs);
+
+    // Nearest hit in [tMin, tMax]. Triangles are two-sided; a ray starting
+    // inside a box hits it at tMin.
+    bool intersect(const Ray& ray, RayHit& hit) const;
+    // Whether anything lies in [tMin, tMax]; stops at the first hit.
+    bool occluded(const Ray& ray) const;
+
+    // Ray packets: hits[i].primitive stays UINT32_MAX for rays that miss.
+    void intersect(std::span<const Ray> rays, std::span<RayHit> hits) const;
+    void occluded(std::span<const Ray> rays, std::span<uint8_t> results) const;
+
+    // Primitives whose bounds overlap the box.
+    void overlap(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+
+    // Pushes a sphere out of the triangles it penetrates, a few rounds so that
+    // corners settle. Returns whether it moved. Triangle trees only.
+    bool collideSphere(glm::vec3& center, float radius, int iterations = 4) const;
+
+    size_t primitiveCount() const { return m_boxes ? m_primitiveBoxes.size() : m_triangles.size(); }
+    size_t nodeCount() const { return m_width == 8 ? m_nodes8.size() : m_nodes4.size(); }
+    uint32_t width() const { return m_width; }
+    glm::vec3 boundsMin() const { return m_boundsMin; }
+    glm::vec3 boundsMax() const { return m_boundsMax; }
+
+    // Name of the SIMD path the node test takes at the given width.
+    static const char* simdPath(uint32_t width = 4);
+
+private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    template <uint32_t W>
+    struct alignas(32) Node {
+        float minX[W], minY[W], minZ[W];
+        float maxX[W], maxY[W], maxZ[W];
+        // Inner child: node index. Leaf child: first primitive. EMPTY if unused.
+        uint32_t child[W];
+        // Primitives of a leaf child, 0 for inner children.
+        uint8_t count[W];
+    };
+
+    // Möller-Trumbore form.
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        uint32_t id;
+    };
+
+    struct PrimitiveBox {
+        glm::vec3 min;
+        glm::vec3 max;
+        uint32_t id;
+    };
+
+    struct Packet;
+
+    template <uint32_t W>
+    auto& nodes() {
+        if constexpr (W == 8) return m_nodes8;
+        else return m_nodes4;
+    }
+    template <uint32_t W>
+    const auto& nodes() const {
+        if constexpr (W == 8) return m_nodes8;
+        else return m_nodes4;
+    }
+
+    void buildTree(
+        std::span<const glm::vec3> mins,
+        std::span<const glm::vec3> maxs,
+        uint32_t count,
+        const BvhBuildOptions& options,
+        std::vector<uint32_t>& order
+    );
+    // Tests leaf primitives [first, first + count), lowering tMax on each hit.
+    bool intersectLeaf(
+        uint32_t first,
+        uint32_t count,
+        const Ray& ray,
+        const glm::vec3& inv,
+        float& tMax,
+        RayHit& hit,
+        bool anyHit
+    ) const;
+    template <uint32_t W>
+    void refitNodes();
+    template <uint32_t W, bool AnyHit>
+    bool traverse(const Ray& ray, RayHit& hit) const;
+    template <uint32_t W, bool AnyHit>
+    void traversePacket(Packet& packet) const;
+    template <uint32_t W>
+    void overlapNodes(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& out) const;
+    template <bool AnyHit>
+    void tracePackets(std::span<const Ray> rays, std::span<RayHit> hits, std::span<uint8_t> results) const;
+
+    uint32_t m_width = 4;
+    bool m_boxes = false;
+    std::vector<Node<4>> m_nodes4;
+    std::vector<Node<8>> m_nodes8;
+    std::vector<Triangle> m_triangles;
+    std::vector<PrimitiveBox> m_primitiveBoxes;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+};
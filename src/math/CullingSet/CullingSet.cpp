@@ -0,0 +1,264 @@
+#include "CullingSet.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/Jobs/Jobs.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CULLING_AVX2 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define CULLING_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    struct Planes {
+        float x[6], y[6], z[6], w[6];
+        float ax[6], ay[6], az[6];
+
+        explicit Planes(const Frustum& frustum) {
+            for (int p = 0; p < 6; ++p) {
+                x[p] = frustum.planes[p].x;
+                y[p] = frustum.planes[p].y;
+                z[p] = frustum.planes[p].z;
+                w[p] = frustum.planes[p].w;
+                ax[p] = std::abs(x[p]);
+                ay[p] = std::abs(y[p]);
+                az[p] = std::abs(z[p]);
+            }
+        }
+    };
+
+    struct Bounds {
+        const float *boxX, *boxY, *boxZ;
+        const float *extentX, *extentY, *extentZ;
+        const float *sphereX, *sphereY, *sphereZ, *radius;
+    };
+
+    // Culls objects [begin, end), writing visible indices to `out`. Returns how many.
+    using Kernel = size_t (*)(const Bounds& b, const Planes& planes, size_t begin, size_t end, uint32_t* out);
+
+    size_t cullScalar(const Bounds& b, const Planes& planes, size_t begin, size_t end, uint32_t* out) {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i) {
+            bool visible = true;
+            for (int p = 0; p < 6 && visible; ++p) {
+                float sphere = planes.x[p] * b.sphereX[i] + planes.y[p] * b.sphereY[i] + planes.z[p] * b.sphereZ[i] + planes.w[p];
+                float box = planes.x[p] * b.boxX[i] + planes.y[p] * b.boxY[i] + planes.z[p] * b.boxZ[i] + planes.w[p];
+                float reach = planes.ax[p] * b.extentX[i] + planes.ay[p] * b.extentY[i] + planes.az[p] * b.extentZ[i];
+                visible = sphere >= -b.radius[i] && box >= -reach;
+            }
+            if (visible) out[count++] = static_cast<uint32_t>(i);
+        }
+        return count;
+    }
+
+    // Appends base + the index of every set bit.
+    inline size_t emitMask(uint32_t mask, size_t base, uint32_t* out) {
+        size_t count = 0;
+        while (mask) {
+            out[count++] = static_cast<uint32_t>(base + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+        return count;
+    }
+
+#if CULLING_AVX2
+    __attribute__((target("avx2,fma")))
+    size_t cullAVX2(const Bounds& b, const Planes& planes, size_t begin, size_t end, uint32_t* out) {
+        size_t count = 0;
+        size_t i = begin;
+        const __m256 zero = _mm256_setzero_ps();
+
+        for (; i + 8 <= end; i += 8) {
+            __m256 sx = _mm256_loadu_ps(b.sphereX + i);
+            __m256 sy = _mm256_loadu_ps(b.sphereY + i);
+            __m256 sz = _mm256_loadu_ps(b.sphereZ + i);
+            __m256 r = _mm256_loadu_ps(b.radius + i);
+            __m256 bx = _mm256_loadu_ps(b.boxX + i);
+            __m256 by = _mm256_loadu_ps(b.boxY + i);
+            __m256 bz = _mm256_loadu_ps(b.boxZ + i);
+            __m256 ex = _mm256_loadu_ps(b.extentX + i);
+            __m256 ey = _mm256_loadu_ps(b.extentY + i);
+            __m256 ez = _mm256_loadu_ps(b.extentZ + i);
+
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m256 px = _mm256_set1_ps(planes.x[p]);
+                __m256 py = _mm256_set1_ps(planes.y[p]);
+                __m256 pz = _mm256_set1_ps(planes.z[p]);
+                __m256 pw = _mm256_set1_ps(planes.w[p]);
+
+                __m256 sphere = _mm256_fmadd_ps(px, sx, _mm256_fmadd_ps(py, sy, _mm256_fmadd_ps(pz, sz, _mm256_add_ps(pw, r))));
+                __m256 box = _mm256_fmadd_ps(px, bx, _mm256_fmadd_ps(py, by, _mm256_fmadd_ps(pz, bz, pw)));
+                box = _mm256_fmadd_ps(_mm256_set1_ps(planes.ax[p]), ex, box);
+                box = _mm256_fmadd_ps(_mm256_set1_ps(planes.ay[p]), ey, box);
+                box = _mm256_fmadd_ps(_mm256_set1_ps(planes.az[p]), ez, box);
+
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(sphere, zero, _CMP_GE_OQ));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(box, zero, _CMP_GE_OQ));
+            }
+            count += emitMask(static_cast<uint32_t>(_mm256_movemask_ps(visible)), i, out + count);
+        }
+        return count + cullScalar(b, planes, i, end, out + count);
+    }
+#endif
+
+#if CULLING_NEON
+    inline uint32x4_t visibleNEON(const Bounds& b, const Planes& planes, size_t i) {
+        float32x4_t sx = vld1q_f32(b.sphereX + i);
+        float32x4_t sy = vld1q_f32(b.sphereY + i);
+        float32x4_t sz = vld1q_f32(b.sphereZ + i);
+        float32x4_t r = vld1q_f32(b.radius + i);
+        float32x4_t bx = vld1q_f32(b.boxX + i);
+        float32x4_t by = vld1q_f32(b.boxY + i);
+        float32x4_t bz = vld1q_f32(b.boxZ + i);
+        float32x4_t ex = vld1q_f32(b.extentX + i);
+        float32x4_t ey = vld1q_f32(b.extentY + i);
+        float32x4_t ez = vld1q_f32(b.extentZ + i);
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+
+        uint32x4_t visible = vdupq_n_u32(~0u);
+        for (int p = 0; p < 6; ++p) {
+            float32x4_t pw = vdupq_n_f32(planes.w[p]);
+            float32x4_t sphere = vfmaq_n_f32(vfmaq_n_f32(vfmaq_n_f32(vaddq_f32(pw, r), sz, planes.z[p]), sy, planes.y[p]), sx, planes.x[p]);
+            float32x4_t box = vfmaq_n_f32(vfmaq_n_f32(vfmaq_n_f32(pw, bz, planes.z[p]), by, planes.y[p]), bx, planes.x[p]);
+            box = vfmaq_n_f32(box, ex, planes.ax[p]);
+            box = vfmaq_n_f32(box, ey, planes.ay[p]);
+            box = vfmaq_n_f32(box, ez, planes.az[p]);
+
+            visible = vandq_u32(visible, vcgeq_f32(sphere, zero));
+            visible = vandq_u32(visible, vcgeq_f32(box, zero));
+        }
+        return visible;
+    }
+
+    // Two NEON registers per step, so eight objects like the AVX2 path.
+    size_t cullNEON(const Bounds& b, const Planes& planes, size_t begin, size_t end, uint32_t* out) {
+        static const uint32_t bitsLow[4] = {1, 2, 4, 8};
+        static const uint32_t bitsHigh[4] = {16, 32, 64, 128};
+        const uint32x4_t low = vld1q_u32(bitsLow);
+        const uint32x4_t high = vld1q_u32(bitsHigh);
+
+        size_t count = 0;
+        size_t i = begin;
+        for (; i + 8 <= end; i += 8) {
+            uint32_t mask = vaddvq_u32(vandq_u32(visibleNEON(b, planes, i), low)) +
+                            vaddvq_u32(vandq_u32(visibleNEON(b, planes, i + 4), high));
+            count += emitMask(mask, i, out + count);
+        }
+        return count + cullScalar(b, planes, i, end, out + count);
+    }
+#endif
+
+    Kernel pickSimdKernel() {
+#if CULLING_AVX2
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return cullAVX2;
+#elif CULLING_NEON
+        return cullNEON;
+#endif
+        return cullScalar;
+    }
+
+    Kernel simdKernel() {
+        static const Kernel kernel = pickSimdKernel();
+        return kernel;
+    }
+}
+
+uint32_t CullingSet::add(const glm::vec3& min, const glm::vec3& max) {
+    return add(min, max, (min + max) * 0.5f, glm::length(max - min) * 0.5f);
+}
+
+uint32_t CullingSet::add(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius) {
+    uint32_t index = static_cast<uint32_t>(size());
+    for (auto* array : {&m_boxX, &m_boxY, &m_boxZ, &m_extentX, &m_extentY, &m_extentZ,
+                        &m_sphereX, &m_sphereY, &m_sphereZ, &m_radius}) {
+        array->push_back(0.0f);
+    }
+    set(index, min, max, center, radius);
+    return index;
+}
+
+void CullingSet::set(uint32_t index, const glm::vec3& min, const glm::vec3& max) {
+    set(index, min, max, (min + max) * 0.5f, glm::length(max - min) * 0.5f);
+}
+
+void CullingSet::set(uint32_t index, const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius) {
+    glm::vec3 boxCenter = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    m_boxX[index] = boxCenter.x;
+    m_boxY[index] = boxCenter.y;
+    m_boxZ[index] = boxCenter.z;
+    m_extentX[index] = extent.x;
+    m_extentY[index] = extent.y;
+    m_extentZ[index] = extent.z;
+    m_sphereX[index] = center.x;
+    m_sphereY[index] = center.y;
+    m_sphereZ[index] = center.z;
+    m_radius[index] = radius;
+}
+
+void CullingSet::clear() {
+    for (auto* array : {&m_boxX, &m_boxY, &m_boxZ, &m_extentX, &m_extentY, &m_extentZ,
+                        &m_sphereX, &m_sphereY, &m_sphereZ, &m_radius}) {
+        array->clear();
+    }
+}
+
+void CullingSet::reserve(size_t count) {
+    for (auto* array : {&m_boxX, &m_boxY, &m_boxZ, &m_extentX, &m_extentY, &m_extentZ,
+                        &m_sphereX, &m_sphereY, &m_sphereZ, &m_radius}) {
+        array->reserve(count);
+    }
+}
+
+void CullingSet::cull(const Frustum& frustum, std::vector<uint32_t>& visible, const CullOptions& options) const {
+    visible.clear();
+    size_t count = size();
+    if (count == 0) return;
+
+    Planes planes(frustum);
+    Bounds bounds{
+        m_boxX.data(), m_boxY.data(), m_boxZ.data(),
+        m_extentX.data(), m_extentY.data(), m_extentZ.data(),
+        m_sphereX.data(), m_sphereY.data(), m_sphereZ.data(), m_radius.data()
+    };
+    Kernel kernel = options.simd ? simdKernel() : cullScalar;
+
+    size_t chunkCount = options.parallel ? (count + CHUNK - 1) / CHUNK : 1;
+    if (chunkCount == 1) {
+        visible.resize(count);
+        visible.resize(kernel(bounds, planes, 0, count, visible.data()));
+        return;
+    }
+
+    // Each chunk writes to its own range of the scratch list; the ranges are
+    // then packed into `visible` in order.
+    if (m_scratch.size() < count) m_scratch.resize(count);
+    m_chunkCounts.resize(chunkCount);
+    Jobs::parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            size_t first = c * CHUNK;
+            size_t last = std::min(first + CHUNK, count);
+            m_chunkCounts[c] = kernel(bounds, planes, first, last, m_scratch.data() + first);
+        }
+    });
+
+    for (size_t c = 0; c < chunkCount; ++c) {
+        const uint32_t* first = m_scratch.data() + c * CHUNK;
+        visible.insert(visible.end(), first, first + m_chunkCounts[c]);
+    }
+}
+
+const char* CullingSet::simdPath() {
+    Kernel kernel = simdKernel();
+#if CULLING_AVX2
+    if (kernel == cullAVX2) return "AVX2";
+#elif CULLING_NEON
+    if (kernel == cullNEON) return "NEON";
+#endif
+    return "scalar";
+}
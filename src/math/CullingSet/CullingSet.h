@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Frustum/Frustum.h"
+
+struct CullOptions {
+    // Use the widest instruction set the CPU supports (AVX2 or NEON).
+    bool simd = true;
+    // Split the set into chunks and cull them across the Jobs pool.
+    bool parallel = true;
+};
+
+// Bounding volumes stored structure-of-arrays so a frustum test can run on
+// LANES objects at once. Each object has a box (centre and half extent) and a
+// bounding sphere; it is visible when both intersect the frustum.
+class CullingSet {
+public:
+    static constexpr size_t LANES = 8;
+    // Objects per parallel task. A multiple of LANES.
+    static constexpr size_t CHUNK = 16384;
+
+    // Returns the object's index. The sphere defaults to the one around the box.
+    uint32_t add(const glm::vec3& min, const glm::vec3& max);
+    uint32_t add(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius);
+    void set(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+    void set(uint32_t index, const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius);
+
+    void clear();
+    void reserve(size_t count);
+    size_t size() const { return m_boxX.size(); }
+    glm::vec3 boxMin(uint32_t index) const {
+        return glm::vec3(m_boxX[index] - m_extentX[index], m_boxY[index] - m_extentY[index], m_boxZ[index] - m_extentZ[index]);
+    }
+    glm::vec3 boxMax(uint32_t index) const {
+        return glm::vec3(m_boxX[index] + m_extentX[index], m_boxY[index] + m_extentY[index], m_boxZ[index] + m_extentZ[index]);
+    }
+
+    // Writes the indices of visible objects to `visible` in ascending order.
+    // Not safe to call concurrently on the same set (shares scratch space).
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible, const CullOptions& options = {}) const;
+
+    // Name of the SIMD path cull() takes when options.simd is set.
+    static const char* simdPath();
+
+private:
+    // Box centre and half extent.
+    std::vector<float> m_boxX, m_boxY, m_boxZ;
+    std::vector<float> m_extentX, m_extentY, m_extentZ;
+    // Sphere centre and radius.
+    std::vector<float> m_sphereX, m_sphereY, m_sphereZ, m_radius;
+
+    mutable std::vector<uint32_t> m_scratch;
+    mutable std::vector<size_t> m_chunkCounts;
+};
@@ -0,0 +1,193 @@
+#include "DynamicMesh.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "math/Mesh/Mesh.h"
+
+namespace {
+    constexpr GLuint64 FENCE_WAIT_NS = 1'000'000;
+
+    void waitFence(GLsync fence) {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, 0, FENCE_WAIT_NS);
+        }
+    }
+
+    // Allocates FRAMES regions of `capacity` elements and carries over the `used`
+    // elements already written to the current region of the old buffer.
+    GLuint regrow(GLuint old, size_t oldCapacity, size_t capacity, size_t used, size_t stride, uint32_t frame) {
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity * DynamicMesh::FRAMES * stride, nullptr, GL_STREAM_DRAW);
+
+        if (old) {
+            if (used > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, old);
+                glCopyBufferSubData(
+                    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                    frame * oldCapacity * stride,
+                    frame * capacity * stride,
+                    used * stride
+                );
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            // Draws already issued keep the old storage alive until they finish.
+            glDeleteBuffers(1, &old);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return buffer;
+    }
+
+    void write(GLuint buffer, size_t byteOffset, const void* data, size_t bytes) {
+        if (bytes == 0) return;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        // Unsynchronized is safe: the fence waited on in beginFrame() covers this region.
+        void* dst = glMapBufferRange(
+            GL_COPY_WRITE_BUFFER,
+            static_cast<GLintptr>(byteOffset),
+            static_cast<GLsizeiptr>(bytes),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        );
+        if (dst) {
+            std::memcpy(dst, data, bytes);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+DynamicMesh::DynamicMesh(size_t vertexCapacity, size_t indexCapacity, GLenum primitive)
+    : m_primitive(primitive) {
+    glGenVertexArrays(1, &m_vao);
+    reserveVertices(std::max<size_t>(vertexCapacity, 1));
+    if (indexCapacity > 0) reserveIndices(indexCapacity);
+}
+
+DynamicMesh::~DynamicMesh() {
+    release();
+}
+
+void DynamicMesh::release() {
+    for (GLsync& fence : m_fences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (m_ebo) glDeleteBuffers(1, &m_ebo);
+    if (m_vbo) glDeleteBuffers(1, &m_vbo);
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    m_ebo = m_vbo = m_vao = 0;
+}
+
+DynamicMesh::DynamicMesh(DynamicMesh&& other) noexcept {
+    *this = std::move(other);
+}
+
+DynamicMesh& DynamicMesh::operator=(DynamicMesh&& other) noexcept {
+    if (this == &other) return *this;
+
+    release();
+
+    m_vao = std::exchange(other.m_vao, 0);
+    m_vbo = std::exchange(other.m_vbo, 0);
+    m_ebo = std::exchange(other.m_ebo, 0);
+    m_primitive = other.m_primitive;
+
+    m_vertexCapacity = std::exchange(other.m_vertexCapacity, 0);
+    m_indexCapacity  = std::exchange(other.m_indexCapacity, 0);
+    m_vertexCount    = std::exchange(other.m_vertexCount, 0);
+    m_indexCount     = std::exchange(other.m_indexCount, 0);
+
+    m_frame = std::exchange(other.m_frame, 0);
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        m_fences[i] = std::exchange(other.m_fences[i], nullptr);
+    }
+
+    return *this;
+}
+
+void DynamicMesh::beginFrame() {
+    // Everything issued so far may read the current region.
+    if (m_fences[m_frame]) glDeleteSync(m_fences[m_frame]);
+    m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_frame = (m_frame + 1) % FRAMES;
+    if (m_fences[m_frame]) {
+        waitFence(m_fences[m_frame]);
+        glDeleteSync(m_fences[m_frame]);
+        m_fences[m_frame] = nullptr;
+    }
+
+    m_vertexCount = 0;
+    m_indexCount = 0;
+}
+
+void DynamicMesh::reserveVertices(size_t count) {
+    if (count <= m_vertexCapacity) return;
+
+    size_t capacity = std::max(count, m_vertexCapacity * 2);
+    m_vbo = regrow(m_vbo, m_vertexCapacity, capacity, static_cast<size_t>(m_vertexCount), sizeof(Vertex), m_frame);
+    m_vertexCapacity = capacity;
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    Mesh::setupVertexAttributes();
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DynamicMesh::reserveIndices(size_t count) {
+    if (count <= m_indexCapacity) return;
+
+    size_t capacity = std::max(count, m_indexCapacity * 2);
+    m_ebo = regrow(m_ebo, m_indexCapacity, capacity, static_cast<size_t>(m_indexCount), sizeof(uint32_t), m_frame);
+    m_indexCapacity = capacity;
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBindVertexArray(0);
+}
+
+void DynamicMesh::update(std::span<const Vertex> vertices, size_t offset) {
+    size_t end = offset + vertices.size();
+    reserveVertices(end);
+
+    write(m_vbo, (m_frame * m_vertexCapacity + offset) * sizeof(Vertex), vertices.data(), vertices.size_bytes());
+    m_vertexCount = std::max(m_vertexCount, static_cast<GLsizei>(end));
+}
+
+void DynamicMesh::updateIndices(std::span<const uint32_t> indices, size_t offset) {
+    size_t end = offset + indices.size();
+    reserveIndices(end);
+
+    write(m_ebo, (m_frame * m_indexCapacity + offset) * sizeof(uint32_t), indices.data(), indices.size_bytes());
+    m_indexCount = std::max(m_indexCount, static_cast<GLsizei>(end));
+}
+
+void DynamicMesh::draw() const {
+    drawRange(0, m_indexCount > 0 ? m_indexCount : m_vertexCount);
+}
+
+void DynamicMesh::drawRange(GLsizei first, GLsizei count) const {
+    if (count <= 0) return;
+
+    glBindVertexArray(m_vao);
+    if (m_indexCount > 0) {
+        // Indices stay relative to the frame's vertex region.
+        glDrawElementsBaseVertex(
+            m_primitive,
+            count,
+            GL_UNSIGNED_INT,
+            (void*)((m_frame * m_indexCapacity + static_cast<size_t>(first)) * sizeof(uint32_t)),
+            static_cast<GLint>(m_frame * m_vertexCapacity)
+        );
+    } else {
+        glDrawArrays(m_primitive, static_cast<GLint>(m_frame * m_vertexCapacity) + first, count);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include <glad/glad.h>
+
+#include "math/Vertex.h"
+
+// Geometry rewritten every frame (debug lines, particles, UI).
+//
+// The vertex and index buffers are split into FRAMES regions. Each frame writes
+// into its own region with an unsynchronized map, and a fence placed at the next
+// beginFrame() keeps the CPU from overwriting a region the GPU may still read.
+// GL 3.3 has no persistent mapping, so every update() is a short map/unmap of
+// just the written range instead.
+class DynamicMesh {
+public:
+    static constexpr uint32_t FRAMES = 3;
+
+    // Capacities are per frame and grow on demand.
+    explicit DynamicMesh(
+        size_t vertexCapacity = 1024,
+        size_t indexCapacity = 0,
+        GLenum primitive = GL_TRIANGLES
+    );
+    ~DynamicMesh();
+
+    DynamicMesh(const DynamicMesh&) = delete;
+    DynamicMesh& operator=(const DynamicMesh&) = delete;
+
+    DynamicMesh(DynamicMesh&& other) noexcept;
+    DynamicMesh& operator=(DynamicMesh&& other) noexcept;
+
+    // Moves to the next region, waiting only if the GPU is still FRAMES frames behind.
+    // Counts reset to zero.
+    void beginFrame();
+
+    // Offsets are in elements, relative to this frame's region. The drawn count
+    // is the furthest element written since beginFrame().
+    void update(std::span<const Vertex> vertices, size_t offset = 0);
+    void updateIndices(std::span<const uint32_t> indices, size_t offset = 0);
+
+    void draw() const;
+    void drawRange(GLsizei first, GLsizei count) const;
+
+    GLsizei vertexCount() const { return m_vertexCount; }
+    GLsizei indexCount() const { return m_indexCount; }
+    size_t vertexCapacity() const { return m_vertexCapacity; }
+    size_t indexCapacity() const { return m_indexCapacity; }
+
+private:
+    void reserveVertices(size_t count);
+    void reserveIndices(size_t count);
+    void release();
+
+    GLuint m_vao = 0;
+    GLuint m_vbo = 0;
+    GLuint m_ebo = 0;
+    GLenum m_primitive = GL_TRIANGLES;
+
+    size_t m_vertexCapacity = 0;
+    size_t m_indexCapacity = 0;
+    GLsizei m_vertexCount = 0;
+    GLsizei m_indexCount = 0;
+
+    uint32_t m_frame = 0;
+    GLsync m_fences[FRAMES] = {};
+};
@@ -0,0 +1,43 @@
+#include "Frustum.h"
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // Gribb/Hartmann: rows of the matrix combined; glm is column-major.
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum f;
+    f.planes[0] = row3 + row0;
+    f.planes[1] = row3 - row0;
+    f.planes[2] = row3 + row1;
+    f.planes[3] = row3 - row1;
+    f.planes[4] = row3 + row2;
+    f.planes[5] = row3 - row2;
+
+    for (auto& p : f.planes) {
+        float len = glm::length(glm::vec3(p));
+        if (len > 0.0f) p /= len;
+    }
+    return f;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& p : planes) {
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersectsAABB(const glm::vec3& min, const glm::vec3& max) const {
+    for (const auto& p : planes) {
+        // Corner furthest along the plane normal.
+        glm::vec3 v(
+            p.x >= 0.0f ? max.x : min.x,
+            p.y >= 0.0f ? max.y : min.y,
+            p.z >= 0.0f ? max.z : min.z
+        );
+        if (glm::dot(glm::vec3(p), v) + p.w < 0.0f) return false;
+    }
+    return true;
+}
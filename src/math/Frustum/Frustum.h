@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Six world-space planes (xyz = inward normal, w = distance) extracted from a
+// view-projection matrix. Order: left, right, bottom, top, near, far.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    bool intersectsAABB(const glm::vec3& min, const glm::vec3& max) const;
+};
@@ -0,0 +1,216 @@
+#include "LightmapPacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    constexpr int MAX_ATTEMPTS = 32;
+
+    struct Chart {
+        uint32_t mesh = 0;
+        // Vertices of this chart only, after splitting shared ones.
+        std::vector<uint32_t> vertices;
+        glm::vec3 axisU = glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec3 axisV = glm::vec3(0.0f, 0.0f, 1.0f);
+        glm::vec2 min = glm::vec2(0.0f);
+        glm::vec2 max = glm::vec2(0.0f);
+
+        // Placement for the current density, in texels.
+        int width = 1;
+        int height = 1;
+        bool rotated = false;
+        int x = 0;
+        int y = 0;
+    };
+
+    uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void buildCharts(const LightmapMesh& mesh, uint32_t meshIndex, float cosine, std::vector<Chart>& charts) {
+        std::vector<Vertex>& vertices = *mesh.vertices;
+        std::vector<uint32_t>& indices = *mesh.indices;
+        uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        std::vector<glm::vec3> normals(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            const glm::vec3& a = vertices[indices[t * 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& c = vertices[indices[t * 3 + 2]].position;
+            // Unnormalised: the length is twice the area, used to weight chart normals.
+            normals[t] = glm::cross(b - a, c - a);
+        }
+
+        std::vector<uint32_t> parent(triangleCount);
+        std::iota(parent.begin(), parent.end(), 0u);
+        std::unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve(indices.size());
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            for (int e = 0; e < 3; ++e) {
+                uint32_t a = indices[t * 3 + e];
+                uint32_t b = indices[t * 3 + (e + 1) % 3];
+                uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+                auto [it, inserted] = edges.try_emplace(key, t);
+                if (inserted) continue;
+
+                uint32_t other = it->second;
+                float la = glm::length(normals[t]), lb = glm::length(normals[other]);
+                if (la <= 0.0f || lb <= 0.0f) continue;
+                if (glm::dot(normals[t], normals[other]) >= cosine * la * lb) {
+                    parent[findRoot(parent, t)] = findRoot(parent, other);
+                }
+            }
+        }
+
+        // Charts in order of their first triangle, so the layout is stable.
+        std::vector<uint32_t> chartOf(triangleCount, UINT32_MAX);
+        std::vector<uint32_t> rootChart(triangleCount, UINT32_MAX);
+        size_t firstChart = charts.size();
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            uint32_t root = findRoot(parent, t);
+            if (rootChart[root] == UINT32_MAX) {
+                rootChart[root] = static_cast<uint32_t>(charts.size());
+                charts.emplace_back();
+                charts.back().mesh = meshIndex;
+            }
+            chartOf[t] = rootChart[root];
+        }
+
+        std::vector<glm::vec3> chartNormals(charts.size() - firstChart, glm::vec3(0.0f));
+        for (uint32_t t = 0; t < triangleCount; ++t) chartNormals[chartOf[t] - firstChart] += normals[t];
+
+        // A vertex belongs to the first chart using it; other charts get a copy.
+        std::vector<uint32_t> owner(vertices.size(), UINT32_MAX);
+        std::unordered_map<uint64_t, uint32_t> copies;
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            uint32_t chart = chartOf[t];
+            for (int c = 0; c < 3; ++c) {
+                uint32_t& index = indices[t * 3 + c];
+                if (owner[index] == UINT32_MAX) {
+                    owner[index] = chart;
+                    charts[chart].vertices.push_back(index);
+                } else if (owner[index] != chart) {
+                    uint64_t key = (static_cast<uint64_t>(chart) << 32) | index;
+                    auto [it, inserted] = copies.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+                    if (inserted) {
+                        vertices.push_back(vertices[index]);
+                        charts[chart].vertices.push_back(it->second);
+                    }
+                    index = it->second;
+                }
+            }
+        }
+
+        for (size_t c = firstChart; c < charts.size(); ++c) {
+            Chart& chart = charts[c];
+            glm::vec3 n = chartNormals[c - firstChart];
+            n = glm::length(n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::vec3 reference = std::abs(n.y) > 0.9f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            chart.axisU = glm::normalize(glm::cross(reference, n));
+            chart.axisV = glm::cross(n, chart.axisU);
+
+            chart.min = glm::vec2(std::numeric_limits<float>::max());
+            chart.max = glm::vec2(-std::numeric_limits<float>::max());
+            for (uint32_t v : chart.vertices) {
+                glm::vec2 p(glm::dot(vertices[v].position, chart.axisU), glm::dot(vertices[v].position, chart.axisV));
+                chart.min = glm::min(chart.min, p);
+                chart.max = glm::max(chart.max, p);
+            }
+        }
+    }
+
+    // Shelf-packs the charts at `density`. Returns the atlas size.
+    glm::ivec2 place(std::vector<Chart>& charts, std::vector<uint32_t>& order, float density, int padding) {
+        int widest = 1;
+        double area = 0.0;
+        for (Chart& chart : charts) {
+            glm::vec2 extent = (chart.max - chart.min) * density;
+            // +1: the corners sit on texel centres.
+            chart.width = static_cast<int>(std::ceil(extent.x)) + 1;
+            chart.height = static_cast<int>(std::ceil(extent.y)) + 1;
+            chart.rotated = chart.height > chart.width;
+            if (chart.rotated) std::swap(chart.width, chart.height);
+            widest = std::max(widest, chart.width);
+            area += static_cast<double>(chart.width + padding) * (chart.height + padding);
+        }
+
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            if (charts[a].height != charts[b].height) return charts[a].height > charts[b].height;
+            if (charts[a].width != charts[b].width) return charts[a].width > charts[b].width;
+            return a < b;
+        });
+
+        int width = std::max(widest + padding * 2, static_cast<int>(std::ceil(std::sqrt(area * 1.1))));
+        width = (width + 3) & ~3;
+
+        int x = padding, y = padding, shelf = 0;
+        for (uint32_t c : order) {
+            Chart& chart = charts[c];
+            if (x + chart.width + padding > width) {
+                y += shelf + padding;
+                x = padding;
+                shelf = 0;
+            }
+            chart.x = x;
+            chart.y = y;
+            x += chart.width + padding;
+            shelf = std::max(shelf, chart.height);
+        }
+        int height = (y + shelf + padding + 3) & ~3;
+        return {width, height};
+    }
+}
+
+namespace LightmapPacker {
+    LightmapAtlas pack(std::span<const LightmapMesh> meshes, const LightmapPackOptions& options) {
+        std::vector<Chart> charts;
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            buildCharts(meshes[m], static_cast<uint32_t>(m), options.chartCosine, charts);
+        }
+
+        LightmapAtlas atlas;
+        atlas.charts = charts.size();
+        if (charts.empty()) return atlas;
+
+        std::vector<uint32_t> order(charts.size());
+        std::iota(order.begin(), order.end(), 0u);
+
+        float density = options.texelsPerUnit;
+        glm::ivec2 size(0);
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; ++attempt) {
+            size = place(charts, order, density, options.padding);
+            if (size.x <= options.maxSize && size.y <= options.maxSize) break;
+            if (attempt + 1 == MAX_ATTEMPTS) {
+                std::cerr << "Lightmap atlas does not fit in " << options.maxSize << "x" << options.maxSize
+                          << " (" << charts.size() << " charts), using " << size.x << "x" << size.y << "\n";
+                break;
+            }
+            float fill = static_cast<float>(options.maxSize) * options.maxSize / (static_cast<float>(size.x) * size.y);
+            density *= std::min(0.95f, std::sqrt(fill));
+        }
+
+        glm::vec2 invSize = 1.0f / glm::vec2(size);
+        for (const Chart& chart : charts) {
+            std::vector<Vertex>& vertices = *meshes[chart.mesh].vertices;
+            for (uint32_t v : chart.vertices) {
+                const glm::vec3& p = vertices[v].position;
+                glm::vec2 s = (glm::vec2(glm::dot(p, chart.axisU), glm::dot(p, chart.axisV)) - chart.min) * density;
+                if (chart.rotated) std::swap(s.x, s.y);
+                vertices[v].lightmapUV = (glm::vec2(chart.x, chart.y) + 0.5f + s) * invSize;
+            }
+        }
+
+        atlas.width = size.x;
+        atlas.height = size.y;
+        atlas.texelsPerUnit = density;
+        return atlas;
+    }
+}
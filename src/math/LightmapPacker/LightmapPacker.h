@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "math/Vertex.h"
+
+struct LightmapPackOptions {
+    float texelsPerUnit = 4.0f;
+    // The density is lowered until the atlas fits in maxSize x maxSize.
+    int maxSize = 4096;
+    // Texels left empty around each chart; the baker dilates into them.
+    int padding = 2;
+    // Triangles sharing an edge go into one chart when the cosine between
+    // their normals is at least this.
+    float chartCosine = 0.999f;
+};
+
+struct LightmapAtlas {
+    int width = 0;
+    int height = 0;
+    // Density actually used, after shrinking to fit.
+    float texelsPerUnit = 0.0f;
+    size_t charts = 0;
+};
+
+// Meshes sharing one atlas. The packer may append vertices (a vertex used by
+// two charts is split) and rewrites indices in place, so index ranges and
+// counts stay valid.
+struct LightmapMesh {
+    std::vector<Vertex>* vertices;
+    std::vector<uint32_t>* indices;
+};
+
+// Lays out lightmap UVs: triangles are grouped into charts of edge-connected,
+// coplanar faces, each chart is projected onto its plane at a uniform texel
+// density, and the charts are shelf-packed into one atlas. Chart corners land
+// on texel centres so bilinear filtering never reads a neighbouring chart.
+// Deterministic for the same input, so a baked atlas can be matched to the
+// geometry regenerated at runtime.
+namespace LightmapPacker {
+    LightmapAtlas pack(std::span<const LightmapMesh> meshes, const LightmapPackOptions& options = {});
+}
@@ -3,7 +3,7 @@
 #include <utility>
 #include <cstddef>
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, GLenum usage) {
+Mesh::Mesh(std::span<const Vertex> vertices, GLenum usage) {
     m_vertexCount = static_cast<GLsizei>(vertices.size());
     m_indexed = false;
 
@@ -15,7 +15,7 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, GLenum usage) {
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferData(
         GL_ARRAY_BUFFER,
-        vertices.size() * sizeof(Vertex),
+        vertices.size_bytes(),
         vertices.data(),
         usage
     );
@@ -26,8 +26,8 @@ Mesh::Mesh(const std::vector<Vertex>& vertices, GLenum usage) {
 }
 
 Mesh::Mesh(
-    const std::vector<Vertex>& vertices,
-    const std::vector<uint32_t>& indices,
+    std::span<const Vertex> vertices,
+    std::span<const uint32_t> indices,
     GLenum usage
 ) {
     m_vertexCount = static_cast<GLsizei>(vertices.size());
@@ -43,7 +43,7 @@ Mesh::Mesh(
     glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
     glBufferData(
         GL_ARRAY_BUFFER,
-        vertices.size() * sizeof(Vertex),
+        vertices.size_bytes(),
         vertices.data(),
         usage
     );
@@ -51,7 +51,7 @@ Mesh::Mesh(
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
     glBufferData(
         GL_ELEMENT_ARRAY_BUFFER,
-        indices.size() * sizeof(uint32_t),
+        indices.size_bytes(),
         indices.data(),
         usage
     );
@@ -77,6 +77,46 @@ void Mesh::setupVertexAttributes() {
         sizeof(Vertex),
         (void*)offsetof(Vertex, color)
     );
+
+    // layout(location = 2) normal
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(
+        2, 3, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex),
+        (void*)offsetof(Vertex, normal)
+    );
+
+    // layout(location = 3) uv
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(
+        3, 2, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex),
+        (void*)offsetof(Vertex, uv)
+    );
+
+    // layout(location = 4) tangent
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(
+        4, 4, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex),
+        (void*)offsetof(Vertex, tangent)
+    );
+
+    // layout(location = 5) material index
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(
+        5, 1, GL_UNSIGNED_INT,
+        sizeof(Vertex),
+        (void*)offsetof(Vertex, material)
+    );
+
+    // layout(location = 6) lightmap uv
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(
+        6, 2, GL_FLOAT, GL_FALSE,
+        sizeof(Vertex),
+        (void*)offsetof(Vertex, lightmapUV)
+    );
 }
 
 Mesh::~Mesh() {
@@ -116,3 +156,37 @@ void Mesh::draw() const {
 
     glBindVertexArray(0);
 }
+
+void Mesh::drawInstanced(GLsizei instances) const {
+    if (instances <= 0) return;
+
+    glBindVertexArray(m_vao);
+    if (m_indexed) {
+        glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void*)0, instances);
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, m_vertexCount, instances);
+    }
+    glBindVertexArray(0);
+}
+
+void Mesh::drawRangeInstanced(GLsizei firstIndex, GLsizei count, GLsizei instances) const {
+    if (!m_indexed || count <= 0 || instances <= 0) return;
+
+    glBindVertexArray(m_vao);
+    glDrawElementsInstanced(
+        GL_TRIANGLES,
+        count,
+        GL_UNSIGNED_INT,
+        (void*)(static_cast<uintptr_t>(firstIndex) * sizeof(uint32_t)),
+        instances
+    );
+    glBindVertexArray(0);
+}
+
+void Mesh::drawMulti(const GLsizei* counts, const void* const* offsets, GLsizei drawCount) const {
+    if (!m_indexed || drawCount <= 0) return;
+
+    glBindVertexArray(m_vao);
+    glMultiDrawElements(GL_TRIANGLES, counts, GL_UNSIGNED_INT, offsets, drawCount);
+    glBindVertexArray(0);
+}
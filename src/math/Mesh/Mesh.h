@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <span>
 #include <cstdint>
 
 #include <glad/glad.h>
@@ -9,11 +10,13 @@
 
 class Mesh {
 public:
-    explicit Mesh(const std::vector<Vertex>& vertices, GLenum usage = GL_STATIC_DRAW);
+    // Spans let callers upload straight from mapped files without a std::vector copy;
+    // vectors convert implicitly.
+    explicit Mesh(std::span<const Vertex> vertices, GLenum usage = GL_STATIC_DRAW);
 
     Mesh(
-        const std::vector<Vertex>& vertices,
-        const std::vector<uint32_t>& indices,
+        std::span<const Vertex> vertices,
+        std::span<const uint32_t> indices,
         GLenum usage = GL_STATIC_DRAW
     );
 
@@ -26,12 +29,21 @@ public:
     Mesh& operator=(Mesh&& other) noexcept;
 
     void draw() const;
+    // `instances` copies of the whole mesh / an index range, told apart by gl_InstanceID.
+    void drawInstanced(GLsizei instances) const;
+    void drawRangeInstanced(GLsizei firstIndex, GLsizei count, GLsizei instances) const;
+    // One glMultiDrawElements over index ranges given as byte offsets.
+    void drawMulti(const GLsizei* counts, const void* const* offsets, GLsizei drawCount) const;
 
     GLuint VAO() const { return m_vao; }
     bool isIndexed() const { return m_indexed; }
+    GLsizei vertexCount() const { return m_vertexCount; }
+    GLsizei indexCount() const { return m_indexCount; }
+
+    // Describes the Vertex layout for the currently bound VAO and GL_ARRAY_BUFFER.
+    static void setupVertexAttributes();
 
 private:
-    void setupVertexAttributes();
 
     GLuint m_vao = 0;
     GLuint m_vbo = 0;
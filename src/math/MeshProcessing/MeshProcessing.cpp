@@ -0,0 +1,228 @@
+#include "MeshProcessing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr size_t TRIANGLE_BATCH = 4096;
+    constexpr size_t VERTEX_BATCH = 8192;
+
+    // Corners (triangle * 3 + k) grouped by the vertex they reference.
+    struct CornerAdjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> corners;
+
+        CornerAdjacency(size_t vertexCount, std::span<const uint32_t> indices)
+            : offsets(vertexCount + 1, 0), corners(indices.size()) {
+            for (uint32_t index : indices) {
+                if (index < vertexCount) ++offsets[index + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                if (indices[i] < vertexCount) corners[cursor[indices[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+    };
+
+    float cornerAngle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+        glm::vec3 e0 = a - p;
+        glm::vec3 e1 = b - p;
+        float l0 = glm::length(e0);
+        float l1 = glm::length(e1);
+        if (l0 <= 0.0f || l1 <= 0.0f) return 0.0f;
+        return std::acos(std::clamp(glm::dot(e0, e1) / (l0 * l1), -1.0f, 1.0f));
+    }
+
+    bool validTriangle(std::span<const Vertex> vertices, const uint32_t* tri) {
+        return tri[0] < vertices.size() && tri[1] < vertices.size() && tri[2] < vertices.size();
+    }
+
+    glm::vec3 anyPerpendicular(const glm::vec3& n) {
+        glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(axis, n));
+    }
+}
+
+namespace MeshProcessing {
+    void computeNormals(std::span<Vertex> vertices, std::span<const uint32_t> indices, bool onlyMissing) {
+        size_t triangleCount = indices.size() / 3;
+        std::vector<glm::vec3> cornerNormals(triangleCount * 3, glm::vec3(0.0f));
+
+        Jobs::parallelFor(triangleCount, TRIANGLE_BATCH, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const uint32_t* tri = indices.data() + t * 3;
+                if (!validTriangle(vertices, tri)) continue;
+
+                glm::vec3 p0 = vertices[tri[0]].position;
+                glm::vec3 p1 = vertices[tri[1]].position;
+                glm::vec3 p2 = vertices[tri[2]].position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                float len = glm::length(n);
+                if (len <= 0.0f) continue;
+                n /= len;
+
+                cornerNormals[t * 3 + 0] = n * cornerAngle(p0, p1, p2);
+                cornerNormals[t * 3 + 1] = n * cornerAngle(p1, p2, p0);
+                cornerNormals[t * 3 + 2] = n * cornerAngle(p2, p0, p1);
+            }
+        });
+
+        CornerAdjacency adjacency(vertices.size(), indices);
+        Jobs::parallelFor(vertices.size(), VERTEX_BATCH, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                if (onlyMissing && glm::dot(vertices[v].normal, vertices[v].normal) > 0.0f) continue;
+
+                glm::vec3 sum(0.0f);
+                for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; ++a) {
+                    sum += cornerNormals[adjacency.corners[a]];
+                }
+                float len = glm::length(sum);
+                vertices[v].normal = len > 0.0f ? sum / len : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+        });
+    }
+
+    void generatePlanarUVs(std::span<Vertex> vertices, float scale) {
+        Jobs::parallelFor(vertices.size(), VERTEX_BATCH, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                Vertex& v = vertices[i];
+                glm::vec3 n = glm::abs(v.normal);
+                glm::vec3 p = v.position * scale;
+
+                // Orient each projection so textures read upright from the front side.
+                if (n.x >= n.y && n.x >= n.z) {
+                    v.uv = glm::vec2(v.normal.x > 0.0f ? -p.z : p.z, p.y);
+                } else if (n.z >= n.y) {
+                    v.uv = glm::vec2(v.normal.z > 0.0f ? p.x : -p.x, p.y);
+                } else {
+                    v.uv = glm::vec2(p.x, v.normal.y > 0.0f ? -p.z : p.z);
+                }
+            }
+        });
+    }
+
+    void computeTangents(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool onlyMissing) {
+        size_t triangleCount = indices.size() / 3;
+        size_t vertexCount = vertices.size();
+
+        // Unit tangent of the corner's triangle, its angle weight (0 for
+        // degenerate UVs) and the handedness it implies at that vertex.
+        struct CornerFrame {
+            glm::vec3 tangent;
+            float weight;
+            float sign;
+        };
+        std::vector<CornerFrame> corners(triangleCount * 3, {glm::vec3(0.0f), 0.0f, 0.0f});
+
+        Jobs::parallelFor(triangleCount, TRIANGLE_BATCH, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                const uint32_t* tri = indices.data() + t * 3;
+                if (!validTriangle(vertices, tri)) continue;
+
+                const Vertex& v0 = vertices[tri[0]];
+                const Vertex& v1 = vertices[tri[1]];
+                const Vertex& v2 = vertices[tri[2]];
+
+                glm::vec3 e1 = v1.position - v0.position;
+                glm::vec3 e2 = v2.position - v0.position;
+                glm::vec2 d1 = v1.uv - v0.uv;
+                glm::vec2 d2 = v2.uv - v0.uv;
+
+                float det = d1.x * d2.y - d2.x * d1.y;
+                if (std::abs(det) < 1e-12f) continue;
+                float r = 1.0f / det;
+
+                glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) * r;
+                glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) * r;
+                float tl = glm::length(tangent);
+                if (tl <= 0.0f) continue;
+                tangent /= tl;
+
+                // Like MikkTSpace, weight each corner by its angle so results do not
+                // depend on how a polygon was triangulated.
+                float weights[3] = {
+                    cornerAngle(v0.position, v1.position, v2.position),
+                    cornerAngle(v1.position, v2.position, v0.position),
+                    cornerAngle(v2.position, v0.position, v1.position)
+                };
+                for (int k = 0; k < 3; ++k) {
+                    const glm::vec3& n = vertices[tri[k]].normal;
+                    float sign = glm::dot(glm::cross(n, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+                    corners[t * 3 + k] = {tangent, weights[k], sign};
+                }
+            }
+        });
+
+        CornerAdjacency adjacency(vertexCount, indices);
+        auto skipped = [&](size_t v) { return onlyMissing && vertices[v].tangent.w != 0.0f; };
+
+        // A vertex shared by triangles of opposite handedness (mirrored UVs) gets
+        // a copy for its left-handed corners, as MikkTSpace does; a single
+        // tangent cannot serve both sides of the mirror.
+        std::vector<uint32_t> mirrored(vertexCount, 0);
+        Jobs::parallelFor(vertexCount, VERTEX_BATCH, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                if (skipped(v)) continue;
+                bool left = false, right = false;
+                for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; ++a) {
+                    const CornerFrame& corner = corners[adjacency.corners[a]];
+                    if (corner.weight <= 0.0f) continue;
+                    left |= corner.sign < 0.0f;
+                    right |= corner.sign > 0.0f;
+                }
+                mirrored[v] = left && right ? 1u : 0u;
+            }
+        });
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (!mirrored[v]) continue;
+            mirrored[v] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertices[v]);
+        }
+
+        Jobs::parallelFor(vertexCount, VERTEX_BATCH, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                if (skipped(v)) continue;
+
+                glm::vec3 n = vertices[v].normal;
+                float nl = glm::length(n);
+                n = nl > 0.0f ? n / nl : glm::vec3(0.0f, 1.0f, 0.0f);
+
+                // [0] right-handed (or all corners when not split), [1] the copy.
+                glm::vec3 sums[2] = {glm::vec3(0.0f), glm::vec3(0.0f)};
+                float handedness = 0.0f;
+                for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; ++a) {
+                    uint32_t c = adjacency.corners[a];
+                    const CornerFrame& corner = corners[c];
+                    if (corner.weight <= 0.0f) continue;
+
+                    int side = 0;
+                    if (mirrored[v] && corner.sign < 0.0f) {
+                        side = 1;
+                        indices[c] = mirrored[v];
+                    }
+                    // Orthogonalised per corner, before averaging.
+                    glm::vec3 t = corner.tangent - n * glm::dot(n, corner.tangent);
+                    float tl = glm::length(t);
+                    if (tl > 1e-8f) sums[side] += t * (corner.weight / tl);
+                    handedness += corner.sign * corner.weight;
+                }
+
+                auto finish = [&](const glm::vec3& sum) {
+                    float length = glm::length(sum);
+                    return length > 1e-8f ? sum / length : anyPerpendicular(n);
+                };
+                if (mirrored[v]) {
+                    vertices[v].tangent = glm::vec4(finish(sums[0]), 1.0f);
+                    vertices[mirrored[v]].tangent = glm::vec4(finish(sums[1]), -1.0f);
+                } else {
+                    vertices[v].tangent = glm::vec4(finish(sums[0]), handedness < 0.0f ? -1.0f : 1.0f);
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "math/Vertex.h"
+
+// Vertex attribute generation for imported and procedural meshes. All passes
+// run over triangle batches on the job pool: per-corner contributions are
+// computed in parallel, then gathered per vertex through a vertex->corner
+// adjacency so the result does not depend on thread count.
+namespace MeshProcessing {
+    // Angle-weighted vertex normals from the triangle winding (counter-clockwise
+    // is the front face). With `onlyMissing`, vertices that already have a normal
+    // are left untouched.
+    void computeNormals(
+        std::span<Vertex> vertices,
+        std::span<const uint32_t> indices,
+        bool onlyMissing = false
+    );
+
+    // Planar UVs for procedural geometry: each vertex is projected onto the plane
+    // most aligned with its normal, in world units times `scale`.
+    void generatePlanarUVs(std::span<Vertex> vertices, float scale = 1.0f);
+
+    // Tangents following MikkTSpace's rules: per-triangle frames from the UV
+    // gradients, orthogonalised against the vertex normal per corner and
+    // angle-weighted. Vertices whose triangles disagree on handedness (mirrored
+    // UVs) are split, appending vertices and rewriting `indices`; UV seams are
+    // already separate vertices. Not bit-identical to the reference library, so
+    // maps baked against it may differ slightly. tangent.w holds the bitangent
+    // sign (+1 or -1). With `onlyMissing`, vertices that already have a tangent
+    // (w != 0) are left untouched.
+    void computeTangents(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, bool onlyMissing = false);
+}
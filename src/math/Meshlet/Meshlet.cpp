@@ -0,0 +1,239 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr size_t CULL_CHUNK = 256;
+    constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+
+    glm::vec3 triangleNormal(std::span<const Vertex> vertices, const uint32_t* tri) {
+        glm::vec3 a = vertices[tri[0]].position;
+        glm::vec3 b = vertices[tri[1]].position;
+        glm::vec3 c = vertices[tri[2]].position;
+        return glm::cross(b - a, c - a);
+    }
+
+    void computeBounds(
+        std::span<const Vertex> vertices,
+        std::span<const uint32_t> indices,
+        Meshlet& m
+    ) {
+        const uint32_t* tris = indices.data() + m.firstIndex;
+        size_t indexCount = static_cast<size_t>(m.triangleCount) * 3;
+
+        glm::vec3 lo(std::numeric_limits<float>::max());
+        glm::vec3 hi(-std::numeric_limits<float>::max());
+        for (size_t i = 0; i < indexCount; ++i) {
+            lo = glm::min(lo, vertices[tris[i]].position);
+            hi = glm::max(hi, vertices[tris[i]].position);
+        }
+        m.center = (lo + hi) * 0.5f;
+        m.radius = 0.0f;
+        for (size_t i = 0; i < indexCount; ++i) {
+            m.radius = std::max(m.radius, glm::length(vertices[tris[i]].position - m.center));
+        }
+
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < m.triangleCount; ++t) {
+            glm::vec3 n = triangleNormal(vertices, tris + t * 3);
+            float len = glm::length(n);
+            if (len > 0.0f) axis += n / len;
+        }
+
+        m.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        m.coneCutoff = 1.0f;
+        float axisLength = glm::length(axis);
+        if (axisLength <= 0.0f) return;
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        for (uint32_t t = 0; t < m.triangleCount; ++t) {
+            glm::vec3 n = triangleNormal(vertices, tris + t * 3);
+            float len = glm::length(n);
+            if (len > 0.0f) minDot = std::min(minDot, glm::dot(n / len, axis));
+        }
+
+        // Wider than ~84 degrees of spread can never be culled as a whole.
+        m.coneAxis = axis;
+        if (minDot > 0.1f) m.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+namespace Meshlets {
+    MeshletMesh build(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+        MeshletMesh out;
+        size_t triangleCount = indices.size() / 3;
+        out.indices.reserve(triangleCount * 3);
+        if (triangleCount == 0 || vertices.empty()) return out;
+
+        // Vertex -> triangle adjacency (CSR).
+        std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; ++i) ++offsets[indices[i] + 1];
+        for (size_t v = 0; v < vertices.size(); ++v) offsets[v + 1] += offsets[v];
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; ++i) {
+                adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<uint8_t> used(triangleCount, 0);
+        // Local slot of each vertex in the current meshlet, UNUSED otherwise.
+        std::vector<uint32_t> slot(vertices.size(), UNUSED);
+        std::vector<uint32_t> local;
+        local.reserve(MAX_VERTICES);
+
+        size_t seed = 0;
+        for (;;) {
+            while (seed < triangleCount && used[seed]) ++seed;
+            if (seed >= triangleCount) break;
+
+            Meshlet m{};
+            m.firstIndex = static_cast<uint32_t>(out.indices.size());
+            glm::vec3 centroid(0.0f);
+
+            auto addTriangle = [&](size_t t) {
+                used[t] = 1;
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t v = indices[t * 3 + k];
+                    if (slot[v] == UNUSED) {
+                        slot[v] = static_cast<uint32_t>(local.size());
+                        local.push_back(v);
+                        centroid += vertices[v].position;
+                    }
+                    out.indices.push_back(v);
+                }
+                ++m.triangleCount;
+            };
+            auto newVertices = [&](size_t t) {
+                uint32_t n = 0;
+                for (int k = 0; k < 3; ++k) n += slot[indices[t * 3 + k]] == UNUSED ? 1u : 0u;
+                return n;
+            };
+
+            addTriangle(seed);
+
+            // Grow through shared vertices, preferring triangles that add the fewest
+            // new vertices and then the ones closest to the cluster centre.
+            while (m.triangleCount < MAX_TRIANGLES) {
+                glm::vec3 center = centroid / static_cast<float>(local.size());
+                size_t best = triangleCount;
+                uint32_t bestNew = 4;
+                float bestDistance = std::numeric_limits<float>::max();
+
+                for (uint32_t v : local) {
+                    for (uint32_t a = offsets[v]; a < offsets[v + 1]; ++a) {
+                        uint32_t t = adjacency[a];
+                        if (used[t]) continue;
+
+                        uint32_t extra = newVertices(t);
+                        if (local.size() + extra > MAX_VERTICES || extra > bestNew) continue;
+
+                        const uint32_t* tri = indices.data() + static_cast<size_t>(t) * 3;
+                        glm::vec3 tc = (vertices[tri[0]].position + vertices[tri[1]].position + vertices[tri[2]].position) / 3.0f;
+                        glm::vec3 d = tc - center;
+                        float distance = glm::dot(d, d);
+                        if (extra < bestNew || distance < bestDistance) {
+                            best = t;
+                            bestNew = extra;
+                            bestDistance = distance;
+                        }
+                    }
+                }
+
+                if (best == triangleCount) break;
+                addTriangle(best);
+            }
+
+            m.vertexCount = static_cast<uint32_t>(local.size());
+            for (uint32_t v : local) slot[v] = UNUSED;
+            local.clear();
+
+            out.meshlets.push_back(m);
+        }
+
+        Jobs::parallelFor(out.meshlets.size(), 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) computeBounds(vertices, out.indices, out.meshlets[i]);
+        });
+
+        return out;
+    }
+
+    void cull(
+        std::span<const Meshlet> meshlets,
+        const glm::mat4& model,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition,
+        bool coneCulling,
+        MeshletDrawList& out
+    ) {
+        out.clear();
+        if (meshlets.empty()) return;
+
+        glm::mat3 linear(model);
+        float scale = std::sqrt(std::max({
+            glm::dot(linear[0], linear[0]),
+            glm::dot(linear[1], linear[1]),
+            glm::dot(linear[2], linear[2])
+        }));
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+
+        struct Range {
+            uint32_t firstIndex;
+            uint32_t indexCount;
+        };
+
+        size_t chunkCount = (meshlets.size() + CULL_CHUNK - 1) / CULL_CHUNK;
+        std::vector<std::vector<Range>> chunkRanges(chunkCount);
+
+        Jobs::parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                auto& ranges = chunkRanges[chunk];
+                size_t first = chunk * CULL_CHUNK;
+                size_t last = std::min(first + CULL_CHUNK, meshlets.size());
+
+                for (size_t i = first; i < last; ++i) {
+                    const Meshlet& m = meshlets[i];
+                    glm::vec3 center = glm::vec3(model * glm::vec4(m.center, 1.0f));
+                    float radius = m.radius * scale;
+
+                    if (!frustum.intersectsSphere(center, radius)) continue;
+
+                    if (coneCulling && m.coneCutoff < 1.0f) {
+                        glm::vec3 axis = glm::normalize(normalMatrix * m.coneAxis);
+                        glm::vec3 view = center - cameraPosition;
+                        if (glm::dot(view, axis) >= m.coneCutoff * glm::length(view) + radius) continue;
+                    }
+
+                    uint32_t count = m.triangleCount * 3;
+                    if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == m.firstIndex) {
+                        ranges.back().indexCount += count;
+                    } else {
+                        ranges.push_back({m.firstIndex, count});
+                    }
+                }
+            }
+        });
+
+        for (const auto& ranges : chunkRanges) {
+            for (const Range& r : ranges) {
+                out.triangleCount += r.indexCount / 3;
+                if (!out.counts.empty()) {
+                    size_t lastEnd = reinterpret_cast<uintptr_t>(out.offsets.back()) / sizeof(uint32_t)
+                                   + static_cast<size_t>(out.counts.back());
+                    if (lastEnd == r.firstIndex) {
+                        out.counts.back() += static_cast<GLsizei>(r.indexCount);
+                        continue;
+                    }
+                }
+                out.counts.push_back(static_cast<GLsizei>(r.indexCount));
+                out.offsets.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(r.firstIndex) * sizeof(uint32_t)));
+            }
+        }
+    }
+}
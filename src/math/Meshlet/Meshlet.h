@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "math/Frustum/Frustum.h"
+#include "math/Vertex.h"
+
+// A cluster of up to MAX_VERTICES unique vertices and MAX_TRIANGLES triangles.
+// Its triangles occupy [firstIndex, firstIndex + triangleCount * 3) of the
+// meshlet-ordered index buffer, so any subset can be drawn with one multi-draw.
+struct Meshlet {
+    uint32_t firstIndex;
+    uint32_t triangleCount;
+    uint32_t vertexCount;
+
+    glm::vec3 center;
+    float radius;
+
+    // Backface cone: the cluster faces away from every viewer inside
+    // dot(normalize(center - eye), coneAxis) >= coneCutoff (adjusted by radius).
+    // coneCutoff >= 1 disables the test.
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+struct MeshletMesh {
+    std::vector<Meshlet> meshlets;
+    // Meshlet-ordered triangle list; same triangles as the source indices.
+    std::vector<uint32_t> indices;
+};
+
+// Compacted index ranges ready for glMultiDrawElements.
+struct MeshletDrawList {
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    size_t triangleCount = 0;
+
+    void clear() {
+        counts.clear();
+        offsets.clear();
+        triangleCount = 0;
+    }
+};
+
+namespace Meshlets {
+    constexpr uint32_t MAX_VERTICES = 64;
+    constexpr uint32_t MAX_TRIANGLES = 124;
+
+    MeshletMesh build(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+
+    // Tests every meshlet against the frustum and (if enabled) its backface cone,
+    // in parallel chunks. Adjacent visible meshlets are merged into one range.
+    void cull(
+        std::span<const Meshlet> meshlets,
+        const glm::mat4& model,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition,
+        bool coneCulling,
+        MeshletDrawList& out
+    );
+}
@@ -0,0 +1,154 @@
+#include "PortalGraph.h"
+
+#include <algorithm>
+
+namespace {
+    // Portals this close to the eye are passed regardless of which side it is on,
+    // so standing in a doorway still sees both rooms.
+    constexpr float PLANE_EPSILON = 0.05f;
+
+    bool isEmpty(const glm::vec4& r) {
+        return r.x >= r.z || r.y >= r.w;
+    }
+
+    bool containsRect(const glm::vec4& outer, const glm::vec4& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.z <= outer.z && inner.w <= outer.w;
+    }
+}
+
+uint32_t PortalGraph::addCell(const glm::vec3& min, const glm::vec3& max) {
+    m_cells.push_back({min, max, {}});
+    return static_cast<uint32_t>(m_cells.size() - 1);
+}
+
+void PortalGraph::addPortal(const glm::vec3 corners[4], uint32_t a, uint32_t b) {
+    Portal p;
+    std::copy(corners, corners + 4, p.corners);
+    p.cells[0] = a;
+    p.cells[1] = b;
+
+    glm::vec3 n = glm::normalize(glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+    glm::vec3 centerA = (m_cells[a].min + m_cells[a].max) * 0.5f;
+    if (glm::dot(centerA - corners[0], n) < 0.0f) n = -n;
+    p.plane = glm::vec4(n, -glm::dot(n, corners[0]));
+
+    uint32_t index = static_cast<uint32_t>(m_portals.size());
+    m_portals.push_back(p);
+    m_cells[a].portals.push_back(index);
+    if (b != OUTSIDE) m_cells[b].portals.push_back(index);
+}
+
+uint32_t PortalGraph::findCell(const glm::vec3& point) const {
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        const Cell& c = m_cells[i];
+        if (glm::all(glm::greaterThanEqual(point, c.min)) && glm::all(glm::lessThanEqual(point, c.max))) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return OUTSIDE;
+}
+
+void PortalGraph::traverse(
+    const glm::mat4& viewProjection,
+    const glm::vec3& eye,
+    uint32_t start,
+    std::vector<VisibleCell>& out,
+    Scratch& scratch
+) const {
+    out.clear();
+    scratch.depth.clear();
+    scratch.queued.clear();
+    scratch.queue.clear();
+    if (start >= m_cells.size()) return;
+    if (scratch.slot.size() != m_cells.size()) scratch.slot.assign(m_cells.size(), OUTSIDE);
+
+    reach(start, glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f), 0, out, scratch);
+
+    // A rectangle only grows, and only to bounds taken from portal rectangles,
+    // so each cell is queued a bounded number of times.
+    for (size_t head = 0; head < scratch.queue.size(); ++head) {
+        uint32_t slot = scratch.queue[head];
+        scratch.queued[slot] = 0;
+        uint32_t depth = scratch.depth[slot];
+        if (depth >= MAX_DEPTH) continue;
+
+        uint32_t cell = out[slot].cell;
+        glm::vec4 rect = out[slot].rect;
+        for (uint32_t index : m_cells[cell].portals) {
+            const Portal& portal = m_portals[index];
+            uint32_t next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+            if (next == OUTSIDE) continue;
+
+            // The eye has to be on this cell's side of the portal.
+            float distance = glm::dot(glm::vec3(portal.plane), eye) + portal.plane.w;
+            if (portal.cells[0] != cell) distance = -distance;
+            if (distance < -PLANE_EPSILON) continue;
+
+            glm::vec4 portalRect;
+            if (distance < PLANE_EPSILON) {
+                portalRect = rect;
+            } else {
+                if (!projectPortal(portal, viewProjection, portalRect)) continue;
+                portalRect = glm::vec4(
+                    std::max(portalRect.x, rect.x), std::max(portalRect.y, rect.y),
+                    std::min(portalRect.z, rect.z), std::min(portalRect.w, rect.w)
+                );
+                if (isEmpty(portalRect)) continue;
+            }
+
+            reach(next, portalRect, depth + 1, out, scratch);
+        }
+    }
+
+    for (const VisibleCell& v : out) scratch.slot[v.cell] = OUTSIDE;
+}
+
+void PortalGraph::reach(uint32_t cell, const glm::vec4& rect, uint32_t depth, std::vector<VisibleCell>& out, Scratch& scratch) {
+    uint32_t& slot = scratch.slot[cell];
+    if (slot == OUTSIDE) {
+        slot = static_cast<uint32_t>(out.size());
+        out.push_back({cell, rect});
+        scratch.depth.push_back(depth);
+        scratch.queued.push_back(1);
+        scratch.queue.push_back(slot);
+        return;
+    }
+
+    // Already seen through a rectangle at least this large: nothing new behind it.
+    glm::vec4& seen = out[slot].rect;
+    if (containsRect(seen, rect)) return;
+    seen = glm::vec4(glm::min(glm::vec2(seen), glm::vec2(rect)), glm::max(glm::vec2(seen.z, seen.w), glm::vec2(rect.z, rect.w)));
+    scratch.depth[slot] = std::min(scratch.depth[slot], depth);
+    if (!scratch.queued[slot]) {
+        scratch.queued[slot] = 1;
+        scratch.queue.push_back(slot);
+    }
+}
+
+bool PortalGraph::projectPortal(const Portal& portal, const glm::mat4& viewProjection, glm::vec4& rect) const {
+    glm::vec4 clip[4];
+    for (int i = 0; i < 4; ++i) clip[i] = viewProjection * glm::vec4(portal.corners[i], 1.0f);
+
+    // Clip the quad against the near plane (z >= -w) before dividing.
+    glm::vec4 poly[8];
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        const glm::vec4& a = clip[i];
+        const glm::vec4& b = clip[(i + 1) % 4];
+        float da = a.z + a.w;
+        float db = b.z + b.w;
+        if (da >= 0.0f) poly[count++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f)) poly[count++] = a + (b - a) * (da / (da - db));
+    }
+    if (count == 0) return false;
+
+    glm::vec2 lo(1.0f), hi(-1.0f);
+    for (int i = 0; i < count; ++i) {
+        glm::vec2 ndc = glm::vec2(poly[i]) / std::max(poly[i].w, 1e-6f);
+        lo = glm::min(lo, ndc);
+        hi = glm::max(hi, ndc);
+    }
+
+    rect = glm::vec4(glm::max(lo, glm::vec2(-1.0f)), glm::min(hi, glm::vec2(1.0f)));
+    return !isEmpty(rect);
+}
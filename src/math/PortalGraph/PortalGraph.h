@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Cells (convex rooms) connected by portals (planar quads such as doors and
+// windows). Visibility is found by walking breadth-first from the camera's cell
+// through every portal whose screen rectangle overlaps the rectangle it was
+// reached through, so the cost follows what is visible rather than the size of
+// the graph. A cell reached again is merged into one rectangle and only walked
+// again if that rectangle grew.
+class PortalGraph {
+public:
+    static constexpr uint32_t OUTSIDE = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t MAX_DEPTH = 32;
+
+    // Screen rectangle in NDC: (minX, minY, maxX, maxY).
+    struct VisibleCell {
+        uint32_t cell;
+        glm::vec4 rect;
+    };
+
+    // `min`/`max` bound the space that counts as inside the cell; make them cover
+    // the doorways so a camera standing in one still finds a cell.
+    uint32_t addCell(const glm::vec3& min, const glm::vec3& max);
+    // Corners in winding order. `b` may be OUTSIDE.
+    void addPortal(const glm::vec3 corners[4], uint32_t a, uint32_t b);
+
+    size_t cellCount() const { return m_cells.size(); }
+    size_t portalCount() const { return m_portals.size(); }
+
+    // Returns OUTSIDE if `point` is in no cell.
+    uint32_t findCell(const glm::vec3& point) const;
+
+    // Working memory for traverse(), kept between calls to avoid reallocating.
+    // The graph itself is not modified, so threads may traverse it at the same
+    // time as long as each has its own Scratch.
+    struct Scratch {
+        // Index into `out` per cell, or OUTSIDE.
+        std::vector<uint32_t> slot;
+        // Per `out` entry.
+        std::vector<uint32_t> depth;
+        std::vector<uint8_t> queued;
+        std::vector<uint32_t> queue;
+    };
+
+    // Fills `out` with every cell visible from `eye` (which must be in `start`)
+    // and the screen rectangle it is seen through. OUTSIDE is never reported.
+    void traverse(
+        const glm::mat4& viewProjection,
+        const glm::vec3& eye,
+        uint32_t start,
+        std::vector<VisibleCell>& out,
+        Scratch& scratch
+    ) const;
+
+private:
+    struct Cell {
+        glm::vec3 min;
+        glm::vec3 max;
+        std::vector<uint32_t> portals;
+    };
+
+    struct Portal {
+        glm::vec3 corners[4];
+        uint32_t cells[2];
+        // Oriented to face into cells[0].
+        glm::vec4 plane;
+    };
+
+    static void reach(uint32_t cell, const glm::vec4& rect, uint32_t depth, std::vector<VisibleCell>& out, Scratch& scratch);
+    bool projectPortal(const Portal& portal, const glm::mat4& viewProjection, glm::vec4& rect) const;
+
+    std::vector<Cell> m_cells;
+    std::vector<Portal> m_portals;
+};
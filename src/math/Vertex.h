@@ -1,8 +1,18 @@
 #pragma once
 
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
 struct Vertex {
     glm::vec3 position;
     glm::vec3 color;
+    glm::vec3 normal = glm::vec3(0.0f);
+    glm::vec2 uv = glm::vec2(0.0f);
+    // xyz = tangent, w = bitangent sign.
+    glm::vec4 tangent = glm::vec4(0.0f);
+    // Index into the MaterialTable the mesh is drawn with.
+    uint32_t material = 0;
+    // Position in the lightmap atlas, written by LightmapPacker.
+    glm::vec2 lightmapUV = glm::vec2(0.0f);
 };
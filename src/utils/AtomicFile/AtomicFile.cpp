@@ -0,0 +1,60 @@
+#include "AtomicFile.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<unsigned> g_counter{0};
+
+    unsigned long processId() {
+#if defined(_WIN32)
+        return static_cast<unsigned long>(_getpid());
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+}
+
+namespace AtomicFile {
+    std::string tempPathFor(const std::string& path) {
+        return path + "." + std::to_string(processId()) + "." + std::to_string(g_counter.fetch_add(1)) + ".tmp";
+    }
+
+    bool write(const std::string& path, std::span<const std::byte> bytes, const char* owner) {
+        std::string tmpPath = tempPathFor(path);
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                std::cerr << owner << ": failed to open " << tmpPath << " for writing\n";
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            // Closed here rather than by the destructor: the final flush can fail
+            // too (a full disk), and then the partial file must not be renamed.
+            out.close();
+            if (!out) {
+                std::cerr << owner << ": failed to write " << tmpPath << "\n";
+                std::error_code ec;
+                std::filesystem::remove(tmpPath, ec);
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            std::cerr << owner << ": failed to replace " << path << ": " << ec.message() << "\n";
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Whole-file writes that readers never see half-done. The bytes go to a
+// temporary file next to `path`, named uniquely per process and call, which
+// then replaces `path` in one rename. Concurrent writers of the same path
+// each finish their own file and the last rename wins.
+namespace AtomicFile {
+    // `owner` prefixes error messages, e.g. "MeshCache".
+    bool write(const std::string& path, std::span<const std::byte> bytes, const char* owner);
+
+    std::string tempPathFor(const std::string& path);
+}
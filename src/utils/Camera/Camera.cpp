@@ -11,18 +11,18 @@ Camera::Camera(
     float nearPlane,
     float farPlane
 )
-    : position(position),
-      worldUp(worldUp),
-      fov(fovDeg),
-      aspect(aspect),
-      nearPlane(nearPlane),
-      farPlane(farPlane)
+    : m_position(position),
+      m_worldUp(worldUp),
+      m_fov(fovDeg),
+      m_aspect(aspect),
+      m_nearPlane(nearPlane),
+      m_farPlane(farPlane)
 {
-    front = glm::normalize(target - position);
+    m_front = glm::normalize(target - position);
 
-    yaw   = glm::degrees(std::atan2(front.z, front.x));
-    float lenXZ = std::sqrt(front.x * front.x + front.z * front.z);
-    pitch = glm::degrees(std::atan2(front.y, lenXZ));
+    m_yaw = glm::degrees(std::atan2(m_front.z, m_front.x));
+    float lenXZ = std::sqrt(m_front.x * m_front.x + m_front.z * m_front.z);
+    m_pitch = glm::degrees(std::atan2(m_front.y, lenXZ));
 
     updateVectors();
 }
@@ -37,78 +37,116 @@ Camera::Camera(
     float nearPlane,
     float farPlane
 )
-    : position(position),
-      worldUp(worldUp),
-      yaw(yawDeg),
-      pitch(pitchDeg),
-      fov(fovDeg),
-      aspect(aspect),
-      nearPlane(nearPlane),
-      farPlane(farPlane)
+    : m_position(position),
+      m_worldUp(worldUp),
+      m_yaw(yawDeg),
+      m_pitch(pitchDeg),
+      m_fov(fovDeg),
+      m_aspect(aspect),
+      m_nearPlane(nearPlane),
+      m_farPlane(farPlane)
 {
     updateVectors();
 }
 
-glm::mat4 Camera::getViewMatrix() const {
-    return glm::lookAt(position, position + front, up);
+const glm::mat4& Camera::getViewMatrix() const {
+    if (m_viewDirty) {
+        m_view = glm::lookAt(m_position, m_position + m_front, m_up);
+        m_viewDirty = false;
+        m_frustumDirty = true;
+    }
+    return m_view;
 }
 
-glm::mat4 Camera::getProjectionMatrix() const {
-    return glm::perspective(glm::radians(fov), aspect, nearPlane, farPlane);
+const glm::mat4& Camera::getProjectionMatrix() const {
+    if (m_projectionDirty) {
+        m_projection = glm::perspective(glm::radians(m_fov), m_aspect, m_nearPlane, m_farPlane);
+        m_projectionDirty = false;
+        m_frustumDirty = true;
+    }
+    return m_projection;
+}
+
+const glm::mat4& Camera::getViewProjectionMatrix() const {
+    getViewMatrix();
+    getProjectionMatrix();
+    if (m_frustumDirty) {
+        m_viewProjection = m_projection * m_view;
+        m_frustum = Frustum::fromMatrix(m_viewProjection);
+        m_frustumDirty = false;
+    }
+    return m_viewProjection;
+}
+
+const Frustum& Camera::frustum() const {
+    getViewProjectionMatrix();
+    return m_frustum;
+}
+
+void Camera::setPosition(const glm::vec3& position) {
+    if (m_position == position) return;
+    m_position = position;
+    m_viewDirty = true;
 }
 
 void Camera::setAspect(float aspect) {
-    this->aspect = aspect;
+    if (m_aspect == aspect) return;
+    m_aspect = aspect;
+    m_projectionDirty = true;
 }
 
 void Camera::setPerspective(float fovDeg, float nearPlane, float farPlane) {
-    this->fov = fovDeg;
-    this->nearPlane = nearPlane;
-    this->farPlane = farPlane;
+    m_fov = fovDeg;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    m_projectionDirty = true;
 }
 
 void Camera::processKeyboard(CameraMovement direction, float deltaTime, float speed) {
     float velocity = speed * deltaTime;
+    m_viewDirty = true;
     if (direction == CameraMovement::Forward)
-        position += front * velocity;
+        m_position += m_front * velocity;
     if (direction == CameraMovement::Backward)
-        position -= front * velocity;
+        m_position -= m_front * velocity;
     if (direction == CameraMovement::Left)
-        position -= right * velocity;
+        m_position -= m_right * velocity;
     if (direction == CameraMovement::Right)
-        position += right * velocity;
+        m_position += m_right * velocity;
     if (direction == CameraMovement::Up)
-        position += worldUp * velocity;
+        m_position += m_worldUp * velocity;
     if (direction == CameraMovement::Down)
-        position -= worldUp * velocity;
+        m_position -= m_worldUp * velocity;
 }
 
 void Camera::processMouseMovement(float xOffset, float yOffset, float sensitivity) {
     xOffset *= sensitivity;
     yOffset *= sensitivity;
 
-    yaw += xOffset;
-    pitch += yOffset;
+    m_yaw += xOffset;
+    m_pitch += yOffset;
 
-    pitch = std::clamp(pitch, -89.0f, 89.0f);
+    m_pitch = std::clamp(m_pitch, -89.0f, 89.0f);
 
     updateVectors();
 }
 
 void Camera::processMouseScroll(float yOffset) {
-    fov -= yOffset;
-    fov = std::clamp(fov, 10.0f, 90.0f);
+    m_fov -= yOffset;
+    m_fov = std::clamp(m_fov, 10.0f, 90.0f);
+    m_projectionDirty = true;
 }
 
 void Camera::updateVectors() {
-    float yawRad   = glm::radians(yaw);
-    float pitchRad = glm::radians(pitch);
+    float yawRad   = glm::radians(m_yaw);
+    float pitchRad = glm::radians(m_pitch);
 
-    front.x = std::cos(pitchRad) * std::cos(yawRad);
-    front.y = std::sin(pitchRad);
-    front.z = std::cos(pitchRad) * std::sin(yawRad);
-    front = glm::normalize(front);
+    m_front.x = std::cos(pitchRad) * std::cos(yawRad);
+    m_front.y = std::sin(pitchRad);
+    m_front.z = std::cos(pitchRad) * std::sin(yawRad);
+    m_front = glm::normalize(m_front);
 
-    right = glm::normalize(glm::cross(front, worldUp));
-    up = glm::normalize(glm::cross(right, front));
+    m_right = glm::normalize(glm::cross(m_front, m_worldUp));
+    m_up = glm::normalize(glm::cross(m_right, m_front));
+    m_viewDirty = true;
 }
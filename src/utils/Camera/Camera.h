@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "math/Frustum/Frustum.h"
+
 enum class CameraMovement {
     Forward,
     Backward,
@@ -14,20 +16,6 @@ enum class CameraMovement {
 
 class Camera {
 public:
-    glm::vec3 position;
-    glm::vec3 front;
-    glm::vec3 up;
-    glm::vec3 right;
-    glm::vec3 worldUp;
-
-    float yaw;
-    float pitch;
-
-    float fov;
-    float aspect;
-    float nearPlane;
-    float farPlane;
-
     Camera(
         glm::vec3 position,
         glm::vec3 target,
@@ -49,9 +37,25 @@ public:
         float farPlane = 1000.0f
     );
 
-    glm::mat4 getViewMatrix() const;
-    glm::mat4 getProjectionMatrix() const;
+    const glm::vec3& position() const { return m_position; }
+    const glm::vec3& front() const { return m_front; }
+    const glm::vec3& up() const { return m_up; }
+    const glm::vec3& right() const { return m_right; }
+    const glm::vec3& worldUp() const { return m_worldUp; }
+    float yaw() const { return m_yaw; }
+    float pitch() const { return m_pitch; }
+    float fov() const { return m_fov; }
+    float aspect() const { return m_aspect; }
+    float nearPlane() const { return m_nearPlane; }
+    float farPlane() const { return m_farPlane; }
+
+    // Cached; rebuilt on first use after the camera changed.
+    const glm::mat4& getViewMatrix() const;
+    const glm::mat4& getProjectionMatrix() const;
+    const glm::mat4& getViewProjectionMatrix() const;
+    const Frustum& frustum() const;
 
+    void setPosition(const glm::vec3& position);
     void setAspect(float aspect);
     void setPerspective(float fovDeg, float nearPlane, float farPlane);
 
@@ -63,4 +67,26 @@ public:
 
 private:
     void updateVectors();
+
+    glm::vec3 m_position;
+    glm::vec3 m_front;
+    glm::vec3 m_up;
+    glm::vec3 m_right;
+    glm::vec3 m_worldUp;
+
+    float m_yaw;
+    float m_pitch;
+
+    float m_fov;
+    float m_aspect;
+    float m_nearPlane;
+    float m_farPlane;
+
+    mutable glm::mat4 m_view;
+    mutable glm::mat4 m_projection;
+    mutable glm::mat4 m_viewProjection;
+    mutable Frustum m_frustum;
+    mutable bool m_viewDirty = true;
+    mutable bool m_projectionDirty = true;
+    mutable bool m_frustumDirty = true;
 };
@@ -0,0 +1,311 @@
+#include "ClusteredLights.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr uint32_t TILES = ClusteredLights::TILES_X * ClusteredLights::TILES_Y;
+    constexpr size_t LIGHT_GRAIN = 256;
+
+    enum Buffer { LIGHT_DATA = 0, CLUSTERS = 1, INDICES = 2 };
+
+    // Bounding sphere of a cone: the circumsphere of the cap for wide cones,
+    // otherwise the sphere through the apex and the cap rim.
+    void spotBounds(const Light& light, glm::vec3& center, float& radius) {
+        glm::vec3 direction = glm::normalize(light.direction);
+        float cosAngle = std::cos(light.outerAngle);
+        if (light.outerAngle > 0.785398f) {
+            center = light.position + direction * (light.range * cosAngle);
+            radius = light.range * std::sin(light.outerAngle);
+        } else {
+            radius = light.range / (2.0f * cosAngle);
+            center = light.position + direction * radius;
+        }
+    }
+
+    bool sphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& min, const glm::vec3& max) {
+        glm::vec3 closest = glm::clamp(center, min, max);
+        glm::vec3 d = center - closest;
+        return glm::dot(d, d) <= radius * radius;
+    }
+
+    uint16_t tileOf(float ndc, uint32_t tiles) {
+        float t = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(tiles));
+        return static_cast<uint16_t>(std::clamp(t, 0.0f, static_cast<float>(tiles - 1)));
+    }
+
+    // NDC range covered by [lo, hi] on one view axis for depths in [nearDepth, farDepth].
+    void projectRange(float lo, float hi, float nearDepth, float farDepth, float tanHalf, float& ndcMin, float& ndcMax) {
+        ndcMin = lo / ((lo < 0.0f ? nearDepth : farDepth) * tanHalf);
+        ndcMax = hi / ((hi > 0.0f ? nearDepth : farDepth) * tanHalf);
+    }
+}
+
+ClusteredLights::ClusteredLights() {
+    m_clusters.assign(CLUSTER_COUNT, glm::uvec2(0));
+    m_clusterCounts.assign(CLUSTER_COUNT, 0);
+    m_slicePairs.resize(SLICES);
+}
+
+ClusteredLights::~ClusteredLights() {
+    if (m_textures[0]) glDeleteTextures(3, m_textures);
+    if (m_buffers[0]) glDeleteBuffers(3, m_buffers);
+}
+
+uint32_t ClusteredLights::add(const Light& light) {
+    m_lights.push_back(light);
+    m_shadowLayers.push_back(-1);
+    return static_cast<uint32_t>(m_lights.size() - 1);
+}
+
+void ClusteredLights::clear() {
+    m_lights.clear();
+    m_shadowLayers.clear();
+}
+
+void ClusteredLights::setSun(const glm::vec3& direction, const glm::vec3& color) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+}
+
+void ClusteredLights::buildClusterBoxes(const Camera& camera) {
+    const glm::mat4& projection = camera.getProjectionMatrix();
+    float tanX = 1.0f / projection[0][0];
+    float tanY = 1.0f / projection[1][1];
+    float ratio = camera.farPlane() / camera.nearPlane();
+
+    m_clusterBoxes.resize(CLUSTER_COUNT);
+    for (uint32_t z = 0; z < SLICES; ++z) {
+        float nearDepth = camera.nearPlane() * std::pow(ratio, static_cast<float>(z) / SLICES);
+        float farDepth = camera.nearPlane() * std::pow(ratio, static_cast<float>(z + 1) / SLICES);
+        for (uint32_t y = 0; y < TILES_Y; ++y) {
+            float y0 = (2.0f * y / TILES_Y - 1.0f) * tanY;
+            float y1 = (2.0f * (y + 1) / TILES_Y - 1.0f) * tanY;
+            for (uint32_t x = 0; x < TILES_X; ++x) {
+                float x0 = (2.0f * x / TILES_X - 1.0f) * tanX;
+                float x1 = (2.0f * (x + 1) / TILES_X - 1.0f) * tanX;
+                // The tile's side planes pass through the eye, so the box spans
+                // the corner rays at both slice depths.
+                ClusterBox& box = m_clusterBoxes[(z * TILES_Y + y) * TILES_X + x];
+                box.min = glm::vec3(
+                    std::min(x0 * nearDepth, x0 * farDepth),
+                    std::min(y0 * nearDepth, y0 * farDepth),
+                    -farDepth
+                );
+                box.max = glm::vec3(
+                    std::max(x1 * nearDepth, x1 * farDepth),
+                    std::max(y1 * nearDepth, y1 * farDepth),
+                    -nearDepth
+                );
+            }
+        }
+    }
+}
+
+void ClusteredLights::update(const Camera& camera, int width, int height, bool upload) {
+    const glm::mat4& view = camera.getViewMatrix();
+    const glm::mat4& projection = camera.getProjectionMatrix();
+    const Frustum& frustum = camera.frustum();
+    float nearPlane = camera.nearPlane();
+    float farPlane = camera.farPlane();
+
+    if (projection != m_boxProjection) {
+        buildClusterBoxes(camera);
+        m_boxProjection = projection;
+    }
+
+    float logRatio = std::log(farPlane / nearPlane);
+    float sliceScale = SLICES / logRatio;
+    m_depthScaleBias = glm::vec2(sliceScale, -sliceScale * std::log(nearPlane));
+    m_tileSize = glm::vec2(static_cast<float>(width) / TILES_X, static_cast<float>(height) / TILES_Y);
+    float tanX = 1.0f / projection[0][0];
+    float tanY = 1.0f / projection[1][1];
+
+    auto sliceOf = [&](float depth) {
+        float s = std::floor(std::log(depth) * m_depthScaleBias.x + m_depthScaleBias.y);
+        return static_cast<uint16_t>(std::clamp(s, 0.0f, static_cast<float>(SLICES - 1)));
+    };
+
+    // Cull and bound each light. Culled lights keep an empty slice range so the
+    // compaction below stays serial and ordered.
+    m_bounds.resize(m_lights.size());
+    Jobs::parallelFor(m_lights.size(), LIGHT_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Light& light = m_lights[i];
+            Bounds& bounds = m_bounds[i];
+            bounds.minSlice = 1;
+            bounds.maxSlice = 0;
+
+            glm::vec3 center = light.position;
+            float radius = light.range;
+            if (light.type == LightType::Spot) spotBounds(light, center, radius);
+            if (light.intensity <= 0.0f || !frustum.intersectsSphere(center, radius)) continue;
+
+            glm::vec3 viewCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+            float depth = -viewCenter.z;
+            float nearDepth = std::max(depth - radius, nearPlane);
+            float farDepth = std::min(depth + radius, farPlane);
+            if (nearDepth > farDepth) continue;
+
+            bounds.center = viewCenter;
+            bounds.radius = radius;
+            bounds.minSlice = sliceOf(nearDepth);
+            bounds.maxSlice = sliceOf(farDepth);
+
+            if (depth - radius <= nearPlane) {
+                // Straddles the eye plane: any tile may be covered.
+                bounds.minTile[0] = 0;
+                bounds.minTile[1] = 0;
+                bounds.maxTile[0] = TILES_X - 1;
+                bounds.maxTile[1] = TILES_Y - 1;
+                continue;
+            }
+            float minX, maxX, minY, maxY;
+            projectRange(viewCenter.x - radius, viewCenter.x + radius, nearDepth, farDepth, tanX, minX, maxX);
+            projectRange(viewCenter.y - radius, viewCenter.y + radius, nearDepth, farDepth, tanY, minY, maxY);
+            bounds.minTile[0] = tileOf(minX, TILES_X);
+            bounds.maxTile[0] = tileOf(maxX, TILES_X);
+            bounds.minTile[1] = tileOf(minY, TILES_Y);
+            bounds.maxTile[1] = tileOf(maxY, TILES_Y);
+        }
+    });
+
+    m_visible.clear();
+    size_t dropped = 0;
+    for (size_t i = 0; i < m_lights.size(); ++i) {
+        if (m_bounds[i].minSlice > m_bounds[i].maxSlice) continue;
+        if (m_visible.size() == MAX_VISIBLE_LIGHTS) {
+            ++dropped;
+            continue;
+        }
+        m_visible.push_back(static_cast<uint32_t>(i));
+    }
+    // Reported every frame through Stats; logged once so a crowded view does
+    // not flood the console.
+    if (dropped > 0 && !m_warnedDropped) {
+        std::cerr << "ClusteredLights: more than " << MAX_VISIBLE_LIGHTS << " visible lights, dropping the rest\n";
+        m_warnedDropped = true;
+    }
+
+    // Each slice is binned by one task, so clusters are never shared between
+    // threads and lights stay in order within a cluster.
+    Jobs::parallelFor(SLICES, 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) {
+            auto& pairs = m_slicePairs[z];
+            pairs.clear();
+            uint32_t* counts = m_clusterCounts.data() + z * TILES;
+            std::fill(counts, counts + TILES, 0u);
+
+            for (uint32_t v = 0; v < m_visible.size(); ++v) {
+                const Bounds& bounds = m_bounds[m_visible[v]];
+                if (z < bounds.minSlice || z > bounds.maxSlice) continue;
+                for (uint32_t y = bounds.minTile[1]; y <= bounds.maxTile[1]; ++y) {
+                    for (uint32_t x = bounds.minTile[0]; x <= bounds.maxTile[0]; ++x) {
+                        uint32_t tile = y * TILES_X + x;
+                        const ClusterBox& box = m_clusterBoxes[z * TILES + tile];
+                        if (!sphereIntersectsBox(bounds.center, bounds.radius, box.min, box.max)) continue;
+                        if (counts[tile] == MAX_LIGHTS_PER_CLUSTER) continue;
+                        ++counts[tile];
+                        pairs.emplace_back(tile, v);
+                    }
+                }
+            }
+        }
+    });
+
+    uint32_t offset = 0;
+    uint32_t maxCount = 0;
+    for (uint32_t c = 0; c < CLUSTER_COUNT; ++c) {
+        m_clusters[c] = glm::uvec2(offset, m_clusterCounts[c]);
+        offset += m_clusterCounts[c];
+        maxCount = std::max(maxCount, m_clusterCounts[c]);
+    }
+
+    m_indices.resize(offset);
+    Jobs::parallelFor(SLICES, 1, [&](size_t begin, size_t end) {
+        for (size_t z = begin; z < end; ++z) {
+            std::array<uint32_t, TILES> cursor;
+            for (uint32_t t = 0; t < TILES; ++t) cursor[t] = m_clusters[z * TILES + t].x;
+            for (const glm::uvec2& pair : m_slicePairs[z]) {
+                m_indices[cursor[pair.x]++] = static_cast<uint16_t>(pair.y);
+            }
+        }
+    });
+
+    m_stats.lights = m_lights.size();
+    m_stats.visibleLights = m_visible.size();
+    m_stats.droppedLights = dropped;
+    m_stats.indices = offset;
+    m_stats.maxClusterLights = maxCount;
+
+    if (upload) uploadBuffers();
+}
+
+void ClusteredLights::uploadBuffers() {
+    // Created on first upload, so CPU-only users need no GL context.
+    if (!m_buffers[0]) {
+        const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+        glGenBuffers(3, m_buffers);
+        glGenTextures(3, m_textures);
+        for (int i = 0; i < 3; ++i) {
+            glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+            glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Point lights get a cone that covers every direction.
+    m_lightData.resize(m_visible.size() * LIGHT_TEXELS);
+    for (size_t v = 0; v < m_visible.size(); ++v) {
+        const Light& light = m_lights[m_visible[v]];
+        bool spot = light.type == LightType::Spot;
+        glm::vec3 direction = spot ? glm::normalize(light.direction) : glm::vec3(0.0f, -1.0f, 0.0f);
+        glm::vec4* texels = &m_lightData[v * LIGHT_TEXELS];
+        texels[0] = glm::vec4(light.position, light.range);
+        texels[1] = glm::vec4(light.color * light.intensity, spot ? std::cos(light.innerAngle) : -1.0f);
+        texels[2] = glm::vec4(direction, spot ? std::cos(light.outerAngle) : -2.0f);
+        texels[3] = glm::vec4(static_cast<float>(m_shadowLayers[m_visible[v]]), 0.0f, 0.0f, 0.0f);
+    }
+
+    // Orphan and refill, so the driver need not wait on last frame's draws.
+    auto fill = [&](Buffer buffer, const void* data, size_t bytes) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(bytes, 16), nullptr, GL_STREAM_DRAW);
+        if (bytes) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+    };
+    fill(LIGHT_DATA, m_lightData.data(), m_lightData.size() * sizeof(glm::vec4));
+    fill(CLUSTERS, m_clusters.data(), m_clusters.size() * sizeof(glm::uvec2));
+    fill(INDICES, m_indices.data(), m_indices.size() * sizeof(uint16_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLights::bind(Shader& shader) const {
+    shader.bind();
+    shader.setInt("lightData", FIRST_TEXTURE_UNIT + LIGHT_DATA);
+    shader.setInt("lightClusters", FIRST_TEXTURE_UNIT + CLUSTERS);
+    shader.setInt("lightIndices", FIRST_TEXTURE_UNIT + INDICES);
+    shader.setVec2("clusterTileSize", m_tileSize);
+    shader.setVec2("clusterDepth", m_depthScaleBias);
+    shader.setVec3("ambientLight", m_ambient);
+    shader.setVec3("sunDirection", m_sunDirection);
+    shader.setVec3("sunColor", m_sunColor);
+
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ClusteredLights::unbind() const {
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
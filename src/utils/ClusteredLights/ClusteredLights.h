@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "utils/Camera/Camera.h"
+#include "utils/Shader/Shader.h"
+
+enum class LightType : uint8_t {
+    Point = 0,
+    Spot = 1,
+};
+
+struct Light {
+    LightType type = LightType::Point;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    // Distance at which the light fades to zero; also bounds its clusters.
+    float range = 5.0f;
+
+    // Spot lights only. Half-angles in radians.
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float innerAngle = 0.5f;
+    float outerAngle = 0.7f;
+    // Spot lights only; ShadowMaps gives the nearest ones an atlas layer.
+    bool castsShadows = false;
+};
+
+// Point and spot lights binned into a froxel grid: TILES_X x TILES_Y screen
+// tiles by SLICES depth slices, spaced exponentially between the camera's near
+// and far planes. update() bins on the worker pool and uploads three texture
+// buffers (light data, per-cluster ranges, light indices), so a fragment only
+// loops over the lights of its own cluster.
+//
+// Shaders declare
+//     uniform samplerBuffer lightData;      // LIGHT_TEXELS per light
+//     uniform usamplerBuffer lightClusters; // (first index, count)
+//     uniform usamplerBuffer lightIndices;
+//     uniform vec2 clusterTileSize;         // pixels
+//     uniform vec2 clusterDepth;            // slice = log(viewDepth) * x + y
+//     uniform vec3 ambientLight;
+//     uniform vec3 sunDirection;            // towards the ground
+//     uniform vec3 sunColor;
+// GL 3.3 has no compute shaders, so binning always runs on the CPU.
+class ClusteredLights {
+public:
+    // Must match the defines in the shaders.
+    static constexpr uint32_t TILES_X = 16;
+    static constexpr uint32_t TILES_Y = 9;
+    static constexpr uint32_t SLICES = 24;
+    static constexpr uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+    // Further lights in a cluster are dropped.
+    static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+    // Visible lights are indexed with 16 bits.
+    static constexpr uint32_t MAX_VISIBLE_LIGHTS = 65535;
+    // Units 0-3 are left to materials and models.
+    static constexpr int FIRST_TEXTURE_UNIT = 4;
+    // Position + range, colour + cos(inner), direction + cos(outer), shadow layer.
+    static constexpr uint32_t LIGHT_TEXELS = 4;
+
+    struct Stats {
+        size_t lights = 0;
+        size_t visibleLights = 0;
+        // Visible lights past MAX_VISIBLE_LIGHTS, left out of the clusters.
+        size_t droppedLights = 0;
+        // Light references across all clusters.
+        size_t indices = 0;
+        size_t maxClusterLights = 0;
+    };
+
+    ClusteredLights();
+    ~ClusteredLights();
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    uint32_t add(const Light& light);
+    void set(uint32_t id, const Light& light) { m_lights[id] = light; }
+    const Light& light(uint32_t id) const { return m_lights[id]; }
+    size_t size() const { return m_lights.size(); }
+    void clear();
+
+    // Layer of the spot shadow array the light samples, or -1 for none.
+    void setShadowLayer(uint32_t id, int layer) { m_shadowLayers[id] = static_cast<int16_t>(layer); }
+    int shadowLayer(uint32_t id) const { return m_shadowLayers[id]; }
+
+    void setAmbient(const glm::vec3& ambient) { m_ambient = ambient; }
+    // Unshadowed here; ShadowMaps supplies the cascades.
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+    const glm::vec3& sunDirection() const { return m_sunDirection; }
+
+    // Bins the lights for this camera and a width x height target, and uploads
+    // the result. Needs no GL context when `upload` is false.
+    void update(const Camera& camera, int width, int height, bool upload = true);
+
+    // Binds the buffers to FIRST_TEXTURE_UNIT onwards and sets the shader's
+    // cluster uniforms for the last update().
+    void bind(Shader& shader) const;
+    void unbind() const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // A visible light after culling, in view space.
+    struct Bounds {
+        glm::vec3 center;
+        float radius;
+        uint16_t minTile[2];
+        uint16_t maxTile[2];
+        uint16_t minSlice;
+        uint16_t maxSlice;
+    };
+
+    struct ClusterBox {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    void buildClusterBoxes(const Camera& camera);
+    void uploadBuffers();
+
+    std::vector<Light> m_lights;
+    std::vector<int16_t> m_shadowLayers;
+    glm::vec3 m_ambient = glm::vec3(0.1f);
+    glm::vec3 m_sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_sunColor = glm::vec3(0.0f);
+
+    // View-space boxes, rebuilt when the projection changes.
+    std::vector<ClusterBox> m_clusterBoxes;
+    glm::mat4 m_boxProjection = glm::mat4(0.0f);
+
+    glm::vec2 m_tileSize = glm::vec2(1.0f);
+    glm::vec2 m_depthScaleBias = glm::vec2(0.0f);
+
+    std::vector<uint32_t> m_visible;
+    std::vector<Bounds> m_bounds;
+    std::vector<uint32_t> m_clusterCounts;
+    // Per cluster: first entry in m_indices and count.
+    std::vector<glm::uvec2> m_clusters;
+    // Per slice: (tile, visible light) pairs in light order.
+    std::vector<std::vector<glm::uvec2>> m_slicePairs;
+    std::vector<uint16_t> m_indices;
+    std::vector<glm::vec4> m_lightData;
+
+    GLuint m_buffers[3] = {};
+    GLuint m_textures[3] = {};
+    Stats m_stats;
+    bool m_warnedDropped = false;
+};
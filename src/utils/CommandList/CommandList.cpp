@@ -0,0 +1,254 @@
+#include "CommandList.h"
+
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "utils/MaterialTable/MaterialTable.h"
+#include "utils/Shader/Shader.h"
+
+namespace {
+    // Every command starts 8-byte aligned, enough for the pointers they hold.
+    constexpr size_t COMMAND_ALIGN = 8;
+
+    GLenum toGL(BlendFactor factor) {
+        switch (factor) {
+            case BlendFactor::Zero: return GL_ZERO;
+            case BlendFactor::One: return GL_ONE;
+            case BlendFactor::SrcAlpha: return GL_SRC_ALPHA;
+            case BlendFactor::OneMinusSrcAlpha: return GL_ONE_MINUS_SRC_ALPHA;
+        }
+        return GL_ONE;
+    }
+}
+
+void CommandReplay::invalidate() {
+    m_shader = NO_COMMAND_HANDLE;
+    m_materials = NO_COMMAND_HANDLE;
+    m_materialsShader = NO_COMMAND_HANDLE;
+    m_mesh = NO_COMMAND_HANDLE;
+    m_scissorKnown = false;
+    m_blendKnown = false;
+}
+
+void CommandReplay::finish() {
+    if (m_mesh != NO_COMMAND_HANDLE) glBindVertexArray(0);
+    if (m_materials != NO_COMMAND_HANDLE) m_resources.materials[m_materials]->unbind();
+    if (m_scissor || !m_scissorKnown) glDisable(GL_SCISSOR_TEST);
+    if (m_blend || !m_blendKnown) {
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+    invalidate();
+    m_scissorKnown = true;
+    m_blendKnown = true;
+    m_scissor = false;
+    m_blend = false;
+}
+
+void CommandList::clear() {
+    m_bytes.clear();
+    m_count = 0;
+    m_shader = NO_COMMAND_HANDLE;
+    m_materials = NO_COMMAND_HANDLE;
+    m_materialsShader = NO_COMMAND_HANDLE;
+    m_mesh = NO_COMMAND_HANDLE;
+}
+
+template <typename T>
+void CommandList::push(CommandType type, T command) {
+    constexpr size_t size = (sizeof(T) + COMMAND_ALIGN - 1) / COMMAND_ALIGN * COMMAND_ALIGN;
+    static_assert(size <= UINT16_MAX);
+    command.header.type = type;
+    command.header.size = static_cast<uint16_t>(size);
+
+    size_t offset = m_bytes.size();
+    m_bytes.resize(offset + size);
+    std::memcpy(m_bytes.data() + offset, &command, sizeof(T));
+    ++m_count;
+}
+
+void CommandList::useShader(CommandHandle shader) {
+    if (shader == m_shader) return;
+    push(CommandType::UseShader, UseShaderCmd{{}, shader});
+    m_shader = shader;
+}
+
+void CommandList::bindMaterials(CommandHandle materials) {
+    if (materials == NO_COMMAND_HANDLE) return;
+    if (materials == m_materials && m_materialsShader == m_shader && m_shader != NO_COMMAND_HANDLE) return;
+    push(CommandType::BindMaterials, BindMaterialsCmd{{}, materials});
+    m_materials = materials;
+    m_materialsShader = m_shader;
+}
+
+void CommandList::bindMesh(CommandHandle mesh) {
+    if (mesh == m_mesh) return;
+    push(CommandType::BindMesh, BindMeshCmd{{}, mesh});
+    m_mesh = mesh;
+}
+
+void CommandList::drawMesh(CommandHandle handle, const Mesh& mesh) {
+    bindMesh(handle);
+    if (mesh.isIndexed()) {
+        push(CommandType::DrawElements, DrawElementsCmd{{}, static_cast<uint32_t>(mesh.indexCount()), 0});
+    } else {
+        push(CommandType::DrawArrays, DrawArraysCmd{{}, static_cast<uint32_t>(mesh.vertexCount())});
+    }
+}
+
+void CommandList::drawMeshRange(CommandHandle handle, const Mesh& mesh, uint32_t firstIndex, uint32_t count) {
+    if (!mesh.isIndexed() || count == 0) return;
+    bindMesh(handle);
+    push(CommandType::DrawElements, DrawElementsCmd{{}, count, firstIndex});
+}
+
+void CommandList::scissor(const glm::ivec4& rect) {
+    push(CommandType::Scissor, ScissorCmd{{}, rect});
+}
+
+void CommandList::blend(bool enabled, BlendFactor src, BlendFactor dst) {
+    push(CommandType::Blend, BlendCmd{{}, static_cast<uint8_t>(enabled ? 1 : 0), src, dst});
+}
+
+void CommandList::callback(CommandCallback fn, const void* data) {
+    push(CommandType::Callback, CallbackCmd{{}, fn, data});
+    m_shader = NO_COMMAND_HANDLE;
+    m_materials = NO_COMMAND_HANDLE;
+    m_materialsShader = NO_COMMAND_HANDLE;
+    m_mesh = NO_COMMAND_HANDLE;
+}
+
+void CommandList::execute(CommandReplay& replay) const {
+    CommandReplay::Stats& stats = replay.m_stats;
+    const CommandResources& resources = replay.m_resources;
+    const std::byte* cursor = m_bytes.data();
+    const std::byte* end = cursor + m_bytes.size();
+
+    auto read = [&cursor](auto& command) { std::memcpy(&command, cursor, sizeof(command)); };
+
+    while (cursor < end) {
+        CommandHeader header;
+        std::memcpy(&header, cursor, sizeof(header));
+        ++stats.commands;
+
+        switch (header.type) {
+            case CommandType::UseShader: {
+                UseShaderCmd command;
+                read(command);
+                if (command.shader == replay.m_shader) {
+                    ++stats.filtered;
+                    break;
+                }
+                resources.shaders[command.shader]->bind();
+                replay.m_shader = command.shader;
+                ++stats.programChanges;
+                break;
+            }
+            case CommandType::BindMaterials: {
+                BindMaterialsCmd command;
+                read(command);
+                if (command.materials == replay.m_materials && replay.m_materialsShader == replay.m_shader) {
+                    ++stats.filtered;
+                    break;
+                }
+                // Binds the shader's program too, which is already current.
+                resources.materials[command.materials]->bind(*resources.shaders[replay.m_shader]);
+                replay.m_materials = command.materials;
+                replay.m_materialsShader = replay.m_shader;
+                ++stats.materialChanges;
+                break;
+            }
+            case CommandType::BindMesh: {
+                BindMeshCmd command;
+                read(command);
+                if (command.mesh == replay.m_mesh) {
+                    ++stats.filtered;
+                    break;
+                }
+                glBindVertexArray(resources.meshes[command.mesh]->VAO());
+                replay.m_mesh = command.mesh;
+                ++stats.meshChanges;
+                break;
+            }
+            case CommandType::DrawElements: {
+                DrawElementsCmd command;
+                read(command);
+                glDrawElements(
+                    GL_TRIANGLES,
+                    static_cast<GLsizei>(command.count),
+                    GL_UNSIGNED_INT,
+                    (void*)(static_cast<uintptr_t>(command.firstIndex) * sizeof(uint32_t))
+                );
+                ++stats.drawCalls;
+                break;
+            }
+            case CommandType::DrawArrays: {
+                DrawArraysCmd command;
+                read(command);
+                glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(command.count));
+                ++stats.drawCalls;
+                break;
+            }
+            case CommandType::Scissor: {
+                ScissorCmd command;
+                read(command);
+                bool enabled = command.rect.z >= 0;
+                bool known = replay.m_scissorKnown;
+                if (known && enabled == replay.m_scissor && (!enabled || command.rect == replay.m_scissorRect)) {
+                    ++stats.filtered;
+                    break;
+                }
+                if (!known || enabled != replay.m_scissor) {
+                    if (enabled) glEnable(GL_SCISSOR_TEST);
+                    else glDisable(GL_SCISSOR_TEST);
+                    replay.m_scissor = enabled;
+                }
+                if (enabled && (!known || command.rect != replay.m_scissorRect)) {
+                    glScissor(command.rect.x, command.rect.y, command.rect.z, command.rect.w);
+                    replay.m_scissorRect = command.rect;
+                }
+                replay.m_scissorKnown = true;
+                break;
+            }
+            case CommandType::Blend: {
+                BlendCmd command;
+                read(command);
+                bool enabled = command.enabled != 0;
+                bool known = replay.m_blendKnown;
+                if (known && enabled == replay.m_blend &&
+                    (!enabled || (command.src == replay.m_blendSrc && command.dst == replay.m_blendDst))) {
+                    ++stats.filtered;
+                    break;
+                }
+                if (enabled) {
+                    if (!known || !replay.m_blend) {
+                        glEnable(GL_BLEND);
+                        glDepthMask(GL_FALSE);
+                    }
+                    glBlendFunc(toGL(command.src), toGL(command.dst));
+                    replay.m_blendSrc = command.src;
+                    replay.m_blendDst = command.dst;
+                } else {
+                    glDepthMask(GL_TRUE);
+                    glDisable(GL_BLEND);
+                }
+                replay.m_blend = enabled;
+                replay.m_blendKnown = true;
+                break;
+            }
+            case CommandType::Callback: {
+                CallbackCmd command;
+                read(command);
+                if (replay.m_materials != NO_COMMAND_HANDLE) resources.materials[replay.m_materials]->unbind();
+                // Mesh::draw leaves VAO 0 bound; callbacks expect the same.
+                if (replay.m_mesh != NO_COMMAND_HANDLE) glBindVertexArray(0);
+                command.fn(command.data);
+                replay.invalidate();
+                ++stats.drawCalls;
+                break;
+            }
+        }
+        cursor += header.size;
+    }
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Mesh/Mesh.h"
+
+class MaterialTable;
+class Shader;
+
+using CommandCallback = void (*)(const void* data);
+
+// Shaders, material tables and meshes are named in commands by index into
+// the CommandResources a list is executed with.
+using CommandHandle = uint32_t;
+inline constexpr CommandHandle NO_COMMAND_HANDLE = UINT32_MAX;
+
+// The objects a list's handles refer to. Only the replay resolves them, so
+// recording never sees a backend object.
+struct CommandResources {
+    std::span<Shader* const> shaders;
+    std::span<const MaterialTable* const> materials;
+    std::span<const Mesh* const> meshes;
+};
+
+enum class BlendFactor : uint8_t {
+    Zero,
+    One,
+    SrcAlpha,
+    OneMinusSrcAlpha,
+};
+
+enum class CommandType : uint8_t {
+    UseShader,
+    BindMaterials,
+    BindMesh,
+    DrawElements,
+    DrawArrays,
+    Scissor,
+    Blend,
+    Callback,
+};
+
+// Commands are plain structs packed back to back in the list's arena, each
+// starting with its header. They hold handles and backend-neutral state and
+// never touch GL themselves.
+struct CommandHeader {
+    CommandType type;
+    uint8_t pad = 0;
+    // Bytes to the next command.
+    uint16_t size;
+};
+
+// Replays command lists on the context thread, skipping state that is already
+// set. One replay spans every list of a draw, so lists recorded separately
+// (on other threads, for other object ranges) do not repeat each other's
+// binds.
+class CommandReplay {
+public:
+    struct Stats {
+        size_t commands = 0;
+        size_t drawCalls = 0;
+        size_t programChanges = 0;
+        size_t materialChanges = 0;
+        size_t meshChanges = 0;
+        // State commands dropped because they matched the current state.
+        size_t filtered = 0;
+    };
+
+    explicit CommandReplay(const CommandResources& resources) : m_resources(resources) {}
+
+    // Puts back the defaults the replay may have changed: no VAO, no material
+    // table, no scissor, no blending, depth writes on.
+    void finish();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    friend class CommandList;
+
+    // Forgets all state after a callback, which may change anything.
+    void invalidate();
+
+    CommandResources m_resources;
+    CommandHandle m_shader = NO_COMMAND_HANDLE;
+    CommandHandle m_materials = NO_COMMAND_HANDLE;
+    // Shader the table was bound for; a new shader needs it bound again.
+    CommandHandle m_materialsShader = NO_COMMAND_HANDLE;
+    CommandHandle m_mesh = NO_COMMAND_HANDLE;
+    // Scissor and blend state are unknown after a callback until the next
+    // command sets them outright.
+    bool m_scissorKnown = true;
+    bool m_blendKnown = true;
+    bool m_scissor = false;
+    glm::ivec4 m_scissorRect = glm::ivec4(0, 0, -1, -1);
+    bool m_blend = false;
+    BlendFactor m_blendSrc = BlendFactor::One;
+    BlendFactor m_blendDst = BlendFactor::Zero;
+    Stats m_stats;
+};
+
+// A list of draw commands recorded without a GL context, so worker threads
+// can each prepare part of a frame. Recording drops state that repeats the
+// list's own previous command; the replay filters across lists.
+//
+// Storage is one growing byte arena that clear() rewinds, so steady-state
+// frames record without allocating.
+class CommandList {
+public:
+    void clear();
+    bool empty() const { return m_bytes.empty(); }
+    size_t bytes() const { return m_bytes.size(); }
+    size_t commandCount() const { return m_count; }
+
+    void useShader(CommandHandle shader);
+    // Binds the table for the current shader.
+    void bindMaterials(CommandHandle materials);
+    // `mesh` is read only for its index or vertex count.
+    void drawMesh(CommandHandle handle, const Mesh& mesh);
+    void drawMeshRange(CommandHandle handle, const Mesh& mesh, uint32_t firstIndex, uint32_t count);
+    // A negative rect width disables the scissor test.
+    void scissor(const glm::ivec4& rect);
+    // Transparent-style blending: on with these factors and depth writes off,
+    // or off with depth writes back on.
+    void blend(bool enabled, BlendFactor src = BlendFactor::SrcAlpha, BlendFactor dst = BlendFactor::OneMinusSrcAlpha);
+    // Runs fn(data) on the context thread; it may change any state.
+    void callback(CommandCallback fn, const void* data);
+
+    void execute(CommandReplay& replay) const;
+
+private:
+    struct UseShaderCmd {
+        CommandHeader header;
+        CommandHandle shader;
+    };
+    struct BindMaterialsCmd {
+        CommandHeader header;
+        CommandHandle materials;
+    };
+    struct BindMeshCmd {
+        CommandHeader header;
+        CommandHandle mesh;
+    };
+    struct DrawElementsCmd {
+        CommandHeader header;
+        uint32_t count;
+        uint32_t firstIndex;
+    };
+    struct DrawArraysCmd {
+        CommandHeader header;
+        uint32_t count;
+    };
+    struct ScissorCmd {
+        CommandHeader header;
+        glm::ivec4 rect;
+    };
+    struct BlendCmd {
+        CommandHeader header;
+        uint8_t enabled;
+        BlendFactor src;
+        BlendFactor dst;
+    };
+    struct CallbackCmd {
+        CommandHeader header;
+        CommandCallback fn;
+        const void* data;
+    };
+
+    template <typename T>
+    void push(CommandType type, T command);
+    void bindMesh(CommandHandle mesh);
+
+    std::vector<std::byte> m_bytes;
+    size_t m_count = 0;
+
+    // What this list last recorded, to skip repeats while recording;
+    // NO_COMMAND_HANDLE when unknown (a new list, or after a callback).
+    CommandHandle m_shader = NO_COMMAND_HANDLE;
+    CommandHandle m_materials = NO_COMMAND_HANDLE;
+    CommandHandle m_materialsShader = NO_COMMAND_HANDLE;
+    CommandHandle m_mesh = NO_COMMAND_HANDLE;
+};
@@ -0,0 +1,148 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Weight of a new GPU sample in the smoothed time.
+    constexpr float SMOOTHING = 0.25f;
+    // Scale up only once the frame is this far under budget.
+    constexpr float HEADROOM = 0.85f;
+}
+
+DynamicResolution::DynamicResolution(const DynamicResolutionOptions& options)
+    : m_options(options)
+    , m_easu("easu")
+    , m_rcas("rcas")
+{
+    // Core profile needs a VAO bound even for attribute-less draws.
+    glGenVertexArrays(1, &m_vao);
+    glGenQueries(QUERY_LATENCY, m_queries);
+    m_scale = m_options.maxScale;
+
+    m_easu.bind();
+    m_easu.setInt("inputTex", 0);
+    m_rcas.bind();
+    m_rcas.setInt("inputTex", 0);
+    m_rcas.setFloat("sharpness", std::exp2(-m_options.sharpness));
+}
+
+DynamicResolution::~DynamicResolution() {
+    glDeleteQueries(QUERY_LATENCY, m_queries);
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+}
+
+void DynamicResolution::beginFrame() {
+    m_timing = !m_pending[m_current];
+    if (m_timing) glBeginQuery(GL_TIME_ELAPSED, m_queries[m_current]);
+}
+
+void DynamicResolution::endFrame() {
+    m_changed = false;
+    if (m_timing) {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_pending[m_current] = true;
+        m_timing = false;
+    }
+    m_current = (m_current + 1) % QUERY_LATENCY;
+
+    // Oldest first; stop at the first one still in flight.
+    for (int i = 0; i < QUERY_LATENCY; ++i) {
+        int slot = (m_current + i) % QUERY_LATENCY;
+        if (!m_pending[slot]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(m_queries[slot], GL_QUERY_RESULT, &ns);
+        m_pending[slot] = false;
+        update(static_cast<float>(ns) * 1e-6f);
+    }
+}
+
+void DynamicResolution::setFixedScale(float scale) {
+    m_fixedScale = scale > 0.0f ? std::clamp(scale, 0.1f, 1.0f) : 0.0f;
+    float next = m_fixedScale > 0.0f ? m_fixedScale : m_options.maxScale;
+    m_changed = next != m_scale;
+    m_scale = next;
+    m_samplesSinceChange = 0;
+}
+
+void DynamicResolution::update(float gpuMs) {
+    m_gpuMs = m_gpuMs > 0.0f ? m_gpuMs + (gpuMs - m_gpuMs) * SMOOTHING : gpuMs;
+    if (m_fixedScale > 0.0f) return;
+    if (++m_samplesSinceChange < m_options.settleFrames) return;
+
+    float step = m_options.step;
+    float wanted = m_scale * std::sqrt(m_options.targetMs / std::max(m_gpuMs, 1e-3f));
+    float next = m_scale;
+    if (m_gpuMs > m_options.targetMs) {
+        next = std::floor(wanted / step + 1e-3f) * step;
+    } else if (m_gpuMs < m_options.targetMs * HEADROOM && wanted >= m_scale + step) {
+        next = m_scale + step;
+    }
+    next = std::clamp(next, m_options.minScale, m_options.maxScale);
+    if (std::abs(next - m_scale) < step * 0.5f) return;
+
+    m_scale = next;
+    m_samplesSinceChange = 0;
+    m_changed = true;
+}
+
+glm::ivec2 DynamicResolution::renderSize(int outputWidth, int outputHeight) const {
+    if (m_scale >= 1.0f) return {outputWidth, outputHeight};
+    return {
+        std::max(1, static_cast<int>(std::lround(outputWidth * m_scale))),
+        std::max(1, static_cast<int>(std::lround(outputHeight * m_scale))),
+    };
+}
+
+void DynamicResolution::addPasses(RenderGraph& graph, RenderResource input, RenderResource target) {
+    const RenderTextureDesc output = graph.desc(target);
+    RenderResource upscaled = RenderGraph::INVALID;
+
+    graph.addPass(
+        "easu",
+        [&](RenderGraph::Builder& builder) {
+            builder.read(input);
+            upscaled = builder.create("easu-output", {output.width, output.height, GL_RGBA8});
+        },
+        [this, input, output](const RenderGraph::Context& context) {
+            const RenderTextureDesc& in = context.desc(input);
+            glDisable(GL_DEPTH_TEST);
+            m_easu.bind();
+            m_easu.setVec2("inputSize", glm::vec2(in.width, in.height));
+            m_easu.setVec2("outputSize", glm::vec2(output.width, output.height));
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(input));
+
+            glBindVertexArray(m_vao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glEnable(GL_DEPTH_TEST);
+        }
+    );
+
+    graph.addPass(
+        "rcas",
+        [&](RenderGraph::Builder& builder) {
+            builder.read(upscaled);
+            builder.write(target);
+        },
+        [this, upscaled](const RenderGraph::Context& context) {
+            glDisable(GL_DEPTH_TEST);
+            m_rcas.bind();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, context.texture(upscaled));
+
+            glBindVertexArray(m_vao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glEnable(GL_DEPTH_TEST);
+        }
+    );
+}
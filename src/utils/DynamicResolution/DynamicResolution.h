@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "utils/RenderGraph/RenderGraph.h"
+#include "utils/Shader/Shader.h"
+
+struct DynamicResolutionOptions {
+    // GPU milliseconds a frame should take, with some headroom under the refresh interval.
+    float targetMs = 14.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // Scales are multiples of this, so the render graph's pool only ever
+    // sees a handful of target sizes.
+    float step = 0.05f;
+    // GPU samples between changes; timings arrive a few frames late, so
+    // reacting sooner would overshoot.
+    int settleFrames = 8;
+    // RCAS strength in stops: 0 is the sharpest, each stop halves it.
+    float sharpness = 0.25f;
+};
+
+// Renders the scene at a fraction of the output size, chosen from measured
+// GPU time, and upscales it. Each frame is timed with a GL_TIME_ELAPSED query
+// that is read back QUERY_LATENCY frames later, so the CPU never waits on
+// the GPU. The controller assumes cost follows pixel count and moves the
+// scale by the square root of budget / time, down as far as needed at once
+// and up one step at a time.
+//
+// Upscaling follows AMD FidelityFX Super Resolution 1: EASU, an edge-adaptive
+// 12-tap Lanczos-like filter clamped to the nearest texels, then RCAS, a
+// contrast-adaptive sharpen limited so it cannot ring. Both are full-screen
+// passes in the render graph; at scale 1 the caller composites straight to the
+// output and neither runs.
+class DynamicResolution {
+public:
+    static constexpr int QUERY_LATENCY = 4;
+
+    explicit DynamicResolution(const DynamicResolutionOptions& options = {});
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    // Brackets the frame's GPU work. Timing is skipped for a frame whose
+    // query slot has not been read back yet.
+    void beginFrame();
+    void endFrame();
+
+    // Pins the scale and stops the controller; 0 hands control back.
+    void setFixedScale(float scale);
+    float scale() const { return m_scale; }
+    // Smoothed GPU time of recent frames, 0 before the first result.
+    float gpuMs() const { return m_gpuMs; }
+    // Whether the last endFrame() changed the scale.
+    bool changed() const { return m_changed; }
+
+    glm::ivec2 renderSize(int outputWidth, int outputHeight) const;
+    bool upscaling(int outputWidth, int outputHeight) const {
+        return renderSize(outputWidth, outputHeight) != glm::ivec2(outputWidth, outputHeight);
+    }
+
+    // Adds EASU (input to an output-sized texture) and RCAS (to `target`).
+    void addPasses(RenderGraph& graph, RenderResource input, RenderResource target);
+
+private:
+    void update(float gpuMs);
+
+    DynamicResolutionOptions m_options;
+    Shader m_easu;
+    Shader m_rcas;
+    GLuint m_vao = 0;
+
+    GLuint m_queries[QUERY_LATENCY] = {};
+    bool m_pending[QUERY_LATENCY] = {};
+    int m_current = 0;
+    bool m_timing = false;
+
+    float m_scale = 1.0f;
+    float m_fixedScale = 0.0f;
+    float m_gpuMs = 0.0f;
+    int m_samplesSinceChange = 0;
+    bool m_changed = false;
+};
@@ -0,0 +1,200 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "utils/ImageWriter/ImageWriter.h"
+#include "utils/Profiler/Profiler.h"
+
+FrameCapture::FrameCapture(int width, int height, const std::string& directory, const FrameCaptureOptions& options)
+    : m_width(width)
+    , m_height(height)
+    , m_directory(directory)
+    , m_frameBytes(static_cast<size_t>(width) * height * 4)
+    , m_written(options.written)
+    , m_maxQueued(static_cast<size_t>(std::max(options.encoders, 1)) * 2)
+{
+    glGenFramebuffers(1, &m_fbo);
+    m_slots.resize(static_cast<size_t>(std::max(options.depth, 1)));
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(m_frameBytes), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    for (int i = 0; i < std::max(options.encoders, 1); ++i) {
+        m_encoders.emplace_back([this, i] {
+            PROFILE_THREAD("encoder " + std::to_string(i));
+            encode();
+        });
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    finish();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& encoder : m_encoders) encoder.join();
+
+    for (Slot& slot : m_slots) glDeleteBuffers(1, &slot.buffer);
+    glDeleteFramebuffers(1, &m_fbo);
+}
+
+void FrameCapture::capture(GLuint texture, uint32_t index) {
+    PROFILE_SCOPE("frame capture");
+    Slot& slot = m_slots[m_next];
+    if (slot.fence) {
+        if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_stats.readbackStalls;
+            }
+            glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        collect(slot);
+    }
+
+    GLint previousRead = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(previousRead));
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.index = index;
+    m_next = (m_next + 1) % m_slots.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.captured;
+}
+
+void FrameCapture::poll() {
+    // Oldest first, and in order: a later fence cannot pass before an earlier one.
+    // The first wait flushes, so a fence still sitting in the command queue
+    // gets submitted instead of polling unsignaled forever.
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+        if (!slot.fence) continue;
+        GLenum status = glClientWaitSync(slot.fence, flags, 0);
+        flags = 0;
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        collect(slot);
+    }
+}
+
+void FrameCapture::finish() {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[(m_next + i) % m_slots.size()];
+        if (!slot.fence) continue;
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        collect(slot);
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_jobs.empty() && m_encoding == 0; });
+}
+
+std::string FrameCapture::framePath(uint32_t index) const {
+    return m_directory + "/" + fileName(index);
+}
+
+std::string FrameCapture::fileName(uint32_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%05u.png", index);
+    return name;
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void FrameCapture::collect(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::vector<uint8_t> pixels;
+    {
+        // Bounded, so slow encoders hold back rendering rather than pile up frames.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_jobs.size() >= m_maxQueued) {
+            ++m_stats.encoderStalls;
+            m_done.wait(lock, [this] { return m_jobs.size() < m_maxQueued; });
+        }
+        if (!m_spare.empty()) {
+            pixels = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+    }
+    pixels.resize(m_frameBytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(m_frameBytes), GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(pixels.data(), mapped, m_frameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!mapped) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.failed;
+            m_spare.push_back(std::move(pixels));
+        }
+        if (m_written) m_written(slot.index, false);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back({slot.index, std::move(pixels)});
+    m_wake.notify_one();
+}
+
+void FrameCapture::encode() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty()) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            ++m_encoding;
+        }
+        m_done.notify_all();
+
+        bool ok;
+        {
+            PROFILE_SCOPE("encode frame");
+            // The scene leaves no meaningful alpha, so frames are saved as RGB,
+            // packed in place. GL rows run bottom to top.
+            uint8_t* data = job.pixels.data();
+            size_t count = static_cast<size_t>(m_width) * m_height;
+            for (size_t i = 0; i < count; ++i) {
+                data[i * 3 + 0] = data[i * 4 + 0];
+                data[i * 3 + 1] = data[i * 4 + 1];
+                data[i * 3 + 2] = data[i * 4 + 2];
+            }
+            ok = ImageWriter::writePng(framePath(job.index), m_width, m_height, 3, data, true);
+        }
+        if (m_written) m_written(job.index, ok);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_encoding;
+            if (ok) ++m_stats.written;
+            else ++m_stats.failed;
+            m_spare.push_back(std::move(job.pixels));
+        }
+        m_done.notify_all();
+    }
+}
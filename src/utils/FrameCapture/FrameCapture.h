@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+
+struct FrameCaptureOptions {
+    // Readbacks in flight. capture() only waits on the GPU once this many
+    // frames are queued ahead of the oldest.
+    int depth = 3;
+    int encoders = 2;
+    // Runs once frame `index` is on disk or has failed; usually on an
+    // encoder thread.
+    std::function<void(uint32_t index, bool ok)> written;
+};
+
+// Saves rendered frames as numbered PNGs without stalling the renderer.
+// capture() queues a glReadPixels into a pixel pack buffer behind a fence and
+// returns at once; poll() maps the readbacks whose fences have passed, copies
+// them out and hands them to encoder threads, which compress and write the
+// files while the next frames render.
+//
+// All calls must come from the context thread.
+class FrameCapture {
+public:
+    struct Stats {
+        uint64_t captured = 0;
+        uint64_t written = 0;
+        uint64_t failed = 0;
+        // capture() calls that had to wait for the GPU to finish a readback.
+        uint64_t readbackStalls = 0;
+        // poll() calls that had to wait for the encoders to catch up.
+        uint64_t encoderStalls = 0;
+    };
+
+    // Frames are written to `directory`, which must exist.
+    FrameCapture(int width, int height, const std::string& directory, const FrameCaptureOptions& options = {});
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Reads `texture` (GL_RGBA8, width x height) as frame `index`.
+    void capture(GLuint texture, uint32_t index);
+    // Hands finished readbacks to the encoders; call once a frame.
+    void poll();
+    // Waits for every readback and every file.
+    void finish();
+
+    // Where frame `index` is written: fileName(index) in the directory.
+    std::string framePath(uint32_t index) const;
+    static std::string fileName(uint32_t index);
+    Stats stats() const;
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        uint32_t index = 0;
+    };
+
+    struct Job {
+        uint32_t index;
+        std::vector<uint8_t> pixels;
+    };
+
+    // Maps a finished slot and queues its pixels for encoding.
+    void collect(Slot& slot);
+    void encode();
+
+    int m_width;
+    int m_height;
+    std::string m_directory;
+    size_t m_frameBytes;
+    std::function<void(uint32_t, bool)> m_written;
+
+    GLuint m_fbo = 0;
+    std::vector<Slot> m_slots;
+    // Next slot to fill; also the oldest in flight.
+    size_t m_next = 0;
+
+    std::vector<std::thread> m_encoders;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::deque<Job> m_jobs;
+    // Pixel buffers returned by the encoders, reused for later frames.
+    std::vector<std::vector<uint8_t>> m_spare;
+    size_t m_encoding = 0;
+    size_t m_maxQueued;
+    bool m_stop = false;
+    Stats m_stats;
+};
@@ -0,0 +1,43 @@
+#include "FrameLoop.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/Time/Time.h"
+
+FrameLoop::FrameLoop(const FrameLoopOptions& options)
+    : m_options(options)
+{
+    double rate = m_options.tickRate > 0.0 ? m_options.tickRate : 60.0;
+    m_tickNs = std::max<int64_t>(1, static_cast<int64_t>(std::llround(1e9 / rate)));
+    m_options.maxTicksPerFrame = std::max(1, m_options.maxTicksPerFrame);
+    m_lastNs = Time::now();
+}
+
+void FrameLoop::resetClock() {
+    m_lastNs = Time::now();
+    m_accumulatorNs = 0;
+}
+
+int FrameLoop::beginFrame() {
+    int64_t now = Time::now();
+    m_frameNs = now - m_lastNs;
+    m_lastNs = now;
+
+    int64_t step = m_frameNs;
+    if (m_options.fixedFrameSeconds > 0.0) {
+        step = static_cast<int64_t>(std::llround(m_options.fixedFrameSeconds * 1e9));
+    } else {
+        step = std::min(step, static_cast<int64_t>(std::llround(m_options.maxFrameSeconds * 1e9)));
+    }
+    m_accumulatorNs += std::max<int64_t>(step, 0);
+
+    int64_t due = m_accumulatorNs / m_tickNs;
+    m_accumulatorNs -= due * m_tickNs;
+    if (due > m_options.maxTicksPerFrame) {
+        m_droppedTicks += static_cast<uint64_t>(due - m_options.maxTicksPerFrame);
+        due = m_options.maxTicksPerFrame;
+    }
+    m_ticks += static_cast<uint64_t>(due);
+    return static_cast<int>(due);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+struct FrameLoopOptions {
+    // Simulation ticks per second.
+    double tickRate = 60.0;
+    // Spiral-of-death guard: a frame never runs more ticks than this. When
+    // ticks cost more than the time they cover, the simulation slows down
+    // instead of falling ever further behind.
+    int maxTicksPerFrame = 8;
+    // Longer frames (a breakpoint, a window drag) count as this long.
+    double maxFrameSeconds = 0.25;
+    // > 0 replaces the measured frame time, so every run simulates the same
+    // ticks in the same frames whatever the machine; for benchmarks.
+    double fixedFrameSeconds = 0.0;
+};
+
+// Decouples simulation from rendering: each rendered frame adds its measured
+// duration to an accumulator and the caller runs one fixed tick per whole
+// tick period in it. The remainder, as alpha(), blends the last two
+// simulated states so motion stays smooth at any render rate.
+//
+// Time is kept as integer nanoseconds, so ticks never drift and a fixed
+// frame time gives bit-identical tick counts across runs.
+class FrameLoop {
+public:
+    explicit FrameLoop(const FrameLoopOptions& options = {});
+
+    // Measures the frame since the last call (or construction) and returns
+    // how many ticks to simulate before rendering it.
+    int beginFrame();
+    // Restarts the clock without ticking, e.g. after a long load.
+    void resetClock();
+
+    double tickSeconds() const { return static_cast<double>(m_tickNs) * 1e-9; }
+    // Position of the rendered frame between the previous tick (0) and the
+    // latest one (1).
+    double alpha() const { return static_cast<double>(m_accumulatorNs) / static_cast<double>(m_tickNs); }
+
+    uint64_t ticks() const { return m_ticks; }
+    double simulationSeconds() const { return static_cast<double>(m_ticks) * tickSeconds(); }
+    // Last frame as measured, before clamping.
+    double frameSeconds() const { return static_cast<double>(m_frameNs) * 1e-9; }
+    // Ticks the guard gave up since construction.
+    uint64_t droppedTicks() const { return m_droppedTicks; }
+
+private:
+    FrameLoopOptions m_options;
+    int64_t m_tickNs = 0;
+    int64_t m_lastNs = 0;
+    int64_t m_frameNs = 0;
+    int64_t m_accumulatorNs = 0;
+    uint64_t m_ticks = 0;
+    uint64_t m_droppedTicks = 0;
+};
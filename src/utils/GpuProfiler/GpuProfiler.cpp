@@ -0,0 +1,209 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    void writeEscaped(std::ofstream& out, const std::string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+    }
+}
+
+GpuProfiler::~GpuProfiler() {
+    if (!m_queries.empty()) glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+}
+
+GLuint GpuProfiler::acquireQuery() {
+    if (m_freeQueries.empty()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        m_queries.push_back(query);
+        return query;
+    }
+    GLuint query = m_freeQueries.back();
+    m_freeQueries.pop_back();
+    return query;
+}
+
+uint32_t GpuProfiler::intern(const std::string& name, uint32_t depth) {
+    auto it = m_names.find(name);
+    if (it != m_names.end()) return it->second;
+
+    uint32_t id = static_cast<uint32_t>(m_stats.size());
+    m_names.emplace(name, id);
+    GpuScopeStats stats;
+    stats.name = name;
+    stats.depth = static_cast<int>(depth);
+    m_stats.push_back(stats);
+    m_history.emplace_back();
+    return id;
+}
+
+void GpuProfiler::beginFrame() {
+    m_open.clear();
+    m_skippedDepth = 0;
+
+    Frame& frame = m_frames[m_current];
+    m_recording = !frame.pending;
+    if (!m_recording) {
+        ++m_droppedFrames;
+        return;
+    }
+    frame.markers.clear();
+    begin("frame");
+}
+
+void GpuProfiler::endFrame() {
+    if (m_recording) {
+        while (!m_open.empty()) end();
+        m_frames[m_current].pending = true;
+        m_recording = false;
+    }
+    m_current = (m_current + 1) % FRAME_LATENCY;
+
+    // Oldest first; the root marker's end is the frame's last query, so once
+    // it is available the rest are too.
+    for (int i = 0; i < FRAME_LATENCY; ++i) {
+        Frame& frame = m_frames[(m_current + i) % FRAME_LATENCY];
+        if (!frame.pending) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(frame.markers.front().end, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+        resolve(frame);
+        frame.pending = false;
+    }
+}
+
+void GpuProfiler::begin(const std::string& name) {
+    if (!m_recording) {
+        ++m_skippedDepth;
+        return;
+    }
+    uint32_t depth = static_cast<uint32_t>(m_open.size());
+    Marker marker{intern(name, depth), depth, acquireQuery()};
+    glQueryCounter(marker.begin, GL_TIMESTAMP);
+
+    std::vector<Marker>& markers = m_frames[m_current].markers;
+    m_open.push_back(static_cast<uint32_t>(markers.size()));
+    markers.push_back(marker);
+}
+
+void GpuProfiler::end() {
+    if (!m_recording) {
+        if (m_skippedDepth > 0) --m_skippedDepth;
+        return;
+    }
+    if (m_open.empty()) {
+        std::cerr << "GpuProfiler: end() without a matching begin()\n";
+        return;
+    }
+    Marker& marker = m_frames[m_current].markers[m_open.back()];
+    m_open.pop_back();
+    marker.end = acquireQuery();
+    glQueryCounter(marker.end, GL_TIMESTAMP);
+}
+
+void GpuProfiler::resolve(Frame& frame) {
+    m_frameMs.assign(m_stats.size(), 0.0);
+    m_seen.assign(m_stats.size(), 0);
+
+    std::vector<TraceEvent> events;
+    if (m_traceFrames > 0) events.reserve(frame.markers.size());
+    for (const Marker& marker : frame.markers) {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(marker.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(marker.end, GL_QUERY_RESULT, &end);
+        m_freeQueries.push_back(marker.begin);
+        m_freeQueries.push_back(marker.end);
+        end = std::max(end, begin);
+
+        m_frameMs[marker.name] += static_cast<double>(end - begin) * 1e-6;
+        m_seen[marker.name] = 1;
+        if (m_traceFrames > 0) events.push_back({marker.name, begin, end});
+    }
+    frame.markers.clear();
+
+    for (uint32_t id = 0; id < m_stats.size(); ++id) {
+        if (!m_seen[id]) continue;
+        History& history = m_history[id];
+        history.ms[history.next] = static_cast<float>(m_frameMs[id]);
+        history.next = (history.next + 1) % HISTORY;
+        history.count = std::min(history.count + 1, HISTORY);
+
+        GpuScopeStats& stats = m_stats[id];
+        stats.lastMs = m_frameMs[id];
+        double sum = 0.0;
+        float lo = history.ms[0], hi = history.ms[0];
+        for (uint32_t i = 0; i < history.count; ++i) {
+            sum += history.ms[i];
+            lo = std::min(lo, history.ms[i]);
+            hi = std::max(hi, history.ms[i]);
+        }
+        stats.averageMs = sum / history.count;
+        stats.minMs = lo;
+        stats.maxMs = hi;
+        stats.samples = history.count;
+    }
+
+    if (m_traceFrames > 0) {
+        m_trace.push_back(std::move(events));
+        while (m_trace.size() > m_traceFrames) m_trace.pop_front();
+    }
+}
+
+std::string GpuProfiler::summary() const {
+    std::string text;
+    char buffer[96];
+    for (const GpuScopeStats& stats : m_stats) {
+        if (stats.depth > 1 || stats.samples == 0) continue;
+        if (!text.empty()) text += " | ";
+        const char* unit = stats.depth == 0 ? " ms" : "";
+        std::snprintf(buffer, sizeof(buffer), "%s %.2f%s", stats.name.c_str(), stats.averageMs, unit);
+        text += buffer;
+    }
+    return text;
+}
+
+void GpuProfiler::setTraceFrames(size_t frames) {
+    m_traceFrames = frames;
+    while (m_trace.size() > m_traceFrames) m_trace.pop_front();
+}
+
+bool GpuProfiler::writeTrace(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        std::cerr << "Failed to write GPU trace: " << path << "\n";
+        return false;
+    }
+
+    // Chrome trace timestamps are microseconds; GL's are nanoseconds from an
+    // arbitrary origin, so they are shifted to start at 0.
+    uint64_t origin = 0;
+    if (!m_trace.empty() && !m_trace.front().empty()) origin = m_trace.front().front().begin;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+    char buffer[96];
+    for (const std::vector<TraceEvent>& frame : m_trace) {
+        for (const TraceEvent& event : frame) {
+            out << ",\n{\"name\":\"";
+            writeEscaped(out, m_stats[event.name].name);
+            std::snprintf(
+                buffer,
+                sizeof(buffer),
+                "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                static_cast<double>(event.begin - origin) * 1e-3,
+                static_cast<double>(event.end - event.begin) * 1e-3
+            );
+            out << buffer;
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
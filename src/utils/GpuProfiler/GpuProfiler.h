@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Rolling GPU time of one named scope, over the last GpuProfiler::HISTORY
+// frames it ran in. Several scopes with the same name in one frame add up.
+struct GpuScopeStats {
+    std::string name;
+    // Nesting depth where the scope was first seen; the frame itself is 0.
+    int depth = 0;
+    double lastMs = 0.0;
+    double averageMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    uint32_t samples = 0;
+};
+
+// GPU timing of nested scopes. Each scope brackets its commands with two
+// GL_TIMESTAMP queries (GL_TIME_ELAPSED cannot nest), taken from a pool that
+// grows to the busiest frame and is then reused. Results are read back
+// FRAME_LATENCY frames later, once the GPU has caught up, so the CPU never
+// waits on them; if the GPU falls further behind, whole frames go unmeasured
+// instead of stalling.
+//
+// beginFrame() opens a root scope named "frame". Resolved frames feed the
+// rolling stats and, when enabled, a buffer written out as a Chrome trace
+// (chrome://tracing or Perfetto).
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY = 4;
+    static constexpr uint32_t HISTORY = 120;
+
+    class Scope {
+    public:
+        Scope(GpuProfiler& profiler, const std::string& name) : m_profiler(profiler) { m_profiler.begin(name); }
+        ~Scope() { m_profiler.end(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        GpuProfiler& m_profiler;
+    };
+
+    GpuProfiler() = default;
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    void beginFrame();
+    // Closes the frame and resolves every earlier frame the GPU has finished.
+    void endFrame();
+
+    // Scopes must nest and close within the frame they opened in.
+    void begin(const std::string& name);
+    void end();
+
+    // In the order scopes were first seen.
+    const std::vector<GpuScopeStats>& stats() const { return m_stats; }
+    // Top-level scopes as "frame 3.10 ms | opaque 1.92 | ...", averaged.
+    std::string summary() const;
+    // Frames skipped because their queries were still in flight.
+    uint64_t droppedFrames() const { return m_droppedFrames; }
+
+    // Keeps the last `frames` resolved frames for writeTrace(); 0 stops recording.
+    void setTraceFrames(size_t frames);
+    bool writeTrace(const std::string& path) const;
+
+private:
+    struct Marker {
+        uint32_t name;
+        uint32_t depth;
+        GLuint begin;
+        GLuint end = 0;
+    };
+
+    struct Frame {
+        std::vector<Marker> markers;
+        bool pending = false;
+    };
+
+    struct TraceEvent {
+        uint32_t name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    struct History {
+        float ms[HISTORY] = {};
+        uint32_t next = 0;
+        uint32_t count = 0;
+    };
+
+    GLuint acquireQuery();
+    uint32_t intern(const std::string& name, uint32_t depth);
+    void resolve(Frame& frame);
+
+    std::vector<GLuint> m_queries;
+    std::vector<GLuint> m_freeQueries;
+    Frame m_frames[FRAME_LATENCY];
+    int m_current = 0;
+    bool m_recording = false;
+    // Open markers of the current frame, innermost last.
+    std::vector<uint32_t> m_open;
+    // Scopes opened in a frame that is not being recorded.
+    uint32_t m_skippedDepth = 0;
+    uint64_t m_droppedFrames = 0;
+
+    std::unordered_map<std::string, uint32_t> m_names;
+    std::vector<GpuScopeStats> m_stats;
+    std::vector<History> m_history;
+    // Per-name sums while resolving one frame.
+    std::vector<double> m_frameMs;
+    std::vector<uint8_t> m_seen;
+
+    size_t m_traceFrames = 0;
+    std::deque<std::vector<TraceEvent>> m_trace;
+};
@@ -0,0 +1,129 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace {
+    bool hasExtension(const char* extensions, const char* name) {
+        if (!extensions) return false;
+        size_t length = std::strlen(name);
+        for (const char* at = std::strstr(extensions, name); at; at = std::strstr(at + length, name)) {
+            bool starts = at == extensions || at[-1] == ' ';
+            bool ends = at[length] == ' ' || at[length] == '\0';
+            if (starts && ends) return true;
+        }
+        return false;
+    }
+
+    void reportError(const char* what) {
+        std::cerr << what << " (EGL error 0x" << std::hex << eglGetError() << std::dec << ")\n";
+    }
+}
+#endif
+
+HeadlessContext::HeadlessContext() {
+#if defined(__linux__)
+    // Surfaceless needs no X11 or Wayland server and no DRM device.
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (hasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT")
+        );
+        if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && !eglInitialize(display, nullptr, nullptr)) display = EGL_NO_DISPLAY;
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            reportError("Failed to initialize an EGL display");
+            return;
+        }
+    }
+    m_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        reportError("EGL display does not support desktop OpenGL");
+        return;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE,
+    };
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &configCount);
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (configCount == 0) {
+        // Fine for a surfaceless context, which never draws to a surface.
+        if (!hasExtension(extensions, "EGL_KHR_no_config_context") &&
+            !hasExtension(extensions, "EGL_MESA_configless_context")) {
+            reportError("No EGL config supports OpenGL pbuffers");
+            return;
+        }
+        config = EGL_NO_CONFIG_KHR;
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        reportError("Failed to create an OpenGL 3.3 core context");
+        return;
+    }
+
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (!hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+        const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        if (configCount > 0) surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        if (surface == EGL_NO_SURFACE) {
+            reportError("Failed to create an EGL pbuffer");
+            eglDestroyContext(display, context);
+            return;
+        }
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        reportError("Failed to make the headless context current");
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglDestroyContext(display, context);
+        return;
+    }
+    m_context = context;
+    m_surface = surface;
+#else
+    std::cerr << "Headless rendering needs EGL, which this platform's build does not use\n";
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+#if defined(__linux__)
+    if (!m_display) return;
+    if (m_context) {
+        eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_surface) eglDestroySurface(m_display, m_surface);
+        eglDestroyContext(m_display, m_context);
+    }
+    eglTerminate(m_display);
+#endif
+}
+
+void* HeadlessContext::getProcAddress(const char* name) {
+#if defined(__linux__)
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+#else
+    (void)name;
+    return nullptr;
+#endif
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// An OpenGL 3.3 core context with no window, for machines without a display
+// or GPU. On Linux it comes from EGL: Mesa's surfaceless platform where
+// available (llvmpipe included), otherwise the default display with a
+// one-pixel pbuffer to make current. Other platforms have no headless path.
+//
+// There is no default framebuffer worth drawing to; render into FBOs.
+class HeadlessContext {
+public:
+    // Creates the context and makes it current on the calling thread. Check
+    // valid(); failures are reported on std::cerr.
+    HeadlessContext();
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool valid() const { return m_context != nullptr; }
+    // "surfaceless" or "pbuffer".
+    const char* kind() const { return m_surface ? "pbuffer" : "surfaceless"; }
+
+    // For gladLoadGLLoader.
+    static void* getProcAddress(const char* name);
+
+private:
+    // EGL handles, kept opaque so this header needs no EGL headers.
+    void* m_display = nullptr;
+    void* m_context = nullptr;
+    void* m_surface = nullptr;
+};
@@ -0,0 +1,295 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    constexpr size_t MIN_MATCH = 3;
+    constexpr size_t MAX_MATCH = 258;
+    constexpr size_t WINDOW = 32768;
+    constexpr int HASH_BITS = 15;
+    constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+    constexpr uint16_t LENGTH_BASE[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+    };
+    constexpr uint8_t LENGTH_EXTRA[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+    };
+    constexpr uint16_t DISTANCE_BASE[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+    };
+    constexpr uint8_t DISTANCE_EXTRA[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+    };
+
+    uint32_t reverseBits(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        return reversed;
+    }
+
+    // Deflate's fixed codes (RFC 1951, 3.2.6), bit-reversed because the
+    // stream is packed least significant bit first.
+    struct FixedCodes {
+        uint16_t literal[288];
+        uint8_t literalBits[288];
+        uint8_t distance[30];
+        // Index into LENGTH_BASE for each match length.
+        uint8_t lengthIndex[MAX_MATCH + 1];
+
+        FixedCodes() {
+            for (uint32_t symbol = 0; symbol < 288; ++symbol) {
+                uint32_t code = 0xC0 + symbol - 280;
+                uint32_t bits = 8;
+                if (symbol < 144) {
+                    code = 0x30 + symbol;
+                } else if (symbol < 256) {
+                    code = 0x190 + symbol - 144;
+                    bits = 9;
+                } else if (symbol < 280) {
+                    code = symbol - 256;
+                    bits = 7;
+                }
+                literal[symbol] = static_cast<uint16_t>(reverseBits(code, static_cast<int>(bits)));
+                literalBits[symbol] = static_cast<uint8_t>(bits);
+            }
+            for (uint32_t symbol = 0; symbol < 30; ++symbol) {
+                distance[symbol] = static_cast<uint8_t>(reverseBits(symbol, 5));
+            }
+            uint8_t index = 0;
+            for (size_t length = MIN_MATCH; length <= MAX_MATCH; ++length) {
+                while (index + 1 < 29 && LENGTH_BASE[index + 1] <= length) ++index;
+                lengthIndex[length] = index;
+            }
+        }
+    };
+
+    const FixedCodes& fixedCodes() {
+        static const FixedCodes codes;
+        return codes;
+    }
+
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+        void put(uint32_t value, int bits) {
+            m_bits |= static_cast<uint64_t>(value) << m_count;
+            m_count += bits;
+            while (m_count >= 8) {
+                m_out.push_back(static_cast<uint8_t>(m_bits));
+                m_bits >>= 8;
+                m_count -= 8;
+            }
+        }
+
+        void flush() {
+            if (m_count > 0) m_out.push_back(static_cast<uint8_t>(m_bits));
+            m_bits = 0;
+            m_count = 0;
+        }
+
+    private:
+        std::vector<uint8_t>& m_out;
+        uint64_t m_bits = 0;
+        int m_count = 0;
+    };
+
+    uint32_t hash3(const uint8_t* p) {
+        uint32_t value = p[0] | (p[1] << 8) | (p[2] << 16);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // One fixed-Huffman block. Each position checks only the most recent
+    // earlier occurrence of its first three bytes: no chains, no lazy matching.
+    void deflateFixed(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        const FixedCodes& codes = fixedCodes();
+        BitWriter bits(out);
+        bits.put(1, 1); // last block
+        bits.put(1, 2); // fixed codes
+
+        std::vector<uint32_t> head(size_t(1) << HASH_BITS, NO_POSITION);
+        size_t i = 0;
+        while (i < size) {
+            size_t length = 0;
+            size_t distance = 0;
+            if (i + MIN_MATCH <= size) {
+                uint32_t h = hash3(data + i);
+                uint32_t candidate = head[h];
+                head[h] = static_cast<uint32_t>(i);
+                if (candidate != NO_POSITION && i - candidate <= WINDOW) {
+                    size_t limit = std::min(MAX_MATCH, size - i);
+                    size_t n = 0;
+                    while (n < limit && data[candidate + n] == data[i + n]) ++n;
+                    if (n >= MIN_MATCH) {
+                        length = n;
+                        distance = i - candidate;
+                    }
+                }
+            }
+
+            if (length == 0) {
+                bits.put(codes.literal[data[i]], codes.literalBits[data[i]]);
+                ++i;
+                continue;
+            }
+
+            uint8_t index = codes.lengthIndex[length];
+            uint32_t symbol = 257 + index;
+            bits.put(codes.literal[symbol], codes.literalBits[symbol]);
+            bits.put(static_cast<uint32_t>(length - LENGTH_BASE[index]), LENGTH_EXTRA[index]);
+            size_t d = static_cast<size_t>(std::upper_bound(DISTANCE_BASE, DISTANCE_BASE + 30, distance) - DISTANCE_BASE) - 1;
+            bits.put(codes.distance[d], 5);
+            bits.put(static_cast<uint32_t>(distance - DISTANCE_BASE[d]), DISTANCE_EXTRA[d]);
+
+            // Index the positions the match covers, so later data can refer into it.
+            for (size_t j = i + 1; j < i + length && j + MIN_MATCH <= size; ++j) {
+                head[hash3(data + j)] = static_cast<uint32_t>(j);
+            }
+            i += length;
+        }
+        bits.put(codes.literal[256], codes.literalBits[256]);
+        bits.flush();
+    }
+
+    uint32_t adler32(const uint8_t* data, size_t size) {
+        uint32_t a = 1, b = 0;
+        while (size > 0) {
+            // The largest run before b can overflow 32 bits.
+            size_t run = std::min<size_t>(size, 5552);
+            for (size_t i = 0; i < run; ++i) {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+            data += run;
+            size -= run;
+        }
+        return (b << 16) | a;
+    }
+
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+        out.insert(out.end(), {
+            static_cast<uint8_t>(value >> 24),
+            static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value),
+        });
+    }
+
+    void putChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+        putBigEndian(out, static_cast<uint32_t>(data.size()));
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        putBigEndian(out, crc32(out.data() + start, out.size() - start));
+    }
+
+    // Picks, per row, whichever of the None, Sub and Up filters leaves the
+    // smallest residuals; small, repetitive residuals are what LZ77 finds.
+    void filterRows(
+        int width,
+        int height,
+        int channels,
+        const uint8_t* pixels,
+        bool flip,
+        std::vector<uint8_t>& out
+    ) {
+        size_t stride = static_cast<size_t>(width) * channels;
+        out.resize((stride + 1) * height);
+        std::vector<uint8_t> candidates[3];
+        for (std::vector<uint8_t>& candidate : candidates) candidate.resize(stride);
+
+        const uint8_t* above = nullptr;
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* row = pixels + stride * static_cast<size_t>(flip ? height - 1 - y : y);
+            uint64_t costs[3] = {0, 0, 0};
+            for (size_t x = 0; x < stride; ++x) {
+                uint8_t left = x >= static_cast<size_t>(channels) ? row[x - channels] : 0;
+                uint8_t up = above ? above[x] : 0;
+                uint8_t values[3] = {row[x], static_cast<uint8_t>(row[x] - left), static_cast<uint8_t>(row[x] - up)};
+                for (int f = 0; f < 3; ++f) {
+                    candidates[f][x] = values[f];
+                    costs[f] += static_cast<uint64_t>(std::abs(static_cast<int8_t>(values[f])));
+                }
+            }
+            int best = static_cast<int>(std::min_element(costs, costs + 3) - costs);
+            uint8_t* dst = out.data() + (stride + 1) * y;
+            dst[0] = static_cast<uint8_t>(best);
+            std::copy(candidates[best].begin(), candidates[best].end(), dst + 1);
+            above = row;
+        }
+    }
+}
+
+namespace ImageWriter {
+    bool writePng(
+        const std::string& path,
+        int width,
+        int height,
+        int channels,
+        const uint8_t* pixels,
+        bool flipVertically
+    ) {
+        if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)) {
+            std::cerr << "Cannot write a " << width << "x" << height << "x" << channels << " PNG: " << path << "\n";
+            return false;
+        }
+
+        std::vector<uint8_t> filtered;
+        filterRows(width, height, channels, pixels, flipVertically, filtered);
+
+        std::vector<uint8_t> zlib = {0x78, 0x01};
+        zlib.reserve(filtered.size() / 2);
+        deflateFixed(filtered.data(), filtered.size(), zlib);
+        putBigEndian(zlib, adler32(filtered.data(), filtered.size()));
+
+        std::vector<uint8_t> header;
+        putBigEndian(header, static_cast<uint32_t>(width));
+        putBigEndian(header, static_cast<uint32_t>(height));
+        // 8 bits per channel; truecolour or truecolour with alpha; deflate,
+        // adaptive filtering, no interlace.
+        header.insert(header.end(), {8, static_cast<uint8_t>(channels == 4 ? 6 : 2), 0, 0, 0});
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        putChunk(png, "IHDR", header);
+        putChunk(png, "IDAT", zlib);
+        putChunk(png, "IEND", {});
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to write image: " << path << "\n";
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+        return static_cast<bool>(file);
+    }
+}
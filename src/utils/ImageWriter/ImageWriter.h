@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Image files written without third-party encoders.
+namespace ImageWriter {
+    // 8-bit RGB (3 channels) or RGBA (4) PNG, rows tightly packed. Compresses
+    // with a single-probe LZ77 and deflate's fixed Huffman codes, so files
+    // come out somewhat larger than zlib's; takes tens of milliseconds for a
+    // 1080p frame, meant for worker threads.
+    bool writePng(
+        const std::string& path,
+        int width,
+        int height,
+        int channels,
+        const uint8_t* pixels,
+        bool flipVertically = false
+    );
+}
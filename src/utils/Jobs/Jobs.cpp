@@ -0,0 +1,154 @@
+#include "Jobs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils/Profiler/Profiler.h"
+
+namespace {
+    struct Batch {
+        const std::function<void(size_t, size_t)>* fn = nullptr;
+        size_t count = 0;
+        size_t chunkSize = 1;
+        size_t chunkCount = 0;
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> doneChunks{0};
+    };
+
+    // Claims and runs chunks until the batch is exhausted.
+    // Returns true if this call finished the last chunk.
+    bool runChunks(Batch& batch) {
+        bool finishedLast = false;
+        for (;;) {
+            size_t chunk = batch.nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= batch.chunkCount) break;
+
+            size_t begin = chunk * batch.chunkSize;
+            size_t end = std::min(begin + batch.chunkSize, batch.count);
+            {
+                PROFILE_SCOPE("job");
+                (*batch.fn)(begin, end);
+            }
+
+            size_t done = batch.doneChunks.fetch_add(1, std::memory_order_acq_rel) + 1;
+            if (done == batch.chunkCount) finishedLast = true;
+        }
+        return finishedLast;
+    }
+
+    class Pool {
+    public:
+        Pool() {
+            unsigned int hw = std::thread::hardware_concurrency();
+            unsigned int workers = hw > 1 ? hw - 1 : 0;
+            m_threads.reserve(workers);
+            for (unsigned int i = 0; i < workers; ++i) {
+                m_threads.emplace_back([this, i] {
+                    PROFILE_THREAD("worker " + std::to_string(i + 1));
+                    workerLoop();
+                });
+            }
+        }
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_wake.notify_all();
+            for (auto& t : m_threads) t.join();
+        }
+
+        unsigned int threadCount() const {
+            return static_cast<unsigned int>(m_threads.size()) + 1;
+        }
+
+        void run(const std::shared_ptr<Batch>& batch) {
+            if (!m_threads.empty() && batch->chunkCount > 1) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_queue.push_back(batch);
+                }
+                m_wake.notify_all();
+            }
+
+            if (runChunks(*batch)) m_done.notify_all();
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [&] {
+                return batch->doneChunks.load(std::memory_order_acquire) == batch->chunkCount;
+            });
+            std::erase(m_queue, batch);
+        }
+
+    private:
+        void workerLoop() {
+            for (;;) {
+                std::shared_ptr<Batch> batch;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+                    if (m_stop) return;
+
+                    batch = m_queue.front();
+                    if (batch->nextChunk.load(std::memory_order_relaxed) >= batch->chunkCount) {
+                        m_queue.pop_front();
+                        continue;
+                    }
+                }
+
+                if (runChunks(*batch)) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_done.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> m_threads;
+        std::deque<std::shared_ptr<Batch>> m_queue;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        bool m_stop = false;
+    };
+
+    Pool& pool() {
+        static Pool instance;
+        return instance;
+    }
+}
+
+namespace Jobs {
+    unsigned int threadCount() {
+        return pool().threadCount();
+    }
+
+    void parallelFor(
+        size_t count,
+        size_t grain,
+        const std::function<void(size_t begin, size_t end)>& fn
+    ) {
+        if (count == 0) return;
+
+        grain = std::max<size_t>(grain, 1);
+        if (count <= grain || threadCount() == 1) {
+            fn(0, count);
+            return;
+        }
+
+        auto batch = std::make_shared<Batch>();
+        batch->fn = &fn;
+        batch->count = count;
+        batch->chunkSize = grain;
+        batch->chunkCount = (count + grain - 1) / grain;
+
+        pool().run(batch);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace Jobs {
+    // Threads that take part in a parallelFor: the pool workers plus the caller.
+    unsigned int threadCount();
+
+    // Splits [0, count) into ranges of roughly `grain` items and runs fn(begin, end)
+    // across the worker pool. The calling thread works too and returns once every
+    // range has finished, so nested calls cannot deadlock.
+    void parallelFor(
+        size_t count,
+        size_t grain,
+        const std::function<void(size_t begin, size_t end)>& fn
+    );
+}
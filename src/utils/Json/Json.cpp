@@ -0,0 +1,239 @@
+#include "Json.h"
+
+#include <charconv>
+#include <cstdint>
+
+namespace Json {
+    static const Value NULL_VALUE;
+
+    size_t Value::size() const {
+        if (m_type == Type::Array) return m_items.size();
+        if (m_type == Type::Object) return m_members.size();
+        return 0;
+    }
+
+    const Value& Value::operator[](std::string_view key) const {
+        if (m_type != Type::Object) return NULL_VALUE;
+        for (const auto& [name, value] : m_members) {
+            if (name == key) return value;
+        }
+        return NULL_VALUE;
+    }
+
+    const Value& Value::operator[](size_t index) const {
+        if (m_type != Type::Array || index >= m_items.size()) return NULL_VALUE;
+        return m_items[index];
+    }
+
+    bool Value::has(std::string_view key) const {
+        return &(*this)[key] != &NULL_VALUE;
+    }
+
+    class Parser {
+    public:
+        explicit Parser(std::string_view text) : m_text(text) {}
+
+        bool parseDocument(Value& out, std::string& error) {
+            skipWhitespace();
+            if (!parseValue(out, 0)) {
+                error = m_error + " at offset " + std::to_string(m_pos);
+                return false;
+            }
+            skipWhitespace();
+            if (m_pos != m_text.size()) {
+                error = "trailing characters at offset " + std::to_string(m_pos);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr int MAX_DEPTH = 256;
+
+        bool fail(const char* message) {
+            m_error = message;
+            return false;
+        }
+
+        void skipWhitespace() {
+            while (m_pos < m_text.size()) {
+                char c = m_text[m_pos];
+                if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+                ++m_pos;
+            }
+        }
+
+        bool consume(char c) {
+            skipWhitespace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c) {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool matchLiteral(std::string_view literal) {
+            if (m_text.substr(m_pos, literal.size()) != literal) return false;
+            m_pos += literal.size();
+            return true;
+        }
+
+        bool parseValue(Value& out, int depth) {
+            if (depth > MAX_DEPTH) return fail("nesting too deep");
+
+            skipWhitespace();
+            if (m_pos >= m_text.size()) return fail("unexpected end of input");
+
+            char c = m_text[m_pos];
+            if (c == '{') return parseObject(out, depth);
+            if (c == '[') return parseArray(out, depth);
+            if (c == '"') {
+                out.m_type = Type::String;
+                return parseString(out.m_string);
+            }
+            if (matchLiteral("true")) {
+                out.m_type = Type::Bool;
+                out.m_bool = true;
+                return true;
+            }
+            if (matchLiteral("false")) {
+                out.m_type = Type::Bool;
+                out.m_bool = false;
+                return true;
+            }
+            if (matchLiteral("null")) {
+                out.m_type = Type::Null;
+                return true;
+            }
+            return parseNumber(out);
+        }
+
+        bool parseObject(Value& out, int depth) {
+            out.m_type = Type::Object;
+            ++m_pos;
+            if (consume('}')) return true;
+
+            do {
+                skipWhitespace();
+                if (m_pos >= m_text.size() || m_text[m_pos] != '"') return fail("expected object key");
+
+                std::string key;
+                if (!parseString(key)) return false;
+                if (!consume(':')) return fail("expected ':'");
+
+                out.m_members.emplace_back(std::move(key), Value());
+                if (!parseValue(out.m_members.back().second, depth + 1)) return false;
+            } while (consume(','));
+
+            if (!consume('}')) return fail("expected '}'");
+            return true;
+        }
+
+        bool parseArray(Value& out, int depth) {
+            out.m_type = Type::Array;
+            ++m_pos;
+            if (consume(']')) return true;
+
+            do {
+                out.m_items.emplace_back();
+                if (!parseValue(out.m_items.back(), depth + 1)) return false;
+            } while (consume(','));
+
+            if (!consume(']')) return fail("expected ']'");
+            return true;
+        }
+
+        bool parseNumber(Value& out) {
+            const char* begin = m_text.data() + m_pos;
+            const char* end = m_text.data() + m_text.size();
+
+            double value = 0.0;
+            auto result = std::from_chars(begin, end, value);
+            if (result.ec != std::errc()) return fail("invalid value");
+
+            out.m_type = Type::Number;
+            out.m_number = value;
+            m_pos += static_cast<size_t>(result.ptr - begin);
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, uint32_t cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            } else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+
+        bool parseHex4(uint32_t& out) {
+            if (m_pos + 4 > m_text.size()) return fail("truncated unicode escape");
+            const char* begin = m_text.data() + m_pos;
+            auto result = std::from_chars(begin, begin + 4, out, 16);
+            if (result.ec != std::errc() || result.ptr != begin + 4) return fail("invalid unicode escape");
+            m_pos += 4;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            ++m_pos;
+            for (;;) {
+                size_t start = m_pos;
+                while (m_pos < m_text.size() && m_text[m_pos] != '"' && m_text[m_pos] != '\\') ++m_pos;
+                out.append(m_text.substr(start, m_pos - start));
+
+                if (m_pos >= m_text.size()) return fail("unterminated string");
+                if (m_text[m_pos] == '"') {
+                    ++m_pos;
+                    return true;
+                }
+
+                ++m_pos;
+                if (m_pos >= m_text.size()) return fail("unterminated escape");
+                char e = m_text[m_pos++];
+                switch (e) {
+                    case '"': out.push_back('"'); break;
+                    case '\\': out.push_back('\\'); break;
+                    case '/': out.push_back('/'); break;
+                    case 'b': out.push_back('\b'); break;
+                    case 'f': out.push_back('\f'); break;
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u': {
+                        uint32_t cp = 0;
+                        if (!parseHex4(cp)) return false;
+                        if (cp >= 0xD800 && cp <= 0xDBFF && matchLiteral("\\u")) {
+                            uint32_t low = 0;
+                            if (!parseHex4(low)) return false;
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, cp);
+                        break;
+                    }
+                    default:
+                        return fail("invalid escape");
+                }
+            }
+        }
+
+        std::string_view m_text;
+        size_t m_pos = 0;
+        std::string m_error;
+    };
+
+    bool parse(std::string_view text, Value& out, std::string& error) {
+        out = Value();
+        Parser parser(text);
+        return parser.parseDocument(out, error);
+    }
+}
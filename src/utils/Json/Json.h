@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal JSON DOM, enough for glTF documents and small config files.
+namespace Json {
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    class Value {
+    public:
+        Type type() const { return m_type; }
+
+        bool isNull() const { return m_type == Type::Null; }
+        bool isBool() const { return m_type == Type::Bool; }
+        bool isNumber() const { return m_type == Type::Number; }
+        bool isString() const { return m_type == Type::String; }
+        bool isArray() const { return m_type == Type::Array; }
+        bool isObject() const { return m_type == Type::Object; }
+
+        bool asBool(bool fallback = false) const { return isBool() ? m_bool : fallback; }
+        double asNumber(double fallback = 0.0) const { return isNumber() ? m_number : fallback; }
+        int asInt(int fallback = 0) const { return isNumber() ? static_cast<int>(m_number) : fallback; }
+        const std::string& asString() const { return m_string; }
+
+        // Arrays and objects; other types have size 0.
+        size_t size() const;
+
+        // Missing keys and out-of-range indices return a shared null value.
+        const Value& operator[](std::string_view key) const;
+        const Value& operator[](size_t index) const;
+        bool has(std::string_view key) const;
+
+        const std::vector<Value>& items() const { return m_items; }
+        const std::vector<std::pair<std::string, Value>>& members() const { return m_members; }
+
+    private:
+        friend class Parser;
+
+        Type m_type = Type::Null;
+        bool m_bool = false;
+        double m_number = 0.0;
+        std::string m_string;
+        std::vector<Value> m_items;
+        std::vector<std::pair<std::string, Value>> m_members;
+    };
+
+    // Returns false and fills `error` on malformed input.
+    bool parse(std::string_view text, Value& out, std::string& error);
+}
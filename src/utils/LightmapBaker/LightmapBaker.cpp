@@ -0,0 +1,532 @@
+#include "LightmapBaker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "utils/AtomicFile/AtomicFile.h"
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+    // Ray origins are pushed this far off their surface.
+    constexpr float SURFACE_OFFSET = 2e-3f;
+    // Lights adding less than this (before the shadow ray) are skipped.
+    constexpr float MIN_CONTRIBUTION = 1e-4f;
+    // Bounces after which paths may be cut by Russian roulette.
+    constexpr int ROULETTE_BOUNCE = 2;
+    // Texel coverage.
+    constexpr uint8_t EMPTY = 0;
+    // Centre within reach of a triangle, snapped onto it.
+    constexpr uint8_t EDGE = 1;
+    constexpr uint8_t INSIDE = 2;
+
+    uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // PCG step per draw, seeded from a hash.
+    struct Random {
+        uint32_t state;
+
+        float next() {
+            state = state * 747796405u + 2891336453u;
+            uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+            word = (word >> 22u) ^ word;
+            return static_cast<float>(word >> 8) / 16777216.0f;
+        }
+    };
+
+    glm::vec3 cosineSample(const glm::vec3& n, Random& random) {
+        float r1 = random.next();
+        float r2 = random.next();
+        float phi = 2.0f * PI * r1;
+        float r = std::sqrt(r2);
+
+        // Orthonormal basis around n (Duff et al. 2017).
+        float sign = std::copysign(1.0f, n.z);
+        float a = -1.0f / (sign + n.z);
+        float b = n.x * n.y * a;
+        glm::vec3 t(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+        glm::vec3 s(b, sign + n.y * n.y * a, -n.y);
+        return glm::normalize(t * (r * std::cos(phi)) + s * (r * std::sin(phi)) + n * std::sqrt(std::max(0.0f, 1.0f - r2)));
+    }
+
+    float luminance(const glm::vec3& c) {
+        return glm::dot(c, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+    }
+
+    uint64_t cellKey(const glm::ivec3& c) {
+        auto bits = [](int v) { return static_cast<uint64_t>(v) & 0x1FFFFFu; };
+        return (bits(c.x) << 42) | (bits(c.y) << 21) | bits(c.z);
+    }
+
+    void writeRGBE(const glm::vec3& c, uint8_t* out) {
+        float v = std::max(c.r, std::max(c.g, c.b));
+        if (v < 1e-32f) {
+            out[0] = out[1] = out[2] = out[3] = 0;
+            return;
+        }
+        int exponent;
+        float scale = std::frexp(v, &exponent) * 256.0f / v;
+        out[0] = static_cast<uint8_t>(std::max(0.0f, c.r) * scale);
+        out[1] = static_cast<uint8_t>(std::max(0.0f, c.g) * scale);
+        out[2] = static_cast<uint8_t>(std::max(0.0f, c.b) * scale);
+        out[3] = static_cast<uint8_t>(exponent + 128);
+    }
+
+    // One channel of a scanline in the Radiance run-length scheme: runs of at
+    // least four equal bytes become (128 + length, value), the rest literals.
+    void writeRuns(const uint8_t* data, int count, std::vector<uint8_t>& out) {
+        int cur = 0;
+        while (cur < count) {
+            int runStart = cur;
+            int run = 0;
+            int previousRun = 0;
+            while (run < 4 && runStart < count) {
+                runStart += run;
+                previousRun = run;
+                run = 1;
+                while (runStart + run < count && run < 127 && data[runStart + run] == data[runStart]) ++run;
+            }
+            // A short run right before the long one.
+            if (previousRun > 1 && previousRun == runStart - cur) {
+                out.push_back(static_cast<uint8_t>(128 + previousRun));
+                out.push_back(data[cur]);
+                cur = runStart;
+            }
+            while (cur < runStart) {
+                int literal = std::min(128, runStart - cur);
+                out.push_back(static_cast<uint8_t>(literal));
+                out.insert(out.end(), data + cur, data + cur + literal);
+                cur += literal;
+            }
+            if (run >= 4) {
+                out.push_back(static_cast<uint8_t>(128 + run));
+                out.push_back(data[runStart]);
+                cur += run;
+            }
+        }
+    }
+}
+
+void LightmapBaker::addMesh(
+    std::span<const Vertex> vertices,
+    std::span<const uint32_t> indices,
+    std::span<const glm::vec3> materialAlbedo,
+    Role role,
+    const glm::mat4& transform
+) {
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Receiver r;
+        glm::vec3 albedo(0.0f);
+        glm::vec3 normalSum(0.0f);
+        for (int c = 0; c < 3; ++c) {
+            const Vertex& v = vertices[indices[i + c]];
+            r.uv[c] = v.lightmapUV;
+            r.position[c] = glm::vec3(transform * glm::vec4(v.position, 1.0f));
+            r.normal[c] = normalMatrix * v.normal;
+            glm::vec3 material = v.material < materialAlbedo.size() ? materialAlbedo[v.material] : glm::vec3(DEFAULT_ALBEDO);
+            albedo += material * v.color / 3.0f;
+            normalSum += r.normal[c];
+        }
+
+        glm::vec3 face = glm::cross(r.position[1] - r.position[0], r.position[2] - r.position[0]);
+        if (glm::length(face) <= 0.0f) continue;
+        face = glm::normalize(face);
+        // Procedural quads do not promise a winding; the vertex normals pick the front.
+        if (glm::dot(face, normalSum) < 0.0f) face = -face;
+
+        if (role != Role::Transparent) {
+            m_corners.insert(m_corners.end(), r.position, r.position + 3);
+            m_surfaces.push_back({face, glm::clamp(albedo, 0.0f, 1.0f)});
+        }
+        if (role != Role::Occluder) m_receivers.push_back(r);
+    }
+}
+
+void LightmapBaker::setLights(std::span<const Light> lights) {
+    m_lights.assign(lights.begin(), lights.end());
+}
+
+void LightmapBaker::setSun(const glm::vec3& direction, const glm::vec3& color) {
+    m_sunDirection = glm::normalize(direction);
+    m_sunColor = color;
+}
+
+void LightmapBaker::LightGrid::build(std::span<const Light> source) {
+    cellSize = 0.5f;
+    for (const Light& light : source) cellSize = std::max(cellSize, light.range);
+
+    std::vector<std::pair<uint64_t, uint32_t>> entries;
+    for (uint32_t i = 0; i < source.size(); ++i) {
+        const Light& light = source[i];
+        glm::ivec3 lo = glm::ivec3(glm::floor((light.position - light.range) / cellSize));
+        glm::ivec3 hi = glm::ivec3(glm::floor((light.position + light.range) / cellSize));
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x) entries.push_back({cellKey({x, y, z}), i});
+    }
+    std::sort(entries.begin(), entries.end());
+
+    keys.clear();
+    ranges.clear();
+    lights.clear();
+    lights.reserve(entries.size());
+    for (const auto& [key, light] : entries) {
+        if (keys.empty() || keys.back() != key) {
+            keys.push_back(key);
+            ranges.push_back({static_cast<uint32_t>(lights.size()), 0u});
+        }
+        lights.push_back(light);
+        ++ranges.back().y;
+    }
+}
+
+std::span<const uint32_t> LightmapBaker::LightGrid::query(const glm::vec3& p) const {
+    uint64_t key = cellKey(glm::ivec3(glm::floor(p / cellSize)));
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) return {};
+    const glm::uvec2& range = ranges[static_cast<size_t>(it - keys.begin())];
+    return std::span<const uint32_t>(lights).subspan(range.x, range.y);
+}
+
+void LightmapBaker::rasterize(int width, int height) {
+    size_t texelCount = static_cast<size_t>(width) * height;
+    m_positions.assign(texelCount, glm::vec3(0.0f));
+    m_normals.assign(texelCount, glm::vec3(0.0f));
+    m_coverage.assign(texelCount, EMPTY);
+
+    double worldArea = 0.0, texelArea = 0.0;
+    glm::vec2 size(width, height);
+    for (const Receiver& r : m_receivers) {
+        glm::vec2 p[3] = {r.uv[0] * size, r.uv[1] * size, r.uv[2] * size};
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+        if (std::abs(area) < 1e-8f) continue;
+        worldArea += 0.5 * glm::length(glm::cross(r.position[1] - r.position[0], r.position[2] - r.position[0]));
+        texelArea += 0.5 * std::abs(area);
+
+        glm::vec2 lo = glm::min(p[0], glm::min(p[1], p[2]));
+        glm::vec2 hi = glm::max(p[0], glm::max(p[1], p[2]));
+        int x0 = std::max(0, static_cast<int>(std::floor(lo.x - 1.0f)));
+        int y0 = std::max(0, static_cast<int>(std::floor(lo.y - 1.0f)));
+        int x1 = std::min(width - 1, static_cast<int>(std::ceil(hi.x + 1.0f)));
+        int y1 = std::min(height - 1, static_cast<int>(std::ceil(hi.y + 1.0f)));
+
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                glm::vec2 c(x + 0.5f, y + 0.5f);
+                auto edge = [&](const glm::vec2& a, const glm::vec2& b) {
+                    return ((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) / area;
+                };
+                glm::vec3 w(edge(p[1], p[2]), edge(p[2], p[0]), edge(p[0], p[1]));
+                bool inside = w.x >= -1e-5f && w.y >= -1e-5f && w.z >= -1e-5f;
+
+                size_t texel = static_cast<size_t>(y) * width + x;
+                if (!inside) {
+                    // Texels whose centre misses every triangle but whose
+                    // footprint touches one still get a sample, snapped onto it.
+                    if (m_coverage[texel] != EMPTY) continue;
+                    w = glm::max(w, 0.0f);
+                    w /= w.x + w.y + w.z;
+                    glm::vec2 snapped = p[0] * w.x + p[1] * w.y + p[2] * w.z;
+                    if (glm::length(snapped - c) > 0.75f) continue;
+                } else if (m_coverage[texel] == INSIDE) {
+                    continue;
+                }
+
+                glm::vec3 normal = r.normal[0] * w.x + r.normal[1] * w.y + r.normal[2] * w.z;
+                if (glm::length(normal) <= 0.0f) continue;
+                m_positions[texel] = r.position[0] * w.x + r.position[1] * w.y + r.position[2] * w.z;
+                m_normals[texel] = glm::normalize(normal);
+                m_coverage[texel] = inside ? INSIDE : EDGE;
+            }
+        }
+    }
+    m_texelSize = texelArea > 0.0 ? static_cast<float>(std::sqrt(worldArea / texelArea)) : 1.0f;
+}
+
+glm::vec3 LightmapBaker::directLight(const glm::vec3& position, const glm::vec3& normal) const {
+    glm::vec3 light(0.0f);
+    glm::vec3 origin = position + normal * SURFACE_OFFSET;
+
+    float sun = glm::dot(normal, -m_sunDirection);
+    if (sun > 0.0f && luminance(m_sunColor) > 0.0f) {
+        Ray ray;
+        ray.origin = origin;
+        ray.direction = -m_sunDirection;
+        if (!m_bvh.occluded(ray)) light += m_sunColor * sun;
+    }
+
+    // Same falloff and cone as the room shaders.
+    for (uint32_t i : m_lightGrid.query(position)) {
+        const Light& l = m_lights[i];
+        glm::vec3 toLight = l.position - position;
+        float distance = glm::length(toLight);
+        if (distance >= l.range) continue;
+        glm::vec3 dir = toLight / std::max(distance, 1e-4f);
+        float window = glm::clamp(1.0f - std::pow(distance / l.range, 4.0f), 0.0f, 1.0f);
+        float attenuation = window * window / (distance * distance + 1.0f);
+        float cone = 1.0f;
+        if (l.type == LightType::Spot) {
+            float cosInner = std::cos(l.innerAngle), cosOuter = std::cos(l.outerAngle);
+            float t = glm::clamp((glm::dot(-dir, l.direction) - cosOuter) / std::max(cosInner - cosOuter, 1e-4f), 0.0f, 1.0f);
+            cone = t * t * (3.0f - 2.0f * t);
+        }
+        float diffuse = std::max(glm::dot(normal, dir), 0.0f) * attenuation * cone * l.intensity;
+        if (diffuse < MIN_CONTRIBUTION) continue;
+
+        Ray ray;
+        ray.origin = origin;
+        ray.direction = l.position - origin;
+        ray.tMax = 1.0f - 1e-3f;
+        if (!m_bvh.occluded(ray)) light += l.color * diffuse;
+    }
+    return light;
+}
+
+glm::vec3 LightmapBaker::tracePath(glm::vec3 position, glm::vec3 normal, uint32_t seed, int maxBounces) const {
+    Random random{seed};
+    glm::vec3 radiance(0.0f);
+    glm::vec3 throughput(1.0f);
+
+    for (int bounce = 0; bounce < maxBounces; ++bounce) {
+        Ray ray;
+        ray.origin = position + normal * SURFACE_OFFSET;
+        ray.direction = cosineSample(normal, random);
+
+        RayHit hit;
+        if (!m_bvh.intersect(ray, hit)) {
+            radiance += throughput * m_sky;
+            break;
+        }
+        const Surface& surface = m_surfaces[hit.primitive];
+        // Inside a wall or behind a one-sided surface: no light gets here.
+        if (glm::dot(surface.normal, ray.direction) > 0.0f) break;
+
+        position = ray.origin + ray.direction * hit.t;
+        normal = surface.normal;
+        throughput *= surface.albedo;
+        radiance += throughput * directLight(position, normal);
+
+        if (bounce + 1 >= ROULETTE_BOUNCE) {
+            float survive = glm::clamp(std::max(throughput.r, std::max(throughput.g, throughput.b)), 0.05f, 1.0f);
+            if (random.next() >= survive) break;
+            throughput /= survive;
+        }
+    }
+    return radiance;
+}
+
+void LightmapBaker::bake(
+    int width,
+    int height,
+    const LightmapBakeOptions& options,
+    std::vector<glm::vec3>& texels,
+    const Progress& progress
+) {
+    m_stats = {};
+    m_stats.triangles = m_surfaces.size();
+    size_t texelCount = static_cast<size_t>(width) * height;
+    texels.assign(texelCount, glm::vec3(0.0f));
+    if (width <= 0 || height <= 0) return;
+
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    m_bvh.build(m_corners);
+    m_lightGrid.build(m_lights);
+    rasterize(width, height);
+
+    // Only tiles with covered texels are traced.
+    int tileSize = std::max(1, options.tileSize);
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+    std::vector<uint32_t> tiles;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            bool covered = false;
+            for (int y = ty * tileSize; y < std::min(height, (ty + 1) * tileSize) && !covered; ++y) {
+                for (int x = tx * tileSize; x < std::min(width, (tx + 1) * tileSize); ++x) {
+                    if (m_coverage[static_cast<size_t>(y) * width + x] != EMPTY) {
+                        covered = true;
+                        break;
+                    }
+                }
+            }
+            if (covered) tiles.push_back(static_cast<uint32_t>(ty * tilesX + tx));
+        }
+    }
+    for (uint8_t c : m_coverage) m_stats.texels += c != EMPTY;
+
+    std::vector<glm::vec3> sum(texelCount, glm::vec3(0.0f));
+    std::vector<float> sumSquares(texelCount, 0.0f);
+    int samples = std::max(1, options.samplesPerPass);
+    int passes = std::max(1, options.passes);
+    uint32_t seed = hash(options.seed);
+
+    for (int pass = 0; pass < passes; ++pass) {
+        Jobs::parallelFor(tiles.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; ++t) {
+                int tx = static_cast<int>(tiles[t] % tilesX);
+                int ty = static_cast<int>(tiles[t] / tilesX);
+                for (int y = ty * tileSize; y < std::min(height, (ty + 1) * tileSize); ++y) {
+                    for (int x = tx * tileSize; x < std::min(width, (tx + 1) * tileSize); ++x) {
+                        size_t texel = static_cast<size_t>(y) * width + x;
+                        if (m_coverage[texel] == EMPTY) continue;
+                        uint32_t texelSeed = hash(seed ^ static_cast<uint32_t>(texel));
+                        for (int s = 0; s < samples; ++s) {
+                            uint32_t pathSeed = hash(texelSeed + static_cast<uint32_t>(pass * samples + s) * 0x9E3779B9u);
+                            glm::vec3 c = tracePath(m_positions[texel], m_normals[texel], pathSeed, options.maxBounces);
+                            sum[texel] += c;
+                            sumSquares[texel] += luminance(c) * luminance(c);
+                        }
+                    }
+                }
+            }
+        });
+        m_stats.passes = pass + 1;
+        m_stats.paths += static_cast<uint64_t>(m_stats.texels) * samples;
+        if (progress) progress(pass + 1, passes);
+        if (options.timeLimitMs > 0.0 && elapsed(start) >= options.timeLimitMs) break;
+    }
+    m_stats.traceMs = elapsed(start);
+
+    float n = static_cast<float>(m_stats.passes * samples);
+    m_variance.assign(texelCount, 0.0f);
+    for (size_t i = 0; i < texelCount; ++i) {
+        if (m_coverage[i] == EMPTY) continue;
+        texels[i] = sum[i] / n;
+        float mean = luminance(texels[i]);
+        m_variance[i] = std::max(0.0f, sumSquares[i] / n - mean * mean) / n;
+    }
+
+    auto denoiseStart = std::chrono::steady_clock::now();
+    denoise(width, height, options.denoiseIterations, texels);
+    dilate(width, height, options.dilation, texels);
+    m_stats.denoiseMs = elapsed(denoiseStart);
+}
+
+void LightmapBaker::denoise(int width, int height, int iterations, std::vector<glm::vec3>& color) const {
+    // B3 spline taps.
+    const float kernel[5] = {1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+    // Luminance differences are compared against this many standard deviations.
+    const float luminanceSigma = 4.0f;
+
+    std::vector<glm::vec3> filtered(color.size());
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        int step = 1 << iteration;
+        Jobs::parallelFor(static_cast<size_t>(height), 8, [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    size_t p = y * width + x;
+                    filtered[p] = color[p];
+                    if (m_coverage[p] == EMPTY) continue;
+
+                    const glm::vec3& position = m_positions[p];
+                    const glm::vec3& normal = m_normals[p];
+                    float lum = luminance(color[p]);
+                    float lumScale = luminanceSigma * std::sqrt(m_variance[p]) + 1e-4f;
+
+                    glm::vec3 total(0.0f);
+                    float weights = 0.0f;
+                    for (int j = -2; j <= 2; ++j) {
+                        int qy = static_cast<int>(y) + j * step;
+                        if (qy < 0 || qy >= height) continue;
+                        for (int i = -2; i <= 2; ++i) {
+                            int qx = x + i * step;
+                            if (qx < 0 || qx >= width) continue;
+                            size_t q = static_cast<size_t>(qy) * width + qx;
+                            if (m_coverage[q] == EMPTY) continue;
+
+                            // Neighbours in the atlas may be far apart in the world
+                            // (another chart) or on another plane.
+                            glm::vec3 offset = m_positions[q] - position;
+                            float reach = (std::sqrt(static_cast<float>(i * i + j * j)) * step * 1.5f + 1.0f) * m_texelSize;
+                            if (glm::dot(offset, offset) > reach * reach) continue;
+                            float plane = std::abs(glm::dot(offset, normal)) / m_texelSize;
+                            float facing = std::max(0.0f, glm::dot(normal, m_normals[q]));
+
+                            float w = kernel[i + 2] * kernel[j + 2];
+                            w *= std::exp(-plane);
+                            w *= std::pow(facing, 64.0f);
+                            w *= std::exp(-std::abs(luminance(color[q]) - lum) / lumScale);
+                            total += color[q] * w;
+                            weights += w;
+                        }
+                    }
+                    if (weights > 0.0f) filtered[p] = total / weights;
+                }
+            }
+        });
+        color.swap(filtered);
+    }
+}
+
+void LightmapBaker::dilate(int width, int height, int rings, std::vector<glm::vec3>& color) const {
+    std::vector<uint8_t> filled(m_coverage.size());
+    for (size_t i = 0; i < filled.size(); ++i) filled[i] = m_coverage[i] != EMPTY;
+
+    std::vector<uint8_t> next;
+    for (int ring = 0; ring < rings; ++ring) {
+        next = filled;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t p = static_cast<size_t>(y) * width + x;
+                if (filled[p]) continue;
+
+                glm::vec3 total(0.0f);
+                int count = 0;
+                for (int j = -1; j <= 1; ++j) {
+                    for (int i = -1; i <= 1; ++i) {
+                        int qx = x + i, qy = y + j;
+                        if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                        size_t q = static_cast<size_t>(qy) * width + qx;
+                        if (!filled[q]) continue;
+                        total += color[q];
+                        ++count;
+                    }
+                }
+                if (count > 0) {
+                    color[p] = total / static_cast<float>(count);
+                    next[p] = 1;
+                }
+            }
+        }
+        filled.swap(next);
+    }
+}
+
+bool LightmapBaker::save(const std::string& path, int width, int height, std::span<const glm::vec3> texels) {
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) + " +X " + std::to_string(width) + "\n";
+    std::vector<uint8_t> file(header.begin(), header.end());
+
+    std::vector<uint8_t> rgbe(static_cast<size_t>(width) * 4);
+    std::vector<uint8_t> channel(width);
+    // The run-length scheme only covers widths in [8, 32767].
+    bool encode = width >= 8 && width < 32768;
+    for (int y = height - 1; y >= 0; --y) {
+        for (int x = 0; x < width; ++x) writeRGBE(texels[static_cast<size_t>(y) * width + x], &rgbe[x * 4]);
+        if (encode) {
+            file.insert(file.end(), {2, 2, static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width & 0xFF)});
+            for (int c = 0; c < 4; ++c) {
+                for (int x = 0; x < width; ++x) channel[x] = rgbe[x * 4 + c];
+                writeRuns(channel.data(), width, file);
+            }
+        } else {
+            file.insert(file.end(), rgbe.begin(), rgbe.end());
+        }
+    }
+    // A bake takes minutes; one interrupted while writing must not leave a
+    // truncated lightmap for the next run to load.
+    return AtomicFile::write(path, std::as_bytes(std::span(file)), "LightmapBaker");
+}
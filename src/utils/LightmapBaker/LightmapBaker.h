@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Bvh/Bvh.h"
+#include "math/Vertex.h"
+#include "utils/ClusteredLights/ClusteredLights.h"
+
+struct LightmapBakeOptions {
+    // Each pass adds samplesPerPass paths to every texel.
+    int passes = 8;
+    int samplesPerPass = 16;
+    int maxBounces = 4;
+    // Stop after the pass that crosses this many milliseconds; 0 = run every pass.
+    double timeLimitMs = 0.0;
+    // Square tiles of texels handed to the job pool.
+    int tileSize = 16;
+    // Edge-aware a-trous iterations (steps 1, 2, 4, ...); 0 leaves the noise.
+    int denoiseIterations = 4;
+    // Rings of empty texels filled from their neighbours; at least the packer's padding.
+    int dilation = 4;
+    uint32_t seed = 1;
+};
+
+// Indirect light for lightmapped geometry, path traced on the CPU so bakes run
+// on machines without a GPU. Receivers are rasterised into the atlas through
+// their lightmap UVs; from each texel, cosine-weighted paths are traced through
+// a Bvh of every mesh, adding direct light (sun and point/spot lights, with
+// shadow rays) at each bounce and the sky colour when a path escapes. Direct
+// light on the texel itself is left out: the room shaders add it at runtime,
+// so the lightmap takes the place of the flat ambient term.
+//
+// Tiles run on the job pool. Every path seeds its random numbers from the
+// texel, pass and sample, so the result does not depend on the thread count.
+// Passes refine progressively; the average is then denoised with an
+// edge-aware a-trous filter guided by position, normal and the per-texel
+// variance, and dilated into the chart padding.
+class LightmapBaker {
+public:
+    // Albedo for vertices whose material has no entry.
+    static constexpr float DEFAULT_ALBEDO = 0.5f;
+
+    struct Stats {
+        size_t triangles = 0;
+        size_t texels = 0;
+        int passes = 0;
+        uint64_t paths = 0;
+        double traceMs = 0.0;
+        double denoiseMs = 0.0;
+    };
+
+    using Progress = std::function<void(int pass, int passes)>;
+
+    enum class Role {
+        // Gets lightmap texels, blocks and bounces light.
+        Receiver,
+        // Only blocks and bounces light.
+        Occluder,
+        // Gets lightmap texels but lets light through, e.g. glass.
+        Transparent
+    };
+
+    // Albedo per vertex is materialAlbedo[vertex.material] * vertex.color.
+    // Receivers and transparent meshes need lightmap UVs.
+    void addMesh(
+        std::span<const Vertex> vertices,
+        std::span<const uint32_t> indices,
+        std::span<const glm::vec3> materialAlbedo,
+        Role role,
+        const glm::mat4& transform = glm::mat4(1.0f)
+    );
+    void setLights(std::span<const Light> lights);
+    // `direction` points towards the ground, as in ClusteredLights.
+    void setSun(const glm::vec3& direction, const glm::vec3& color);
+    void setSky(const glm::vec3& color) { m_sky = color; }
+
+    // Bakes a width x height atlas into `texels`, row 0 at lightmap v = 0.
+    // `progress` runs after each pass.
+    void bake(
+        int width,
+        int height,
+        const LightmapBakeOptions& options,
+        std::vector<glm::vec3>& texels,
+        const Progress& progress = {}
+    );
+
+    const Stats& stats() const { return m_stats; }
+
+    // Radiance .hdr: run-length encoded RGBE, top row first.
+    static bool save(const std::string& path, int width, int height, std::span<const glm::vec3> texels);
+
+private:
+    struct Surface {
+        // Front side, from the vertex normals.
+        glm::vec3 normal;
+        glm::vec3 albedo;
+    };
+
+    struct Receiver {
+        glm::vec2 uv[3];
+        glm::vec3 position[3];
+        glm::vec3 normal[3];
+    };
+
+    struct LightGrid {
+        float cellSize = 1.0f;
+        std::vector<uint64_t> keys;
+        // Per key: range in `lights`.
+        std::vector<glm::uvec2> ranges;
+        std::vector<uint32_t> lights;
+
+        void build(std::span<const Light> source);
+        std::span<const uint32_t> query(const glm::vec3& p) const;
+    };
+
+    void rasterize(int width, int height);
+    glm::vec3 directLight(const glm::vec3& position, const glm::vec3& normal) const;
+    glm::vec3 tracePath(glm::vec3 position, glm::vec3 normal, uint32_t seed, int maxBounces) const;
+    void denoise(int width, int height, int iterations, std::vector<glm::vec3>& color) const;
+    void dilate(int width, int height, int rings, std::vector<glm::vec3>& color) const;
+
+    // Three corners per triangle, world space.
+    std::vector<glm::vec3> m_corners;
+    std::vector<Surface> m_surfaces;
+    std::vector<Receiver> m_receivers;
+    Bvh m_bvh;
+
+    std::vector<Light> m_lights;
+    LightGrid m_lightGrid;
+    glm::vec3 m_sunDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+    glm::vec3 m_sunColor = glm::vec3(0.0f);
+    glm::vec3 m_sky = glm::vec3(0.0f);
+
+    // Per texel, from rasterize().
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    std::vector<uint8_t> m_coverage;
+    // Mean luminance variance of each texel's estimate, for the denoiser.
+    std::vector<float> m_variance;
+    // World size of one texel, averaged over the receivers.
+    float m_texelSize = 1.0f;
+
+    Stats m_stats;
+};
@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#include <iostream>
+#include <utility>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "MappedFile: failed to open " << path << "\n";
+        return;
+    }
+
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    m_file = file;
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_open = true;
+    if (m_size == 0) return;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        std::cerr << "MappedFile: failed to map " << path << "\n";
+        close();
+        return;
+    }
+    m_mapping = mapping;
+    m_data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        std::cerr << "MappedFile: failed to map " << path << "\n";
+        close();
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "MappedFile: failed to open " << path << "\n";
+        return;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "MappedFile: failed to stat " << path << "\n";
+        ::close(fd);
+        return;
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+    m_open = true;
+    if (m_size > 0) {
+        void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr == MAP_FAILED) {
+            std::cerr << "MappedFile: failed to map " << path << "\n";
+            m_size = 0;
+            m_open = false;
+        } else {
+            madvise(ptr, m_size, MADV_WILLNEED);
+            m_data = static_cast<const std::byte*>(ptr);
+        }
+    }
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+
+    close();
+
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_open = std::exchange(other.m_open, false);
+#if defined(_WIN32)
+    m_file = std::exchange(other.m_file, nullptr);
+    m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+
+    return *this;
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file) CloseHandle(static_cast<HANDLE>(m_file));
+    m_mapping = nullptr;
+    m_file = nullptr;
+#else
+    if (m_data) munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. The mapping stays valid (and at the
+// same address) until the object is destroyed, even if it is moved.
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool isOpen() const { return m_open; }
+
+    const std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    std::span<const std::byte> bytes() const { return {m_data, m_size}; }
+    std::string_view text() const {
+        return {reinterpret_cast<const char*>(m_data), m_size};
+    }
+
+private:
+    void close();
+
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+
+#if defined(_WIN32)
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,74 @@
+#include "MaterialTable.h"
+
+#include <iostream>
+
+#include "utils/Texture/Texture.h"
+#include "utils/Profiler/Profiler.h"
+
+MaterialTable::MaterialTable(std::span<const MaterialDesc> materials, int layerSize)
+    : m_materials(materials.begin(), materials.end()) {
+    PROFILE_SCOPE("MaterialTable::MaterialTable");
+    if (m_materials.size() > MAX_MATERIALS) {
+        std::cerr << "MaterialTable: " << m_materials.size() << " materials, keeping the first "
+                  << MAX_MATERIALS << "\n";
+        m_materials.resize(MAX_MATERIALS);
+    }
+
+    // Materials sharing a texture share its layer.
+    std::vector<std::string> layers;
+    std::vector<int> materialLayers(m_materials.size(), -1);
+    for (size_t i = 0; i < m_materials.size(); ++i) {
+        const MaterialDesc& m = m_materials[i];
+        if (m.texturePath.empty()) continue;
+        size_t l = 0;
+        while (l < layers.size() && layers[l] != m.texturePath) ++l;
+        if (l == layers.size()) layers.push_back(m.texturePath);
+        materialLayers[i] = static_cast<int>(l);
+    }
+
+    std::vector<glm::vec2> aspectScales;
+    m_textures = Texture::loadArray2D(layers, layerSize, true, &aspectScales);
+
+    std::vector<GpuMaterial> gpu(m_materials.size());
+    for (size_t i = 0; i < m_materials.size(); ++i) {
+        const MaterialDesc& m = m_materials[i];
+        int layer = materialLayers[i];
+        glm::vec2 aspect = layer >= 0 && m.keepAspect ? aspectScales[static_cast<size_t>(layer)] : glm::vec2(1.0f);
+        gpu[i] = {m.color, glm::vec4(static_cast<float>(layer), m.uvScale, aspect)};
+    }
+
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(GpuMaterial) * MAX_MATERIALS, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GpuMaterial) * gpu.size(), gpu.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+MaterialTable::~MaterialTable() {
+    if (m_ubo) glDeleteBuffers(1, &m_ubo);
+    if (m_textures) glDeleteTextures(1, &m_textures);
+}
+
+int MaterialTable::find(std::string_view name) const {
+    for (size_t i = 0; i < m_materials.size(); ++i) {
+        if (m_materials[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void MaterialTable::bind(Shader& shader, int textureUnit) const {
+    shader.bind();
+    shader.setUniformBlockBinding("Materials", UNIFORM_BINDING);
+    shader.setInt("materialTex", textureUnit);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING, m_ubo);
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_textures);
+}
+
+void MaterialTable::unbind(int textureUnit) const {
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING, 0);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "utils/Shader/Shader.h"
+
+struct MaterialDesc {
+    std::string name;
+    // Optional; untextured materials use `color` alone.
+    std::string texturePath;
+    // Multiplies the texture. Alpha below 1 marks the material as translucent.
+    glm::vec4 color = glm::vec4(1.0f);
+    float uvScale = 1.0f;
+    // Scales UVs so a non-square texture tiles at its own aspect. Turn off for
+    // textures fitted to a 0..1 quad, e.g. pictures.
+    bool keepAspect = true;
+};
+
+// Materials addressed by the per-vertex `material` index. The parameters live in
+// a uniform block and the textures in one GL_TEXTURE_2D_ARRAY, so a shader picks
+// its material per fragment without rebinding anything between draws.
+//
+// Shaders declare the block as
+//     struct Material { vec4 color; vec4 params; };  // params: layer (-1 = none), uv scale, aspect scale (zw)
+//     layout(std140) uniform Materials { Material materials[MAX_MATERIALS]; };
+class MaterialTable {
+public:
+    // Must match MAX_MATERIALS in the shaders.
+    static constexpr uint32_t MAX_MATERIALS = 256;
+    static constexpr GLuint UNIFORM_BINDING = 0;
+    static constexpr int DEFAULT_LAYER_SIZE = 1024;
+
+    explicit MaterialTable(std::span<const MaterialDesc> materials, int layerSize = DEFAULT_LAYER_SIZE);
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    size_t size() const { return m_materials.size(); }
+    const MaterialDesc& material(size_t i) const { return m_materials[i]; }
+    // Index of the named material, or -1.
+    int find(std::string_view name) const;
+    bool isTranslucent(size_t i) const { return m_materials[i].color.a < 1.0f; }
+
+    // Binds the block to UNIFORM_BINDING and the texture array to `textureUnit`,
+    // pointing the shader's "Materials" block and "materialTex" sampler at them.
+    void bind(Shader& shader, int textureUnit = 0) const;
+    void unbind(int textureUnit = 0) const;
+
+private:
+    struct GpuMaterial {
+        glm::vec4 color;
+        glm::vec4 params;
+    };
+
+    std::vector<MaterialDesc> m_materials;
+    GLuint m_ubo = 0;
+    GLuint m_textures = 0;
+};
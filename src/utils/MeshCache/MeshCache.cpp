@@ -0,0 +1,554 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+
+#include "utils/AtomicFile/AtomicFile.h"
+#include "utils/Jobs/Jobs.h"
+#include "utils/Profiler/Profiler.h"
+
+namespace {
+    constexpr char MAGIC[4] = {'R', 'M', 'S', 'H'};
+    constexpr uint32_t FLAG_COMPRESSED_INDICES = 1u << 0;
+    constexpr uint32_t FLAG_FLIP_TEXTURES = 1u << 0;
+    constexpr uint32_t FLAG_DOUBLE_SIDED = 1u << 1;
+
+    // Bump when a Vertex field changes meaning without moving, e.g. a new
+    // colour space or tangent convention.
+    constexpr uint32_t VERTEX_REVISION = 1;
+
+    constexpr uint32_t hashField(uint32_t hash, size_t offset, size_t size) {
+        hash = (hash ^ static_cast<uint32_t>(offset)) * 16777619u;
+        return (hash ^ static_cast<uint32_t>(size)) * 16777619u;
+    }
+
+    // Offsets and sizes of every Vertex field, so any reordering, resize or new
+    // field invalidates the cache even when sizeof(Vertex) stays the same.
+    // New fields must be added here.
+    constexpr uint32_t VERTEX_LAYOUT = [] {
+        uint32_t hash = hashField(2166136261u, VERTEX_REVISION, sizeof(Vertex));
+        hash = hashField(hash, offsetof(Vertex, position), sizeof(Vertex::position));
+        hash = hashField(hash, offsetof(Vertex, color), sizeof(Vertex::color));
+        hash = hashField(hash, offsetof(Vertex, normal), sizeof(Vertex::normal));
+        hash = hashField(hash, offsetof(Vertex, uv), sizeof(Vertex::uv));
+        hash = hashField(hash, offsetof(Vertex, tangent), sizeof(Vertex::tangent));
+        hash = hashField(hash, offsetof(Vertex, material), sizeof(Vertex::material));
+        hash = hashField(hash, offsetof(Vertex, lightmapUV), sizeof(Vertex::lightmapUV));
+        return hash;
+    }();
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t vertexLayout;
+        uint32_t meshCount;
+        uint32_t materialCount;
+        // Paths of the files besides the source that the model was built from.
+        uint32_t dependencyCount;
+        uint64_t fileSize;
+    };
+
+    struct BlobRef {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct MeshEntry {
+        BlobRef name;
+        BlobRef vertices;
+        BlobRef indices;
+        BlobRef meshlets;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t lodCount;
+        uint32_t flags;
+        uint32_t meshletCount;
+        uint32_t reserved0;
+        MeshCache::Lod lods[MeshCache::MAX_LODS];
+        float boundsMin[3];
+        float boundsMax[3];
+        float sphere[4];
+        int32_t material;
+        uint32_t reserved;
+    };
+
+    struct MaterialEntry {
+        BlobRef name;
+        BlobRef baseColorPath;
+        BlobRef normalPath;
+        BlobRef baseColorImage;
+        BlobRef normalImage;
+        float baseColor[4];
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    void encodeVarint(uint32_t value, std::vector<std::byte>& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::byte>(value));
+    }
+
+    // Consecutive triangles mostly reference nearby vertices, so deltas are small.
+    std::vector<std::byte> compressIndices(std::span<const uint32_t> indices) {
+        std::vector<std::byte> out;
+        out.reserve(indices.size() * 2);
+        int64_t previous = 0;
+        for (uint32_t index : indices) {
+            int64_t delta = static_cast<int64_t>(index) - previous;
+            uint32_t zigzag = static_cast<uint32_t>((delta << 1) ^ (delta >> 63));
+            encodeVarint(zigzag, out);
+            previous = index;
+        }
+        return out;
+    }
+
+    bool decompressIndices(std::span<const std::byte> in, std::span<uint32_t> out) {
+        size_t pos = 0;
+        int64_t previous = 0;
+        for (uint32_t& index : out) {
+            uint32_t value = 0;
+            int shift = 0;
+            for (;;) {
+                if (pos >= in.size() || shift > 28) return false;
+                uint32_t byte = static_cast<uint32_t>(in[pos++]);
+                value |= (byte & 0x7F) << shift;
+                if (!(byte & 0x80)) break;
+                shift += 7;
+            }
+            int64_t delta = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+            previous += delta;
+            index = static_cast<uint32_t>(previous);
+        }
+        return true;
+    }
+
+    // LOD and meshlet ranges must lie inside the index block and hold whole
+    // triangles; meshlets cover LOD0 only.
+    bool rangesValid(const MeshEntry& e) {
+        for (uint32_t l = 0; l < e.lodCount; ++l) {
+            const MeshCache::Lod& lod = e.lods[l];
+            if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > e.indexCount || lod.indexCount % 3 != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool meshletsValid(std::span<const Meshlet> meshlets, const MeshCache::Lod& lod0) {
+        for (const Meshlet& m : meshlets) {
+            if (m.firstIndex < lod0.firstIndex ||
+                static_cast<uint64_t>(m.firstIndex) + static_cast<uint64_t>(m.triangleCount) * 3 >
+                    static_cast<uint64_t>(lod0.firstIndex) + lod0.indexCount) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool indicesValid(std::span<const uint32_t> indices, uint32_t vertexCount) {
+        uint32_t largest = 0;
+        for (uint32_t index : indices) largest = std::max(largest, index);
+        return indices.empty() || largest < vertexCount;
+    }
+
+    class Writer {
+    public:
+        size_t reserve(size_t bytes) {
+            size_t offset = m_data.size();
+            m_data.resize(offset + bytes);
+            return offset;
+        }
+
+        BlobRef append(const void* data, size_t bytes, size_t alignment = 1) {
+            size_t offset = alignUp(m_data.size(), alignment);
+            m_data.resize(offset + bytes);
+            if (bytes) std::memcpy(m_data.data() + offset, data, bytes);
+            return {offset, bytes};
+        }
+
+        BlobRef append(std::string_view text) {
+            return append(text.data(), text.size());
+        }
+
+        template <typename T>
+        void store(size_t offset, const T& value) {
+            std::memcpy(m_data.data() + offset, &value, sizeof(T));
+        }
+
+        std::vector<std::byte>& data() { return m_data; }
+
+    private:
+        std::vector<std::byte> m_data;
+    };
+}
+
+namespace MeshCache {
+    Bounds computeBounds(std::span<const Vertex> vertices) {
+        Bounds b;
+        if (vertices.empty()) return b;
+
+        b.min = b.max = vertices[0].position;
+        for (const auto& v : vertices) {
+            b.min = glm::min(b.min, v.position);
+            b.max = glm::max(b.max, v.position);
+        }
+        b.center = (b.min + b.max) * 0.5f;
+        for (const auto& v : vertices) {
+            b.radius = std::max(b.radius, glm::length(v.position - b.center));
+        }
+        return b;
+    }
+
+    std::vector<uint32_t> buildLodChain(
+        std::span<const Vertex> vertices,
+        std::span<const uint32_t> indices,
+        uint32_t lodCount,
+        std::vector<Lod>& lods
+    ) {
+        lodCount = std::clamp<uint32_t>(lodCount, 1, MAX_LODS);
+
+        std::vector<uint32_t> chain(indices.begin(), indices.end());
+        lods.clear();
+        lods.push_back({0, static_cast<uint32_t>(indices.size()), 0.0f});
+        if (lodCount == 1 || vertices.empty()) return chain;
+
+        Bounds bounds = computeBounds(vertices);
+        float extent = std::max({bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z});
+        if (extent <= 0.0f) return chain;
+
+        // Start at twice the average edge length; each level doubles the cell, which
+        // roughly quarters the triangle count of a surface-like mesh.
+        double edgeSum = 0.0;
+        size_t edgeSamples = 0;
+        size_t step = std::max<size_t>(3, (indices.size() / 3 / 4096) * 3);
+        for (size_t t = 0; t + 2 < indices.size(); t += step) {
+            edgeSum += glm::length(vertices[indices[t]].position - vertices[indices[t + 1]].position);
+            ++edgeSamples;
+        }
+        float averageEdge = edgeSamples ? static_cast<float>(edgeSum / edgeSamples) : extent / 64.0f;
+        float cell = std::max(averageEdge * 2.0f, extent / 2048.0f);
+        std::vector<uint32_t> remap(vertices.size());
+        std::unordered_map<uint64_t, uint32_t> representative;
+
+        for (uint32_t level = 1; level < lodCount; ++level, cell *= 2.0f) {
+            representative.clear();
+            representative.reserve(vertices.size() / 4);
+
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                glm::vec3 q = (vertices[i].position - bounds.min) / cell;
+                uint64_t key = (static_cast<uint64_t>(q.x) & 0x1FFFFF)
+                             | ((static_cast<uint64_t>(q.y) & 0x1FFFFF) << 21)
+                             | ((static_cast<uint64_t>(q.z) & 0x1FFFFF) << 42);
+                remap[i] = representative.try_emplace(key, static_cast<uint32_t>(i)).first->second;
+            }
+
+            uint32_t first = static_cast<uint32_t>(chain.size());
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                uint32_t a = remap[indices[t]];
+                uint32_t b = remap[indices[t + 1]];
+                uint32_t c = remap[indices[t + 2]];
+                if (a == b || b == c || a == c) continue;
+                chain.push_back(a);
+                chain.push_back(b);
+                chain.push_back(c);
+            }
+
+            uint32_t count = static_cast<uint32_t>(chain.size()) - first;
+            if (count == 0 || count >= lods.back().indexCount) {
+                chain.resize(first);
+                break;
+            }
+            lods.push_back({first, count, cell});
+        }
+
+        return chain;
+    }
+
+    bool write(const std::string& path, const ModelData& model, const WriteOptions& options) {
+        PROFILE_SCOPE("MeshCache::write");
+        // LOD chains are independent per mesh.
+        std::vector<std::vector<uint32_t>> chains(model.meshes.size());
+        std::vector<std::vector<Lod>> lods(model.meshes.size());
+        std::vector<Bounds> bounds(model.meshes.size());
+        std::vector<std::vector<Meshlet>> meshlets(model.meshes.size());
+        Jobs::parallelFor(model.meshes.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const MeshData& mesh = model.meshes[i];
+                bounds[i] = computeBounds(mesh.vertices);
+
+                MeshletMesh clustered = Meshlets::build(mesh.vertices, mesh.indices);
+                meshlets[i] = std::move(clustered.meshlets);
+                chains[i] = buildLodChain(mesh.vertices, clustered.indices, options.lodCount, lods[i]);
+            }
+        });
+
+        Writer w;
+        size_t headerOffset = w.reserve(sizeof(FileHeader));
+        size_t meshTable = w.reserve(sizeof(MeshEntry) * model.meshes.size());
+        size_t materialTable = w.reserve(sizeof(MaterialEntry) * model.materials.size());
+
+        std::vector<std::string> dependencies = model.dependencies;
+        for (const MaterialData& m : model.materials) {
+            if (!m.baseColorTexture.empty()) dependencies.push_back(m.baseColorTexture);
+            if (!m.normalTexture.empty()) dependencies.push_back(m.normalTexture);
+        }
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        // A file that is missing now would make the cache look stale forever.
+        std::erase_if(dependencies, [](const std::string& dependency) {
+            std::error_code ec;
+            return !std::filesystem::is_regular_file(dependency, ec);
+        });
+        size_t dependencyTable = w.reserve(sizeof(BlobRef) * dependencies.size());
+
+        for (size_t i = 0; i < model.meshes.size(); ++i) {
+            const MeshData& mesh = model.meshes[i];
+
+            MeshEntry entry{};
+            entry.name = w.append(mesh.name);
+            entry.vertices = w.append(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex), BLOCK_ALIGNMENT);
+            entry.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+            entry.indexCount = static_cast<uint32_t>(chains[i].size());
+
+            if (options.compressIndices) {
+                std::vector<std::byte> packed = compressIndices(chains[i]);
+                entry.indices = w.append(packed.data(), packed.size(), BLOCK_ALIGNMENT);
+                entry.flags |= FLAG_COMPRESSED_INDICES;
+            } else {
+                entry.indices = w.append(chains[i].data(), chains[i].size() * sizeof(uint32_t), BLOCK_ALIGNMENT);
+            }
+
+            entry.meshlets = w.append(meshlets[i].data(), meshlets[i].size() * sizeof(Meshlet), alignof(Meshlet));
+            entry.meshletCount = static_cast<uint32_t>(meshlets[i].size());
+
+            entry.lodCount = static_cast<uint32_t>(lods[i].size());
+            std::copy(lods[i].begin(), lods[i].end(), entry.lods);
+
+            const Bounds& b = bounds[i];
+            std::memcpy(entry.boundsMin, &b.min, sizeof(entry.boundsMin));
+            std::memcpy(entry.boundsMax, &b.max, sizeof(entry.boundsMax));
+            entry.sphere[0] = b.center.x;
+            entry.sphere[1] = b.center.y;
+            entry.sphere[2] = b.center.z;
+            entry.sphere[3] = b.radius;
+            entry.material = mesh.material;
+
+            w.store(meshTable + i * sizeof(MeshEntry), entry);
+        }
+
+        for (size_t i = 0; i < model.materials.size(); ++i) {
+            const MaterialData& m = model.materials[i];
+
+            MaterialEntry entry{};
+            entry.name = w.append(m.name);
+            entry.baseColorPath = w.append(m.baseColorTexture);
+            entry.normalPath = w.append(m.normalTexture);
+            entry.baseColorImage = w.append(m.baseColorImage.data(), m.baseColorImage.size());
+            entry.normalImage = w.append(m.normalImage.data(), m.normalImage.size());
+            std::memcpy(entry.baseColor, &m.baseColor, sizeof(entry.baseColor));
+            entry.flags = (m.flipTextures ? FLAG_FLIP_TEXTURES : 0) | (m.doubleSided ? FLAG_DOUBLE_SIDED : 0);
+
+            w.store(materialTable + i * sizeof(MaterialEntry), entry);
+        }
+
+        for (size_t i = 0; i < dependencies.size(); ++i) {
+            w.store(dependencyTable + i * sizeof(BlobRef), w.append(dependencies[i]));
+        }
+
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.vertexLayout = VERTEX_LAYOUT;
+        header.meshCount = static_cast<uint32_t>(model.meshes.size());
+        header.materialCount = static_cast<uint32_t>(model.materials.size());
+        header.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        header.fileSize = w.data().size();
+        w.store(headerOffset, header);
+
+        // Written aside and renamed into place, so a crash never leaves a truncated
+        // cache and concurrent builds of the same model cannot interleave.
+        return AtomicFile::write(path, w.data(), "MeshCache");
+    }
+
+    File::File(const std::string& path) : m_file(path) {
+        PROFILE_SCOPE("MeshCache::File");
+        if (!m_file.isOpen()) return;
+
+        std::span<const std::byte> bytes = m_file.bytes();
+        if (bytes.size() < sizeof(FileHeader)) {
+            std::cerr << "MeshCache: " << path << " is truncated\n";
+            return;
+        }
+
+        FileHeader header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header.version != VERSION ||
+            header.vertexLayout != VERTEX_LAYOUT ||
+            header.fileSize != bytes.size()) {
+            std::cerr << "MeshCache: " << path << " has an incompatible header\n";
+            return;
+        }
+
+        size_t tablesEnd = sizeof(FileHeader)
+                         + sizeof(MeshEntry) * header.meshCount
+                         + sizeof(MaterialEntry) * header.materialCount
+                         + sizeof(BlobRef) * header.dependencyCount;
+        if (tablesEnd > bytes.size()) {
+            std::cerr << "MeshCache: " << path << " is truncated\n";
+            return;
+        }
+
+        auto blob = [&](const BlobRef& ref, std::span<const std::byte>& out) {
+            if (ref.offset > bytes.size() || ref.size > bytes.size() - ref.offset) return false;
+            out = bytes.subspan(static_cast<size_t>(ref.offset), static_cast<size_t>(ref.size));
+            return true;
+        };
+        auto text = [](std::span<const std::byte> b) {
+            return std::string_view(reinterpret_cast<const char*>(b.data()), b.size());
+        };
+
+        const std::byte* base = bytes.data();
+        const auto* meshEntries = reinterpret_cast<const MeshEntry*>(base + sizeof(FileHeader));
+        const auto* materialEntries = reinterpret_cast<const MaterialEntry*>(
+            base + sizeof(FileHeader) + sizeof(MeshEntry) * header.meshCount
+        );
+
+        m_meshes.reserve(header.meshCount);
+        for (uint32_t i = 0; i < header.meshCount; ++i) {
+            const MeshEntry& e = meshEntries[i];
+            std::span<const std::byte> name, vertices, indices, meshlets;
+            if (!blob(e.name, name) || !blob(e.vertices, vertices) || !blob(e.indices, indices) ||
+                !blob(e.meshlets, meshlets) ||
+                vertices.size() != static_cast<size_t>(e.vertexCount) * sizeof(Vertex) ||
+                meshlets.size() != static_cast<size_t>(e.meshletCount) * sizeof(Meshlet) ||
+                e.lodCount == 0 || e.lodCount > MAX_LODS ||
+                !rangesValid(e)) {
+                std::cerr << "MeshCache: " << path << " has a corrupt mesh entry " << i << "\n";
+                m_meshes.clear();
+                return;
+            }
+
+            MeshView view;
+            view.name = text(name);
+            view.vertices = {reinterpret_cast<const Vertex*>(vertices.data()), e.vertexCount};
+            view.indexCount = e.indexCount;
+            if (e.flags & FLAG_COMPRESSED_INDICES) {
+                view.compressedIndices = indices;
+            } else {
+                if (indices.size() != static_cast<size_t>(e.indexCount) * sizeof(uint32_t)) {
+                    std::cerr << "MeshCache: " << path << " has a corrupt index block " << i << "\n";
+                    m_meshes.clear();
+                    return;
+                }
+                view.indices = {reinterpret_cast<const uint32_t*>(indices.data()), e.indexCount};
+                if (!indicesValid(view.indices, e.vertexCount)) {
+                    std::cerr << "MeshCache: " << path << " has out-of-range indices in mesh " << i << "\n";
+                    m_meshes.clear();
+                    return;
+                }
+            }
+            view.lods = {e.lods, e.lodCount};
+            view.meshlets = {reinterpret_cast<const Meshlet*>(meshlets.data()), e.meshletCount};
+            if (!meshletsValid(view.meshlets, e.lods[0])) {
+                std::cerr << "MeshCache: " << path << " has out-of-range meshlets in mesh " << i << "\n";
+                m_meshes.clear();
+                return;
+            }
+            std::memcpy(&view.bounds.min, e.boundsMin, sizeof(e.boundsMin));
+            std::memcpy(&view.bounds.max, e.boundsMax, sizeof(e.boundsMax));
+            view.bounds.center = glm::vec3(e.sphere[0], e.sphere[1], e.sphere[2]);
+            view.bounds.radius = e.sphere[3];
+            view.material = e.material;
+            m_meshes.push_back(view);
+        }
+
+        m_materials.reserve(header.materialCount);
+        for (uint32_t i = 0; i < header.materialCount; ++i) {
+            const MaterialEntry& e = materialEntries[i];
+            std::span<const std::byte> name, basePath, normalPath, baseImage, normalImage;
+            if (!blob(e.name, name) || !blob(e.baseColorPath, basePath) || !blob(e.normalPath, normalPath) ||
+                !blob(e.baseColorImage, baseImage) || !blob(e.normalImage, normalImage)) {
+                std::cerr << "MeshCache: " << path << " has a corrupt material entry " << i << "\n";
+                m_meshes.clear();
+                m_materials.clear();
+                return;
+            }
+
+            MaterialData m;
+            m.name = text(name);
+            m.baseColorTexture = text(basePath);
+            m.normalTexture = text(normalPath);
+            m.baseColorImage = baseImage;
+            m.normalImage = normalImage;
+            std::memcpy(&m.baseColor, e.baseColor, sizeof(e.baseColor));
+            m.flipTextures = (e.flags & FLAG_FLIP_TEXTURES) != 0;
+            m.doubleSided = (e.flags & FLAG_DOUBLE_SIDED) != 0;
+            m_materials.push_back(std::move(m));
+        }
+
+        m_valid = true;
+    }
+
+    std::span<const uint32_t> File::indices(size_t mesh, std::vector<uint32_t>& scratch) const {
+        const MeshView& view = m_meshes[mesh];
+        if (view.compressedIndices.empty()) return view.indices;
+
+        scratch.resize(view.indexCount);
+        if (!decompressIndices(view.compressedIndices, scratch) ||
+            !indicesValid(scratch, static_cast<uint32_t>(view.vertices.size()))) {
+            std::cerr << "MeshCache: corrupt compressed index stream in mesh " << view.name << "\n";
+            scratch.clear();
+        }
+        return scratch;
+    }
+
+    std::string cachePathFor(const std::string& sourcePath) {
+        return sourcePath + ".rmsh";
+    }
+
+    bool isFresh(const std::string& cachePath, const std::string& sourcePath) {
+        std::error_code ec;
+        auto cacheTime = std::filesystem::last_write_time(cachePath, ec);
+        if (ec) return false;
+        auto sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+        if (ec) return false;
+        if (cacheTime < sourceTime) return false;
+
+        MappedFile file(cachePath);
+        if (!file.isOpen() || file.size() < sizeof(FileHeader)) return false;
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header.version != VERSION ||
+            header.vertexLayout != VERTEX_LAYOUT ||
+            header.fileSize != file.size()) {
+            return false;
+        }
+
+        size_t table = sizeof(FileHeader)
+                     + sizeof(MeshEntry) * header.meshCount
+                     + sizeof(MaterialEntry) * header.materialCount;
+        if (table + sizeof(BlobRef) * header.dependencyCount > file.size()) return false;
+        for (uint32_t i = 0; i < header.dependencyCount; ++i) {
+            BlobRef ref;
+            std::memcpy(&ref, file.data() + table + i * sizeof(BlobRef), sizeof(ref));
+            if (ref.offset > file.size() || ref.size > file.size() - ref.offset) return false;
+            std::string dependency(reinterpret_cast<const char*>(file.data() + ref.offset), static_cast<size_t>(ref.size));
+            auto dependencyTime = std::filesystem::last_write_time(dependency, ec);
+            if (ec || cacheTime < dependencyTime) return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Meshlet/Meshlet.h"
+#include "math/Vertex.h"
+#include "utils/MappedFile/MappedFile.h"
+#include "utils/ModelImporter/ModelImporter.h"
+
+// Versioned binary cache for imported meshes (*.rmsh).
+//
+// Layout: header, mesh table, material table, dependency table, then data blocks. Every vertex and
+// index block starts on a 64-byte boundary so the mapped bytes can be handed to
+// glBufferData as-is. All LODs of a mesh share its vertex block; each LOD is a
+// range of the index block. Index blocks may optionally be stored compressed
+// (delta + zigzag + varint), in which case they are decoded before upload.
+// LOD0 is stored in meshlet order, with the meshlet table alongside it.
+namespace MeshCache {
+    constexpr uint32_t VERSION = 4;
+    constexpr uint32_t MAX_LODS = 8;
+    constexpr size_t BLOCK_ALIGNMENT = 64;
+
+    struct Lod {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        // Cell size (in model units) the LOD was clustered with; 0 for the full mesh.
+        float error;
+    };
+
+    struct Bounds {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+    };
+
+    struct WriteOptions {
+        // Total levels including LOD0; clamped to MAX_LODS.
+        uint32_t lodCount = 4;
+        bool compressIndices = false;
+    };
+
+    // View of one cached mesh. Spans point into the mapping of the owning File.
+    struct MeshView {
+        std::string_view name;
+        std::span<const Vertex> vertices;
+        // Empty when the index block is compressed; use File::indices() instead.
+        std::span<const uint32_t> indices;
+        std::span<const std::byte> compressedIndices;
+        uint32_t indexCount = 0;
+        std::span<const Lod> lods;
+        // Clusters over LOD0's index range.
+        std::span<const Meshlet> meshlets;
+        Bounds bounds;
+        int material = -1;
+    };
+
+    class File {
+    public:
+        File() = default;
+        explicit File(const std::string& path);
+
+        bool isValid() const { return m_valid; }
+
+        size_t meshCount() const { return m_meshes.size(); }
+        const MeshView& mesh(size_t i) const { return m_meshes[i]; }
+
+        size_t materialCount() const { return m_materials.size(); }
+        // Image spans view the mapping, so the File must outlive their use.
+        const MaterialData& material(size_t i) const { return m_materials[i]; }
+
+        // Returns the index block of a mesh, decoding into `scratch` if it is compressed.
+        std::span<const uint32_t> indices(size_t mesh, std::vector<uint32_t>& scratch) const;
+
+    private:
+        MappedFile m_file;
+        std::vector<MeshView> m_meshes;
+        std::vector<MaterialData> m_materials;
+        bool m_valid = false;
+    };
+
+    Bounds computeBounds(std::span<const Vertex> vertices);
+
+    // Builds coarser index lists over the same vertices by clustering vertices on
+    // progressively larger grids. Returns the concatenated index list; `lods` receives
+    // the ranges, LOD0 being the original indices.
+    std::vector<uint32_t> buildLodChain(
+        std::span<const Vertex> vertices,
+        std::span<const uint32_t> indices,
+        uint32_t lodCount,
+        std::vector<Lod>& lods
+    );
+
+    bool write(const std::string& path, const ModelData& model, const WriteOptions& options = {});
+
+    // Default cache location for a source asset.
+    std::string cachePathFor(const std::string& sourcePath);
+
+    // True if the cache exists, has a matching version and vertex layout, and is
+    // newer than the source and every file recorded as a dependency.
+    bool isFresh(const std::string& cachePath, const std::string& sourcePath);
+}
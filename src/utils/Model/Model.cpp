@@ -0,0 +1,199 @@
+#include "Model.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+
+#include <glad/glad.h>
+
+#include "utils/Jobs/Jobs.h"
+#include "utils/Profiler/Profiler.h"
+#include "utils/Texture/Texture.h"
+
+static unsigned int loadMaterialTexture(
+    const std::string& path,
+    std::span<const std::byte> embedded,
+    bool flip,
+    std::unordered_map<std::string, unsigned int>& cache
+) {
+    if (!embedded.empty()) return Texture::load2DFromMemory(embedded, flip);
+    if (path.empty()) return 0;
+
+    auto it = cache.find(path);
+    if (it != cache.end()) return it->second;
+
+    unsigned int tex = Texture::load2D(path, flip);
+    if (tex == 0) std::cerr << "Model: failed to load texture: " << path << "\n";
+    cache.emplace(path, tex);
+    return tex;
+}
+
+Model::Model(const ModelData& data) {
+    loadMaterials(data.materials);
+
+    // Clustering is CPU-only, so do it for every mesh in parallel before uploading.
+    std::vector<MeshletMesh> clustered(data.meshes.size());
+    Jobs::parallelFor(data.meshes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            clustered[i] = Meshlets::build(data.meshes[i].vertices, data.meshes[i].indices);
+        }
+    });
+
+    m_parts.reserve(data.meshes.size());
+    for (size_t i = 0; i < data.meshes.size(); ++i) {
+        const MeshData& src = data.meshes[i];
+        if (src.vertices.empty() || src.indices.empty()) continue;
+        Part part;
+        part.mesh = std::make_unique<Mesh>(src.vertices, clustered[i].indices);
+        part.lods.push_back({0, static_cast<uint32_t>(clustered[i].indices.size()), 0.0f});
+        part.meshlets = std::move(clustered[i].meshlets);
+        part.material = src.material;
+        m_parts.push_back(std::move(part));
+        growBounds(MeshCache::computeBounds(src.vertices));
+    }
+}
+
+Model::Model(const MeshCache::File& cache) {
+    std::vector<MaterialData> materials;
+    materials.reserve(cache.materialCount());
+    for (size_t i = 0; i < cache.materialCount(); ++i) materials.push_back(cache.material(i));
+    loadMaterials(materials);
+
+    std::vector<uint32_t> scratch;
+    m_parts.reserve(cache.meshCount());
+    for (size_t i = 0; i < cache.meshCount(); ++i) {
+        const MeshCache::MeshView& view = cache.mesh(i);
+        std::span<const uint32_t> indices = cache.indices(i, scratch);
+        if (view.vertices.empty() || indices.empty()) continue;
+
+        Part part;
+        part.mesh = std::make_unique<Mesh>(view.vertices, indices);
+        part.lods.assign(view.lods.begin(), view.lods.end());
+        part.meshlets.assign(view.meshlets.begin(), view.meshlets.end());
+        part.material = view.material;
+        m_parts.push_back(std::move(part));
+        growBounds(view.bounds);
+    }
+}
+
+void Model::growBounds(const MeshCache::Bounds& bounds) {
+    if (m_parts.size() == 1) {
+        m_boundsMin = bounds.min;
+        m_boundsMax = bounds.max;
+    } else {
+        m_boundsMin = glm::min(m_boundsMin, bounds.min);
+        m_boundsMax = glm::max(m_boundsMax, bounds.max);
+    }
+}
+
+std::unique_ptr<Model> Model::load(const std::string& path) {
+    PROFILE_SCOPE("Model::load");
+    std::string cachePath = MeshCache::cachePathFor(path);
+
+    if (!MeshCache::isFresh(cachePath, path)) {
+        ModelData data;
+        if (!ModelImporter::load(path, data)) return nullptr;
+        if (!MeshCache::write(cachePath, data)) {
+            std::cerr << "Model: could not write mesh cache, using imported data directly\n";
+            return std::make_unique<Model>(data);
+        }
+    }
+
+    MeshCache::File cache(cachePath);
+    if (!cache.isValid()) {
+        ModelData data;
+        if (!ModelImporter::load(path, data)) return nullptr;
+        return std::make_unique<Model>(data);
+    }
+    return std::make_unique<Model>(cache);
+}
+
+void Model::loadMaterials(std::span<const MaterialData> materials) {
+    // Materials often share image files; load each file once.
+    std::unordered_map<std::string, unsigned int> textureCache;
+
+    m_materials.reserve(materials.size());
+    for (const auto& src : materials) {
+        Material material;
+        material.baseColor = src.baseColor;
+        material.doubleSided = src.doubleSided;
+        material.baseColorTex = loadMaterialTexture(src.baseColorTexture, src.baseColorImage, src.flipTextures, textureCache);
+        material.normalTex = loadMaterialTexture(src.normalTexture, src.normalImage, src.flipTextures, textureCache);
+        m_materials.push_back(material);
+    }
+}
+
+Model::~Model() {
+    std::vector<unsigned int> textures;
+    for (const auto& m : m_materials) {
+        if (m.baseColorTex) textures.push_back(m.baseColorTex);
+        if (m.normalTex) textures.push_back(m.normalTex);
+    }
+    std::sort(textures.begin(), textures.end());
+    textures.erase(std::unique(textures.begin(), textures.end()), textures.end());
+    if (!textures.empty()) glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+}
+
+void Model::bindMaterial(Shader& shader, int index) const {
+    Material material;
+    if (index >= 0 && index < static_cast<int>(m_materials.size())) {
+        material = m_materials[static_cast<size_t>(index)];
+    }
+
+    shader.setVec4("uBaseColor", material.baseColor);
+    shader.setInt("uHasBaseColorTex", material.baseColorTex ? 1 : 0);
+    shader.setInt("uHasNormalTex", material.normalTex ? 1 : 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, material.normalTex);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, material.baseColorTex);
+}
+
+void Model::drawDepth(GLsizei instances, uint32_t lod) const {
+    for (const auto& part : m_parts) {
+        const MeshCache::Lod& range = part.lods[std::min<size_t>(lod, part.lods.size() - 1)];
+        part.mesh->drawRangeInstanced(
+            static_cast<GLsizei>(range.firstIndex),
+            static_cast<GLsizei>(range.indexCount),
+            instances
+        );
+    }
+}
+
+void Model::drawCulled(
+    Shader& shader,
+    const glm::mat4& model,
+    const Frustum& frustum,
+    const glm::vec3& cameraPosition
+) const {
+    shader.bind();
+    shader.setInt("baseColorTex", 0);
+    shader.setInt("normalTex", 1);
+
+    int boundMaterial = -2;
+    for (const auto& part : m_parts) {
+        if (part.meshlets.empty()) continue;
+
+        // Models are drawn without GL face culling; only single-sided materials
+        // may drop back-facing meshlets.
+        bool singleSided = part.material >= 0 && part.material < static_cast<int>(m_materials.size()) &&
+                           !m_materials[static_cast<size_t>(part.material)].doubleSided;
+        Meshlets::cull(part.meshlets, model, frustum, cameraPosition, singleSided, m_drawList);
+        if (m_drawList.counts.empty()) continue;
+
+        if (part.material != boundMaterial) {
+            boundMaterial = part.material;
+            bindMaterial(shader, part.material);
+        }
+        part.mesh->drawMulti(
+            m_drawList.counts.data(),
+            m_drawList.offsets.data(),
+            static_cast<GLsizei>(m_drawList.counts.size())
+        );
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
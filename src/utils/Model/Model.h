@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Frustum/Frustum.h"
+#include "math/Mesh/Mesh.h"
+#include "math/Meshlet/Meshlet.h"
+#include "utils/MeshCache/MeshCache.h"
+#include "utils/ModelImporter/ModelImporter.h"
+#include "utils/Shader/Shader.h"
+
+// GPU side of an imported model: one Mesh per MeshData and the material
+// textures loaded through the Texture loader.
+class Model {
+public:
+    explicit Model(const ModelData& data);
+    // Uploads straight from the cache's mapping.
+    explicit Model(const MeshCache::File& cache);
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    // Loads `path` through its mesh cache, importing and writing the cache
+    // first if it is missing or older than the source. Returns null on failure.
+    static std::unique_ptr<Model> load(const std::string& path);
+
+    // Draws LOD0, culling meshlets against the frustum, and against their
+    // backface cones for single-sided materials.
+    void drawCulled(
+        Shader& shader,
+        const glm::mat4& model,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition
+    ) const;
+
+    // Geometry only, `instances` times, for depth passes with the shader already bound.
+    void drawDepth(GLsizei instances, uint32_t lod = 0) const;
+
+    size_t meshCount() const { return m_parts.size(); }
+
+    // Model-space box around every mesh.
+    const glm::vec3& boundsMin() const { return m_boundsMin; }
+    const glm::vec3& boundsMax() const { return m_boundsMax; }
+
+private:
+    struct Material {
+        glm::vec4 baseColor = glm::vec4(1.0f);
+        unsigned int baseColorTex = 0;
+        unsigned int normalTex = 0;
+        bool doubleSided = true;
+    };
+
+    struct Part {
+        std::unique_ptr<Mesh> mesh;
+        std::vector<MeshCache::Lod> lods;
+        std::vector<Meshlet> meshlets;
+        int material = -1;
+    };
+
+    void loadMaterials(std::span<const MaterialData> materials);
+    void bindMaterial(Shader& shader, int material) const;
+    void growBounds(const MeshCache::Bounds& bounds);
+
+    std::vector<Part> m_parts;
+    std::vector<Material> m_materials;
+    glm::vec3 m_boundsMin = glm::vec3(0.0f);
+    glm::vec3 m_boundsMax = glm::vec3(0.0f);
+
+    mutable MeshletDrawList m_drawList;
+};
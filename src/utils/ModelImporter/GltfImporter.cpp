@@ -0,0 +1,516 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "utils/Jobs/Jobs.h"
+#include "utils/Json/Json.h"
+
+// glTF 2.0 (.gltf + .bin or self-contained .glb). Buffers are spans into the mapped
+// files, so accessors are decoded straight from the mapping into the interleaved
+// Vertex layout. Only base64 data URIs need an owned copy.
+
+namespace {
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+    constexpr int GL_BYTE_ = 5120;
+    constexpr int GL_UNSIGNED_BYTE_ = 5121;
+    constexpr int GL_SHORT_ = 5122;
+    constexpr int GL_UNSIGNED_SHORT_ = 5123;
+    constexpr int GL_UNSIGNED_INT_ = 5125;
+    constexpr int GL_FLOAT_ = 5126;
+
+    constexpr int MODE_TRIANGLES = 4;
+
+    uint32_t readU32(const std::byte* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    struct Accessor {
+        const std::byte* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = GL_FLOAT_;
+        int components = 1;
+        bool normalized = false;
+
+        bool valid() const { return data != nullptr; }
+
+        float component(size_t element, int c) const {
+            const std::byte* p = data + element * stride;
+            switch (componentType) {
+                case GL_FLOAT_: {
+                    float v;
+                    std::memcpy(&v, p + c * 4, 4);
+                    return v;
+                }
+                case GL_UNSIGNED_BYTE_: {
+                    float v = static_cast<float>(static_cast<uint8_t>(p[c]));
+                    return normalized ? v / 255.0f : v;
+                }
+                case GL_BYTE_: {
+                    float v = static_cast<float>(static_cast<int8_t>(p[c]));
+                    return normalized ? std::max(v / 127.0f, -1.0f) : v;
+                }
+                case GL_UNSIGNED_SHORT_: {
+                    uint16_t raw;
+                    std::memcpy(&raw, p + c * 2, 2);
+                    float v = static_cast<float>(raw);
+                    return normalized ? v / 65535.0f : v;
+                }
+                case GL_SHORT_: {
+                    int16_t raw;
+                    std::memcpy(&raw, p + c * 2, 2);
+                    float v = static_cast<float>(raw);
+                    return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+                }
+                case GL_UNSIGNED_INT_: {
+                    uint32_t raw;
+                    std::memcpy(&raw, p + c * 4, 4);
+                    return static_cast<float>(raw);
+                }
+            }
+            return 0.0f;
+        }
+
+        uint32_t index(size_t element) const {
+            const std::byte* p = data + element * stride;
+            switch (componentType) {
+                case GL_UNSIGNED_BYTE_: return static_cast<uint8_t>(p[0]);
+                case GL_UNSIGNED_SHORT_: {
+                    uint16_t v;
+                    std::memcpy(&v, p, 2);
+                    return v;
+                }
+                case GL_UNSIGNED_INT_: return readU32(p);
+            }
+            return 0;
+        }
+    };
+
+    int componentCount(const std::string& type) {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT4") return 16;
+        return 0;
+    }
+
+    size_t componentSize(int componentType) {
+        switch (componentType) {
+            case GL_BYTE_:
+            case GL_UNSIGNED_BYTE_: return 1;
+            case GL_SHORT_:
+            case GL_UNSIGNED_SHORT_: return 2;
+            case GL_UNSIGNED_INT_:
+            case GL_FLOAT_: return 4;
+        }
+        return 0;
+    }
+
+    bool decodeBase64(std::string_view in, std::vector<std::byte>& out) {
+        auto value = [](char c) -> int {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+' || c == '-') return 62;
+            if (c == '/' || c == '_') return 63;
+            return -1;
+        };
+
+        out.clear();
+        out.reserve(in.size() * 3 / 4);
+        uint32_t acc = 0;
+        int bits = 0;
+        for (char c : in) {
+            if (c == '=') break;
+            int v = value(c);
+            if (v < 0) {
+                if (c == '\n' || c == '\r' || c == ' ') continue;
+                return false;
+            }
+            acc = (acc << 6) | static_cast<uint32_t>(v);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                out.push_back(static_cast<std::byte>((acc >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
+
+    class Document {
+    public:
+        Document(const Json::Value& root, std::vector<std::span<const std::byte>> buffers)
+            : m_root(root), m_buffers(std::move(buffers)) {}
+
+        std::span<const std::byte> bufferView(int index) const {
+            const Json::Value& view = m_root["bufferViews"][static_cast<size_t>(index)];
+            if (!view.isObject()) return {};
+
+            size_t buffer = static_cast<size_t>(view["buffer"].asInt(-1));
+            if (buffer >= m_buffers.size()) return {};
+
+            size_t offset = static_cast<size_t>(view["byteOffset"].asNumber(0));
+            size_t length = static_cast<size_t>(view["byteLength"].asNumber(0));
+            if (offset + length > m_buffers[buffer].size()) return {};
+            return m_buffers[buffer].subspan(offset, length);
+        }
+
+        Accessor accessor(int index) const {
+            Accessor out;
+            const Json::Value& acc = m_root["accessors"][static_cast<size_t>(index)];
+            if (!acc.isObject() || !acc.has("bufferView")) return out;
+            if (acc.has("sparse")) {
+                std::cerr << "ModelImporter: sparse glTF accessors are not supported\n";
+                return out;
+            }
+
+            int viewIndex = acc["bufferView"].asInt(-1);
+            std::span<const std::byte> view = bufferView(viewIndex);
+            if (view.empty()) return out;
+
+            out.componentType = acc["componentType"].asInt(GL_FLOAT_);
+            out.components = componentCount(acc["type"].asString());
+            out.normalized = acc["normalized"].asBool(false);
+            out.count = static_cast<size_t>(acc["count"].asNumber(0));
+
+            size_t elementSize = componentSize(out.componentType) * static_cast<size_t>(out.components);
+            if (elementSize == 0) return out;
+
+            size_t stride = static_cast<size_t>(
+                m_root["bufferViews"][static_cast<size_t>(viewIndex)]["byteStride"].asNumber(0)
+            );
+            out.stride = stride ? stride : elementSize;
+
+            size_t offset = static_cast<size_t>(acc["byteOffset"].asNumber(0));
+            if (out.count > 0 && offset + (out.count - 1) * out.stride + elementSize > view.size()) {
+                std::cerr << "ModelImporter: glTF accessor " << index << " overruns its buffer view\n";
+                return out;
+            }
+
+            out.data = view.data() + offset;
+            return out;
+        }
+
+        const Json::Value& root() const { return m_root; }
+
+    private:
+        const Json::Value& m_root;
+        std::vector<std::span<const std::byte>> m_buffers;
+    };
+
+    struct PrimitiveJob {
+        const Json::Value* primitive;
+        std::string name;
+        glm::mat4 transform;
+    };
+
+    glm::mat4 nodeLocalTransform(const Json::Value& node) {
+        const Json::Value& matrix = node["matrix"];
+        if (matrix.isArray() && matrix.size() == 16) {
+            float m[16];
+            for (size_t i = 0; i < 16; ++i) m[i] = static_cast<float>(matrix[i].asNumber());
+            return glm::make_mat4(m);
+        }
+
+        glm::vec3 t(0.0f), s(1.0f);
+        glm::quat r(1.0f, 0.0f, 0.0f, 0.0f);
+        const Json::Value& tv = node["translation"];
+        const Json::Value& rv = node["rotation"];
+        const Json::Value& sv = node["scale"];
+        if (tv.size() == 3) t = glm::vec3(tv[0].asNumber(), tv[1].asNumber(), tv[2].asNumber());
+        if (rv.size() == 4) r = glm::quat(
+            static_cast<float>(rv[3].asNumber(1.0)),
+            static_cast<float>(rv[0].asNumber()),
+            static_cast<float>(rv[1].asNumber()),
+            static_cast<float>(rv[2].asNumber())
+        );
+        if (sv.size() == 3) s = glm::vec3(sv[0].asNumber(1.0), sv[1].asNumber(1.0), sv[2].asNumber(1.0));
+
+        glm::mat4 m = glm::translate(glm::mat4(1.0f), t);
+        m *= glm::mat4_cast(r);
+        m = glm::scale(m, s);
+        return m;
+    }
+
+    void collectNode(
+        const Json::Value& root,
+        size_t nodeIndex,
+        const glm::mat4& parent,
+        std::vector<PrimitiveJob>& jobs,
+        int depth
+    ) {
+        const Json::Value& node = root["nodes"][nodeIndex];
+        if (!node.isObject() || depth > 64) return;
+
+        glm::mat4 world = parent * nodeLocalTransform(node);
+
+        if (node.has("mesh")) {
+            const Json::Value& mesh = root["meshes"][static_cast<size_t>(node["mesh"].asInt(-1))];
+            const Json::Value& primitives = mesh["primitives"];
+            for (size_t p = 0; p < primitives.size(); ++p) {
+                std::string name = mesh["name"].asString();
+                if (name.empty()) name = node["name"].asString();
+                jobs.push_back({&primitives[p], name, world});
+            }
+        }
+
+        const Json::Value& children = node["children"];
+        for (size_t c = 0; c < children.size(); ++c) {
+            collectNode(root, static_cast<size_t>(children[c].asInt(-1)), world, jobs, depth + 1);
+        }
+    }
+
+    bool decodePrimitive(const Document& doc, const PrimitiveJob& job, MeshData& out) {
+        const Json::Value& prim = *job.primitive;
+        if (prim["mode"].asInt(MODE_TRIANGLES) != MODE_TRIANGLES) return false;
+
+        const Json::Value& attributes = prim["attributes"];
+        Accessor position = doc.accessor(attributes["POSITION"].asInt(-1));
+        if (!position.valid() || position.components != 3) return false;
+
+        Accessor normal = attributes.has("NORMAL") ? doc.accessor(attributes["NORMAL"].asInt()) : Accessor();
+        Accessor uv = attributes.has("TEXCOORD_0") ? doc.accessor(attributes["TEXCOORD_0"].asInt()) : Accessor();
+        Accessor color = attributes.has("COLOR_0") ? doc.accessor(attributes["COLOR_0"].asInt()) : Accessor();
+        Accessor tangent = attributes.has("TANGENT") ? doc.accessor(attributes["TANGENT"].asInt()) : Accessor();
+
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(job.transform)));
+        // A mirroring transform flips the bitangent relative to the transformed frame.
+        float handedness = glm::determinant(glm::mat3(job.transform)) < 0.0f ? -1.0f : 1.0f;
+
+        out.name = job.name;
+        out.material = prim["material"].asInt(-1);
+        out.vertices.resize(position.count);
+        for (size_t i = 0; i < position.count; ++i) {
+            Vertex& v = out.vertices[i];
+            glm::vec3 p(position.component(i, 0), position.component(i, 1), position.component(i, 2));
+            v.position = glm::vec3(job.transform * glm::vec4(p, 1.0f));
+            v.color = glm::vec3(1.0f);
+            v.normal = glm::vec3(0.0f);
+            v.uv = glm::vec2(0.0f);
+
+            if (normal.valid() && i < normal.count) {
+                glm::vec3 n(normal.component(i, 0), normal.component(i, 1), normal.component(i, 2));
+                v.normal = glm::normalize(normalMatrix * n);
+            }
+            if (uv.valid() && i < uv.count) {
+                v.uv = glm::vec2(uv.component(i, 0), uv.component(i, 1));
+            }
+            // Authored tangents are kept; MeshProcessing only fills in missing ones.
+            if (tangent.valid() && i < tangent.count && tangent.components == 4) {
+                glm::vec3 t(tangent.component(i, 0), tangent.component(i, 1), tangent.component(i, 2));
+                t = glm::mat3(job.transform) * t;
+                float w = tangent.component(i, 3) < 0.0f ? -1.0f : 1.0f;
+                if (glm::dot(t, t) > 0.0f) v.tangent = glm::vec4(glm::normalize(t), w * handedness);
+            }
+            if (color.valid() && i < color.count && color.components >= 3) {
+                v.color = glm::vec3(color.component(i, 0), color.component(i, 1), color.component(i, 2));
+            }
+        }
+
+        if (prim.has("indices")) {
+            Accessor indices = doc.accessor(prim["indices"].asInt());
+            if (!indices.valid()) return false;
+            out.indices.resize(indices.count);
+            for (size_t i = 0; i < indices.count; ++i) {
+                uint32_t index = indices.index(i);
+                out.indices[i] = index < position.count ? index : 0;
+            }
+        } else {
+            out.indices.resize(position.count);
+            for (size_t i = 0; i < position.count; ++i) out.indices[i] = static_cast<uint32_t>(i);
+        }
+
+        // A mirroring transform flips the winding.
+        if (glm::determinant(glm::mat3(job.transform)) < 0.0f) {
+            for (size_t i = 0; i + 2 < out.indices.size(); i += 3) std::swap(out.indices[i + 1], out.indices[i + 2]);
+        }
+
+        return true;
+    }
+
+    void resolveImage(
+        const Document& doc,
+        const std::filesystem::path& dir,
+        int textureIndex,
+        std::string& path,
+        std::span<const std::byte>& embedded,
+        ModelData& out
+    ) {
+        const Json::Value& root = doc.root();
+        const Json::Value& texture = root["textures"][static_cast<size_t>(textureIndex)];
+        const Json::Value& image = root["images"][static_cast<size_t>(texture["source"].asInt(-1))];
+        if (!image.isObject()) return;
+
+        if (image.has("bufferView")) {
+            embedded = doc.bufferView(image["bufferView"].asInt());
+            return;
+        }
+
+        const std::string& uri = image["uri"].asString();
+        if (uri.starts_with("data:")) {
+            size_t comma = uri.find(',');
+            if (comma == std::string::npos) return;
+            std::vector<std::byte> decoded;
+            if (!decodeBase64(std::string_view(uri).substr(comma + 1), decoded)) return;
+            out.ownedBuffers.push_back(std::move(decoded));
+            embedded = out.ownedBuffers.back();
+        } else if (!uri.empty()) {
+            path = (dir / uri).string();
+        }
+    }
+}
+
+namespace ModelImporter {
+    bool loadGltf(const std::string& path, ModelData& out) {
+        MappedFile file(path);
+        if (!file.isOpen() || file.size() < 4) {
+            std::cerr << "ModelImporter: failed to open " << path << "\n";
+            return false;
+        }
+
+        std::filesystem::path dir = std::filesystem::path(path).parent_path();
+
+        std::string_view jsonText;
+        std::span<const std::byte> glbBinary;
+
+        if (readU32(file.data()) == GLB_MAGIC) {
+            if (file.size() < 20) {
+                std::cerr << "ModelImporter: truncated GLB header in " << path << "\n";
+                return false;
+            }
+            size_t offset = 12;
+            while (offset + 8 <= file.size()) {
+                uint32_t length = readU32(file.data() + offset);
+                uint32_t type = readU32(file.data() + offset + 4);
+                offset += 8;
+                if (offset + length > file.size()) break;
+
+                if (type == GLB_CHUNK_JSON) {
+                    jsonText = std::string_view(reinterpret_cast<const char*>(file.data() + offset), length);
+                } else if (type == GLB_CHUNK_BIN && glbBinary.empty()) {
+                    glbBinary = file.bytes().subspan(offset, length);
+                }
+                offset += (length + 3) & ~size_t(3);
+            }
+        } else {
+            jsonText = file.text();
+        }
+
+        Json::Value root;
+        std::string error;
+        if (!Json::parse(jsonText, root, error)) {
+            std::cerr << "ModelImporter: invalid glTF JSON in " << path << ": " << error << "\n";
+            return false;
+        }
+
+        std::vector<std::span<const std::byte>> buffers;
+        const Json::Value& bufferList = root["buffers"];
+        for (size_t i = 0; i < bufferList.size(); ++i) {
+            const Json::Value& buffer = bufferList[i];
+            const std::string& uri = buffer["uri"].asString();
+            size_t length = static_cast<size_t>(buffer["byteLength"].asNumber(0));
+
+            std::span<const std::byte> bytes;
+            if (uri.empty()) {
+                bytes = glbBinary;
+            } else if (uri.starts_with("data:")) {
+                size_t comma = uri.find(',');
+                std::vector<std::byte> decoded;
+                if (comma != std::string::npos && decodeBase64(std::string_view(uri).substr(comma + 1), decoded)) {
+                    out.ownedBuffers.push_back(std::move(decoded));
+                    bytes = out.ownedBuffers.back();
+                }
+            } else {
+                MappedFile external((dir / uri).string());
+                if (external.isOpen()) {
+                    bytes = external.bytes();
+                    out.mappings.push_back(std::move(external));
+                    out.dependencies.push_back((dir / uri).string());
+                }
+            }
+
+            if (bytes.size() < length) {
+                std::cerr << "ModelImporter: glTF buffer " << i << " is missing or truncated in " << path << "\n";
+                return false;
+            }
+            buffers.push_back(bytes.first(length));
+        }
+
+        Document doc(root, std::move(buffers));
+
+        std::vector<PrimitiveJob> jobs;
+        const Json::Value& scenes = root["scenes"];
+        if (scenes.size() > 0) {
+            const Json::Value& scene = scenes[static_cast<size_t>(root["scene"].asInt(0))];
+            const Json::Value& nodes = scene["nodes"];
+            for (size_t n = 0; n < nodes.size(); ++n) {
+                collectNode(root, static_cast<size_t>(nodes[n].asInt(-1)), glm::mat4(1.0f), jobs, 0);
+            }
+        } else {
+            const Json::Value& meshes = root["meshes"];
+            for (size_t m = 0; m < meshes.size(); ++m) {
+                const Json::Value& primitives = meshes[m]["primitives"];
+                for (size_t p = 0; p < primitives.size(); ++p) {
+                    jobs.push_back({&primitives[p], meshes[m]["name"].asString(), glm::mat4(1.0f)});
+                }
+            }
+        }
+
+        std::vector<MeshData> decoded(jobs.size());
+        std::vector<char> ok(jobs.size(), 0);
+        Jobs::parallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) ok[i] = decodePrimitive(doc, jobs[i], decoded[i]);
+        });
+
+        int materialBase = static_cast<int>(out.materials.size());
+        for (size_t i = 0; i < decoded.size(); ++i) {
+            if (!ok[i]) continue;
+            if (decoded[i].material >= 0) decoded[i].material += materialBase;
+            out.meshes.push_back(std::move(decoded[i]));
+        }
+
+        const Json::Value& materials = root["materials"];
+        for (size_t i = 0; i < materials.size(); ++i) {
+            const Json::Value& m = materials[i];
+            MaterialData material;
+            material.name = m["name"].asString();
+            material.flipTextures = false;
+            material.doubleSided = m["doubleSided"].asBool(false);
+
+            const Json::Value& pbr = m["pbrMetallicRoughness"];
+            const Json::Value& factor = pbr["baseColorFactor"];
+            if (factor.size() == 4) {
+                material.baseColor = glm::vec4(
+                    factor[0].asNumber(1.0), factor[1].asNumber(1.0),
+                    factor[2].asNumber(1.0), factor[3].asNumber(1.0)
+                );
+            }
+            if (pbr["baseColorTexture"].has("index")) {
+                resolveImage(doc, dir, pbr["baseColorTexture"]["index"].asInt(),
+                             material.baseColorTexture, material.baseColorImage, out);
+            }
+            if (m["normalTexture"].has("index")) {
+                resolveImage(doc, dir, m["normalTexture"]["index"].asInt(),
+                             material.normalTexture, material.normalImage, out);
+            }
+            out.materials.push_back(std::move(material));
+        }
+
+        // The GLB chunk views point into this mapping.
+        out.mappings.push_back(std::move(file));
+        return true;
+    }
+}
@@ -0,0 +1,54 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "math/MeshProcessing/MeshProcessing.h"
+#include "utils/Profiler/Profiler.h"
+
+size_t ModelData::triangleCount() const {
+    size_t count = 0;
+    for (const auto& mesh : meshes) count += mesh.indices.size() / 3;
+    return count;
+}
+
+namespace ModelImporter {
+    bool load(const std::string& path, ModelData& out) {
+        PROFILE_SCOPE("ModelImporter::load");
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+        auto start = std::chrono::steady_clock::now();
+
+        bool ok = false;
+        if (ext == ".obj") {
+            ok = loadObj(path, out);
+        } else if (ext == ".gltf" || ext == ".glb") {
+            ok = loadGltf(path, out);
+        } else {
+            std::cerr << "ModelImporter: unsupported file type: " << path << "\n";
+            return false;
+        }
+
+        if (ok) {
+            // Meshes arrive ready for normal mapping: fill in missing normals, then tangents.
+            for (auto& mesh : out.meshes) {
+                MeshProcessing::computeNormals(mesh.vertices, mesh.indices, true);
+                MeshProcessing::computeTangents(mesh.vertices, mesh.indices, true);
+            }
+
+            auto elapsed = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start
+            ).count();
+            std::cout << "ModelImporter: loaded " << path << " ("
+                      << out.meshes.size() << " meshes, "
+                      << out.triangleCount() << " triangles) in "
+                      << elapsed << " ms\n";
+        }
+        return ok;
+    }
+}
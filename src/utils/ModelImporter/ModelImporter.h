@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "math/Vertex.h"
+#include "utils/MappedFile/MappedFile.h"
+
+struct MaterialData {
+    std::string name;
+    glm::vec4 baseColor = glm::vec4(1.0f);
+
+    // File paths (already resolved against the model's directory), empty if unused.
+    std::string baseColorTexture;
+    std::string normalTexture;
+
+    // Images embedded in a binary buffer. These are views into ModelData::mappings
+    // or ModelData::ownedBuffers and take precedence over the paths above.
+    std::span<const std::byte> baseColorImage;
+    std::span<const std::byte> normalImage;
+
+    // glTF puts the texture origin at the top-left, OBJ/OpenGL at the bottom-left.
+    bool flipTextures = true;
+
+    // Back faces are visible. glTF materials say so explicitly; OBJ has no such
+    // notion, so its faces are kept from both sides.
+    bool doubleSided = true;
+};
+
+struct MeshData {
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    int material = -1;
+};
+
+struct ModelData {
+    std::vector<MeshData> meshes;
+    std::vector<MaterialData> materials;
+
+    // Keep the source files mapped for as long as materials reference them.
+    std::vector<MappedFile> mappings;
+    std::vector<std::vector<std::byte>> ownedBuffers;
+
+    // Files read besides the model itself (material libraries, external buffers),
+    // so caches of it go stale when they change. Texture paths are in materials.
+    std::vector<std::string> dependencies;
+
+    size_t triangleCount() const;
+};
+
+namespace ModelImporter {
+    // Picks the importer from the file extension (.obj, .gltf, .glb).
+    bool load(const std::string& path, ModelData& out);
+
+    bool loadObj(const std::string& path, ModelData& out);
+    bool loadGltf(const std::string& path, ModelData& out);
+}
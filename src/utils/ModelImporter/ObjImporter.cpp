@@ -0,0 +1,530 @@
+#include "ModelImporter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "utils/Jobs/Jobs.h"
+
+// The OBJ is parsed in parallel chunks that start on line boundaries. Each chunk keeps
+// its own attribute arrays and triangle corners; chunk-relative (negative) indices are
+// resolved once every chunk's attribute counts are known. Vertices are welded per
+// chunk and material, then the per-chunk results are concatenated in file order.
+
+namespace {
+    constexpr uint32_t NO_INDEX = 0xFFFFFFFFu;
+    constexpr uint32_t CHUNK_RELATIVE = 0x80000000u;
+    constexpr long long RELATIVE_BIAS = 0x40000000;
+    constexpr size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+    // Material that was active when the chunk started; resolved after parsing.
+    constexpr int INHERITED_MATERIAL = -1;
+
+    struct Corner {
+        uint32_t position;
+        uint32_t uv;
+        uint32_t normal;
+    };
+
+    struct MaterialRun {
+        int material;
+        size_t firstTriangle;
+    };
+
+    struct ChunkResult {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> colors;
+        std::vector<glm::vec2> uvs;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners;
+        std::vector<MaterialRun> runs;
+        std::vector<std::string> materialNames;
+        std::vector<std::string> libraries;
+
+        size_t positionBase = 0;
+        size_t uvBase = 0;
+        size_t normalBase = 0;
+    };
+
+    struct ChunkGroup {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    struct ChunkMesh {
+        // Keyed by global material slot.
+        std::unordered_map<int, ChunkGroup> groups;
+    };
+
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) ++p;
+        return p;
+    }
+
+    const char* parseFloat(const char* p, const char* end, float& out) {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+') ++p;
+        auto result = std::from_chars(p, end, out);
+        if (result.ec != std::errc()) {
+            out = 0.0f;
+            while (p < end && !isSpace(*p) && *p != '\n') ++p;
+            return p;
+        }
+        return result.ptr;
+    }
+
+    // Encodes an OBJ index: positive indices are absolute (0-based), negative ones are
+    // relative to the attributes seen so far in this chunk. A relative index may point
+    // back into earlier chunks, so it is kept as a signed chunk-local offset (biased to
+    // fit the low 31 bits) until the chunk's bases are known.
+    uint32_t encodeIndex(long value, size_t localCount) {
+        if (value > 0) {
+            if (static_cast<unsigned long>(value - 1) >= CHUNK_RELATIVE) return NO_INDEX;
+            return static_cast<uint32_t>(value - 1);
+        }
+        if (value < 0) {
+            long long biased = static_cast<long long>(localCount) + value + RELATIVE_BIAS;
+            if (biased < 0 || biased >= static_cast<long long>(NO_INDEX & ~CHUNK_RELATIVE)) return NO_INDEX;
+            return CHUNK_RELATIVE | static_cast<uint32_t>(biased);
+        }
+        return NO_INDEX;
+    }
+
+    const char* parseCorner(const char* p, const char* end, const ChunkResult& chunk, Corner& out) {
+        out = {NO_INDEX, NO_INDEX, NO_INDEX};
+
+        long value = 0;
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) return nullptr;
+        out.position = encodeIndex(value, chunk.positions.size());
+        p = result.ptr;
+
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                result = std::from_chars(p, end, value);
+                if (result.ec == std::errc()) {
+                    out.uv = encodeIndex(value, chunk.uvs.size());
+                    p = result.ptr;
+                }
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                result = std::from_chars(p, end, value);
+                if (result.ec == std::errc()) {
+                    out.normal = encodeIndex(value, chunk.normals.size());
+                    p = result.ptr;
+                }
+            }
+        }
+        return p;
+    }
+
+    std::string_view restOfLine(const char* p, const char* lineEnd) {
+        p = skipSpaces(p, lineEnd);
+        const char* e = lineEnd;
+        while (e > p && isSpace(e[-1])) --e;
+        return {p, static_cast<size_t>(e - p)};
+    }
+
+    void parseChunk(std::string_view text, ChunkResult& chunk) {
+        const char* p = text.data();
+        const char* end = p + text.size();
+
+        chunk.runs.push_back({INHERITED_MATERIAL, 0});
+
+        std::vector<Corner> polygon;
+
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!lineEnd) lineEnd = end;
+
+            p = skipSpaces(p, lineEnd);
+            if (p + 1 < lineEnd) {
+                if (p[0] == 'v' && isSpace(p[1])) {
+                    glm::vec3 v;
+                    const char* q = parseFloat(p + 2, lineEnd, v.x);
+                    q = parseFloat(q, lineEnd, v.y);
+                    q = parseFloat(q, lineEnd, v.z);
+                    chunk.positions.push_back(v);
+
+                    // A lone fourth value is the homogeneous w, which polygons ignore.
+                    // Three or four more are the per-vertex colour extension,
+                    // "v x y z r g b" with an optional alpha that is dropped.
+                    float extra[4];
+                    size_t extraCount = 0;
+                    q = skipSpaces(q, lineEnd);
+                    while (q < lineEnd && extraCount < 4) {
+                        q = parseFloat(q, lineEnd, extra[extraCount++]);
+                        q = skipSpaces(q, lineEnd);
+                    }
+                    glm::vec3 color(1.0f);
+                    if (extraCount >= 3) color = glm::vec3(extra[0], extra[1], extra[2]);
+                    if (!chunk.colors.empty() || color != glm::vec3(1.0f)) {
+                        chunk.colors.resize(chunk.positions.size() - 1, glm::vec3(1.0f));
+                        chunk.colors.push_back(color);
+                    }
+                } else if (p[0] == 'v' && p[1] == 't') {
+                    glm::vec2 t;
+                    const char* q = parseFloat(p + 2, lineEnd, t.x);
+                    parseFloat(q, lineEnd, t.y);
+                    chunk.uvs.push_back(t);
+                } else if (p[0] == 'v' && p[1] == 'n') {
+                    glm::vec3 n;
+                    const char* q = parseFloat(p + 2, lineEnd, n.x);
+                    q = parseFloat(q, lineEnd, n.y);
+                    parseFloat(q, lineEnd, n.z);
+                    chunk.normals.push_back(n);
+                } else if (p[0] == 'f' && isSpace(p[1])) {
+                    polygon.clear();
+                    const char* q = p + 2;
+                    for (;;) {
+                        q = skipSpaces(q, lineEnd);
+                        if (q >= lineEnd) break;
+                        Corner corner;
+                        q = parseCorner(q, lineEnd, chunk, corner);
+                        if (!q) break;
+                        polygon.push_back(corner);
+                    }
+                    for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                        chunk.corners.push_back(polygon[0]);
+                        chunk.corners.push_back(polygon[i]);
+                        chunk.corners.push_back(polygon[i + 1]);
+                    }
+                } else if (std::string_view(p, static_cast<size_t>(lineEnd - p)).starts_with("usemtl")) {
+                    std::string name(restOfLine(p + 6, lineEnd));
+                    chunk.materialNames.push_back(name);
+                    int localId = static_cast<int>(chunk.materialNames.size() - 1);
+
+                    size_t triangle = chunk.corners.size() / 3;
+                    if (chunk.runs.back().firstTriangle == triangle) chunk.runs.back().material = localId;
+                    else chunk.runs.push_back({localId, triangle});
+                } else if (std::string_view(p, static_cast<size_t>(lineEnd - p)).starts_with("mtllib")) {
+                    chunk.libraries.emplace_back(restOfLine(p + 6, lineEnd));
+                }
+            }
+
+            p = lineEnd + 1;
+        }
+    }
+
+    // Takes the last whitespace-separated token so options such as "-bm 1.0" are skipped.
+    std::string lastToken(std::string_view value) {
+        size_t pos = value.find_last_of(" \t");
+        if (pos == std::string_view::npos) return std::string(value);
+        return std::string(value.substr(pos + 1));
+    }
+
+    void parseMtl(
+        const std::filesystem::path& path,
+        std::vector<MaterialData>& materials,
+        std::unordered_map<std::string, int>& lookup,
+        std::vector<std::string>& dependencies
+    ) {
+        MappedFile file(path.string());
+        if (!file.isOpen()) {
+            std::cerr << "ModelImporter: failed to open material library " << path << "\n";
+            return;
+        }
+        dependencies.push_back(path.string());
+
+        std::filesystem::path dir = path.parent_path();
+        std::string_view text = file.text();
+        MaterialData* current = nullptr;
+
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t lineEnd = text.find('\n', pos);
+            if (lineEnd == std::string_view::npos) lineEnd = text.size();
+            std::string_view line = restOfLine(text.data() + pos, text.data() + lineEnd);
+            pos = lineEnd + 1;
+
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t split = line.find_first_of(" \t");
+            std::string_view key = line.substr(0, split);
+            std::string_view value = split == std::string_view::npos
+                ? std::string_view()
+                : restOfLine(line.data() + split, line.data() + line.size());
+
+            if (key == "newmtl") {
+                std::string name(value);
+                auto it = lookup.find(name);
+                if (it == lookup.end()) {
+                    lookup.emplace(name, static_cast<int>(materials.size()));
+                    materials.push_back({});
+                    materials.back().name = name;
+                    current = &materials.back();
+                } else {
+                    current = &materials[it->second];
+                }
+            } else if (!current) {
+                continue;
+            } else if (key == "Kd") {
+                const char* q = value.data();
+                const char* e = q + value.size();
+                q = parseFloat(q, e, current->baseColor.r);
+                q = parseFloat(q, e, current->baseColor.g);
+                parseFloat(q, e, current->baseColor.b);
+            } else if (key == "d") {
+                parseFloat(value.data(), value.data() + value.size(), current->baseColor.a);
+            } else if (key == "Tr") {
+                float tr = 0.0f;
+                parseFloat(value.data(), value.data() + value.size(), tr);
+                current->baseColor.a = 1.0f - tr;
+            } else if (key == "map_Kd") {
+                current->baseColorTexture = (dir / lastToken(value)).string();
+            } else if (key == "map_Bump" || key == "map_bump" || key == "bump" || key == "norm") {
+                current->normalTexture = (dir / lastToken(value)).string();
+            }
+        }
+    }
+
+    uint32_t resolve(uint32_t index, size_t chunkBase) {
+        if (index == NO_INDEX) return NO_INDEX;
+        if (index & CHUNK_RELATIVE) {
+            long long local = static_cast<long long>(index & ~CHUNK_RELATIVE) - RELATIVE_BIAS;
+            long long global = static_cast<long long>(chunkBase) + local;
+            if (global < 0 || global >= static_cast<long long>(NO_INDEX)) return NO_INDEX;
+            return static_cast<uint32_t>(global);
+        }
+        return index;
+    }
+
+    // Open-addressing table that welds identical (position, uv, normal) corners.
+    class CornerMap {
+    public:
+        explicit CornerMap(size_t expected) {
+            size_t capacity = 16;
+            while (capacity < expected * 2) capacity <<= 1;
+            m_keys.assign(capacity, Corner{NO_INDEX, NO_INDEX, NO_INDEX});
+            m_values.resize(capacity);
+            m_mask = capacity - 1;
+        }
+
+        // Returns a pointer to the stored vertex index; `inserted` tells if it is new.
+        uint32_t& findOrInsert(const Corner& key, bool& inserted) {
+            size_t h = (key.position * 73856093u) ^ (key.uv * 19349663u) ^ (key.normal * 83492791u);
+            size_t i = h & m_mask;
+            for (;;) {
+                Corner& slot = m_keys[i];
+                if (slot.position == NO_INDEX) {
+                    slot = key;
+                    inserted = true;
+                    return m_values[i];
+                }
+                if (slot.position == key.position && slot.uv == key.uv && slot.normal == key.normal) {
+                    inserted = false;
+                    return m_values[i];
+                }
+                i = (i + 1) & m_mask;
+            }
+        }
+
+    private:
+        std::vector<Corner> m_keys;
+        std::vector<uint32_t> m_values;
+        size_t m_mask = 0;
+    };
+}
+
+namespace ModelImporter {
+    bool loadObj(const std::string& path, ModelData& out) {
+        MappedFile file(path);
+        if (!file.isOpen()) {
+            std::cerr << "ModelImporter: failed to open " << path << "\n";
+            return false;
+        }
+
+        std::string_view text = file.text();
+
+        // Split on line boundaries.
+        size_t targetChunks = std::max<size_t>(1, std::min<size_t>(
+            Jobs::threadCount() * 4,
+            text.size() / MIN_CHUNK_BYTES + 1
+        ));
+        std::vector<std::string_view> pieces;
+        size_t start = 0;
+        for (size_t i = 1; i <= targetChunks && start < text.size(); ++i) {
+            size_t cut = i == targetChunks ? text.size() : text.size() * i / targetChunks;
+            if (cut < start) continue;
+            size_t newline = text.find('\n', cut);
+            cut = newline == std::string_view::npos ? text.size() : newline + 1;
+            pieces.push_back(text.substr(start, cut - start));
+            start = cut;
+        }
+
+        std::vector<ChunkResult> chunks(pieces.size());
+        Jobs::parallelFor(pieces.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) parseChunk(pieces[i], chunks[i]);
+        });
+
+        // Global attribute bases and material table (serial, proportional to chunk count).
+        std::filesystem::path dir = std::filesystem::path(path).parent_path();
+        std::unordered_map<std::string, int> materialLookup;
+        size_t materialBase = out.materials.size();
+        std::vector<MaterialData> materials;
+
+        size_t positionCount = 0, uvCount = 0, normalCount = 0;
+        bool anyColors = false;
+        for (auto& chunk : chunks) {
+            chunk.positionBase = positionCount;
+            chunk.uvBase = uvCount;
+            chunk.normalBase = normalCount;
+            positionCount += chunk.positions.size();
+            uvCount += chunk.uvs.size();
+            normalCount += chunk.normals.size();
+            anyColors |= !chunk.colors.empty();
+
+            for (const auto& lib : chunk.libraries) parseMtl(dir / lib, materials, materialLookup, out.dependencies);
+        }
+
+        auto materialSlot = [&](const std::string& name) {
+            auto it = materialLookup.find(name);
+            if (it != materialLookup.end()) return it->second;
+            int slot = static_cast<int>(materials.size());
+            materialLookup.emplace(name, slot);
+            materials.push_back({});
+            materials.back().name = name;
+            return slot;
+        };
+
+        // Resolve chunk-local material ids; a chunk inherits the last material of the previous one.
+        int active = -1;
+        for (auto& chunk : chunks) {
+            for (auto& run : chunk.runs) {
+                if (run.material == INHERITED_MATERIAL) run.material = active;
+                else run.material = materialSlot(chunk.materialNames[static_cast<size_t>(run.material)]);
+            }
+            active = chunk.runs.back().material;
+        }
+
+        std::vector<glm::vec3> positions(positionCount);
+        std::vector<glm::vec3> colors(anyColors ? positionCount : 0, glm::vec3(1.0f));
+        std::vector<glm::vec2> uvs(uvCount);
+        std::vector<glm::vec3> normals(normalCount);
+        Jobs::parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const auto& c = chunks[i];
+                std::copy(c.positions.begin(), c.positions.end(), positions.begin() + c.positionBase);
+                if (!c.colors.empty()) std::copy(c.colors.begin(), c.colors.end(), colors.begin() + c.positionBase);
+                std::copy(c.uvs.begin(), c.uvs.end(), uvs.begin() + c.uvBase);
+                std::copy(c.normals.begin(), c.normals.end(), normals.begin() + c.normalBase);
+            }
+        });
+
+        // Weld and emit vertices per chunk and material.
+        std::vector<ChunkMesh> chunkMeshes(chunks.size());
+        Jobs::parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t ci = begin; ci < end; ++ci) {
+                auto& chunk = chunks[ci];
+                auto& meshOut = chunkMeshes[ci];
+                size_t triangleCount = chunk.corners.size() / 3;
+
+                for (size_t r = 0; r < chunk.runs.size(); ++r) {
+                    size_t firstTri = chunk.runs[r].firstTriangle;
+                    size_t lastTri = r + 1 < chunk.runs.size() ? chunk.runs[r + 1].firstTriangle : triangleCount;
+                    if (firstTri == lastTri) continue;
+
+                    auto& group = meshOut.groups[chunk.runs[r].material];
+                    CornerMap welded((lastTri - firstTri) * 3);
+                    group.vertices.reserve(group.vertices.size() + (lastTri - firstTri) * 2);
+                    group.indices.reserve(group.indices.size() + (lastTri - firstTri) * 3);
+
+                    for (size_t t = firstTri; t < lastTri; ++t) {
+                        uint32_t tri[3];
+                        bool valid = true;
+                        for (int k = 0; k < 3; ++k) {
+                            const Corner& raw = chunk.corners[t * 3 + k];
+                            Corner c{
+                                resolve(raw.position, chunk.positionBase),
+                                resolve(raw.uv, chunk.uvBase),
+                                resolve(raw.normal, chunk.normalBase)
+                            };
+                            if (c.position >= positionCount) {
+                                valid = false;
+                                break;
+                            }
+                            if (c.uv != NO_INDEX && c.uv >= uvCount) c.uv = NO_INDEX;
+                            if (c.normal != NO_INDEX && c.normal >= normalCount) c.normal = NO_INDEX;
+
+                            bool inserted = false;
+                            uint32_t& slot = welded.findOrInsert(c, inserted);
+                            if (inserted) {
+                                slot = static_cast<uint32_t>(group.vertices.size());
+                                Vertex v{};
+                                v.position = positions[c.position];
+                                v.color = anyColors ? colors[c.position] : glm::vec3(1.0f);
+                                if (c.normal != NO_INDEX) v.normal = normals[c.normal];
+                                if (c.uv != NO_INDEX) v.uv = uvs[c.uv];
+                                group.vertices.push_back(v);
+                            }
+                            tri[k] = slot;
+                        }
+                        if (!valid) continue;
+                        group.indices.insert(group.indices.end(), tri, tri + 3);
+                    }
+                }
+
+                chunk = ChunkResult();
+            }
+        });
+
+        // Concatenate per-material groups across chunks, one mesh per material in
+        // material index order; each mesh keeps its faces in file order.
+        std::vector<int> usedMaterials;
+        for (const auto& cm : chunkMeshes) {
+            for (const auto& [material, group] : cm.groups) {
+                if (!group.indices.empty() &&
+                    std::find(usedMaterials.begin(), usedMaterials.end(), material) == usedMaterials.end()) {
+                    usedMaterials.push_back(material);
+                }
+            }
+        }
+        std::sort(usedMaterials.begin(), usedMaterials.end());
+
+        std::string baseName = std::filesystem::path(path).stem().string();
+        for (int material : usedMaterials) {
+            MeshData mesh;
+            mesh.name = material >= 0 ? baseName + ":" + materials[static_cast<size_t>(material)].name : baseName;
+            mesh.material = material >= 0 ? static_cast<int>(materialBase) + material : -1;
+
+            struct Part { const ChunkGroup* group; size_t vertexBase; size_t indexBase; };
+            std::vector<Part> parts;
+            size_t vertexCount = 0, indexCount = 0;
+            for (const auto& cm : chunkMeshes) {
+                auto it = cm.groups.find(material);
+                if (it == cm.groups.end()) continue;
+                parts.push_back({&it->second, vertexCount, indexCount});
+                vertexCount += it->second.vertices.size();
+                indexCount += it->second.indices.size();
+            }
+
+            mesh.vertices.resize(vertexCount);
+            mesh.indices.resize(indexCount);
+            Jobs::parallelFor(parts.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Part& part = parts[i];
+                    std::copy(part.group->vertices.begin(), part.group->vertices.end(),
+                              mesh.vertices.begin() + part.vertexBase);
+                    uint32_t offset = static_cast<uint32_t>(part.vertexBase);
+                    std::transform(part.group->indices.begin(), part.group->indices.end(),
+                                   mesh.indices.begin() + part.indexBase,
+                                   [offset](uint32_t index) { return index + offset; });
+                }
+            });
+
+            out.meshes.push_back(std::move(mesh));
+        }
+
+        for (auto& material : materials) out.materials.push_back(std::move(material));
+
+        return true;
+    }
+}
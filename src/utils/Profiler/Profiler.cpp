@@ -0,0 +1,149 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Written only by its thread; head counts every event ever recorded.
+    struct ThreadRing {
+        std::unique_ptr<Event[]> events = std::make_unique<Event[]>(Profiler::RING_SIZE);
+        std::atomic<uint64_t> head{0};
+        uint32_t id = 0;
+        std::string name;
+    };
+
+    std::mutex g_mutex;
+    // Rings are never freed: a thread may record while statics are torn down,
+    // and its events should outlive it anyway.
+    std::vector<ThreadRing*> g_rings;
+    thread_local ThreadRing* t_ring = nullptr;
+
+    uint64_t g_startTicks = 0;
+    Clock::time_point g_startTime;
+
+    ThreadRing& threadRing() {
+        if (!t_ring) {
+            auto* ring = new ThreadRing();
+            std::lock_guard<std::mutex> lock(g_mutex);
+            ring->id = static_cast<uint32_t>(g_rings.size()) + 1;
+            ring->name = "thread " + std::to_string(ring->id);
+            g_rings.push_back(ring);
+            t_ring = ring;
+        }
+        return *t_ring;
+    }
+
+    void writeEscaped(std::ofstream& out, const char* text) {
+        for (; *text; ++text) {
+            char c = *text;
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+    }
+
+    // TSC ticks per microsecond, measured against the steady clock since start().
+    double ticksPerMicrosecond() {
+#if PROFILE_RDTSC
+        // Too short an interval gives a poor ratio.
+        while (Clock::now() - g_startTime < std::chrono::milliseconds(10)) std::this_thread::yield();
+        uint64_t ticks = Profiler::detail::now();
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - g_startTime).count();
+        return static_cast<double>(ticks - g_startTicks) / us;
+#else
+        return static_cast<double>(Clock::period::den) / (1e6 * Clock::period::num);
+#endif
+    }
+}
+
+namespace Profiler {
+    namespace detail {
+        std::atomic<bool> active{false};
+
+        void record(const char* name, uint64_t begin, uint64_t end) {
+            ThreadRing& ring = threadRing();
+            uint64_t head = ring.head.load(std::memory_order_relaxed);
+            ring.events[head & (RING_SIZE - 1)] = {name, begin, end};
+            ring.head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    void start() {
+        // Events from an earlier capture are filtered out by time.
+        g_startTime = Clock::now();
+        g_startTicks = detail::now();
+        detail::active.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() {
+        detail::active.store(false, std::memory_order_relaxed);
+    }
+
+    void setThreadName(const std::string& name) {
+        ThreadRing& ring = threadRing();
+        std::lock_guard<std::mutex> lock(g_mutex);
+        ring.name = name;
+    }
+
+    bool writeTrace(const std::string& path) {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out) {
+            std::cerr << "Failed to write CPU trace: " << path << "\n";
+            return false;
+        }
+        double scale = 1.0 / ticksPerMicrosecond();
+
+        std::lock_guard<std::mutex> lock(g_mutex);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}}";
+        char buffer[128];
+        std::vector<Event> events;
+        for (const ThreadRing* ring : g_rings) {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id << ",\"args\":{\"name\":\"";
+            writeEscaped(out, ring->name.c_str());
+            out << "\"}}";
+
+            // Copy, then drop whatever the owner may have overwritten meanwhile.
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+            events.clear();
+            for (uint64_t i = first; i < head; ++i) events.push_back(ring->events[i & (RING_SIZE - 1)]);
+            uint64_t after = ring->head.load(std::memory_order_acquire);
+            uint64_t valid = after > RING_SIZE ? after - RING_SIZE : 0;
+            size_t skip = static_cast<size_t>(std::min<uint64_t>(valid > first ? valid - first : 0, events.size()));
+
+            for (size_t i = skip; i < events.size(); ++i) {
+                const Event& event = events[i];
+                if (event.begin < g_startTicks) continue;
+                out << ",\n{\"name\":\"";
+                writeEscaped(out, event.name);
+                std::snprintf(
+                    buffer,
+                    sizeof(buffer),
+                    "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    ring->id,
+                    static_cast<double>(event.begin - g_startTicks) * scale,
+                    static_cast<double>(event.end - event.begin) * scale
+                );
+                out << buffer;
+            }
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+}
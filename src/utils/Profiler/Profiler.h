@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Build with -DPROFILE_ENABLED=0 to compile every PROFILE_* macro to nothing.
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+#if PROFILE_ENABLED && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define PROFILE_RDTSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define PROFILE_RDTSC 0
+#include <chrono>
+#endif
+
+// CPU zones for attributing startup and frame time across threads. Each
+// thread appends to its own fixed ring of events, so recording takes no lock
+// and never allocates once the thread's ring exists; when a ring wraps, its
+// oldest events are lost. Timestamps are raw TSC ticks where available,
+// converted to microseconds only when the trace is written.
+//
+// Nothing is recorded until start(); until then a zone costs one relaxed
+// load. Zone names must outlive the trace, e.g. string literals.
+namespace Profiler {
+    // Events kept per thread, about 1.5 MB.
+    constexpr uint32_t RING_SIZE = 1u << 16;
+
+    void start();
+    void stop();
+    // Names the calling thread in the trace.
+    void setThreadName(const std::string& name);
+    // Chrome trace JSON (chrome://tracing or Perfetto) of everything still in
+    // the rings. Call after stop(), or expect zones that end meanwhile to be
+    // missing.
+    bool writeTrace(const std::string& path);
+
+    namespace detail {
+        extern std::atomic<bool> active;
+        void record(const char* name, uint64_t begin, uint64_t end);
+
+        inline uint64_t now() {
+#if PROFILE_RDTSC
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+    }
+
+    class Scope {
+    public:
+        explicit Scope(const char* name)
+            : m_name(name)
+            , m_begin(detail::active.load(std::memory_order_relaxed) ? detail::now() : 0)
+        {}
+        ~Scope() {
+            if (m_begin) detail::record(m_name, m_begin, detail::now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_begin;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILE_ENABLED
+#define PROFILE_SCOPE(name) ::Profiler::Scope PROFILE_CONCAT(profileScope, __COUNTER__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) ::Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,410 @@
+#include "RenderFarm.h"
+
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "utils/FrameCapture/FrameCapture.h"
+#include "utils/Time/Time.h"
+
+extern char** environ;
+
+namespace {
+    enum class FrameState : uint8_t {
+        Pending,
+        Assigned,
+        Done,
+        Failed,
+    };
+
+    struct Worker {
+        pid_t pid = -1;
+        int fd = -1;
+        bool ready = false;
+        // When the worker is taken as hung unless it reports; 0 for never.
+        int64_t deadlineNs = 0;
+        // Partial line read so far.
+        std::string buffer;
+        // Frames handed out and not yet reported.
+        std::vector<uint32_t> assigned;
+    };
+
+    bool sendLine(int fd, const std::string& line) {
+        std::string text = line + "\n";
+        size_t sent = 0;
+        while (sent < text.size()) {
+            // A dead worker must not take the coordinator down with SIGPIPE.
+            ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Appends whatever can be read to `buffer` and moves complete lines to
+    // `lines`. False once the other end is gone.
+    bool readLines(int fd, std::string& buffer, std::vector<std::string>& lines) {
+        char chunk[512];
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0) return errno == EINTR || errno == EAGAIN;
+        if (n == 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        size_t start = 0;
+        for (size_t end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n', start)) {
+            lines.push_back(buffer.substr(start, end - start));
+            start = end + 1;
+        }
+        buffer.erase(0, start);
+        return true;
+    }
+
+    bool spawnWorker(const std::string& executable, const std::vector<std::string>& workerArgs, Worker& worker) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            std::perror("RenderFarm: socketpair");
+            return false;
+        }
+        // dup2 onto WORKER_FD clears close-on-exec there, except when the
+        // descriptor already is WORKER_FD and dup2 does nothing.
+        int childEnd = fds[1];
+        if (childEnd == RenderFarm::WORKER_FD) {
+            childEnd = fcntl(fds[1], F_DUPFD_CLOEXEC, RenderFarm::WORKER_FD + 1);
+            close(fds[1]);
+        }
+
+        std::string fdArg = std::to_string(RenderFarm::WORKER_FD);
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(executable.c_str()));
+        argv.push_back(const_cast<char*>("--farm-worker"));
+        argv.push_back(fdArg.data());
+        for (const std::string& arg : workerArgs) argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+
+        // Every worker would print the same startup log; errors still show.
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, childEnd, RenderFarm::WORKER_FD);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        pid_t pid = -1;
+        int error = posix_spawnp(&pid, executable.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        close(childEnd);
+        if (error != 0) {
+            std::cerr << "RenderFarm: failed to start " << executable << ": " << std::strerror(error) << "\n";
+            close(fds[0]);
+            return false;
+        }
+
+        worker = {};
+        worker.pid = pid;
+        worker.fd = fds[0];
+        return true;
+    }
+
+    // Reaps a worker whose socket closed and says how it ended.
+    void reapWorker(Worker& worker, size_t slot) {
+        close(worker.fd);
+        int status = 0;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {}
+        std::cerr << "RenderFarm: worker " << slot << " (pid " << worker.pid << ") ";
+        if (WIFSIGNALED(status)) std::cerr << "killed by signal " << WTERMSIG(status);
+        else std::cerr << "exited with status " << WEXITSTATUS(status);
+        std::cerr << ", " << worker.assigned.size() << " frames unfinished\n";
+        worker.fd = -1;
+        worker.pid = -1;
+    }
+}
+
+namespace RenderFarm {
+    int coordinate(
+        const std::string& executable,
+        const std::vector<std::string>& workerArgs,
+        const RenderFarmOptions& options
+    ) {
+        const uint32_t frames = options.frames;
+        const size_t workerCount = static_cast<size_t>(std::max(options.workers, 1));
+        const size_t queueDepth = static_cast<size_t>(std::max(options.queueDepth, 1));
+        // Covers a crash per attempt of every worker's share, without letting
+        // a worker that dies on startup respawn forever.
+        const int maxSpawns = static_cast<int>(workerCount) * (std::max(options.maxAttempts, 1) + 1);
+
+        std::vector<FrameState> states(frames, FrameState::Pending);
+        std::vector<int> attempts(frames, 0);
+        std::deque<uint32_t> pending;
+        for (uint32_t i = 0; i < frames; ++i) pending.push_back(i);
+        uint32_t settled = 0;
+        uint32_t failed = 0;
+        uint32_t nextInOrder = 0;
+        int spawns = 0;
+        int lost = 0;
+        int hung = 0;
+        int retries = 0;
+        const int64_t frameTimeoutNs = static_cast<int64_t>(options.frameTimeoutSeconds * 1e9);
+        const int64_t startupTimeoutNs = static_cast<int64_t>(options.startupTimeoutSeconds * 1e9);
+
+        std::ofstream manifest;
+        if (!options.outputDir.empty()) {
+            std::string path = options.outputDir + "/frames.txt";
+            manifest.open(path, std::ios::trunc);
+            if (!manifest) std::cerr << "Failed to write frame list: " << path << "\n";
+        }
+
+        std::vector<Worker> workers(workerCount);
+        auto launch = [&](size_t slot) {
+            if (spawns >= maxSpawns) return false;
+            ++spawns;
+            if (!spawnWorker(executable, workerArgs, workers[slot])) return false;
+            workers[slot].deadlineNs = Time::now() + startupTimeoutNs;
+            return true;
+        };
+        auto settle = [&](uint32_t frame, bool ok) {
+            if (ok) {
+                states[frame] = FrameState::Done;
+                ++settled;
+                return;
+            }
+            if (attempts[frame] < options.maxAttempts) {
+                // To the front: a late frame holds up everything after it in frames.txt.
+                states[frame] = FrameState::Pending;
+                pending.push_front(frame);
+                ++retries;
+                return;
+            }
+            std::cerr << "RenderFarm: giving up on frame " << frame << " after " << attempts[frame] << " attempts\n";
+            states[frame] = FrameState::Failed;
+            ++settled;
+            ++failed;
+        };
+        // Crashed, quit early or killed: its frames go back to the queue.
+        auto lose = [&](size_t slot) {
+            Worker& worker = workers[slot];
+            ++lost;
+            reapWorker(worker, slot);
+            std::vector<uint32_t> unfinished = std::move(worker.assigned);
+            worker = {};
+            for (auto it = unfinished.rbegin(); it != unfinished.rend(); ++it) settle(*it, false);
+            if (settled < frames) launch(slot);
+        };
+
+        std::cout << "Render farm: " << frames << " frames on " << workerCount << " workers\n";
+        int64_t startNs = Time::now();
+        int64_t progressNs = startNs;
+        if (!launch(0)) return 1;
+        bool warm = false;
+
+        std::vector<pollfd> fds;
+        std::vector<size_t> fdSlots;
+        std::vector<std::string> lines;
+        while (settled < frames) {
+            bool anyReady = std::any_of(workers.begin(), workers.end(), [](const Worker& w) { return w.ready; });
+            if (!warm && anyReady) {
+                warm = true;
+                for (size_t slot = 1; slot < workerCount; ++slot) launch(slot);
+            }
+
+            for (Worker& worker : workers) {
+                if (worker.fd < 0 || !worker.ready) continue;
+                // An idle worker's clock starts with its first frame.
+                if (worker.assigned.empty() && !pending.empty()) worker.deadlineNs = Time::now() + frameTimeoutNs;
+                while (worker.assigned.size() < queueDepth && !pending.empty()) {
+                    uint32_t frame = pending.front();
+                    pending.pop_front();
+                    states[frame] = FrameState::Assigned;
+                    ++attempts[frame];
+                    worker.assigned.push_back(frame);
+                    // A failed send shows up as a closed socket below.
+                    if (!sendLine(worker.fd, "frame " + std::to_string(frame))) break;
+                }
+            }
+
+            fds.clear();
+            fdSlots.clear();
+            int64_t nextDeadlineNs = 0;
+            for (size_t slot = 0; slot < workerCount; ++slot) {
+                if (workers[slot].fd < 0) continue;
+                fds.push_back({workers[slot].fd, POLLIN, 0});
+                fdSlots.push_back(slot);
+                int64_t deadline = workers[slot].deadlineNs;
+                if (deadline != 0 && (nextDeadlineNs == 0 || deadline < nextDeadlineNs)) nextDeadlineNs = deadline;
+            }
+            if (fds.empty()) {
+                std::cerr << "RenderFarm: no workers left and none can be started\n";
+                break;
+            }
+            int timeoutMs = -1;
+            if (nextDeadlineNs != 0) {
+                // Rounded up, so the wake-up finds the deadline passed.
+                timeoutMs = static_cast<int>(std::max<int64_t>(0, (nextDeadlineNs - Time::now() + 999'999) / 1'000'000));
+            }
+            if (poll(fds.data(), fds.size(), timeoutMs) < 0) {
+                if (errno == EINTR) continue;
+                std::perror("RenderFarm: poll");
+                break;
+            }
+
+            for (size_t i = 0; i < fds.size(); ++i) {
+                if (!fds[i].revents) continue;
+                size_t slot = fdSlots[i];
+                Worker& worker = workers[slot];
+                lines.clear();
+                bool open = readLines(worker.fd, worker.buffer, lines);
+                for (const std::string& line : lines) {
+                    unsigned frame = 0;
+                    bool done = std::sscanf(line.c_str(), "done %u", &frame) == 1;
+                    if (line == "ready") {
+                        worker.ready = true;
+                        worker.deadlineNs = 0;
+                    } else if (done || std::sscanf(line.c_str(), "failed %u", &frame) == 1) {
+                        auto it = std::find(worker.assigned.begin(), worker.assigned.end(), frame);
+                        if (it == worker.assigned.end()) continue;
+                        worker.assigned.erase(it);
+                        settle(frame, done);
+                        // Each report gives the next held frame a full timeout.
+                        worker.deadlineNs = worker.assigned.empty() ? 0 : Time::now() + frameTimeoutNs;
+                    }
+                }
+                if (!open) lose(slot);
+            }
+
+            int64_t nowNs = Time::now();
+            for (size_t slot = 0; slot < workerCount; ++slot) {
+                Worker& worker = workers[slot];
+                if (worker.fd < 0 || worker.deadlineNs == 0 || nowNs < worker.deadlineNs) continue;
+                std::cerr << "RenderFarm: worker " << slot << " (pid " << worker.pid << ") missed its deadline "
+                          << (worker.ready ? "for a frame" : "to start") << ", killing it\n";
+                ++hung;
+                kill(worker.pid, SIGKILL);
+                lose(slot);
+            }
+
+            uint32_t before = nextInOrder;
+            while (nextInOrder < frames &&
+                   (states[nextInOrder] == FrameState::Done || states[nextInOrder] == FrameState::Failed)) {
+                if (manifest && states[nextInOrder] == FrameState::Done) {
+                    manifest << FrameCapture::fileName(nextInOrder) << "\n";
+                }
+                ++nextInOrder;
+            }
+            if (nextInOrder != before) {
+                manifest.flush();
+                if (Time::now() - progressNs > 1'000'000'000) {
+                    progressNs = Time::now();
+                    std::cout << "  " << nextInOrder << "/" << frames << " frames in order, " << settled << " finished\n";
+                }
+            }
+        }
+
+        for (size_t slot = 0; slot < workerCount; ++slot) {
+            Worker& worker = workers[slot];
+            if (worker.fd < 0) continue;
+            sendLine(worker.fd, "quit");
+            close(worker.fd);
+            while (waitpid(worker.pid, nullptr, 0) < 0 && errno == EINTR) {}
+        }
+
+        double seconds = static_cast<double>(Time::now() - startNs) * 1e-9;
+        uint32_t rendered = settled - failed;
+        std::cout << "Render farm: " << rendered << "/" << frames << " frames in " << seconds << " s ("
+                  << rendered * 3600.0 / seconds << " frames/hour), " << spawns << " workers started, "
+                  << lost << " lost (" << hung << " hung), " << retries << " frames retried\n";
+        return rendered == frames ? 0 : 1;
+    }
+}
+
+FarmWorker::FarmWorker(int fd)
+    : m_fd(fd)
+{}
+
+FarmWorker::~FarmWorker() {
+    close(m_fd);
+}
+
+void FarmWorker::ready() {
+    send("ready");
+}
+
+void FarmWorker::done(uint32_t frame, bool ok) {
+    send((ok ? "done " : "failed ") + std::to_string(frame));
+}
+
+bool FarmWorker::next(uint32_t& frame, int timeoutMs) {
+    for (;;) {
+        size_t end = m_buffer.find('\n');
+        if (end != std::string::npos) {
+            std::string line = m_buffer.substr(0, end);
+            m_buffer.erase(0, end + 1);
+            unsigned value = 0;
+            if (std::sscanf(line.c_str(), "frame %u", &value) == 1) {
+                frame = value;
+                return true;
+            }
+            if (line == "quit") m_finished = true;
+            continue;
+        }
+        if (m_finished) return false;
+
+        pollfd fd{m_fd, POLLIN, 0};
+        int ready = poll(&fd, 1, timeoutMs);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) return false;
+        char chunk[512];
+        ssize_t n = read(m_fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            // The coordinator is gone; nobody is waiting for frames.
+            m_finished = true;
+            return false;
+        }
+        m_buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+void FarmWorker::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    sendLine(m_fd, line);
+}
+
+#else
+
+namespace RenderFarm {
+    int coordinate(const std::string&, const std::vector<std::string>&, const RenderFarmOptions&) {
+        std::cerr << "The render farm needs POSIX processes and headless EGL rendering\n";
+        return 1;
+    }
+}
+
+FarmWorker::FarmWorker(int fd)
+    : m_fd(fd)
+{}
+
+FarmWorker::~FarmWorker() = default;
+
+void FarmWorker::ready() {}
+
+void FarmWorker::done(uint32_t, bool) {}
+
+bool FarmWorker::next(uint32_t&, int) {
+    m_finished = true;
+    return false;
+}
+
+void FarmWorker::send(const std::string&) {}
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct RenderFarmOptions {
+    int workers = 2;
+    // Frames 0 .. frames - 1 are handed out.
+    uint32_t frames = 1;
+    // Frames a worker holds beyond the one it is drawing, enough to keep its
+    // readbacks and encoders busy.
+    int queueDepth = 4;
+    // Tries at one frame before it is given up on.
+    int maxAttempts = 3;
+    // A worker holding frames that reports none of them for this long is
+    // taken as hung, killed and replaced; its frames count a failed try.
+    double frameTimeoutSeconds = 120.0;
+    // The same for a worker that has not reported ready, which includes the
+    // first worker filling the asset caches.
+    double startupTimeoutSeconds = 600.0;
+    // Gets frames.txt, the finished frames' files in frame order, appended
+    // as each next frame completes. Empty for none.
+    std::string outputDir;
+};
+
+// Batch rendering across local worker processes. The coordinator starts
+// copies of this executable, talks to each over a socket pair, and hands out
+// frame indices a few at a time, so faster workers take more of the path. A
+// worker that dies, or misses its deadline and is killed, has its unfinished
+// frames handed out again and is replaced.
+//
+// The first worker starts alone and the rest once it reports ready, so the
+// asset caches it writes (TextureCache, MeshCache) are complete before the
+// others map them.
+//
+// Messages are text lines. To a worker: "frame <i>", "quit". From a worker:
+// "ready", "done <i>", "failed <i>".
+namespace RenderFarm {
+    // Where a worker finds its end of the socket.
+    constexpr int WORKER_FD = 3;
+
+    // Runs the coordinator. Workers are `executable --farm-worker WORKER_FD`
+    // followed by `workerArgs`. Returns the process exit code.
+    int coordinate(
+        const std::string& executable,
+        const std::vector<std::string>& workerArgs,
+        const RenderFarmOptions& options
+    );
+}
+
+// A worker's end of the coordinator's socket.
+class FarmWorker {
+public:
+    explicit FarmWorker(int fd);
+    ~FarmWorker();
+
+    FarmWorker(const FarmWorker&) = delete;
+    FarmWorker& operator=(const FarmWorker&) = delete;
+
+    void ready();
+    // May be called from any thread, e.g. FrameCapture's encoders.
+    void done(uint32_t frame, bool ok);
+
+    // The next frame to render. Waits at most `timeoutMs`, or forever if
+    // negative. False on timeout, and once the coordinator is done with this
+    // worker; finished() tells them apart.
+    bool next(uint32_t& frame, int timeoutMs);
+    bool finished() const { return m_finished; }
+
+private:
+    void send(const std::string& line);
+
+    int m_fd;
+    std::mutex m_sendMutex;
+    std::string m_buffer;
+    bool m_finished = false;
+};
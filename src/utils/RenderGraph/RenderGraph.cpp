@@ -0,0 +1,360 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <queue>
+
+#include "utils/GpuProfiler/GpuProfiler.h"
+
+namespace {
+    bool isDepthFormat(GLenum format) {
+        return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 ||
+               format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH24_STENCIL8 ||
+               format == GL_DEPTH32F_STENCIL8;
+    }
+
+    // Any pixel transfer format/type glTexImage2D accepts for the internal format.
+    void transferFormat(GLenum internalFormat, GLenum& format, GLenum& type) {
+        switch (internalFormat) {
+            case GL_DEPTH24_STENCIL8:
+                format = GL_DEPTH_STENCIL;
+                type = GL_UNSIGNED_INT_24_8;
+                return;
+            case GL_DEPTH32F_STENCIL8:
+                format = GL_DEPTH_STENCIL;
+                type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+                return;
+            case GL_R8: case GL_R16F: case GL_R32F:
+                format = GL_RED;
+                break;
+            case GL_RG8: case GL_RG16F: case GL_RG32F:
+                format = GL_RG;
+                break;
+            case GL_RGB8: case GL_RGB16F: case GL_RGB32F: case GL_R11F_G11F_B10F:
+                format = GL_RGB;
+                break;
+            default:
+                format = isDepthFormat(internalFormat) ? GL_DEPTH_COMPONENT : GL_RGBA;
+                break;
+        }
+        type = GL_FLOAT;
+    }
+
+    GLuint allocateTexture(const RenderTextureDesc& desc) {
+        GLenum target = desc.cubemap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+        GLenum format, type;
+        transferFormat(desc.format, format, type);
+
+        GLuint tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(target, tex);
+        int faces = desc.cubemap ? 6 : 1;
+        for (int i = 0; i < faces; ++i) {
+            GLenum face = desc.cubemap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + i : GL_TEXTURE_2D;
+            glTexImage2D(face, 0, desc.format, desc.width, desc.height, 0, format, type, nullptr);
+        }
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (desc.cubemap) glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(target, 0);
+        return tex;
+    }
+}
+
+RenderResource RenderGraph::Builder::create(const std::string& name, const RenderTextureDesc& desc) {
+    return write(m_graph.createTexture(name, desc));
+}
+
+RenderResource RenderGraph::Builder::read(RenderResource resource) {
+    if (resource < m_graph.m_resources.size()) m_graph.m_passes[m_pass].reads.push_back(resource);
+    return resource;
+}
+
+RenderResource RenderGraph::Builder::write(RenderResource resource) {
+    if (resource < m_graph.m_resources.size()) m_graph.m_passes[m_pass].writes.push_back(resource);
+    return resource;
+}
+
+void RenderGraph::Builder::sideEffect() {
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+GLuint RenderGraph::Context::texture(RenderResource resource) const {
+    return m_graph.m_resources[resource].texture;
+}
+
+const RenderTextureDesc& RenderGraph::Context::desc(RenderResource resource) const {
+    return m_graph.m_resources[resource].desc;
+}
+
+void RenderGraph::Context::attachCubeFace(RenderResource resource, int face, int level) const {
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER,
+        GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+        m_graph.m_resources[resource].texture,
+        level
+    );
+}
+
+RenderGraph::~RenderGraph() {
+    for (const PoolTexture& pooled : m_pool) glDeleteTextures(1, &pooled.texture);
+    if (m_fbo) glDeleteFramebuffers(1, &m_fbo);
+}
+
+RenderResource RenderGraph::importTexture(const std::string& name, GLuint texture, const RenderTextureDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.texture = texture;
+    resource.imported = true;
+    m_resources.push_back(resource);
+    return static_cast<RenderResource>(m_resources.size() - 1);
+}
+
+RenderResource RenderGraph::importBackbuffer(int width, int height) {
+    RenderTextureDesc desc;
+    desc.width = width;
+    desc.height = height;
+    RenderResource resource = importTexture("backbuffer", 0, desc);
+    m_resources[resource].backbuffer = true;
+    return resource;
+}
+
+RenderResource RenderGraph::createTexture(const std::string& name, const RenderTextureDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_resources.push_back(resource);
+    return static_cast<RenderResource>(m_resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, const SetupFn& setup, const ExecuteFn& execute) {
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    m_passes.push_back(std::move(pass));
+
+    Builder builder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::compile() {
+    m_stats = {};
+    m_stats.passes = m_passes.size();
+    size_t passCount = m_passes.size();
+
+    std::vector<std::vector<uint32_t>> writers(m_resources.size());
+    for (uint32_t p = 0; p < passCount; ++p) {
+        for (RenderResource r : m_passes[p].writes) writers[r].push_back(p);
+    }
+
+    // Cull: keep passes with side effects or writing imported resources, then
+    // everything that writes what a kept pass reads.
+    std::vector<uint32_t> stack;
+    for (uint32_t p = 0; p < passCount; ++p) {
+        Pass& pass = m_passes[p];
+        pass.live = pass.sideEffect || std::any_of(pass.writes.begin(), pass.writes.end(), [&](RenderResource r) {
+            return m_resources[r].imported;
+        });
+        if (pass.live) stack.push_back(p);
+    }
+    while (!stack.empty()) {
+        uint32_t p = stack.back();
+        stack.pop_back();
+        for (RenderResource r : m_passes[p].reads) {
+            for (uint32_t writer : writers[r]) {
+                if (!m_passes[writer].live) {
+                    m_passes[writer].live = true;
+                    stack.push_back(writer);
+                }
+            }
+        }
+    }
+
+    // Order passes sharing a resource. A read waits for the last writer declared
+    // before it, and the next writer waits for the read (write-after-read).
+    // Writers run in declaration order (write-after-write). A read declared
+    // before any writer waits for all of them, so a pass may be added ahead of
+    // the passes producing its input. Ties keep the declaration order.
+    std::vector<std::vector<uint32_t>> edges(passCount);
+    std::vector<uint32_t> incoming(passCount, 0);
+    auto addEdge = [&](uint32_t from, uint32_t to) {
+        if (from == to) return;
+        if (std::find(edges[from].begin(), edges[from].end(), to) != edges[from].end()) return;
+        edges[from].push_back(to);
+        ++incoming[to];
+    };
+    for (std::vector<uint32_t>& list : writers) {
+        std::erase_if(list, [&](uint32_t p) { return !m_passes[p].live; });
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+        for (size_t i = 1; i < list.size(); ++i) addEdge(list[i - 1], list[i]);
+    }
+    for (uint32_t p = 0; p < passCount; ++p) {
+        if (!m_passes[p].live) continue;
+        for (RenderResource r : m_passes[p].reads) {
+            const std::vector<uint32_t>& list = writers[r];
+            auto before = std::lower_bound(list.begin(), list.end(), p);
+            if (before == list.begin()) {
+                for (uint32_t writer : list) addEdge(writer, p);
+                continue;
+            }
+            addEdge(*(before - 1), p);
+            auto after = std::upper_bound(list.begin(), list.end(), p);
+            if (after != list.end()) addEdge(p, *after);
+        }
+    }
+
+    m_order.clear();
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+    for (uint32_t p = 0; p < passCount; ++p) {
+        if (m_passes[p].live && incoming[p] == 0) ready.push(p);
+        if (!m_passes[p].live) ++m_stats.culledPasses;
+    }
+    while (!ready.empty()) {
+        uint32_t p = ready.top();
+        ready.pop();
+        m_order.push_back(p);
+        for (uint32_t next : edges[p]) {
+            if (--incoming[next] == 0) ready.push(next);
+        }
+    }
+    if (m_order.size() + m_stats.culledPasses != passCount) {
+        std::cerr << "RenderGraph: cycle between passes; dropping the passes involved\n";
+    }
+
+    // Transient lifetimes over the execution order.
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        const Pass& pass = m_passes[m_order[i]];
+        for (const auto* list : {&pass.reads, &pass.writes}) {
+            for (RenderResource r : *list) {
+                Resource& resource = m_resources[r];
+                if (resource.imported) continue;
+                resource.firstUse = std::min(resource.firstUse, i);
+                resource.lastUse = std::max(resource.lastUse, i);
+            }
+        }
+    }
+
+    // Hand out pool textures in execution order, returning each one after its
+    // last reader so later passes can reuse it.
+    std::vector<uint32_t> usedSlots;
+    for (uint32_t i = 0; i < m_order.size(); ++i) {
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.firstUse != i) continue;
+            resource.poolSlot = acquire(resource.desc);
+            resource.texture = m_pool[resource.poolSlot].texture;
+            ++m_stats.transientTextures;
+            if (std::find(usedSlots.begin(), usedSlots.end(), resource.poolSlot) == usedSlots.end()) {
+                usedSlots.push_back(resource.poolSlot);
+            }
+        }
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.poolSlot == UINT32_MAX || resource.lastUse != i) continue;
+            m_pool[resource.poolSlot].inUse = false;
+        }
+    }
+    m_stats.pooledTextures = usedSlots.size();
+}
+
+uint32_t RenderGraph::acquire(const RenderTextureDesc& desc) {
+    for (uint32_t i = 0; i < m_pool.size(); ++i) {
+        if (!m_pool[i].inUse && m_pool[i].desc == desc) {
+            m_pool[i].inUse = true;
+            m_pool[i].used = true;
+            return i;
+        }
+    }
+    m_pool.push_back({desc, allocateTexture(desc), true, true});
+    ++m_stats.allocations;
+    return static_cast<uint32_t>(m_pool.size() - 1);
+}
+
+void RenderGraph::bindTargets(const Pass& pass) const {
+    bool backbuffer = false;
+    const Resource* first = nullptr;
+    for (RenderResource r : pass.writes) {
+        const Resource& resource = m_resources[r];
+        if (!first) first = &resource;
+        backbuffer = backbuffer || resource.backbuffer;
+    }
+
+    if (backbuffer) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+        GLenum drawBuffers[8];
+        GLsizei colorCount = 0;
+        bool depth = false;
+        for (RenderResource r : pass.writes) {
+            const Resource& resource = m_resources[r];
+            // Cubemaps are attached face by face from the pass itself.
+            if (resource.desc.cubemap) continue;
+            if (isDepthFormat(resource.desc.format)) {
+                GLenum attachment = resource.desc.format == GL_DEPTH24_STENCIL8 || resource.desc.format == GL_DEPTH32F_STENCIL8
+                    ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, resource.texture, 0);
+                depth = true;
+            } else if (colorCount < 8) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + colorCount, GL_TEXTURE_2D, resource.texture, 0);
+                drawBuffers[colorCount] = GL_COLOR_ATTACHMENT0 + colorCount;
+                ++colorCount;
+            }
+        }
+        if (!depth) glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+        // Detach colour slots left over from an earlier pass.
+        for (GLsizei i = colorCount; i < 8; ++i) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+        }
+        bool cubeTarget = std::any_of(pass.writes.begin(), pass.writes.end(), [&](RenderResource r) {
+            return m_resources[r].desc.cubemap;
+        });
+        if (cubeTarget && colorCount == 0) {
+            drawBuffers[colorCount++] = GL_COLOR_ATTACHMENT0;
+        }
+        if (colorCount > 0) glDrawBuffers(colorCount, drawBuffers);
+        else glDrawBuffer(GL_NONE);
+    }
+
+    if (first) glViewport(0, 0, first->desc.width, first->desc.height);
+}
+
+void RenderGraph::execute(GpuProfiler* profiler) {
+    if (m_fbo == 0) glGenFramebuffers(1, &m_fbo);
+
+    Context context(*this);
+    for (uint32_t p : m_order) {
+        const Pass& pass = m_passes[p];
+        if (profiler) profiler->begin(pass.name);
+        if (!pass.writes.empty()) bindTargets(pass);
+        pass.execute(context);
+        if (profiler) profiler->end();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderGraph::reset() {
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+
+    // Textures the last frame did not need (e.g. sized for a previous window
+    // size) are released; the rest wait for the next frame.
+    std::erase_if(m_pool, [](const PoolTexture& pooled) {
+        if (!pooled.used) glDeleteTextures(1, &pooled.texture);
+        return !pooled.used;
+    });
+    for (PoolTexture& pooled : m_pool) {
+        pooled.inUse = false;
+        pooled.used = false;
+    }
+}
+
+std::vector<std::string> RenderGraph::order() const {
+    std::vector<std::string> names;
+    names.reserve(m_order.size());
+    for (uint32_t p : m_order) names.push_back(m_passes[p].name);
+    return names;
+}
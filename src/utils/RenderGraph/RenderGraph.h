@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+class GpuProfiler;
+
+struct RenderTextureDesc {
+    int width = 0;
+    int height = 0;
+    // Sized internal format, e.g. GL_RGBA16F or GL_DEPTH_COMPONENT24.
+    GLenum format = GL_RGBA8;
+    bool cubemap = false;
+
+    bool operator==(const RenderTextureDesc&) const = default;
+};
+
+using RenderResource = uint32_t;
+
+// A frame described as passes that declare which textures they read and write.
+// compile() drops passes whose results nobody uses, orders the rest so each
+// read sees the writes declared before it and no later write overtakes it,
+// and maps transient textures onto a pool: a texture freed by one pass is
+// handed to a later pass asking for the same description, and the pool
+// survives reset() so steady-state frames allocate nothing.
+//
+// GL 3.3 has no explicit barriers or memory aliasing; ordering passes is the
+// barrier, and aliasing happens at texture granularity.
+class RenderGraph {
+public:
+    static constexpr RenderResource INVALID = UINT32_MAX;
+
+    class Builder {
+    public:
+        // A texture that lives only inside this frame, first written by this pass.
+        RenderResource create(const std::string& name, const RenderTextureDesc& desc);
+        RenderResource read(RenderResource resource);
+        RenderResource write(RenderResource resource);
+        // Keeps the pass even if nothing reads what it writes.
+        void sideEffect();
+
+    private:
+        friend class RenderGraph;
+        Builder(RenderGraph& graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+        RenderGraph& m_graph;
+        uint32_t m_pass;
+    };
+
+    class Context {
+    public:
+        GLuint texture(RenderResource resource) const;
+        const RenderTextureDesc& desc(RenderResource resource) const;
+        // Points colour attachment 0 of the pass framebuffer at one cubemap face.
+        void attachCubeFace(RenderResource resource, int face, int level = 0) const;
+
+    private:
+        friend class RenderGraph;
+        explicit Context(const RenderGraph& graph) : m_graph(graph) {}
+        const RenderGraph& m_graph;
+    };
+
+    using SetupFn = std::function<void(Builder&)>;
+    using ExecuteFn = std::function<void(const Context&)>;
+
+    struct Stats {
+        size_t passes = 0;
+        size_t culledPasses = 0;
+        size_t transientTextures = 0;
+        // Distinct pool textures backing them this frame.
+        size_t pooledTextures = 0;
+        // Pool textures created by the last compile(); 0 once the pool is warm.
+        size_t allocations = 0;
+    };
+
+    RenderGraph() = default;
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // Textures owned elsewhere. Writes to them count as results of the frame.
+    RenderResource importTexture(const std::string& name, GLuint texture, const RenderTextureDesc& desc);
+    // The default framebuffer. A pass writing it renders to FBO 0.
+    RenderResource importBackbuffer(int width, int height);
+    // A transient texture declared up front, so passes can be added in any order.
+    RenderResource createTexture(const std::string& name, const RenderTextureDesc& desc);
+
+    const RenderTextureDesc& desc(RenderResource resource) const { return m_resources[resource].desc; }
+
+    // `setup` runs immediately; `execute` runs from execute(), so it must not
+    // capture locals of the caller by reference.
+    void addPass(const std::string& name, const SetupFn& setup, const ExecuteFn& execute);
+
+    void compile();
+    // Runs the compiled passes, each with its framebuffer bound and the
+    // viewport set to its first written texture. With a profiler, each pass
+    // is timed as a scope named after it.
+    void execute(GpuProfiler* profiler = nullptr);
+    // Forgets passes and resources. Pool textures used this frame are kept for
+    // the next one; the others are deleted.
+    void reset();
+
+    const Stats& stats() const { return m_stats; }
+    // Execution order of the last compile(), by pass name.
+    std::vector<std::string> order() const;
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTextureDesc desc;
+        GLuint texture = 0;
+        bool imported = false;
+        bool backbuffer = false;
+        // Transient lifetime, as indices into m_order.
+        uint32_t firstUse = UINT32_MAX;
+        uint32_t lastUse = 0;
+        // Slot in m_pool while allocated.
+        uint32_t poolSlot = UINT32_MAX;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteFn execute;
+        std::vector<RenderResource> reads;
+        std::vector<RenderResource> writes;
+        bool sideEffect = false;
+        bool live = false;
+    };
+
+    struct PoolTexture {
+        RenderTextureDesc desc;
+        GLuint texture = 0;
+        bool inUse = false;
+        // Acquired since the last reset().
+        bool used = false;
+    };
+
+    uint32_t acquire(const RenderTextureDesc& desc);
+    void bindTargets(const Pass& pass) const;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<uint32_t> m_order;
+    std::vector<PoolTexture> m_pool;
+    GLuint m_fbo = 0;
+    Stats m_stats;
+};
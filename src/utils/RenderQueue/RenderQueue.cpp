@@ -0,0 +1,257 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr size_t RADIX = 256;
+    // Below this a comparison sort wins.
+    constexpr size_t SMALL_SORT = 1024;
+    constexpr size_t SORT_CHUNK = 32768;
+
+    // Trampoline for packets that draw themselves.
+    void runCallback(const void* data) {
+        const auto& packet = *static_cast<const DrawPacket*>(data);
+        packet.callback(packet);
+    }
+
+    uint32_t floatBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline uint32_t digit(uint64_t key, int pass) {
+        return static_cast<uint32_t>(key >> (pass * 8)) & 0xFF;
+    }
+}
+
+void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch) {
+    size_t count = items.size();
+    if (count < SMALL_SORT) {
+        std::sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) {
+            return a.key != b.key ? a.key < b.key : a.index < b.index;
+        });
+        return;
+    }
+
+    size_t chunkCount = (count + SORT_CHUNK - 1) / SORT_CHUNK;
+    auto chunkRange = [&](size_t c) {
+        return std::pair<size_t, size_t>(c * SORT_CHUNK, std::min((c + 1) * SORT_CHUNK, count));
+    };
+
+    // A byte every key shares does not reorder anything.
+    uint64_t varying = 0;
+    for (size_t i = 1; i < count; ++i) varying |= items[i].key ^ items[0].key;
+
+    scratch.resize(count);
+    std::vector<std::array<size_t, RADIX>> offsets(chunkCount);
+
+    for (int pass = 0; pass < 8; ++pass) {
+        if (digit(varying, pass) == 0) continue;
+
+        Jobs::parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                auto [first, last] = chunkRange(c);
+                offsets[c].fill(0);
+                for (size_t i = first; i < last; ++i) ++offsets[c][digit(items[i].key, pass)];
+            }
+        });
+
+        // Bucket-major, then chunk order, keeps the sort stable.
+        size_t running = 0;
+        for (size_t d = 0; d < RADIX; ++d) {
+            for (size_t c = 0; c < chunkCount; ++c) {
+                size_t n = offsets[c][d];
+                offsets[c][d] = running;
+                running += n;
+            }
+        }
+
+        Jobs::parallelFor(chunkCount, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                auto [first, last] = chunkRange(c);
+                auto& cursor = offsets[c];
+                for (size_t i = first; i < last; ++i) {
+                    scratch[cursor[digit(items[i].key, pass)]++] = items[i];
+                }
+            }
+        });
+        items.swap(scratch);
+    }
+}
+
+uint64_t RenderQueue::makeKey(RenderPass pass, float depth, uint32_t program, uint32_t material, uint32_t mesh) {
+    constexpr uint64_t DEPTH_MASK = (1ull << DEPTH_BITS) - 1;
+
+    // Non-negative floats order like their bit patterns; drop the sign bit and
+    // the low mantissa bits to fit the field.
+    uint64_t depthKey = (floatBits(std::max(depth, 0.0f)) >> (31 - DEPTH_BITS)) & DEPTH_MASK;
+    bool translucent = pass == RenderPass::Transparent;
+    if (translucent) {
+        depthKey = DEPTH_MASK - depthKey;
+    } else {
+        depthKey &= DEPTH_MASK << (DEPTH_BITS - OPAQUE_DEPTH_BITS);
+    }
+
+    uint64_t key = static_cast<uint64_t>(pass);
+    key = (key << TRANSLUCENT_BITS) | (translucent ? 1u : 0u);
+    key = (key << DEPTH_BITS) | depthKey;
+    key = (key << PROGRAM_BITS) | (program & ((1u << PROGRAM_BITS) - 1));
+    key = (key << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+    key = (key << MESH_BITS) | (mesh & ((1u << MESH_BITS) - 1));
+    return key;
+}
+
+void RenderQueue::clear() {
+    m_packets.clear();
+    m_handles.clear();
+    m_items.clear();
+    m_shaders.clear();
+    m_materials.clear();
+    m_meshes.clear();
+    m_meshIds.clear();
+}
+
+CommandHandle RenderQueue::shaderHandle(Shader* shader) {
+    if (!shader) return NO_COMMAND_HANDLE;
+    auto it = std::find(m_shaders.begin(), m_shaders.end(), shader);
+    if (it != m_shaders.end()) return static_cast<CommandHandle>(it - m_shaders.begin());
+    m_shaders.push_back(shader);
+    return static_cast<CommandHandle>(m_shaders.size() - 1);
+}
+
+CommandHandle RenderQueue::materialsHandle(const MaterialTable* materials) {
+    if (!materials) return NO_COMMAND_HANDLE;
+    auto it = std::find(m_materials.begin(), m_materials.end(), materials);
+    if (it != m_materials.end()) return static_cast<CommandHandle>(it - m_materials.begin());
+    m_materials.push_back(materials);
+    return static_cast<CommandHandle>(m_materials.size() - 1);
+}
+
+CommandHandle RenderQueue::meshHandle(const Mesh* mesh) {
+    if (!mesh) return NO_COMMAND_HANDLE;
+    auto [it, inserted] = m_meshIds.try_emplace(mesh, static_cast<CommandHandle>(m_meshes.size()));
+    if (inserted) m_meshes.push_back(mesh);
+    return it->second;
+}
+
+void RenderQueue::submit(const DrawPacket& packet) {
+    PacketHandles handles{shaderHandle(packet.shader), materialsHandle(packet.materials), meshHandle(packet.mesh)};
+    // Key ids are handle + 1, leaving 0 for none.
+    auto keyId = [](CommandHandle handle) { return handle == NO_COMMAND_HANDLE ? 0u : handle + 1; };
+    uint64_t key = makeKey(packet.pass, packet.depth, keyId(handles.shader), keyId(handles.materials), keyId(handles.mesh));
+
+    m_items.push_back({key, static_cast<uint32_t>(m_packets.size())});
+    m_packets.push_back(packet);
+    m_handles.push_back(handles);
+}
+
+void RenderQueue::sort() {
+    m_stats = {};
+    m_stats.packets = m_packets.size();
+
+    const Shader* shader = nullptr;
+    const MaterialTable* materials = nullptr;
+    for (const DrawPacket& packet : m_packets) {
+        if (packet.callback) {
+            shader = nullptr;
+            materials = nullptr;
+            continue;
+        }
+        if (packet.shader != shader) ++m_stats.unsortedStateChanges;
+        if (packet.materials && (packet.materials != materials || packet.shader != shader)) ++m_stats.unsortedStateChanges;
+        shader = packet.shader;
+        materials = packet.materials;
+    }
+
+    radixSort(m_items, m_scratch);
+}
+
+void RenderQueue::setTransparentState(Shader* shader, BlendFactor srcFactor, BlendFactor dstFactor) {
+    m_transparentShader = shader;
+    m_transparentSrc = srcFactor;
+    m_transparentDst = dstFactor;
+}
+
+void RenderQueue::record(size_t begin, size_t end, CommandHandle transparentShader, CommandList& list) const {
+    list.clear();
+    RenderPass pass = RenderPass::Opaque;
+    glm::ivec4 scissor(0, 0, -1, -1);
+    // Blend and scissor are restated at the start and after each callback.
+    bool restate = true;
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t index = m_items[i].index;
+        const DrawPacket& packet = m_packets[index];
+        const PacketHandles& handles = m_handles[index];
+
+        if (restate || packet.pass != pass) {
+            list.blend(packet.pass == RenderPass::Transparent, m_transparentSrc, m_transparentDst);
+            pass = packet.pass;
+        }
+        bool scissorChanged = (packet.scissor.z >= 0 || scissor.z >= 0) && packet.scissor != scissor;
+        if (restate || scissorChanged) {
+            list.scissor(packet.scissor);
+            scissor = packet.scissor;
+        }
+        restate = false;
+
+        if (packet.callback) {
+            list.callback(runCallback, &packet);
+            restate = true;
+            continue;
+        }
+        if (!packet.shader || !packet.mesh) continue;
+
+        bool overridden = pass == RenderPass::Transparent && transparentShader != NO_COMMAND_HANDLE;
+        list.useShader(overridden ? transparentShader : handles.shader);
+        list.bindMaterials(handles.materials);
+        if (packet.indexCount < 0) {
+            list.drawMesh(handles.mesh, *packet.mesh);
+        } else if (packet.indexCount > 0) {
+            list.drawMeshRange(handles.mesh, *packet.mesh, static_cast<uint32_t>(packet.firstIndex),
+                               static_cast<uint32_t>(packet.indexCount));
+        }
+    }
+}
+
+void RenderQueue::execute(RenderPass first, RenderPass last) {
+    // Keys sort by pass first, so the range is contiguous.
+    auto passOf = [&](const SortItem& item) { return m_packets[item.index].pass; };
+    auto begin = std::partition_point(m_items.begin(), m_items.end(), [&](const SortItem& item) {
+        return passOf(item) < first;
+    });
+    auto end = std::partition_point(begin, m_items.end(), [&](const SortItem& item) {
+        return passOf(item) <= last;
+    });
+    size_t offset = static_cast<size_t>(begin - m_items.begin());
+    size_t count = static_cast<size_t>(end - begin);
+    if (count == 0) return;
+
+    CommandHandle transparentShader = shaderHandle(m_transparentShader);
+
+    size_t lanes = std::max<size_t>(Jobs::threadCount(), 1) * 2;
+    size_t grain = std::max(MIN_RECORD_GRAIN, (count + lanes - 1) / lanes);
+    size_t listCount = (count + grain - 1) / grain;
+    if (m_lists.size() < listCount) m_lists.resize(listCount);
+    Jobs::parallelFor(listCount, 1, [&](size_t listBegin, size_t listEnd) {
+        for (size_t l = listBegin; l < listEnd; ++l) {
+            size_t itemBegin = offset + l * grain;
+            record(itemBegin, std::min(itemBegin + grain, offset + count), transparentShader, m_lists[l]);
+        }
+    });
+
+    CommandReplay replay({m_shaders, m_materials, m_meshes});
+    for (size_t l = 0; l < listCount; ++l) m_lists[l].execute(replay);
+    replay.finish();
+
+    const CommandReplay::Stats& stats = replay.stats();
+    m_stats.drawCalls += stats.drawCalls;
+    m_stats.programChanges += stats.programChanges;
+    m_stats.materialChanges += stats.materialChanges;
+    m_stats.meshChanges += stats.meshChanges;
+    m_stats.filteredCommands += stats.filtered;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "math/Mesh/Mesh.h"
+#include "utils/CommandList/CommandList.h"
+#include "utils/MaterialTable/MaterialTable.h"
+#include "utils/Shader/Shader.h"
+
+// Executed in this order. Transparent packets are blended with depth writes off.
+enum class RenderPass : uint8_t {
+    Opaque = 0,
+    // After opaque geometry so early-Z rejects everything already covered.
+    Sky = 1,
+    Transparent = 2,
+};
+
+struct DrawPacket;
+using DrawCallback = void (*)(const DrawPacket& packet);
+
+// One draw. The queue derives the sort key from the pass, depth, shader,
+// material table and mesh, so submitters only describe what to draw.
+struct DrawPacket {
+    RenderPass pass = RenderPass::Opaque;
+    // Distance from the eye. Opaque packets draw front-to-back (in coarse buckets,
+    // so state still groups inside each), transparent ones back-to-front.
+    float depth = 0.0f;
+
+    Shader* shader = nullptr;
+    const MaterialTable* materials = nullptr;
+    const Mesh* mesh = nullptr;
+    GLsizei firstIndex = 0;
+    // Negative draws the whole mesh.
+    GLsizei indexCount = -1;
+
+    // Pixel rectangle (x, y, width, height); a negative width disables scissoring.
+    glm::ivec4 scissor = glm::ivec4(0, 0, -1, -1);
+
+    // Replaces the mesh draw for packets that set their own state. The queue
+    // assumes the callback may change the program and textures.
+    DrawCallback callback = nullptr;
+    const void* user = nullptr;
+    uint32_t arg = 0;
+};
+
+struct SortItem {
+    uint64_t key;
+    uint32_t index;
+};
+
+// Sorts by key (stable), 8 bits per pass, skipping bytes all keys share.
+// Histograms and scatters run on the Jobs pool for large inputs.
+void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+
+class RenderQueue {
+public:
+    // Key layout, most significant first.
+    static constexpr int PASS_BITS = 2;
+    static constexpr int TRANSLUCENT_BITS = 1;
+    static constexpr int DEPTH_BITS = 24;
+    static constexpr int PROGRAM_BITS = 12;
+    static constexpr int MATERIAL_BITS = 10;
+    static constexpr int MESH_BITS = 15;
+    // Depth bits kept for opaque packets: float exponent plus two mantissa bits,
+    // i.e. four buckets per doubling of distance.
+    static constexpr int OPAQUE_DEPTH_BITS = 10;
+    // Fewest packets per command list. A frame is split into about two lists
+    // per job thread, but no finer: each list starts by restating its state.
+    static constexpr size_t MIN_RECORD_GRAIN = 64;
+
+    struct Stats {
+        size_t packets = 0;
+        size_t drawCalls = 0;
+        size_t programChanges = 0;
+        size_t materialChanges = 0;
+        size_t meshChanges = 0;
+        // Program + material changes the packets would have cost in submission order.
+        size_t unsortedStateChanges = 0;
+        // Recorded binds the replay skipped because the state was already set.
+        size_t filteredCommands = 0;
+    };
+
+    void clear();
+    void submit(const DrawPacket& packet);
+
+    void sort();
+    // Draws the sorted packets of passes [first, last] and restores blend,
+    // depth-mask and scissor state. Packets are recorded into command lists
+    // on the Jobs pool, then replayed in order on this thread.
+    void execute(RenderPass first = RenderPass::Opaque, RenderPass last = RenderPass::Transparent);
+
+    // Transparent packets are drawn with `shader` (when set) in place of their
+    // own and with these blend factors instead of straight alpha, e.g. for an
+    // order-independent accumulation pass.
+    void setTransparentState(Shader* shader, BlendFactor srcFactor, BlendFactor dstFactor);
+
+    size_t size() const { return m_packets.size(); }
+    const Stats& stats() const { return m_stats; }
+
+    static uint64_t makeKey(RenderPass pass, float depth, uint32_t program, uint32_t material, uint32_t mesh);
+
+private:
+    // Per-frame handles for what a packet names, used in its sort key and in
+    // the recorded commands.
+    struct PacketHandles {
+        CommandHandle shader;
+        CommandHandle materials;
+        CommandHandle mesh;
+    };
+
+    CommandHandle shaderHandle(Shader* shader);
+    CommandHandle materialsHandle(const MaterialTable* materials);
+    CommandHandle meshHandle(const Mesh* mesh);
+    // Records sorted items [begin, end) into `list`, assuming nothing about
+    // the state left by earlier items.
+    void record(size_t begin, size_t end, CommandHandle transparentShader, CommandList& list) const;
+
+    std::vector<DrawPacket> m_packets;
+    std::vector<PacketHandles> m_handles;
+    std::vector<SortItem> m_items;
+    std::vector<SortItem> m_scratch;
+    // What the handles index, rebuilt each frame.
+    std::vector<Shader*> m_shaders;
+    std::vector<const MaterialTable*> m_materials;
+    std::vector<const Mesh*> m_meshes;
+    std::unordered_map<const Mesh*, CommandHandle> m_meshIds;
+    // Reused across execute() calls so recording stops allocating.
+    std::vector<CommandList> m_lists;
+    Stats m_stats;
+
+    Shader* m_transparentShader = nullptr;
+    BlendFactor m_transparentSrc = BlendFactor::SrcAlpha;
+    BlendFactor m_transparentDst = BlendFactor::OneMinusSrcAlpha;
+};
@@ -0,0 +1,74 @@
+#include "RenderThread.h"
+
+#include <GLFW/glfw3.h>
+
+#include "utils/Profiler/Profiler.h"
+
+RenderThread::RenderThread(GLFWwindow* window, FrameFn frame)
+    : m_window(window)
+    , m_frame(std::move(frame))
+{
+    m_thread = std::thread([this] { run(); });
+}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::submit() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_submitted;
+    }
+    m_wake.notify_one();
+}
+
+bool RenderThread::waitPickedUp(std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_pickedUp.wait_for(lock, timeout, [this] { return m_taken == m_submitted || m_stop; });
+}
+
+void RenderThread::stop() {
+    if (!m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+uint64_t RenderThread::framesPresented() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_presented;
+}
+
+void RenderThread::run() {
+    PROFILE_THREAD("render");
+    glfwMakeContextCurrent(m_window);
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_taken != m_submitted; });
+            if (m_stop) break;
+            m_taken = m_submitted;
+        }
+        m_pickedUp.notify_all();
+
+        bool drew = false;
+        {
+            PROFILE_SCOPE("render frame");
+            drew = m_frame();
+        }
+        if (drew) {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(m_window);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_presented;
+        }
+    }
+
+    glfwMakeContextCurrent(nullptr);
+    m_pickedUp.notify_all();
+}
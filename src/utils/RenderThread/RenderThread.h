@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct GLFWwindow;
+
+// Owns a window's GL context on a thread of its own, so a swap waiting on
+// vsync or a driver busy with the last frame stalls neither event polling
+// nor simulation on the main thread.
+//
+// The main thread publishes frame snapshots (see TripleBuffer) and calls
+// submit(); the render thread wakes, runs `frame`, and swaps if it drew.
+// waitPickedUp() lets the main thread pace itself to the renderer, so the
+// newest snapshot is never more than one frame away from being drawn.
+class RenderThread {
+public:
+    // Returns whether it drew something worth presenting.
+    using FrameFn = std::function<bool()>;
+
+    // Takes over the window's context; no thread may have it current.
+    RenderThread(GLFWwindow* window, FrameFn frame);
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    // A new snapshot is ready. Never blocks.
+    void submit();
+    // Waits until the render thread has started on the last submit(), at
+    // most `timeout`. Returns whether it had.
+    bool waitPickedUp(std::chrono::nanoseconds timeout);
+    // Finishes the frame in progress and releases the context, which the
+    // caller may then make current again.
+    void stop();
+
+    uint64_t framesPresented() const;
+
+private:
+    void run();
+
+    GLFWwindow* m_window;
+    FrameFn m_frame;
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_pickedUp;
+    uint64_t m_submitted = 0;
+    uint64_t m_taken = 0;
+    uint64_t m_presented = 0;
+    bool m_stop = false;
+};
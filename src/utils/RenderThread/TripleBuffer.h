@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Single-writer, single-reader handoff of the latest value. The writer fills
+// back() and publishes it; the reader takes whatever was published last.
+// Neither side ever waits: the three slots let the writer start on the next
+// value while the reader still holds the previous one. Values the reader
+// never picked up are simply overwritten, so it always sees the newest.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer only. Holds whatever was written here two publishes ago.
+    T& back() { return m_slots[m_back]; }
+
+    // Writer only. Returns false if it replaced a value the reader never took.
+    bool publish() {
+        uint8_t previous = m_ready.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+        m_back = previous & INDEX;
+        return !(previous & FRESH);
+    }
+
+    // Reader only. Moves the newest published value to front(); false if
+    // nothing was published since the last call.
+    bool acquire() {
+        if (!(m_ready.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t previous = m_ready.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX;
+        return true;
+    }
+
+    // Reader only.
+    const T& front() const { return m_slots[m_front]; }
+
+private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T m_slots[3];
+    uint8_t m_back = 0;
+    std::atomic<uint8_t> m_ready{1};
+    uint8_t m_front = 2;
+};
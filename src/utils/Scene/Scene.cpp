@@ -0,0 +1,131 @@
+#include "Scene.h"
+
+#include <atomic>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "utils/Jobs/Jobs.h"
+
+namespace {
+    constexpr size_t ENTITY_BATCH = 2048;
+}
+
+Scene::Entity Scene::create(Entity parent) {
+    Entity entity = static_cast<Entity>(size());
+    uint32_t depth = 0;
+    if (parent != NONE) {
+        for (Entity p = parent; m_parent[p] != NONE; p = m_parent[p]) ++depth;
+        ++depth;
+    }
+    if (m_levels.size() <= depth) m_levels.resize(depth + 1);
+    m_levels[depth].push_back(entity);
+
+    m_parent.push_back(parent);
+    m_position.push_back(glm::vec3(0.0f));
+    m_rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    m_scale.push_back(glm::vec3(1.0f));
+    m_world.push_back(glm::mat4(1.0f));
+    m_dirty.push_back(1);
+    m_moved.push_back(0);
+    m_boundsSlot.push_back(NONE);
+    m_renderable.push_back(NONE);
+    m_anyDirty = true;
+    return entity;
+}
+
+void Scene::markDirty(Entity entity) {
+    m_dirty[entity] = 1;
+    m_anyDirty = true;
+}
+
+void Scene::setPosition(Entity entity, const glm::vec3& position) {
+    m_position[entity] = position;
+    markDirty(entity);
+}
+
+void Scene::setRotation(Entity entity, const glm::quat& rotation) {
+    m_rotation[entity] = rotation;
+    markDirty(entity);
+}
+
+void Scene::setScale(Entity entity, const glm::vec3& scale) {
+    m_scale[entity] = scale;
+    markDirty(entity);
+}
+
+void Scene::setTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    m_position[entity] = position;
+    m_rotation[entity] = rotation;
+    m_scale[entity] = scale;
+    markDirty(entity);
+}
+
+void Scene::setBounds(Entity entity, const glm::vec3& min, const glm::vec3& max) {
+    uint32_t slot = m_boundsSlot[entity];
+    if (slot == NONE) {
+        slot = m_bounds.add(min, max);
+        m_boundsSlot[entity] = slot;
+        m_boundsEntity.push_back(entity);
+        m_localMin.push_back(min);
+        m_localMax.push_back(max);
+    } else {
+        m_localMin[slot] = min;
+        m_localMax[slot] = max;
+    }
+    // The world box is rebuilt by the next update.
+    markDirty(entity);
+}
+
+void Scene::update() {
+    m_updatedCount = 0;
+    if (!m_anyDirty) return;
+
+    std::atomic<size_t> updated{0};
+    // Parents sit on shallower levels, so their world matrices are final
+    // before any child reads them.
+    for (const auto& level : m_levels) {
+        Jobs::parallelFor(level.size(), ENTITY_BATCH, [&](size_t begin, size_t end) {
+            size_t count = 0;
+            for (size_t i = begin; i < end; ++i) {
+                Entity e = level[i];
+                Entity p = m_parent[e];
+                bool moved = m_dirty[e] || (p != NONE && m_moved[p]);
+                m_moved[e] = moved;
+                if (!moved) continue;
+                m_dirty[e] = 0;
+
+                glm::mat4 local = glm::translate(glm::mat4(1.0f), m_position[e]) *
+                                  glm::mat4_cast(m_rotation[e]) *
+                                  glm::scale(glm::mat4(1.0f), m_scale[e]);
+                m_world[e] = p == NONE ? local : m_world[p] * local;
+
+                uint32_t slot = m_boundsSlot[e];
+                if (slot != NONE) {
+                    // Arvo: transform the centre, and the extent by the absolute matrix.
+                    const glm::mat4& m = m_world[e];
+                    glm::vec3 center = (m_localMin[slot] + m_localMax[slot]) * 0.5f;
+                    glm::vec3 extent = (m_localMax[slot] - m_localMin[slot]) * 0.5f;
+                    glm::vec3 worldCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+                    glm::vec3 worldExtent =
+                        glm::abs(glm::vec3(m[0])) * extent.x +
+                        glm::abs(glm::vec3(m[1])) * extent.y +
+                        glm::abs(glm::vec3(m[2])) * extent.z;
+                    m_bounds.set(slot, worldCenter - worldExtent, worldCenter + worldExtent);
+                }
+                ++count;
+            }
+            updated += count;
+        });
+    }
+
+    m_updatedCount = updated;
+    m_anyDirty = false;
+}
+
+void Scene::cull(const Frustum& frustum, std::vector<Entity>& visible, const CullOptions& options) const {
+    m_bounds.cull(frustum, m_visibleSlots, options);
+    visible.resize(m_visibleSlots.size());
+    for (size_t i = 0; i < m_visibleSlots.size(); ++i) {
+        visible[i] = m_boundsEntity[m_visibleSlots[i]];
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "math/CullingSet/CullingSet.h"
+#include "math/Frustum/Frustum.h"
+
+// Entity store with one contiguous array per component. An entity is an index
+// into those arrays; parents are always created before their children, so
+// entities can be grouped by depth and each depth updated in parallel.
+class Scene {
+public:
+    using Entity = uint32_t;
+    static constexpr Entity NONE = UINT32_MAX;
+
+    Entity create(Entity parent = NONE);
+    size_t size() const { return m_parent.size(); }
+
+    void setPosition(Entity entity, const glm::vec3& position);
+    void setRotation(Entity entity, const glm::quat& rotation);
+    void setScale(Entity entity, const glm::vec3& scale);
+    void setTransform(Entity entity, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+
+    Entity parent(Entity entity) const { return m_parent[entity]; }
+    const glm::vec3& position(Entity entity) const { return m_position[entity]; }
+    const glm::quat& rotation(Entity entity) const { return m_rotation[entity]; }
+    const glm::vec3& scale(Entity entity) const { return m_scale[entity]; }
+    // As of the last update().
+    const glm::mat4& world(Entity entity) const { return m_world[entity]; }
+
+    // Local-space box. Only entities with bounds are returned by cull().
+    void setBounds(Entity entity, const glm::vec3& min, const glm::vec3& max);
+    bool hasBounds(Entity entity) const { return m_boundsSlot[entity] != NONE; }
+    // World box as of the last update(); the entity must have bounds.
+    glm::vec3 worldMin(Entity entity) const { return m_bounds.boxMin(m_boundsSlot[entity]); }
+    glm::vec3 worldMax(Entity entity) const { return m_bounds.boxMax(m_boundsSlot[entity]); }
+
+    // Opaque handle for the renderer (e.g. an index into its model list).
+    void setRenderable(Entity entity, uint32_t handle) { m_renderable[entity] = handle; }
+    uint32_t renderable(Entity entity) const { return m_renderable[entity]; }
+
+    // Recomputes world matrices and bounds of entities whose transform, or an
+    // ancestor's, changed since the last call. Returns immediately when nothing
+    // moved; otherwise static entities cost one flag check each.
+    void update();
+
+    // Entities with bounds that intersect the frustum, in the order their
+    // bounds were first set.
+    void cull(const Frustum& frustum, std::vector<Entity>& visible, const CullOptions& options = {}) const;
+
+    // Entities recomputed by the last update().
+    size_t updatedCount() const { return m_updatedCount; }
+
+private:
+    void markDirty(Entity entity);
+
+    // Hierarchy
+    std::vector<Entity> m_parent;
+    std::vector<std::vector<Entity>> m_levels;
+
+    // Transform
+    std::vector<glm::vec3> m_position;
+    std::vector<glm::quat> m_rotation;
+    std::vector<glm::vec3> m_scale;
+    std::vector<glm::mat4> m_world;
+    // Local transform changed since the last update.
+    std::vector<uint8_t> m_dirty;
+    // World transform changed during the last update; read by children.
+    std::vector<uint8_t> m_moved;
+
+    // Bounds, indexed by the entity's slot in m_bounds.
+    std::vector<uint32_t> m_boundsSlot;
+    std::vector<Entity> m_boundsEntity;
+    std::vector<glm::vec3> m_localMin;
+    std::vector<glm::vec3> m_localMax;
+    CullingSet m_bounds;
+
+    std::vector<uint32_t> m_renderable;
+
+    bool m_anyDirty = false;
+    size_t m_updatedCount = 0;
+    mutable std::vector<uint32_t> m_visibleSlots;
+};
@@ -43,6 +43,16 @@ void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
     glUniform3fv(location, 1, glm::value_ptr(value));
 }
 
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
+    GLint location = glGetUniformLocation(program, name.c_str());
+    if (location == -1) {
+        std::cerr << "Warning: uniform '" << name << "' doesn't exist or was optimized out\n";
+        return;
+    }
+
+    glUniform4fv(location, 1, glm::value_ptr(value));
+}
+
 void Shader::setMat4(const std::string& name, const glm::mat4& matrix) const
 {
     GLint location = glGetUniformLocation(program, name.c_str());
@@ -53,3 +63,13 @@ void Shader::setMat4(const std::string& name, const glm::mat4& matrix) const
 
     glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrix));
 }
+
+void Shader::setUniformBlockBinding(const std::string& name, GLuint binding) const {
+    GLuint index = glGetUniformBlockIndex(program, name.c_str());
+    if (index == GL_INVALID_INDEX) {
+        std::cerr << "Warning: uniform block '" << name << "' doesn't exist or was optimized out\n";
+        return;
+    }
+
+    glUniformBlockBinding(program, index, binding);
+}
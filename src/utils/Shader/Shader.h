@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <filesystem>
 #include <fstream>
@@ -20,6 +23,12 @@ public:
     Shader(const std::string& shader)
         : vertPath(SHADERS_DIR + "/" + shader + "/" + shader + ".vert"), fragPath(SHADERS_DIR + "/" + shader + "/" + shader + ".frag")
     {
+        // Optional geometry stage, picked up when <name>.geom exists.
+        std::filesystem::path geom = SHADERS_DIR + "/" + shader + "/" + shader + ".geom";
+        if (std::filesystem::exists(geom)) {
+            geomPath = geom;
+            lastGeomWrite = std::filesystem::last_write_time(geomPath);
+        }
         compileAndLink();
         lastVertWrite = std::filesystem::last_write_time(vertPath);
         lastFragWrite = std::filesystem::last_write_time(fragPath);
@@ -45,8 +54,13 @@ public:
         try {
             auto v = std::filesystem::last_write_time(vertPath);
             auto f = std::filesystem::last_write_time(fragPath);
-            if (v != lastVertWrite || f != lastFragWrite) {
-                lastVertWrite = v; lastFragWrite = f;
+            auto g = geomPath.empty() ? lastGeomWrite : std::filesystem::last_write_time(geomPath);
+            bool includeChanged = false;
+            for (const auto& [path, time] : includeWrites) {
+                if (std::filesystem::last_write_time(path) != time) includeChanged = true;
+            }
+            if (v != lastVertWrite || f != lastFragWrite || g != lastGeomWrite || includeChanged) {
+                lastVertWrite = v; lastFragWrite = f; lastGeomWrite = g;
                 std::cout << "[Shader] Change detected, reloading: "
                           << vertPath << " / " << fragPath << std::endl;
                 GLuint oldProg = program;
@@ -69,12 +83,17 @@ public:
     void setFloat(const std::string& name, float value) const;
     void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
+    void setVec4(const std::string& name, const glm::vec4& value) const;
     void setMat4(const std::string& name, const glm::mat4& matrix) const;
+    // Points uniform block `name` at a buffer binding index.
+    void setUniformBlockBinding(const std::string& name, GLuint binding) const;
 
 private:
-    std::filesystem::path vertPath, fragPath;
-    std::filesystem::file_time_type lastVertWrite, lastFragWrite;
+    std::filesystem::path vertPath, fragPath, geomPath;
+    std::filesystem::file_time_type lastVertWrite, lastFragWrite, lastGeomWrite;
     GLuint program = 0;
+    // Files pulled in through #include by the last compile, with their write times.
+    std::vector<std::pair<std::filesystem::path, std::filesystem::file_time_type>> includeWrites;
 
     static std::string readFile(const std::filesystem::path& p) {
         std::ifstream in(p, std::ios::binary);
@@ -99,6 +118,46 @@ private:
         return out;
     }
 
+    // Replaces each `#include "file"` line with that file, resolved against the
+    // including file's directory. GLSL has no file names in #line, so errors in
+    // an included file report its position in includeWrites, plus one, as the
+    // source string number.
+    std::string expandIncludes(const std::string& source, const std::filesystem::path& file, size_t sourceString = 0, int depth = 0) {
+        if (depth > 8) throw std::runtime_error("Shader includes nested too deeply in: " + file.string());
+
+        std::string out;
+        out.reserve(source.size());
+        size_t lineNumber = 1;
+        size_t begin = 0;
+        while (begin < source.size()) {
+            size_t end = source.find('\n', begin);
+            if (end == std::string::npos) end = source.size();
+            std::string_view line(source.data() + begin, end - begin);
+
+            size_t i = line.find_first_not_of(" \t");
+            if (i != std::string_view::npos && line.compare(i, 8, "#include") == 0) {
+                size_t open = line.find('"', i + 8);
+                size_t close = open == std::string_view::npos ? open : line.find('"', open + 1);
+                if (close == std::string_view::npos) {
+                    throw std::runtime_error("Malformed #include in " + file.string() + ":" + std::to_string(lineNumber));
+                }
+                std::filesystem::path included = file.parent_path() / std::string(line.substr(open + 1, close - open - 1));
+                includeWrites.emplace_back(included, std::filesystem::last_write_time(included));
+                size_t includedString = includeWrites.size();
+
+                out += "#line 1 " + std::to_string(includedString) + "\n";
+                out += expandIncludes(readFile(included), included, includedString, depth + 1);
+                out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceString) + "\n";
+            } else {
+                out.append(line);
+                out += '\n';
+            }
+            begin = end + 1;
+            ++lineNumber;
+        }
+        return out;
+    }
+
     static std::string prepareSourceForGLSL(const std::string& source) {
         size_t i = 0;
         while (i < source.size() && isspace((unsigned char)source[i])) ++i;
@@ -111,7 +170,8 @@ private:
             } else {
                 result.reserve(source.size() + 32);
                 result = source.substr(0, pos + 1);
-                result += "#line 1\n";
+                // Keep the file's own numbering, which #include expansion continues.
+                result += "#line " + std::to_string(std::count(source.begin(), source.begin() + pos, '\n') + 2) + "\n";
                 result += source.substr(pos + 1);
             }
             return result;
@@ -142,8 +202,9 @@ private:
 
     bool compileAndLink() {
         try {
-            std::string vsrc = readFile(vertPath);
-            std::string fsrc = readFile(fragPath);
+            includeWrites.clear();
+            std::string vsrc = expandIncludes(readFile(vertPath), vertPath);
+            std::string fsrc = expandIncludes(readFile(fragPath), fragPath);
 
             vsrc = prepareSourceForGLSL(vsrc);
             fsrc = prepareSourceForGLSL(fsrc);
@@ -158,9 +219,19 @@ private:
                 glDeleteShader(vs); glDeleteShader(fs); return false;
             }
 
+            GLuint gs = 0;
+            if (!geomPath.empty()) {
+                std::string gsrc = prepareSourceForGLSL(expandIncludes(readFile(geomPath), geomPath));
+                gs = glCreateShader(GL_GEOMETRY_SHADER);
+                if (!compileShader(gs, gsrc, geomPath.string())) {
+                    glDeleteShader(vs); glDeleteShader(fs); glDeleteShader(gs); return false;
+                }
+            }
+
             GLuint newProgram = glCreateProgram();
             glAttachShader(newProgram, vs);
             glAttachShader(newProgram, fs);
+            if (gs) glAttachShader(newProgram, gs);
             glLinkProgram(newProgram);
 
             GLint linkStatus = 0;
@@ -175,6 +246,7 @@ private:
                 glDeleteProgram(newProgram);
                 glDeleteShader(vs);
                 glDeleteShader(fs);
+                if (gs) glDeleteShader(gs);
                 return false;
             }
 
@@ -184,6 +256,10 @@ private:
             glDetachShader(program, fs);
             glDeleteShader(vs);
             glDeleteShader(fs);
+            if (gs) {
+                glDetachShader(program, gs);
+                glDeleteShader(gs);
+            }
 
             return true;
         } catch (std::exception& e) {
@@ -0,0 +1,362 @@
+#include "ShadowMaps.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    // How far behind a cascade (towards the sun) casters are still captured.
+    constexpr float SUN_CASTER_DISTANCE = 100.0f;
+    // Cascades move in steps of this fraction of their width.
+    constexpr float CASCADE_SNAP_FRACTION = 1.0f / 16.0f;
+    constexpr float SPOT_NEAR = 0.05f;
+
+    // Clip space [-1, 1] to texture space [0, 1].
+    const glm::mat4 TEXTURE_BIAS(
+        0.5f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.5f, 0.0f, 0.0f,
+        0.0f, 0.0f, 0.5f, 0.0f,
+        0.5f, 0.5f, 0.5f, 1.0f
+    );
+
+    GLuint allocateDepthArray(int size, int layers, bool compare) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        GLint filter = compare ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+        // Outside the map counts as lit.
+        const float border[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+        if (compare) {
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return texture;
+    }
+
+    bool sameShadow(const Light& a, const Light& b) {
+        return a.position == b.position && a.direction == b.direction &&
+               a.range == b.range && a.outerAngle == b.outerAngle;
+    }
+}
+
+ShadowMaps::ShadowMaps()
+    : m_depthShader("shadow_depth")
+{
+    // Depth-only framebuffers.
+    glGenFramebuffers(1, &m_fbo);
+    glGenFramebuffers(1, &m_readFbo);
+    for (GLuint fbo : {m_fbo, m_readFbo}) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(GpuShadows), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    m_cascades.size = CASCADE_SIZE;
+    m_cascades.views.resize(CASCADES);
+    m_cascades.texture = allocateDepthArray(CASCADE_SIZE, CASCADES, true);
+
+    m_spots.size = SPOT_SHADOW_SIZE;
+    m_spots.views.resize(MAX_SPOT_SHADOWS);
+    m_spots.texture = allocateDepthArray(SPOT_SHADOW_SIZE, MAX_SPOT_SHADOWS, true);
+    for (View& view : m_spots.views) view.active = false;
+    m_spotSlots.resize(MAX_SPOT_SHADOWS);
+}
+
+ShadowMaps::~ShadowMaps() {
+    for (Target* target : {&m_cascades, &m_spots}) {
+        if (target->texture) glDeleteTextures(1, &target->texture);
+        if (target->cache) glDeleteTextures(1, &target->cache);
+    }
+    if (m_ubo) glDeleteBuffers(1, &m_ubo);
+    if (m_fbo) glDeleteFramebuffers(1, &m_fbo);
+    if (m_readFbo) glDeleteFramebuffers(1, &m_readFbo);
+}
+
+void ShadowMaps::setDynamicBounds(const glm::vec3& min, const glm::vec3& max) {
+    m_dynamicMin = min;
+    m_dynamicMax = max;
+}
+
+void ShadowMaps::invalidateStatic() {
+    for (View& view : m_cascades.views) view.valid = false;
+    for (View& view : m_spots.views) view.valid = false;
+}
+
+void ShadowMaps::setShadowDistance(float distance) {
+    m_shadowDistance = distance;
+}
+
+void ShadowMaps::setSplitLambda(float lambda) {
+    m_splitLambda = lambda;
+}
+
+void ShadowMaps::fitCascades(const Camera& camera, const glm::vec3& sunDirection) {
+    if (sunDirection != m_sunDirection) {
+        for (View& view : m_cascades.views) view.valid = false;
+        m_sunDirection = sunDirection;
+    }
+
+    float nearPlane = camera.nearPlane();
+    float farPlane = std::min(m_shadowDistance, camera.farPlane());
+    float tanY = std::tan(glm::radians(camera.fov()) * 0.5f);
+    float tanX = tanY * camera.aspect();
+    glm::mat4 cameraToWorld = glm::inverse(camera.getViewMatrix());
+
+    glm::vec3 up = std::abs(sunDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    // Fixed orientation: only the translation follows the camera.
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), sunDirection, up);
+
+    float sliceNear = nearPlane;
+    for (int i = 0; i < CASCADES; ++i) {
+        // Practical split scheme: a blend of logarithmic and uniform spacing.
+        float t = static_cast<float>(i + 1) / CASCADES;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        float sliceFar = m_splitLambda * logSplit + (1.0f - m_splitLambda) * uniformSplit;
+
+        // The bounding sphere of the slice does not change as the camera turns,
+        // so neither does the texel size.
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int c = 0; c < 8; ++c) {
+            float depth = (c & 4) ? sliceFar : sliceNear;
+            glm::vec3 viewCorner((c & 1 ? 1.0f : -1.0f) * tanX * depth, (c & 2 ? 1.0f : -1.0f) * tanY * depth, -depth);
+            corners[c] = glm::vec3(cameraToWorld * glm::vec4(viewCorner, 1.0f));
+            center += corners[c] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        // Snapping the centre to whole texels keeps edges from shimmering;
+        // snapping to a coarser grid, with the radius grown to cover the
+        // offset, keeps the matrix (and the cached layer) unchanged for longer.
+        float snap = 2.0f * radius * CASCADE_SNAP_FRACTION;
+        float extent = radius + snap;
+        float texel = 2.0f * extent / CASCADE_SIZE;
+        float step = texel * std::ceil(snap / texel);
+
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter = glm::round(lightCenter / step) * step;
+        glm::mat4 projection = glm::ortho(
+            lightCenter.x - extent, lightCenter.x + extent,
+            lightCenter.y - extent, lightCenter.y + extent,
+            -lightCenter.z - extent - SUN_CASTER_DISTANCE, -lightCenter.z + extent
+        );
+
+        View& view = m_cascades.views[i];
+        glm::mat4 viewProjection = projection * lightView;
+        if (viewProjection != view.viewProjection) {
+            view.viewProjection = viewProjection;
+            view.frustum = Frustum::fromMatrix(viewProjection);
+            view.valid = false;
+        }
+
+        m_gpu.cascades[i] = TEXTURE_BIAS * viewProjection;
+        m_gpu.splits[i] = sliceFar;
+        m_gpu.texelSizes[i] = texel;
+        sliceNear = sliceFar;
+    }
+}
+
+void ShadowMaps::assignSpots(const Camera& camera, ClusteredLights& lights) {
+    const Frustum& frustum = camera.frustum();
+
+    m_candidates.clear();
+    for (uint32_t id = 0; id < lights.size(); ++id) {
+        const Light& light = lights.light(id);
+        if (light.type != LightType::Spot || !light.castsShadows || light.intensity <= 0.0f) continue;
+        if (!frustum.intersectsSphere(light.position, light.range)) continue;
+        m_candidates.push_back(id);
+    }
+    auto distance = [&](uint32_t id) {
+        glm::vec3 d = lights.light(id).position - camera.position();
+        return glm::dot(d, d);
+    };
+    if (m_candidates.size() > static_cast<size_t>(MAX_SPOT_SHADOWS)) {
+        std::nth_element(m_candidates.begin(), m_candidates.begin() + MAX_SPOT_SHADOWS, m_candidates.end(),
+            [&](uint32_t a, uint32_t b) { return distance(a) < distance(b); });
+        m_candidates.resize(MAX_SPOT_SHADOWS);
+    }
+    std::sort(m_candidates.begin(), m_candidates.end());
+
+    // Lights that keep their slot keep their cached layer.
+    for (size_t slot = 0; slot < m_spotSlots.size(); ++slot) {
+        SpotSlot& spot = m_spotSlots[slot];
+        if (spot.light == UINT32_MAX) continue;
+        bool kept = spot.light < lights.size() &&
+                    std::binary_search(m_candidates.begin(), m_candidates.end(), spot.light);
+        if (kept) continue;
+        if (spot.light < lights.size()) lights.setShadowLayer(spot.light, -1);
+        spot.light = UINT32_MAX;
+        m_spots.views[slot].active = false;
+        m_spots.views[slot].valid = false;
+    }
+
+    size_t freeSlot = 0;
+    for (uint32_t id : m_candidates) {
+        if (lights.shadowLayer(id) >= 0) continue;
+        while (m_spotSlots[freeSlot].light != UINT32_MAX) ++freeSlot;
+        m_spotSlots[freeSlot].light = id;
+        m_spots.views[freeSlot].active = true;
+        m_spots.views[freeSlot].valid = false;
+        lights.setShadowLayer(id, static_cast<int>(freeSlot));
+    }
+
+    m_stats.spotShadows = m_candidates.size();
+    for (size_t slot = 0; slot < m_spotSlots.size(); ++slot) {
+        SpotSlot& spot = m_spotSlots[slot];
+        if (spot.light == UINT32_MAX) continue;
+        const Light& light = lights.light(spot.light);
+        View& view = m_spots.views[slot];
+        if (view.valid && sameShadow(light, spot.state)) continue;
+
+        spot.state = light;
+        glm::vec3 direction = glm::normalize(light.direction);
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 projection = glm::perspective(2.0f * light.outerAngle, 1.0f, SPOT_NEAR, light.range);
+        view.viewProjection = projection * glm::lookAt(light.position, light.position + direction, up);
+        view.frustum = Frustum::fromMatrix(view.viewProjection);
+        view.valid = false;
+        m_gpu.spots[slot] = TEXTURE_BIAS * view.viewProjection;
+    }
+}
+
+void ShadowMaps::drawBatched(GLuint texture, const std::vector<int>& layers, const Target& target, const DrawCasters& draw) {
+    if (layers.empty() || !draw) return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
+    glViewport(0, 0, target.size, target.size);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    // Slope-scaled bias against acne; the receivers add a normal offset.
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 2.0f);
+
+    m_depthShader.bind();
+    for (size_t first = 0; first < layers.size(); first += MAX_VIEWS) {
+        size_t count = std::min<size_t>(MAX_VIEWS, layers.size() - first);
+        m_batchFrustums.clear();
+        for (size_t i = 0; i < count; ++i) {
+            const View& view = target.views[layers[first + i]];
+            std::string index = "[" + std::to_string(i) + "]";
+            m_depthShader.setMat4("viewProjections" + index, view.viewProjection);
+            m_depthShader.setInt("layers" + index, layers[first + i]);
+            m_batchFrustums.push_back(view.frustum);
+        }
+        m_depthShader.setMat4("model", glm::mat4(1.0f));
+        draw(m_depthShader, m_batchFrustums);
+        ++m_stats.drawBatches;
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMaps::copyLayer(const Target& target, int layer) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFbo);
+    glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target.cache, 0, layer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbo);
+    glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target.texture, 0, layer);
+    glBlitFramebuffer(0, 0, target.size, target.size, 0, 0, target.size, target.size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowMaps::render(Target& target) {
+    bool dynamicCasters = m_drawDynamic && glm::all(glm::lessThanEqual(m_dynamicMin, m_dynamicMax));
+    if (m_drawDynamic && !target.cache) {
+        target.cache = allocateDepthArray(target.size, static_cast<int>(target.views.size()), false);
+        for (View& view : target.views) view.valid = false;
+    }
+
+    std::vector<int>& staticLayers = m_staticLayers;
+    std::vector<int>& dynamicLayers = m_dynamicLayers;
+    std::vector<int>& copyLayers = m_copyLayers;
+    staticLayers.clear();
+    dynamicLayers.clear();
+    copyLayers.clear();
+    for (int layer = 0; layer < static_cast<int>(target.views.size()); ++layer) {
+        View& view = target.views[layer];
+        if (!view.active) continue;
+        bool stale = !view.valid;
+        bool dynamic = dynamicCasters && view.frustum.intersectsAABB(m_dynamicMin, m_dynamicMax);
+        if (stale) staticLayers.push_back(layer);
+        if (dynamic) dynamicLayers.push_back(layer);
+        // Restore the static image where dynamic casters were or will be drawn.
+        if (stale || dynamic || view.dynamic) copyLayers.push_back(layer);
+        view.valid = true;
+        view.dynamic = dynamic;
+    }
+
+    // Clear the stale layers one at a time; a layered attachment clears them all.
+    GLuint staticTexture = target.cache ? target.cache : target.texture;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glDepthMask(GL_TRUE);
+    for (int layer : staticLayers) {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticTexture, 0, layer);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    drawBatched(staticTexture, staticLayers, target, m_drawStatic);
+    m_stats.staticLayers += staticLayers.size();
+    if (!target.cache) return;
+
+    for (int layer : copyLayers) copyLayer(target, layer);
+    drawBatched(target.texture, dynamicLayers, target, m_drawDynamic);
+    m_stats.dynamicLayers += dynamicLayers.size();
+}
+
+void ShadowMaps::update(const Camera& camera, ClusteredLights& lights) {
+    m_stats = {};
+    fitCascades(camera, lights.sunDirection());
+    assignSpots(camera, lights);
+
+    render(m_cascades);
+    render(m_spots);
+    m_dynamicMin = glm::vec3(0.0f);
+    m_dynamicMax = glm::vec3(-1.0f);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GpuShadows), &m_gpu);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ShadowMaps::bind(Shader& shader) const {
+    shader.bind();
+    shader.setUniformBlockBinding("Shadows", UNIFORM_BINDING);
+    shader.setInt("cascadeShadows", CASCADE_TEXTURE_UNIT);
+    shader.setInt("spotShadows", SPOT_TEXTURE_UNIT);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING, m_ubo);
+    glActiveTexture(GL_TEXTURE0 + CASCADE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_cascades.texture);
+    glActiveTexture(GL_TEXTURE0 + SPOT_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_spots.texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ShadowMaps::unbind() const {
+    glActiveTexture(GL_TEXTURE0 + CASCADE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0 + SPOT_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING, 0);
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "math/Frustum/Frustum.h"
+#include "utils/Camera/Camera.h"
+#include "utils/ClusteredLights/ClusteredLights.h"
+#include "utils/Shader/Shader.h"
+
+// Sun cascades and spot light shadows, each kept in a depth array texture
+// (the spot "atlas" has one layer per shadowed light).
+//
+// Cascades are fitted to bounding spheres of the camera frustum slices and
+// snapped to a coarse grid in light space, so a cascade keeps the same matrix
+// until the camera has moved a fraction of its width. Static casters are only
+// re-rendered into a layer when its matrix or light changed, or after
+// invalidateStatic(). Dynamic casters are drawn every frame on top of a copy of
+// the cached static layer, and only into layers their bounds touch.
+//
+// All casters are drawn depth-only through the "shadow_depth" program: one
+// instanced draw covers every layer being updated, with gl_InstanceID picking
+// the layer in the geometry shader.
+//
+// Shaders declare
+//     layout(std140) uniform Shadows { ... };  // see GpuShadows
+//     uniform sampler2DArrayShadow cascadeShadows;
+//     uniform sampler2DArrayShadow spotShadows;
+class ShadowMaps {
+public:
+    // Must match the defines in the shaders.
+    static constexpr int CASCADES = 4;
+    static constexpr int MAX_SPOT_SHADOWS = 32;
+    // Views one draw can update; shadow_depth.geom has the same limit.
+    static constexpr int MAX_VIEWS = 32;
+
+    static constexpr int CASCADE_SIZE = 2048;
+    static constexpr int SPOT_SHADOW_SIZE = 512;
+    static constexpr GLuint UNIFORM_BINDING = 1;
+    // After ClusteredLights' units.
+    static constexpr int CASCADE_TEXTURE_UNIT = 7;
+    static constexpr int SPOT_TEXTURE_UNIT = 8;
+
+    // Draws casters inside any of `views`, each with one instance per view.
+    // The depth shader is bound and its "model" uniform set to identity.
+    using DrawCasters = std::function<void(Shader& depthShader, std::span<const Frustum> views)>;
+
+    struct Stats {
+        // Layers whose static casters were re-rendered by the last update().
+        size_t staticLayers = 0;
+        // Layers dynamic casters were drawn into.
+        size_t dynamicLayers = 0;
+        size_t drawBatches = 0;
+        size_t spotShadows = 0;
+    };
+
+    ShadowMaps();
+    ~ShadowMaps();
+
+    ShadowMaps(const ShadowMaps&) = delete;
+    ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+    void setStaticCasters(DrawCasters draw) { m_drawStatic = std::move(draw); }
+    void setDynamicCasters(DrawCasters draw) { m_drawDynamic = std::move(draw); }
+    // World box around all dynamic casters, each frame before update(); without
+    // it no dynamic casters are drawn that frame.
+    void setDynamicBounds(const glm::vec3& min, const glm::vec3& max);
+    // Static geometry changed: every layer is re-rendered.
+    void invalidateStatic();
+
+    // Cascades cover view depths up to this distance.
+    void setShadowDistance(float distance);
+    // Splits between uniform (0) and logarithmic (1) spacing.
+    void setSplitLambda(float lambda);
+
+    // Fits the cascades, gives the nearest visible shadow-casting spot lights a
+    // layer (written back through ClusteredLights::setShadowLayer), renders what
+    // changed and uploads the matrices. Call before lights.update(). Changes the
+    // framebuffer binding and viewport.
+    void update(const Camera& camera, ClusteredLights& lights);
+
+    // Points the shader's "Shadows" block and samplers at the maps.
+    void bind(Shader& shader) const;
+    void unbind() const;
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // Matches the std140 "Shadows" block.
+    struct GpuShadows {
+        // World to shadow texture space ([0, 1] in xyz).
+        glm::mat4 cascades[CASCADES];
+        // View depth at which each cascade ends.
+        glm::vec4 splits;
+        // World size of one texel per cascade, for the normal offset.
+        glm::vec4 texelSizes;
+        glm::mat4 spots[MAX_SPOT_SHADOWS];
+    };
+
+    struct View {
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        Frustum frustum{};
+        // Static casters in the cache match viewProjection.
+        bool valid = false;
+        // Dynamic casters were drawn into the layer last frame.
+        bool dynamic = false;
+        // Spot layers without a light are skipped.
+        bool active = true;
+    };
+
+    struct Target {
+        GLuint texture = 0;
+        // Static-only copy, allocated once dynamic casters exist.
+        GLuint cache = 0;
+        int size = 0;
+        std::vector<View> views;
+    };
+
+    struct SpotSlot {
+        // Light id in ClusteredLights, or UINT32_MAX when free.
+        uint32_t light = UINT32_MAX;
+        Light state;
+    };
+
+    void fitCascades(const Camera& camera, const glm::vec3& sunDirection);
+    void assignSpots(const Camera& camera, ClusteredLights& lights);
+    void render(Target& target);
+    void drawBatched(GLuint texture, const std::vector<int>& layers, const Target& target, const DrawCasters& draw);
+    void copyLayer(const Target& target, int layer);
+
+    Shader m_depthShader;
+    GLuint m_fbo = 0;
+    GLuint m_readFbo = 0;
+    GLuint m_ubo = 0;
+
+    Target m_cascades;
+    Target m_spots;
+    std::vector<SpotSlot> m_spotSlots;
+    GpuShadows m_gpu{};
+
+    DrawCasters m_drawStatic;
+    DrawCasters m_drawDynamic;
+    glm::vec3 m_dynamicMin = glm::vec3(0.0f);
+    glm::vec3 m_dynamicMax = glm::vec3(-1.0f);
+
+    float m_shadowDistance = 80.0f;
+    float m_splitLambda = 0.75f;
+    glm::vec3 m_sunDirection = glm::vec3(0.0f);
+
+    // Scratch
+    std::vector<uint32_t> m_candidates;
+    std::vector<Frustum> m_batchFrustums;
+    std::vector<int> m_staticLayers;
+    std::vector<int> m_dynamicLayers;
+    std::vector<int> m_copyLayers;
+
+    Stats m_stats;
+};
@@ -5,31 +5,38 @@
 
 #include <glad/glad.h>
 
+#include "utils/Profiler/Profiler.h"
+
 Skybox::Skybox(const Mesh& cube, const std::string& hdrPath, int cubemapSize, int restoreW, int restoreH)
     : m_cube(&cube),
       m_equirectToCube("equirect_to_cubemap"),
       m_skyboxShader("skybox"),
       m_skyboxCubemap(0)
 {
-    unsigned int hdr2D = Texture::loadHDRI2D(hdrPath);
-    if (hdr2D == 0) {
-        std::cerr << "Skybox: Failed to load HDRI: " << hdrPath << "\n";
-        return;
-    }
-
-    m_skyboxCubemap = Texture::convertHDRIToCubemap(
-        hdr2D,
-        m_equirectToCube,
-        cube.VAO(),
-        cubemapSize,
-        restoreW,
-        restoreH
-    );
+    PROFILE_SCOPE("Skybox::Skybox");
+    std::string settings = "cubemap " + std::to_string(cubemapSize);
+    m_skyboxCubemap = Texture::cached({hdrPath}, settings, GL_TEXTURE_CUBE_MAP, [&]() -> unsigned int {
+        unsigned int hdr2D = Texture::loadHDRI2D(hdrPath);
+        if (hdr2D == 0) {
+            std::cerr << "Skybox: Failed to load HDRI: " << hdrPath << "\n";
+            return 0;
+        }
+
+        unsigned int cubemap = Texture::convertHDRIToCubemap(
+            hdr2D,
+            m_equirectToCube,
+            cube.VAO(),
+            cubemapSize,
+            restoreW,
+            restoreH
+        );
+        glDeleteTextures(1, &hdr2D);
+        return cubemap;
+    });
+    if (m_skyboxCubemap == 0) return;
 
     m_skyboxShader.bind();
     m_skyboxShader.setInt("skybox", 0);
-
-    if (hdr2D) glDeleteTextures(1, &hdr2D);
 }
 
 Skybox::~Skybox() {
@@ -37,6 +44,24 @@ Skybox::~Skybox() {
 }
 
 void Skybox::draw(const Camera& camera) const {
+    draw(camera.getProjectionMatrix(), glm::mat4(glm::mat3(camera.getViewMatrix())));
+}
+
+void Skybox::submit(RenderQueue& queue, const Camera& camera) const {
+    m_submitProj = camera.getProjectionMatrix();
+    m_submitView = glm::mat4(glm::mat3(camera.getViewMatrix()));
+
+    DrawPacket packet;
+    packet.pass = RenderPass::Sky;
+    packet.callback = [](const DrawPacket& p) {
+        const Skybox* skybox = static_cast<const Skybox*>(p.user);
+        skybox->draw(skybox->m_submitProj, skybox->m_submitView);
+    };
+    packet.user = this;
+    queue.submit(packet);
+}
+
+void Skybox::draw(const glm::mat4& proj, const glm::mat4& view) const {
     if (!m_skyboxCubemap || !m_cube) return;
 
     glDepthFunc(GL_LEQUAL);
@@ -45,9 +70,6 @@ void Skybox::draw(const Camera& camera) const {
 
     m_skyboxShader.bind();
 
-    glm::mat4 proj = camera.getProjectionMatrix();
-    glm::mat4 view = glm::mat4(glm::mat3(camera.getViewMatrix()));
-
     m_skyboxShader.setMat4("proj", proj);
     m_skyboxShader.setMat4("view", view);
 
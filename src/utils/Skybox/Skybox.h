@@ -8,6 +8,7 @@
 #include "utils/Texture/Texture.h"
 #include "utils/Camera/Camera.h"
 #include "math/Mesh/Mesh.h"
+#include "utils/RenderQueue/RenderQueue.h"
 
 class Skybox {
 public:
@@ -18,10 +19,18 @@ public:
     Skybox& operator=(const Skybox&) = delete;
 
     void draw(const Camera& camera) const;
+    // Queues the sky for RenderPass::Sky, after opaque geometry.
+    void submit(RenderQueue& queue, const Camera& camera) const;
 
 private:
+    void draw(const glm::mat4& proj, const glm::mat4& view) const;
+
     const Mesh* m_cube = NULL;
     Shader m_equirectToCube;
     Shader m_skyboxShader;
     unsigned int m_skyboxCubemap = 0;
+
+    // Matrices captured by submit() for the queued draw.
+    mutable glm::mat4 m_submitProj = glm::mat4(1.0f);
+    mutable glm::mat4 m_submitView = glm::mat4(1.0f);
 };
@@ -1,29 +1,22 @@
 #include "Texture.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include <glad/glad.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
-namespace Texture {
-    unsigned int load2D(const std::string& path, bool flipVertically) {
-        stbi_set_flip_vertically_on_load(flipVertically);
+#include "utils/RenderGraph/RenderGraph.h"
+#include "utils/Profiler/Profiler.h"
+#include "utils/TextureCache/TextureCache.h"
 
-        int width, height, channels;
-        unsigned char* data = stbi_load(
-            path.c_str(),
-            &width,
-            &height,
-            &channels,
-            0
-        );
-
-        if (!data) {
-            std::cerr << "Failed to load texture: " << path << std::endl;
-            return 0;
-        }
+namespace {
+    std::string g_cacheDirectory;
+}
 
+namespace Texture {
+    static unsigned int upload2D(unsigned char* data, int width, int height, int channels) {
         GLenum format = GL_RGB;
         if (channels == 1) format = GL_RED;
         else if (channels == 3) format = GL_RGB;
@@ -62,12 +55,166 @@ namespace Texture {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+        return textureID;
+    }
+
+    unsigned int load2D(const std::string& path, bool flipVertically) {
+        PROFILE_SCOPE("Texture::load2D");
+        stbi_set_flip_vertically_on_load(flipVertically);
+
+        int width, height, channels;
+        unsigned char* data = stbi_load(
+            path.c_str(),
+            &width,
+            &height,
+            &channels,
+            0
+        );
+
+        if (!data) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            return 0;
+        }
+
+        unsigned int textureID = upload2D(data, width, height, channels);
+        stbi_image_free(data);
+
+        return textureID;
+    }
+
+    unsigned int load2DFromMemory(std::span<const std::byte> encoded, bool flipVertically) {
+        stbi_set_flip_vertically_on_load(flipVertically);
+
+        int width, height, channels;
+        unsigned char* data = stbi_load_from_memory(
+            reinterpret_cast<const stbi_uc*>(encoded.data()),
+            static_cast<int>(encoded.size()),
+            &width,
+            &height,
+            &channels,
+            0
+        );
+
+        if (!data) {
+            std::cerr << "Failed to decode embedded texture (" << encoded.size() << " bytes)" << std::endl;
+            return 0;
+        }
+
+        unsigned int textureID = upload2D(data, width, height, channels);
+        stbi_image_free(data);
+
+        return textureID;
+    }
+
+    // load2D() keeps the file's channel count, and a blit from a GL_RED texture
+    // fills green and blue with 0 (swizzles only apply to sampling), so grey
+    // images are expanded on the CPU before they are blitted into a layer.
+    static unsigned int loadRGBA(const std::string& path, bool flipVertically) {
+        stbi_set_flip_vertically_on_load(flipVertically);
+
+        int width, height, channels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+        if (!data) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            return 0;
+        }
+
+        unsigned int textureID = upload2D(data, width, height, 4);
         stbi_image_free(data);
 
         return textureID;
     }
 
+    static unsigned int buildArray2D(const std::vector<std::string>& paths, int size, bool flipVertically) {
+        GLsizei layers = static_cast<GLsizei>(std::max<size_t>(paths.size(), 1));
+
+        unsigned int arrayID;
+        glGenTextures(1, &arrayID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayID);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        GLint prevRead = 0, prevDraw = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prevRead);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prevDraw);
+
+        GLuint fbos[2];
+        glGenFramebuffers(2, fbos);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+
+        for (GLsizei layer = 0; layer < layers; ++layer) {
+            glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, arrayID, 0, layer);
+
+            unsigned int source = static_cast<size_t>(layer) < paths.size()
+                ? loadRGBA(paths[static_cast<size_t>(layer)], flipVertically)
+                : 0;
+            if (source == 0) {
+                const GLfloat white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+                glClearBufferfv(GL_COLOR, 0, white);
+                continue;
+            }
+
+            // Blit from the mip level closest above the target size; a linear blit
+            // only filters 2x2 texels, so larger ratios would alias.
+            GLint width = 0, height = 0;
+            glBindTexture(GL_TEXTURE_2D, source);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+            GLint level = 0;
+            while ((width >> (level + 1)) >= size && (height >> (level + 1)) >= size) ++level;
+
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, level);
+            glBlitFramebuffer(
+                0, 0, std::max(width >> level, 1), std::max(height >> level, 1),
+                0, 0, size, size,
+                GL_COLOR_BUFFER_BIT, GL_LINEAR
+            );
+
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glDeleteTextures(1, &source);
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(prevRead));
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, static_cast<GLuint>(prevDraw));
+        glDeleteFramebuffers(2, fbos);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrayID);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        return arrayID;
+    }
+
+    unsigned int loadArray2D(
+        const std::vector<std::string>& paths,
+        int size,
+        bool flipVertically,
+        std::vector<glm::vec2>* aspectScales
+    ) {
+        PROFILE_SCOPE("Texture::loadArray2D");
+        if (aspectScales) {
+            // Header only, so this also holds when the array comes from the cache.
+            aspectScales->assign(paths.size(), glm::vec2(1.0f));
+            for (size_t i = 0; i < paths.size(); ++i) {
+                int width = 0, height = 0, channels = 0;
+                if (!stbi_info(paths[i].c_str(), &width, &height, &channels) || width <= 0 || height <= 0) continue;
+                (*aspectScales)[i] = glm::vec2(static_cast<float>(height), static_cast<float>(width)) /
+                                     static_cast<float>(std::min(width, height));
+            }
+        }
+        std::string settings = "array rgba " + std::to_string(size) + (flipVertically ? " flipped" : "");
+        return cached(paths, settings, GL_TEXTURE_2D_ARRAY, [&]() {
+            return buildArray2D(paths, size, flipVertically);
+        });
+    }
+
     unsigned int loadCubemap(const std::vector<std::string>& faces) {
+        PROFILE_SCOPE("Texture::loadCubemap");
         unsigned int textureID;
         glGenTextures(1, &textureID);
         glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
@@ -144,6 +291,7 @@ namespace Texture {
     }
 
     unsigned int loadHDRI2D(const std::string& path) {
+        PROFILE_SCOPE("Texture::loadHDRI2D");
         stbi_set_flip_vertically_on_load(true);
 
         int w, h, n;
@@ -188,6 +336,51 @@ namespace Texture {
         return hdrTex;
     }
 
+    unsigned int loadLightmap(const std::string& path, int* width, int* height) {
+        PROFILE_SCOPE("Texture::loadLightmap");
+        stbi_set_flip_vertically_on_load(true);
+
+        int w, h, n;
+        float* data = stbi_loadf(path.c_str(), &w, &h, &n, 3);
+        if (!data) {
+            std::cerr << "Failed to load lightmap: " << path << "\n";
+            return 0;
+        }
+
+        unsigned int lightmapTex = 0;
+        glGenTextures(1, &lightmapTex);
+        glBindTexture(GL_TEXTURE_2D, lightmapTex);
+        // Shared-exponent: 4 bytes per texel, the same as the RGBE file.
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB9_E5, w, h, 0, GL_RGB, GL_FLOAT, data);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        stbi_image_free(data);
+        if (width) *width = w;
+        if (height) *height = h;
+        return lightmapTex;
+    }
+
+    glm::vec3 averageColor(const std::string& path) {
+        int w, h, n;
+        unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 3);
+        if (!data) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            return glm::vec3(1.0f);
+        }
+
+        double sum[3] = {};
+        size_t count = static_cast<size_t>(w) * h;
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) sum[c] += data[i * 3 + c];
+        }
+        stbi_image_free(data);
+        return glm::vec3(sum[0], sum[1], sum[2]) / (255.0f * static_cast<float>(count));
+    }
+
     unsigned int createEmptyEnvCubemap(int size) {
         unsigned int tex = 0;
         glGenTextures(1, &tex);
@@ -231,61 +424,81 @@ namespace Texture {
         int restoreViewportW,
         int restoreViewportH
     ) {
+        PROFILE_SCOPE("Texture::convertHDRIToCubemap");
         unsigned int envCubemap = createEmptyEnvCubemap(cubemapSize);
 
-        unsigned int captureFBO, captureRBO;
-        glGenFramebuffers(1, &captureFBO);
-        glGenRenderbuffers(1, &captureRBO);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, cubemapSize, cubemapSize);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+        RenderGraph graph;
+        RenderResource environment = graph.importTexture(
+            "environment",
+            envCubemap,
+            {cubemapSize, cubemapSize, GL_RGB16F, true}
+        );
 
-        shaderEquirectToCube.bind();
-        shaderEquirectToCube.setInt("equirectangularMap", 0);
-        shaderEquirectToCube.setMat4("projection", CAPTURE_PROJECTION);
+        graph.addPass(
+            "equirect-to-cubemap",
+            [&](RenderGraph::Builder& builder) {
+                builder.create("capture-depth", {cubemapSize, cubemapSize, GL_DEPTH_COMPONENT24});
+                builder.write(environment);
+            },
+            [&](const RenderGraph::Context& context) {
+                shaderEquirectToCube.bind();
+                shaderEquirectToCube.setInt("equirectangularMap", 0);
+                shaderEquirectToCube.setMat4("projection", CAPTURE_PROJECTION);
+
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, hdrTex2D);
+
+                for (int i = 0; i < 6; i++)
+                {
+                    shaderEquirectToCube.setMat4("view", CAPTURE_VIEWS[i]);
+                    context.attachCubeFace(environment, i);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                    glBindVertexArray(cubeVAO);
+
+                    GLint elementBuffer = 0;
+                    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+
+                    if (elementBuffer != 0) {
+                        GLint bufSize = 0;
+                        glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufSize);
+                        GLsizei indexCount = static_cast<GLsizei>(bufSize / sizeof(unsigned int));
+                        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+                    } else {
+                        glDrawArrays(GL_TRIANGLES, 0, 36);
+                    }
+                }
+            }
+        );
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, hdrTex2D);
+        graph.compile();
+        graph.execute();
 
-        glViewport(0, 0, cubemapSize, cubemapSize);
-        glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+        glViewport(0, 0, restoreViewportW, restoreViewportH);
 
-        for (unsigned int i = 0; i < 6; i++)
-        {
-            shaderEquirectToCube.setMat4("view", CAPTURE_VIEWS[i]);
-            glFramebufferTexture2D(
-                GL_FRAMEBUFFER,
-                GL_COLOR_ATTACHMENT0,
-                GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                envCubemap, 0
-            );
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        return envCubemap;
+    }
 
-            glBindVertexArray(cubeVAO);
+    void setCacheDirectory(const std::string& directory) {
+        g_cacheDirectory = directory;
+    }
 
-            GLint elementBuffer = 0;
-            glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+    unsigned int cached(
+        const std::vector<std::string>& sources,
+        const std::string& settings,
+        unsigned int target,
+        const std::function<unsigned int()>& build
+    ) {
+        if (g_cacheDirectory.empty()) return build();
 
-            if (elementBuffer != 0) {
-                GLint bufSize = 0;
-                glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufSize);
-                GLsizei indexCount = static_cast<GLsizei>(bufSize / sizeof(unsigned int));
-                glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-            } else {
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-            }
+        std::string path = TextureCache::cachePathFor(g_cacheDirectory, sources, settings);
+        if (TextureCache::isFresh(path, sources)) {
+            unsigned int texture = TextureCache::load(path);
+            if (texture) return texture;
         }
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        glDeleteFramebuffers(1, &captureFBO);
-        glDeleteRenderbuffers(1, &captureRBO);
-
-        glViewport(0, 0, restoreViewportW, restoreViewportH);
-
-        return envCubemap;
+        unsigned int texture = build();
+        if (texture) TextureCache::write(path, target, texture);
+        return texture;
     }
 
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
+#include <glm/glm.hpp>
+
 #include "utils/Shader/Shader.h"
 
 namespace Texture {
@@ -10,6 +15,25 @@ namespace Texture {
         const std::string& path,
         bool flipVertically = true
     );
+    // Decodes an encoded image (PNG/JPG/...) that already lives in memory,
+    // e.g. a glTF image inside a mapped .glb file.
+    unsigned int load2DFromMemory(
+        std::span<const std::byte> encoded,
+        bool flipVertically = true
+    );
+
+    // Loads every image into one layer of a size x size RGBA8 GL_TEXTURE_2D_ARRAY,
+    // rescaling on the GPU. Grey images are expanded to grey RGB. Layers whose
+    // image fails to load are left white.
+    // Squaring a layer stretches non-square images; if `aspectScales` is given
+    // it receives, per layer, the UV scale that restores the image's aspect
+    // (the longer side keeps a scale of 1).
+    unsigned int loadArray2D(
+        const std::vector<std::string>& paths,
+        int size,
+        bool flipVertically = true,
+        std::vector<glm::vec2>* aspectScales = nullptr
+    );
 
     unsigned int loadCubemap(
         const std::vector<std::string>& faces
@@ -20,7 +44,25 @@ namespace Texture {
     );
 
     unsigned int loadHDRI2D(const std::string& path);
+    // Baked lightmap (.hdr) as GL_RGB9_E5, linear, clamped, no mipmaps.
+    // Writes its size to width/height if given.
+    unsigned int loadLightmap(const std::string& path, int* width = nullptr, int* height = nullptr);
+    // CPU only: mean colour of an image in [0, 1], white if it fails to load.
+    glm::vec3 averageColor(const std::string& path);
     unsigned int createEmptyEnvCubemap(int size);
+
+    // Where loadArray2D() and cached() keep finished textures (see
+    // TextureCache). Empty, the default, turns caching off.
+    void setCacheDirectory(const std::string& directory);
+    // Loads the texture cached for `sources` and `settings`, or runs `build`
+    // and caches what it returns. `target` is GL_TEXTURE_2D_ARRAY or
+    // GL_TEXTURE_CUBE_MAP. Without a cache directory, just runs `build`.
+    unsigned int cached(
+        const std::vector<std::string>& sources,
+        const std::string& settings,
+        unsigned int target,
+        const std::function<unsigned int()>& build
+    );
     unsigned int convertHDRIToCubemap(
         unsigned int hdrTex2D,
         Shader& shaderEquirectToCube,
@@ -0,0 +1,262 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "utils/AtomicFile/AtomicFile.h"
+#include "utils/MappedFile/MappedFile.h"
+#include "utils/Profiler/Profiler.h"
+
+namespace {
+    constexpr char MAGIC[4] = {'R', 'T', 'E', 'X'};
+    constexpr size_t BLOCK_ALIGNMENT = 64;
+
+    struct FileHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t target;
+        uint32_t internalFormat;
+        uint32_t format;
+        uint32_t type;
+        int32_t width;
+        int32_t height;
+        // Layers of an array; 1 for a cube map.
+        int32_t depth;
+        uint32_t levels;
+        uint32_t imageCount;
+        int32_t minFilter;
+        int32_t magFilter;
+        int32_t wrapS;
+        int32_t wrapT;
+        int32_t wrapR;
+        uint64_t fileSize;
+    };
+
+    struct ImageEntry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct PixelFormat {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        uint32_t bytesPerPixel;
+    };
+
+    // Formats the engine's cacheable textures use, read back unconverted.
+    constexpr PixelFormat FORMATS[] = {
+        {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4},
+        {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3},
+        {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8},
+        {GL_RGB16F, GL_RGB, GL_HALF_FLOAT, 6},
+        {GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 4},
+        {GL_RGB9_E5, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, 4},
+    };
+
+    const PixelFormat* findFormat(GLenum internalFormat) {
+        for (const PixelFormat& format : FORMATS) {
+            if (format.internalFormat == internalFormat) return &format;
+        }
+        return nullptr;
+    }
+
+    bool isMipmapped(GLint minFilter) {
+        return minFilter != GL_NEAREST && minFilter != GL_LINEAR;
+    }
+
+    size_t alignUp(size_t value) {
+        return (value + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+    }
+
+    uint64_t fnv1a(const std::string& text, uint64_t hash) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        // Separates consecutive strings, so ("ab", "c") and ("a", "bc") differ.
+        hash ^= 0xFF;
+        hash *= 1099511628211ull;
+        return hash;
+    }
+
+    uint32_t faceCount(GLenum target) {
+        return target == GL_TEXTURE_CUBE_MAP ? 6u : 1u;
+    }
+
+    GLenum imageTarget(GLenum target, uint32_t face) {
+        return target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+    }
+}
+
+namespace TextureCache {
+    std::string cachePathFor(
+        const std::string& directory,
+        const std::vector<std::string>& sources,
+        const std::string& settings
+    ) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const std::string& source : sources) hash = fnv1a(source, hash);
+        hash = fnv1a(settings, hash);
+
+        std::string stem = sources.empty() ? "texture" : std::filesystem::path(sources.front()).stem().string();
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), "-%016llx.rtex", static_cast<unsigned long long>(hash));
+        return directory + "/" + stem + suffix;
+    }
+
+    bool isFresh(const std::string& cachePath, const std::vector<std::string>& sources) {
+        std::error_code ec;
+        auto cacheTime = std::filesystem::last_write_time(cachePath, ec);
+        if (ec) return false;
+        for (const std::string& source : sources) {
+            auto sourceTime = std::filesystem::last_write_time(source, ec);
+            if (ec || cacheTime < sourceTime) return false;
+        }
+
+        MappedFile file(cachePath);
+        if (!file.isOpen() || file.size() < sizeof(FileHeader)) return false;
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+               header.version == VERSION &&
+               header.fileSize == file.size();
+    }
+
+    bool write(const std::string& path, GLenum target, GLuint texture) {
+        PROFILE_SCOPE("TextureCache::write");
+        if (target != GL_TEXTURE_2D_ARRAY && target != GL_TEXTURE_CUBE_MAP) {
+            std::cerr << "TextureCache: only arrays and cube maps are cached, not " << path << "\n";
+            return false;
+        }
+
+        glBindTexture(target, texture);
+        GLenum levelTarget = imageTarget(target, 0);
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.target = target;
+        GLint internalFormat = 0;
+        glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+        glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_WIDTH, &header.width);
+        glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_HEIGHT, &header.height);
+        header.depth = 1;
+        if (target == GL_TEXTURE_2D_ARRAY) glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_DEPTH, &header.depth);
+        glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &header.minFilter);
+        glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &header.magFilter);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &header.wrapS);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &header.wrapT);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_R, &header.wrapR);
+
+        const PixelFormat* format = findFormat(static_cast<GLenum>(internalFormat));
+        if (!format || header.width <= 0 || header.height <= 0) {
+            std::cerr << "TextureCache: cannot cache format 0x" << std::hex << internalFormat << std::dec
+                      << " (" << header.width << "x" << header.height << ") in " << path << "\n";
+            glBindTexture(target, 0);
+            return false;
+        }
+        header.internalFormat = format->internalFormat;
+        header.format = format->format;
+        header.type = format->type;
+        header.levels = 1;
+        if (isMipmapped(header.minFilter)) {
+            while ((std::max(header.width, header.height) >> header.levels) > 0) ++header.levels;
+        }
+        uint32_t faces = faceCount(target);
+        header.imageCount = header.levels * faces;
+
+        std::vector<ImageEntry> images(header.imageCount);
+        size_t offset = alignUp(sizeof(FileHeader) + sizeof(ImageEntry) * images.size());
+        for (uint32_t level = 0; level < header.levels; ++level) {
+            size_t w = static_cast<size_t>(std::max(header.width >> level, 1));
+            size_t h = static_cast<size_t>(std::max(header.height >> level, 1));
+            for (uint32_t face = 0; face < faces; ++face) {
+                ImageEntry& image = images[level * faces + face];
+                image.offset = offset;
+                image.size = w * h * static_cast<size_t>(header.depth) * format->bytesPerPixel;
+                offset = alignUp(offset + image.size);
+            }
+        }
+        header.fileSize = offset;
+
+        std::vector<std::byte> bytes(offset);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + sizeof(header), images.data(), sizeof(ImageEntry) * images.size());
+
+        GLint prevAlign = 4;
+        glGetIntegerv(GL_PACK_ALIGNMENT, &prevAlign);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        for (uint32_t level = 0; level < header.levels; ++level) {
+            for (uint32_t face = 0; face < faces; ++face) {
+                const ImageEntry& image = images[level * faces + face];
+                glGetTexImage(imageTarget(target, face), static_cast<GLint>(level), format->format, format->type, bytes.data() + image.offset);
+            }
+        }
+        glPixelStorei(GL_PACK_ALIGNMENT, prevAlign);
+        glBindTexture(target, 0);
+
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+        // Written aside and renamed into place, so a crash never leaves a truncated
+        // cache and concurrent builds of the same texture cannot interleave.
+        return AtomicFile::write(path, bytes, "TextureCache");
+    }
+
+    GLuint load(const std::string& path) {
+        PROFILE_SCOPE("TextureCache::load");
+        MappedFile file(path);
+        if (!file.isOpen() || file.size() < sizeof(FileHeader)) return 0;
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.fileSize != file.size()) {
+            return 0;
+        }
+        GLenum target = header.target;
+        uint32_t faces = faceCount(target);
+        if ((target != GL_TEXTURE_2D_ARRAY && target != GL_TEXTURE_CUBE_MAP) ||
+            header.imageCount != header.levels * faces ||
+            sizeof(FileHeader) + sizeof(ImageEntry) * header.imageCount > file.size()) {
+            return 0;
+        }
+        std::vector<ImageEntry> images(header.imageCount);
+        std::memcpy(images.data(), file.data() + sizeof(FileHeader), sizeof(ImageEntry) * images.size());
+        for (const ImageEntry& image : images) {
+            if (image.offset > file.size() || image.size > file.size() - image.offset) return 0;
+        }
+
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(target, texture);
+        GLint prevAlign = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &prevAlign);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (uint32_t level = 0; level < header.levels; ++level) {
+            GLsizei w = std::max(header.width >> level, 1);
+            GLsizei h = std::max(header.height >> level, 1);
+            for (uint32_t face = 0; face < faces; ++face) {
+                const std::byte* pixels = file.data() + images[level * faces + face].offset;
+                if (target == GL_TEXTURE_2D_ARRAY) {
+                    glTexImage3D(target, static_cast<GLint>(level), static_cast<GLint>(header.internalFormat),
+                                 w, h, header.depth, 0, header.format, header.type, pixels);
+                } else {
+                    glTexImage2D(imageTarget(target, face), static_cast<GLint>(level), static_cast<GLint>(header.internalFormat),
+                                 w, h, 0, header.format, header.type, pixels);
+                }
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, prevAlign);
+
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.levels) - 1);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, header.minFilter);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, header.magFilter);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, header.wrapS);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, header.wrapT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, header.wrapR);
+        glBindTexture(target, 0);
+        return texture;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// Versioned binary cache of finished GL textures (*.rtex).
+//
+// A cache holds every mip level of a GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP
+// as glGetTexImage returned it, plus its sampler state. A later load uploads
+// straight from the mapped file, skipping image decoding, GPU rescaling and
+// mipmap generation. Processes rendering the same scene share one copy
+// through the page cache.
+//
+// Layout: header, image table (level-major; six faces per level for cube
+// maps, one image of all layers per level for arrays), then data blocks on
+// 64-byte boundaries.
+namespace TextureCache {
+    constexpr uint32_t VERSION = 1;
+
+    // Cache file in `directory` for a texture made from `sources` with
+    // `settings` (anything else that changes the result, e.g. its size).
+    std::string cachePathFor(
+        const std::string& directory,
+        const std::vector<std::string>& sources,
+        const std::string& settings
+    );
+    // Exists, is newer than every source and has this version's layout.
+    bool isFresh(const std::string& cachePath, const std::vector<std::string>& sources);
+
+    // Reads back `texture` and writes it to `path`, through a temporary file
+    // so readers never see a partial cache.
+    bool write(const std::string& path, GLenum target, GLuint texture);
+    // Creates a texture from a cache written by write(); 0 if it is invalid.
+    GLuint load(const std::string& path);
+}
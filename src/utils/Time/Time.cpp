@@ -1,15 +1,13 @@
 #include "Time.h"
 
-#include <GLFW/glfw3.h>
+#include <chrono>
 
-namespace Time {
-    float deltaTime = 0.0f;
-    float lastFrame = 0.0f;
+namespace {
+    const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+}
 
-    void update() {
-        float currentFrame = static_cast<float>(glfwGetTime());
-        
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+namespace Time {
+    int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
     }
 }
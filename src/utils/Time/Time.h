@@ -1,9 +1,10 @@
 #pragma once
 
-namespace Time {
-    extern float deltaTime;
-
-    extern float lastFrame;
+#include <cstdint>
 
-    void update();
+// A 64-bit monotonic clock that starts with the program. Frame deltas come
+// from FrameLoop.
+namespace Time {
+    // Nanoseconds since the clock started.
+    int64_t now();
 }
@@ -0,0 +1,82 @@
+#include "WeightedOIT.h"
+
+WeightedOIT::WeightedOIT()
+    : m_composite("oit_composite")
+{
+    // Core profile needs a VAO bound even for attribute-less draws.
+    glGenVertexArrays(1, &m_vao);
+
+    m_composite.bind();
+    m_composite.setInt("opaqueColor", 0);
+    m_composite.setInt("accumTex", 1);
+    m_composite.setInt("revealageTex", 2);
+}
+
+WeightedOIT::~WeightedOIT() {
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+}
+
+void WeightedOIT::addPasses(
+    RenderGraph& graph,
+    RenderQueue& queue,
+    Shader& accumulateShader,
+    RenderResource opaqueColor,
+    RenderResource opaqueDepth,
+    RenderResource target
+) {
+    // A copy: creating textures below can reallocate the graph's resource list.
+    const RenderTextureDesc size = graph.desc(opaqueDepth);
+    RenderResource accum = RenderGraph::INVALID;
+    RenderResource revealage = RenderGraph::INVALID;
+
+    graph.addPass(
+        "oit-accumulate",
+        [&](RenderGraph::Builder& builder) {
+            // Attached for depth testing against the opaque scene; never written.
+            builder.read(opaqueDepth);
+            builder.write(opaqueDepth);
+            accum = builder.create("oit-accum", {size.width, size.height, ACCUM_FORMAT});
+            revealage = builder.create("oit-revealage", {size.width, size.height, REVEALAGE_FORMAT});
+        },
+        [&queue, &accumulateShader](const RenderGraph::Context&) {
+            const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            glClearBufferfv(GL_COLOR, 0, zero);
+            glClearBufferfv(GL_COLOR, 1, zero);
+
+            // Both targets blend additively; see room_oit.frag for revealage.
+            queue.setTransparentState(&accumulateShader, BlendFactor::One, BlendFactor::One);
+            queue.execute(RenderPass::Transparent, RenderPass::Transparent);
+            queue.setTransparentState(nullptr, BlendFactor::SrcAlpha, BlendFactor::OneMinusSrcAlpha);
+        }
+    );
+
+    graph.addPass(
+        "oit-composite",
+        [&](RenderGraph::Builder& builder) {
+            builder.read(opaqueColor);
+            builder.read(accum);
+            builder.read(revealage);
+            builder.write(target);
+        },
+        [this, opaqueColor, accum, revealage](const RenderGraph::Context& context) {
+            glDisable(GL_DEPTH_TEST);
+            m_composite.bind();
+
+            const RenderResource inputs[] = {opaqueColor, accum, revealage};
+            for (int i = 0; i < 3; ++i) {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, context.texture(inputs[i]));
+            }
+
+            glBindVertexArray(m_vao);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+
+            for (int i = 2; i >= 0; --i) {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+            glEnable(GL_DEPTH_TEST);
+        }
+    );
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "utils/RenderGraph/RenderGraph.h"
+#include "utils/RenderQueue/RenderQueue.h"
+#include "utils/Shader/Shader.h"
+
+// Weighted blended order-independent transparency. The transparent packets of
+// a RenderQueue are drawn once, unsorted, into an accumulation and a revealage
+// target; a full-screen pass then resolves them over the opaque image.
+class WeightedOIT {
+public:
+    static constexpr GLenum ACCUM_FORMAT = GL_RGBA16F;
+    static constexpr GLenum REVEALAGE_FORMAT = GL_R16F;
+
+    WeightedOIT();
+    ~WeightedOIT();
+
+    WeightedOIT(const WeightedOIT&) = delete;
+    WeightedOIT& operator=(const WeightedOIT&) = delete;
+
+    // Adds the accumulation and composite passes. `accumulateShader` replaces
+    // the packets' own shaders and must write the two targets (see room_oit);
+    // the caller keeps its view/projection uniforms current. The composite
+    // writes opaqueColor with the transparent layers on top to `target`.
+    void addPasses(
+        RenderGraph& graph,
+        RenderQueue& queue,
+        Shader& accumulateShader,
+        RenderResource opaqueColor,
+        RenderResource opaqueDepth,
+        RenderResource target
+    );
+
+private:
+    Shader m_composite;
+    GLuint m_vao = 0;
+};